@@ -47,7 +47,7 @@ namespace {
 
   #define FIELD_FILENAME "field.dat"
 
-  #define ERR_FILE "error.dat"
+  #define ERR_FILE "error.npy"
 
 }/* namespace (anon) */
 
@@ -1,6 +1,7 @@
 #include "common.h"
 
 #include <fields/createFieldFile.h>
+#include <fields/field-shards.h>
 #include <fields/indices.h>
 
 #include <xylose/strutil.h>
@@ -10,6 +11,7 @@
 #include <iostream>
 #include <fstream>
 #include <stdexcept>
+#include <cstdlib>
 
 
 namespace {
@@ -25,7 +27,11 @@ namespace {
   const Vector<double,3> dxs      = V3(20.*um, 20.*um, 20.*um);
 }
 
-int main() {
+/* usage:  createfieldfile [shard nshards]
+ * With arguments, only the given z-slab shard of the table is written (to
+ * FIELD_FILENAME.shard-<shard>);  the shards are combined with mergeshards.
+ */
+int main( int argc, char ** argv ) {
   ChimpDB db;
   db.addParticleType("87Rb");
   db.initBinaryInteractions();
@@ -36,6 +42,18 @@ int main() {
   bsrc.Gravity::bg[Z] = -physical::unit::gravity;
   bsrc.delta = delta_B;
 
+  if ( argc == 3 ) {
+    const int shard = std::atoi(argv[1]);
+    Vector<int,3> nshards(1);
+    nshards[Z] = std::atoi(argv[2]);
+
+    std::ofstream out( (FIELD_FILENAME ".shard-" + xylose::to_string(shard)).c_str() );
+    out.precision(17);
+    fields::createFieldShard( bsrc, X_MINc, X_MAXc, dxc, X_MINs, X_MAXs, dxs,
+                              nshards, shard, out );
+    return 0;
+  }
+
   createFieldFile(bsrc,
                   X_MINc,
                   X_MAXc,
@@ -0,0 +1,109 @@
+#include <fields/inspect-table.h>
+#include <fields/field-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+#include <xylose/strutil.h>
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+
+namespace {
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+
+  void usage() {
+    std::cerr <<
+      "usage:  inspecttable info    FILE\n"
+      "        inspecttable line    FILE x0 y0 z0 x1 y1 z1 [n [species]]\n"
+      "        inspecttable slice   FILE x|y|z value [n [species]]\n"
+      "        inspecttable convert FILE OUTPUT text|binary|npy|float\n"
+      "Tables of ForceRecord<3,s> (4*s columns) are supported.  'line' and\n"
+      "'slice' write text to stdout (n points [101] along each direction) and\n"
+      "only load the part of the tables that they cover.  'convert' streams\n"
+      "the tables one z-plane at a time;  'float' is npy in single precision."
+      << std::endl;
+  }
+
+  double arg( char ** argv, const int & i ) { return std::atof( argv[i] ); }
+
+  /** Run a command for tables of ForceRecord<3,S>. */
+  template < unsigned int S >
+  int run( const int & argc, char ** argv ) {
+    typedef fields::ForceRecord<3u,S> Record;
+    typedef fields::FieldLookup<Record> Lookup;
+
+    const std::string cmd = argv[1], file = argv[2];
+    std::cout.precision(10);
+
+    if ( cmd == "line" && argc >= 9 ) {
+      fields::extractLine<Lookup>( file,
+                                   V3( arg(argv,3), arg(argv,4), arg(argv,5) ),
+                                   V3( arg(argv,6), arg(argv,7), arg(argv,8) ),
+                                   argc > 9  ? std::atoi(argv[9])  : 101,
+                                   std::cout,
+                                   argc > 10 ? std::atoi(argv[10]) : 0 );
+    } else if ( cmd == "slice" && argc >= 5 &&
+                std::strlen(argv[3]) == 1u &&
+                std::strchr( "xyz", argv[3][0] ) ) {
+      fields::extractSlice<Lookup>( file, argv[3][0] - 'x', arg(argv,4),
+                                    argc > 5 ? std::atoi(argv[5]) : 101,
+                                    std::cout,
+                                    argc > 6 ? std::atoi(argv[6]) : 0 );
+    } else if ( cmd == "convert" && argc == 5 ) {
+      const std::string f = argv[4];
+      if ( f == "text" )
+        fields::convertFieldFile<Record>( file, argv[3], fields::TEXT_FILE );
+      else if ( f == "binary" )
+        fields::convertFieldFile<Record>( file, argv[3], fields::BINARY_FILE );
+      else if ( f == "npy" || f == "float" )
+        fields::convertFieldFile<Record>( file, argv[3], fields::NPY_FILE,
+                                          f == "float" );
+      else {
+        usage();
+        return EXIT_FAILURE;
+      }
+    } else {
+      usage();
+      return EXIT_FAILURE;
+    }
+    return 0;
+  }
+}
+
+int main( int argc, char ** argv ) {
+  if ( argc < 3 ) {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  try {
+    const fields::FieldFileInfo info = fields::readFieldFileInfo( argv[2] );
+    if ( std::string(argv[1]) == "info" ) {
+      std::cout << info;
+      return 0;
+    }
+
+    switch ( info.columns ) {
+      case  4u: return run<1u>( argc, argv );
+      case  8u: return run<2u>( argc, argv );
+      case 12u: return run<3u>( argc, argv );
+      case 16u: return run<4u>( argc, argv );
+      default:
+        throw std::runtime_error( "unsupported record of " +
+                                  xylose::to_string(info.columns) +
+                                  " columns" );
+    }
+  } catch ( std::exception & e ) {
+    std::cerr << "inspecttable:  " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+}
@@ -1,14 +1,18 @@
 #define DX_TIMED 0.3*um
-#define DX_TEST 6*um
 
 #include "common.h"
 
 #include <fields/field-lookup.h>
+#include <fields/error-map.h>
 #include <fields/indices.h>
 
 #include <sys/times.h>
 #include <unistd.h>
 #include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
 
 namespace {
 
@@ -16,14 +20,6 @@ namespace {
   using xylose::V3;
   using namespace fields::indices;
 
-  template <class BSrc1, class BSrc2>
-  double testfield(std::ostream & output,
-                   const BSrc1 & bsrc1,
-                   const BSrc2 & bsrc2,
-                   const Vector<double,3> & xi,
-                   const Vector<double,3> & xf,
-                   const Vector<double,3> & dx );
-
   template <class BSrc>
   double timefield(const BSrc & bsrc,
                    const Vector<double,3> & xi,
@@ -33,13 +29,54 @@ namespace {
   const Vector<double,3> X_MIN   = V3(-30.0*um,          -30.0*um,         -30.*um );
   const Vector<double,3> X_MAX   = V3( 30.0*um + 1e-12,   30.0*um + 1e-12,  30.*um + 1e-12 );
   const Vector<double,3> dx_timed= V3(DX_TIMED, DX_TIMED, DX_TIMED);
-  const Vector<double,3> dx_test = V3(DX_TEST, DX_TEST, DX_TEST);
 
   static const double seconds_per_clock_tick = 1.0 / sysconf(_SC_CLK_TCK);
 
+  void usage( const char * prog ) {
+    std::cerr << "usage:  " << prog << " [--samples n] [--stratified] "
+                 "[--max-a e] [--max-V e] [--volume nx ny nz] [--no-timing]\n";
+    std::exit(EXIT_FAILURE);
+  }
+
 } /* namespace (anon) */
 
-int main() {
+/* usage:  testfield [options]
+ *   --samples n         number of sample points [1000000]
+ *   --stratified        stratified (instead of uniform) random samples
+ *   --max-a e           largest tolerated relative error of a [1e-2]
+ *   --max-V e           largest tolerated relative error of V [1e-2]
+ *   --volume nx ny nz   write the largest errors on an nx*ny*nz grid to
+ *                       ERR_FILE (a NumPy array of shape (nz,nx,ny,2))
+ *   --no-timing         skip the timed comparison
+ *
+ * The samples are evaluated in parallel (OMP_NUM_THREADS threads).  The exit
+ * status is non-zero if any error exceeds its threshold.
+ */
+int main( int argc, char ** argv ) {
+  fields::ErrorMapOptions opts;
+  opts.samples = 1000000;
+  double max_a = 1e-2, max_V = 1e-2;
+  bool timing = true;
+
+  for ( int a = 1; a < argc; ++a ) {
+    const std::string opt = argv[a];
+    if ( opt == "--samples" && a + 1 < argc )
+      opts.samples = std::atol( argv[++a] );
+    else if ( opt == "--stratified" )
+      opts.sampling = fields::STRATIFIED_SAMPLES;
+    else if ( opt == "--max-a" && a + 1 < argc )
+      max_a = std::atof( argv[++a] );
+    else if ( opt == "--max-V" && a + 1 < argc )
+      max_V = std::atof( argv[++a] );
+    else if ( opt == "--volume" && a + 3 < argc ) {
+      for ( int d = X; d <= Z; ++d )
+        opts.volume[d] = std::atoi( argv[++a] );
+    } else if ( opt == "--no-timing" )
+      timing = false;
+    else
+      usage( argv[0] );
+  }
+
   ChimpDB db;
   db.addParticleType("87Rb");
   db.initBinaryInteractions();
@@ -57,66 +94,36 @@ int main() {
   flookup.readindata(FIELD_FILENAME);
 
 
-  std::ofstream errout(ERR_FILE);
-  errout.precision(8);
-  errout << std::scientific;
-  /* print header in file */
-  errout << "# x[3] error a_calc[3] a_lookup[3] Verr V_calc V_lookup\n";
-  testfield(errout, bsrc, flookup, X_MIN, X_MAX, dx_test);
-  errout.close();
-  std::cout << "Finished field test.\nDoing timed test" << std::endl;
+  const fields::ErrorMap errors = fields::mapErrors( bsrc, flookup, opts );
+  std::cout << errors << std::endl;
 
-  std::cout
-          << "BSrc Time    : "
-          << timefield(bsrc,X_MIN, X_MAX, dx_timed) << " s" << std::endl;
+  if ( !errors.volume.empty() ) {
+    std::ofstream errout( ERR_FILE, std::ios::binary );
+    fields::writeErrorVolume( errout, errors );
+  }
 
-  std::cout
-          << "flookup Time : "
-          << timefield(flookup,X_MIN, X_MAX, dx_timed) << " s" << std::endl;
+  if ( timing ) {
+    std::cout << "Doing timed test" << std::endl;
 
-  return 0;
-}
+    std::cout
+            << "BSrc Time    : "
+            << timefield(bsrc,X_MIN, X_MAX, dx_timed) << " s" << std::endl;
 
-namespace {
-  template <class BSrc1, class BSrc2>
-  double testfield(std::ostream & output,
-                   const BSrc1 & bsrc1,
-                   const BSrc2 & btst,
-                   const Vector<double,3> & xi,
-                   const Vector<double,3> & xf,
-                   const Vector<double,3> & dx ) {
-    double err = 0.0;
-    for (Vector<double,3> x = xi; x[Z] <= xf[Z]; x[Z] += dx[Z]) {
-      for (x[X] = xi[X]; x[X] <= xf[X]; x[X]+= dx[X]) {
-        for (x[Y] = xi[Y]; x[Y] <= xf[Y]; x[Y] += dx[Y]) {
-          Vector<double,3> a1, a2, error;
-          bsrc1.accel(a1, x);
-          btst.accel(a2, x);
-
-          double V1,V2,verr;
-          V1 = bsrc1.potential(x);
-          V2 = btst.potential(x);
-          verr = 1.0 - V2/(V1 + 1e-10);
-
-          error = a2; error.compDiv(a1 + 1e-10); error -= 1.0;
-          err += sum(error);
-
-          output << x     << '\t'
-                 << error << '\t'
-                 << a1    << '\t'
-                 << a2    << '\t'
-                 << verr  << '\t'
-                 << V1    << '\t'
-                 << V2    << '\n';
-        }
-      }/*for */
+    std::cout
+            << "flookup Time : "
+            << timefield(flookup,X_MIN, X_MAX, dx_timed) << " s" << std::endl;
+  }
 
-      output << '\n';
-    }
-    return err;
+  if ( !errors.within( max_a, max_V ) ) {
+    std::cerr << "testfield:  errors exceed the thresholds (a: " << max_a
+              << ", V: " << max_V << ')' << std::endl;
+    return EXIT_FAILURE;
   }
 
+  return 0;
+}
 
+namespace {
   template <class BSrc>
   double timefield(const BSrc & bsrc,
                    const Vector<double,3> & xi,
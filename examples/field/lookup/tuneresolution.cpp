@@ -0,0 +1,61 @@
+#include "common.h"
+
+#include <fields/tune-resolution.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <iostream>
+#include <cstdlib>
+#include <exception>
+
+
+namespace {
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+
+  /* the extents of the table in createfieldfile. */
+  const Vector<double,3> X_MIN    = V3(-100.0*um, -100.0*um, -20.*um );
+  const Vector<double,3> X_MAX    = V3( 100.0*um,  100.0*um,  20.*um );
+}
+
+/* usage:  tuneresolution [rel_error [budget_MB]]
+ * Prints the cheapest CORE/SHELL geometry (for createfieldfile) whose
+ * interpolation error of the accelerations is below rel_error [1e-2] and
+ * whose memory is within budget_MB [1024].
+ */
+int main( int argc, char ** argv ) {
+  const double rel_error = argc > 1 ? std::atof(argv[1]) : 1e-2;
+  const double budget    = (argc > 2 ? std::atof(argv[2]) : 1024.) * 1048576.;
+
+  ChimpDB db;
+  db.addParticleType("87Rb");
+  db.initBinaryInteractions();
+
+  BFieldForceTableSrc bsrc;
+  bsrc.db = & db;
+  addwires(bsrc);
+  bsrc.Gravity::bg[Z] = -physical::unit::gravity;
+  bsrc.delta = delta_B;
+
+  try {
+    const fields::TableResolution res =
+      fields::tuneResolution( bsrc, X_MIN, X_MAX, rel_error, budget );
+
+    std::cout << "X_MINc  " << res.X_MINc << '\n'
+              << "X_MAXc  " << res.X_MAXc << '\n'
+              << "dxc     " << res.dxc    << '\n'
+              << "X_MINs  " << res.X_MINs << '\n'
+              << "X_MAXs  " << res.X_MAXs << '\n'
+              << "dxs     " << res.dxs    << '\n'
+              << "memory  " << res.bytes / 1048576. << " MB\n"
+              << "error   " << res.error[0] << " (core), "
+                            << res.error[1] << " (shell)" << std::endl;
+  } catch ( std::exception & e ) {
+    std::cerr << "tuneresolution:  " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return 0;
+}
@@ -0,0 +1,120 @@
+/** \file
+ * Multi-threaded lookup throughput for the different table allocation
+ * options (huge pages, NUMA replicas).
+ *
+ * usage:  lookupbench [N=256] [lookups per thread=10000000]
+ *
+ * The CORE table has N^3 records (N=256 is 512 MB).  Threads should be
+ * pinned (OMP_PROC_BIND=spread) for the NUMA replicas to be effective.
+ */
+
+#include <fields/field-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/table-allocation.h>
+#include <fields/detail/omp.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <sys/time.h>
+#include <iostream>
+#include <cstdlib>
+#include <exception>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+
+  typedef fields::ForceLookup<> Lookup;
+
+  inline double now() {
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec + 1e-6 * tv.tv_usec;
+  }
+
+  /** Allocate and fill an N^3 CORE table (unit spacing). */
+  void createTable( Lookup & lookup, const int & N,
+                    const fields::TableAllocation & alloc ) {
+    fields::setAllocation( lookup, alloc );
+    lookup.initialize( V3(.5*(N-1), .5*(N-1), .5*(N-1)),
+                       V3(1.,1.,1.), V3(0.,0.,0.), V3(N-1.,N-1.,N-1.),
+                       V3(N-1.,N-1.,N-1.), V3(0.,0.,0.), V3(N-1.,N-1.,N-1.) );
+
+    fields::detail::DTable< fields::ForceRecord<> > & t =
+      lookup.table(Lookup::CORE);
+    #pragma omp parallel for
+    for ( int k = 0; k < N; ++k )
+      for ( int i = 0; i < N; ++i )
+        for ( int j = 0; j < N; ++j ) {
+          fields::ForceRecord<> & rec = t(i,j,k);
+          rec.a = V3(i,j,k);
+          rec.V = i + j + k;
+        }
+    t.sync();
+  }
+
+  /** Random lookups from all threads;  returns lookups per second. */
+  double run( const Lookup & lookup, const int & N, const long & nlookups ) {
+    double sum = 0.0;
+    const double t0 = now();
+    #pragma omp parallel reduction(+:sum)
+    {
+      unsigned long long s = 88172645463325252ull + fields::detail::thread_num();
+      const double scale = (N - 1.0) / 18446744073709551616.0;
+      Vector<double,3> a, r;
+      for ( long n = 0; n < nlookups; ++n ) {
+        for ( int d = 0; d < 3; ++d ) {
+          /* xorshift64 */
+          s ^= s << 13; s ^= s >> 7; s ^= s << 17;
+          r[d] = s * scale;
+        }
+        lookup.vector_lookup( a, r, 0u );
+        sum += a[X];
+      }
+    }
+    const double dt = now() - t0;
+    if ( sum == 0.123 ) std::cout << ' ';  /* keep the lookups alive. */
+    return nlookups * fields::detail::max_threads() / dt;
+  }
+
+}/* namespace (anon) */
+
+int main( int argc, char ** argv ) {
+  const int N = argc > 1 ? std::atoi(argv[1]) : 256;
+  const long nlookups = argc > 2 ? std::atol(argv[2]) : 10000000l;
+
+  struct {
+    const char * name;
+    fields::TableAllocation alloc;
+  } const configs[] = {
+    { "default                 ", fields::TableAllocation() },
+    { "transparent huge pages  ", fields::TableAllocation(fields::TRANSPARENT_HUGE_PAGES) },
+    { "2MB huge pages          ", fields::TableAllocation(fields::HUGE_PAGES_2MB) },
+    { "1GB huge pages          ", fields::TableAllocation(fields::HUGE_PAGES_1GB) },
+    { "NUMA replicas           ", fields::TableAllocation(fields::DEFAULT_PAGES, true) },
+    { "NUMA replicas + THP     ", fields::TableAllocation(fields::TRANSPARENT_HUGE_PAGES, true) },
+    { "NUMA replicas + 2MB     ", fields::TableAllocation(fields::HUGE_PAGES_2MB, true) },
+  };
+
+  std::cout << "table: " << N << "^3 records ("
+            << (double(N)*N*N*sizeof(fields::ForceRecord<>) / (1<<20)) << " MB), "
+            << fields::detail::max_threads() << " threads, "
+            << fields::detail::numaNodes() << " NUMA nodes\n";
+
+  for ( unsigned int c = 0u; c < sizeof(configs)/sizeof(configs[0]); ++c ) {
+    std::cout << configs[c].name << ": " << std::flush;
+    try {
+      Lookup lookup;
+      createTable( lookup, N, configs[c].alloc );
+      run( lookup, N, nlookups / 10 );  /* warm up */
+      std::cout << run( lookup, N, nlookups ) * 1e-6 << " Mlookups/s\n";
+    } catch ( std::exception & e ) {
+      std::cout << "unavailable (" << e.what() << ")\n";
+    }
+  }
+
+  return 0;
+}
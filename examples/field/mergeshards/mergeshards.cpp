@@ -0,0 +1,87 @@
+/** \file
+ * Stitch the shards of a field-lookup table (@see fields::createFieldShard)
+ * into one table file.
+ *
+ * usage:  mergeshards [--binary] [--species n] output shard...
+ *
+ *   --binary          write binary data-blocks
+ *   --species n       number of species in the records (1-4) [1]
+ *
+ * The shards are checked to tile the tables exactly before anything is
+ * written.
+ */
+
+#include <fields/field-shards.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+namespace {
+
+  void usage( const char * prog ) {
+    std::cerr << "usage:  " << prog
+              << " [--binary] [--species n] output shard...\n";
+    std::exit(EXIT_FAILURE);
+  }
+
+  template < unsigned int N >
+  long merge( const std::vector<std::string> & shards,
+              std::ostream & out,
+              const fields::FileFormat & format ) {
+    return fields::mergeFieldShards< fields::ForceRecord<3u,N> >(
+      shards, out, "", format );
+  }
+
+}/* namespace (anon) */
+
+int main( int argc, char ** argv ) {
+  fields::FileFormat format = fields::TEXT_FILE;
+  int species = 1;
+
+  int a = 1;
+  for ( ; a < argc && std::strncmp( argv[a], "--", 2 ) == 0; ++a ) {
+    const std::string opt = argv[a];
+    if ( opt == "--binary" )
+      format = fields::BINARY_FILE;
+    else if ( opt == "--species" && a + 1 < argc )
+      species = std::atoi( argv[++a] );
+    else
+      usage( argv[0] );
+  }
+
+  if ( a + 2 > argc )
+    usage( argv[0] );
+  const std::string output = argv[a];
+  const std::vector<std::string> shards( argv + a + 1, argv + argc );
+
+  try {
+    std::ofstream out( output.c_str() );
+    out.precision(17);
+
+    long n = 0;
+    switch ( species ) {
+      case 1: n = merge<1u>( shards, out, format ); break;
+      case 2: n = merge<2u>( shards, out, format ); break;
+      case 3: n = merge<3u>( shards, out, format ); break;
+      case 4: n = merge<4u>( shards, out, format ); break;
+      default: usage( argv[0] );
+    }
+
+    if ( !out.good() )
+      throw std::runtime_error( "could not write '" + output + '\'' );
+
+    std::cout << "wrote " << n << " records to " << output << std::endl;
+  } catch ( std::exception & e ) {
+    std::cerr << "mergeshards:  " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return 0;
+}
@@ -0,0 +1,181 @@
+/** \file
+ * Resample a field-lookup table file onto a new grid.
+ *
+ * usage:  resample [options] input output
+ *
+ * options:
+ *   --core  xmin ymin zmin xmax ymax zmax dx dy dz
+ *                     geometry of the new CORE table
+ *   --shell xmin ymin zmin xmax ymax zmax dx dy dz
+ *                     geometry of the new SHELL table
+ *   --refine f        divide the grid spacings by f
+ *   --cubic           use the tricubic interpolant (instead of the trilinear
+ *                     interpolant of the table)
+ *   --binary          write binary data-blocks
+ *   --band n          calculate n planes at a time, reading only the part of
+ *                     the input that covers them (use with binary input)
+ *   --axisym          the input is an axially symmetric table
+ *   --species n       number of species in the records (1-4) [1]
+ *
+ * The geometry that is not given is taken from the input.  The planes are
+ * calculated in parallel (OMP_NUM_THREADS threads).
+ */
+
+#include <fields/resample.h>
+#include <fields/field-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+
+#include <xylose/Vector.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+
+  struct Options {
+    Options() : refine(1.0), interp(fields::TABLE_INTERPOLANT),
+                format(fields::TEXT_FILE), band(0), axisym(false),
+                species(1) { }
+
+    fields::TableGeometry g[2];
+    double refine;
+    fields::Interpolant interp;
+    fields::FileFormat format;
+    int band;
+    bool axisym;
+    int species;
+    std::string input, output;
+  };
+
+  void usage( const char * prog ) {
+    std::cerr << "usage:  " << prog << " [options] input output\n"
+                 "  --core  xmin ymin zmin xmax ymax zmax dx dy dz\n"
+                 "  --shell xmin ymin zmin xmax ymax zmax dx dy dz\n"
+                 "  --refine f\n"
+                 "  --cubic\n"
+                 "  --binary\n"
+                 "  --band n\n"
+                 "  --axisym\n"
+                 "  --species n   (1-4)\n";
+    std::exit(EXIT_FAILURE);
+  }
+
+  /** Parse the nine numbers of a --core or --shell option. */
+  void readGeometry( fields::TableGeometry & g, int & a,
+                     const int & argc, char ** argv ) {
+    if ( a + 9 >= argc )
+      usage( argv[0] );
+    std::istringstream in;
+    for ( int i = 0; i < 9; ++i ) {
+      in.clear();
+      in.str( argv[++a] );
+      double & x = i < 3 ? g.min[i] : ( i < 6 ? g.max[i-3] : g.dx[i-6] );
+      if ( !(in >> x) )
+        usage( argv[0] );
+    }
+  }
+
+  template < unsigned int N >
+  long run( const Options & o, std::ostream & out ) {
+    typedef fields::ForceRecord<3u,N> Record;
+    const fields::TableGeometry & c = o.g[0], & s = o.g[1];
+
+    std::ostringstream comments;
+    comments << "# resampled from " << o.input << '\n';
+
+    if ( o.axisym )
+      return fields::resampleFieldFile< fields::AxiSymFieldLookup<Record> >(
+        o.input, out, c.min, c.max, c.dx, s.min, s.max, s.dx,
+        o.interp, o.format, o.band, comments.str() );
+    else
+      return fields::resampleFieldFile< fields::FieldLookup<Record> >(
+        o.input, out, c.min, c.max, c.dx, s.min, s.max, s.dx,
+        o.interp, o.format, o.band, comments.str() );
+  }
+
+}/* namespace (anon) */
+
+int main( int argc, char ** argv ) {
+  Options o;
+  bool given[2] = { false, false };
+
+  int a = 1;
+  for ( ; a < argc && std::strncmp( argv[a], "--", 2 ) == 0; ++a ) {
+    const std::string opt = argv[a];
+    if ( opt == "--core" ) {
+      readGeometry( o.g[0], a, argc, argv );
+      given[0] = true;
+    } else if ( opt == "--shell" ) {
+      readGeometry( o.g[1], a, argc, argv );
+      given[1] = true;
+    } else if ( opt == "--refine" && a + 1 < argc ) {
+      o.refine = std::atof( argv[++a] );
+    } else if ( opt == "--cubic" ) {
+      o.interp = fields::CUBIC_INTERPOLANT;
+    } else if ( opt == "--binary" ) {
+      o.format = fields::BINARY_FILE;
+    } else if ( opt == "--band" && a + 1 < argc ) {
+      o.band = std::atoi( argv[++a] );
+    } else if ( opt == "--axisym" ) {
+      o.axisym = true;
+    } else if ( opt == "--species" && a + 1 < argc ) {
+      o.species = std::atoi( argv[++a] );
+    } else
+      usage( argv[0] );
+  }
+
+  if ( a + 2 != argc || o.refine <= 0.0 )
+    usage( argv[0] );
+  o.input = argv[a];
+  o.output = argv[a+1];
+
+  try {
+    /* the geometry that is not given is that of the input. */
+    {
+      std::ifstream in( o.input.c_str() );
+      if ( !in.good() )
+        throw std::runtime_error( "could not open '" + o.input + '\'' );
+      Vector<double,3> r0;
+      fields::TableGeometry g[2];
+      fields::FieldLookupBase< fields::ForceRecord<> >::readGeometry(
+        in, r0, g[0], g[1] );
+      for ( int t = 0; t < 2; ++t )
+        if ( !given[t] )
+          o.g[t] = g[t];
+    }
+
+    for ( int t = 0; t < 2; ++t )
+      o.g[t].dx /= o.refine;
+
+    std::ofstream out( o.output.c_str() );
+    out.precision(17);
+
+    long n = 0;
+    switch ( o.species ) {
+      case 1: n = run<1u>( o, out ); break;
+      case 2: n = run<2u>( o, out ); break;
+      case 3: n = run<3u>( o, out ); break;
+      case 4: n = run<4u>( o, out ); break;
+      default: usage( argv[0] );
+    }
+
+    if ( !out.good() )
+      throw std::runtime_error( "could not write '" + o.output + '\'' );
+
+    std::cout << "wrote " << n << " records to " << o.output << std::endl;
+  } catch ( std::exception & e ) {
+    std::cerr << "resample:  " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return 0;
+}
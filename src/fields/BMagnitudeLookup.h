@@ -0,0 +1,221 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+/** \file
+ * Magnetic force lookup from a single table of |B| and grad|B| that is
+ * shared by all magnetic sub-states and species.
+ */
+
+#ifndef fields_BMagnitudeLookup_h
+#define fields_BMagnitudeLookup_h
+
+#include <fields/Fields.h>
+#include <fields/Forces.h>
+#include <fields/force-lookup.h>
+#include <fields/field-lookup.h>
+#include <fields/make_options.h>
+
+#include <chimp/property/mass.h>
+
+#include <xylose/Vector.h>
+
+#include <physical/physical.h>
+
+namespace fields {
+  namespace BField {
+
+    using xylose::Vector;
+    using xylose::V3;
+
+    /** Source for createFieldFile that tabulates grad|B| (as the vector) and
+     * |B| (as the scalar) of a magnetic field.  Unlike
+     * ForceTableWrapper< BCalcs<BSrc> >, no magnetic moment or mass is
+     * folded into the records, so the resulting table can be used by
+     * BMagnitudeLookup for any magnetic sub-state of any species.
+     *
+     * @param BSrc
+     *     Magnetic field; must be a derivation of the BaseField class.
+     */
+    template < typename BSrc >
+    struct BMagnitudeTableWrapper : BSrc {
+      typedef BSrc MagneticField;
+
+      ForceRecord<3u,1u> getRecord( const Vector<double,3> & r ) const {
+        ForceRecord<3u,1u> retval;
+        gradient_of_magnitude( retval.a, (MagneticField&)*this, r );
+
+        Vector<double,3> B;
+        MagneticField::operator()(B, r);
+        retval.V = B.abs();
+        return retval;
+      }
+    };
+
+
+    /** Lookup replacement for BCalcs.  The table holds only grad|B| and |B|
+     * (@see BMagnitudeTableWrapper) and the magnetic moment and the mass of
+     * the species are applied at lookup time:
+     *   a = - mu * grad|B| / mass(species),
+     *   V =   mu * |B|.
+     * Thus a single table serves every magnetic sub-state and species,
+     * whereas tables written with ForceTableWrapper need one copy of the
+     * records per (state, species) combination.
+     *
+     * @param options
+     *     Field options (@see fields::make_options).
+     *
+     * @param stateful_particles
+     *     Particles passed in via special accel/potential functions are
+     *     expected to have state information such that mu is calculated as:
+     *     mu = physical::constant::si::mu_B * state(particle) (@see BCalcs).
+     *
+     * @param T
+     *     Lookup table of ForceRecord<3,1> records (e.g. FieldLookup or
+     *     AxiSymFieldLookup with any Table storage).
+     */
+    template <
+      typename options = fields::make_options<>::type,
+      bool stateful_particles = false,
+      class T = FieldLookup< ForceRecord<3u,1u> >
+    >
+    struct BMagnitudeLookup;
+
+
+    template < typename options, class T >
+    struct BMagnitudeLookup<options, false, T> : virtual BaseForce<options>,
+                                                  T {
+        /* TYPEDEFS */
+        typedef BaseForce<options> super0;
+        typedef T                  super1;
+
+
+        /* MEMBER STORAGE */
+        /** Magnetic moment used when no particle state is given
+         * (@see BCalcs::mu).  This defaults to \f$F=1\f$ and \f$m_{F}=-1\f$
+         * of \f$^{87}{\rm Rb} \f$.
+         */
+        double mu;
+
+        /* MEMBER FUNCTIONS */
+        /** Default constructor of BMagnitudeLookup. */
+        BMagnitudeLookup() : super0(), super1() {
+          mu = (-0.5) * (-1) * physical::constant::si::mu_B;
+        }
+
+        void accel(      Vector<double,3> & a,
+                   const Vector<double,3> & r,
+                   const Vector<double,3> & v,
+                   const double & t,
+                   const double & dt,
+                   const unsigned int & species,
+                   const double & _mu ) const {
+          super1::vector_lookup(a, r, 0u);
+          a *= - _mu / (*super0::db)[species].chimp::property::mass::value;
+        }
+
+        void accel(      Vector<double,3> & a,
+                   const Vector<double,3> & r,
+                   const Vector<double,3> & v = V3(0.,0.,0.),
+                   const double & t = 0.0,
+                   const double & dt = 0.0,
+                   const unsigned int & species = 0u ) const {
+          this->accel(a, r, v, t, dt, species, this->mu);
+        }
+
+        template < typename P >
+        void accel(      Vector<double,3> & a,
+                   const Vector<double,3> & r,
+                   const Vector<double,3> & v,
+                   const double & t,
+                   const double & dt,
+                         P & p ) const {
+          this->accel(a, r, v, t, dt, static_cast<unsigned int>(species(p)),
+                      this->mu);
+        }
+
+        double potential(const Vector<double,3> & r,
+                         const Vector<double,3> & v,
+                         const double & t,
+                         const unsigned int & species,
+                         const double & _mu ) const {
+          return _mu * super1::scalar_lookup(r, 0u);
+        }
+
+        double potential(const Vector<double,3> & r,
+                         const Vector<double,3> & v = V3(0.,0.,0.),
+                         const double & t = 0.0,
+                         const unsigned int & species = 0u ) const {
+          return this->potential(r,v,t, species, this->mu);
+        }
+
+        template < typename P >
+        double potential(const Vector<double,3> & r,
+                         const Vector<double,3> & v,
+                         const double & t,
+                         const P & p ) const {
+          return this->potential(r,v,t, static_cast<unsigned int>(species(p)),
+                                 this->mu);
+        }
+    };
+
+    template < typename options, class T >
+    struct BMagnitudeLookup<options, true, T>
+      : BMagnitudeLookup<options, false, T> {
+        /* TYPEDEFS */
+        typedef BMagnitudeLookup<options, false, T> super;
+
+        using super::accel;
+        using super::potential;
+
+        template < typename P >
+        void accel(      Vector<double,3> & a,
+                   const Vector<double,3> & r,
+                   const Vector<double,3> & v,
+                   const double & t,
+                   const double & dt,
+                         P & p) const {
+          super::accel(a, r, v, t, dt, static_cast<unsigned int>(species(p)),
+                       physical::constant::si::mu_B * state(p));
+        }
+
+        template < typename P >
+        double potential(const Vector<double,3> & r,
+                         const Vector<double,3> & v,
+                         const double & t,
+                         const P & p) const {
+          return super::potential(r,v,t, static_cast<unsigned int>(species(p)),
+                                  physical::constant::si::mu_B * state(p));
+        }
+    };
+
+  } /* namespace fields::BField */
+}/* namespace fields */
+
+#endif // fields_BMagnitudeLookup_h
@@ -0,0 +1,137 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+/** \file
+ * Force lookup table that is filled on demand from its source.
+ *
+ * Generating a complete table with createFieldFile is wasteful when the
+ * particles only ever visit a small part of it.  CachedField starts with an
+ * empty grid and computes each brick of the grid from the wrapped source the
+ * first time that any thread needs it (@see detail::LazyTable).  Afterwards,
+ * lookups are interpolated exactly like ForceLookup.
+ *
+ * Example:
+ * <code>
+ *   typedef fields::BField::BCalcs< fields::BField::ThinWireSrc > BForce;
+ *   fields::CachedField< fields::ForceTableWrapper<BForce> > force;
+ *   force.source.currents.push_back( ... );
+ *   force.initialize( r0, core_dx, core_min, core_max,
+ *                         shell_dx, shell_min, shell_max );
+ *   force.accel( a, r );
+ * </code>
+ */
+
+#ifndef fields_CachedField_h
+#define fields_CachedField_h
+
+#include <fields/force-lookup.h>
+#include <fields/field-lookup.h>
+#include <fields/detail/LazyTable.h>
+
+#include <xylose/Vector.h>
+
+namespace fields {
+
+  using xylose::Vector;
+
+  /** Force lookup table that computes its records on demand.
+   *
+   * @param Source
+   *     Provides ForceRecord<L,N> getRecord(const Vector<double,3> & r) const
+   *     (e.g. ForceTableWrapper<SomeForce,L,N>).
+   * @param L
+   *     Length of the vectors [Default 3].
+   * @param N
+   *     Number of species [Default 1].
+   */
+  template < typename Source, unsigned int L = 3u, unsigned int N = 1u >
+  class CachedField
+    : public ForceLookup< L,
+        FieldLookup< ForceRecord<L,N>,
+                     detail::LazyTable< ForceRecord<L,N>, Source > > > {
+    /* TYPEDEFS */
+  public:
+    typedef ForceLookup< L,
+      FieldLookup< ForceRecord<L,N>,
+                   detail::LazyTable< ForceRecord<L,N>, Source > > > super;
+    typedef typename super::super Lookup;
+    typedef typename Lookup::super Base;
+
+
+    /* MEMBER STORAGE */
+  public:
+    /** The source of the records.  If the source is changed after records
+     * have been computed, call clear(). */
+    Source source;
+
+
+    /* MEMBER FUNCTIONS */
+  public:
+    CachedField() : super(), source() { }
+
+    /** Create the (empty) lookup table.  Records are computed from source as
+     * needed.
+     * @see FieldLookupBase::initialize.
+     */
+    void initialize( const Vector<double,3> & r0,
+                     const Vector<double,3> & core_dx,
+                     const Vector<double,3> & core_min,
+                     const Vector<double,3> & core_max,
+                     const Vector<double,3> & shell_dx,
+                     const Vector<double,3> & shell_min,
+                     const Vector<double,3> & shell_max ) {
+      Base::initialize( r0, core_dx, core_min, core_max,
+                            shell_dx, shell_min, shell_max );
+      super::table(Base::CORE).bind( source, core_min, core_dx );
+      #ifndef DISABLE_SHELL_LOOKUP
+        super::table(Base::SHELL).bind( source, shell_min, shell_dx );
+      #endif
+    }
+
+    /** Forget all computed records (e.g. after changing the source).  This
+     * must not be called while other threads are doing lookups. */
+    void clear() {
+      super::table(Base::CORE).clear();
+      #ifndef DISABLE_SHELL_LOOKUP
+        super::table(Base::SHELL).clear();
+      #endif
+    }
+
+    /** Fraction of the bricks of a table that have been computed. */
+    double filled( const typename Base::DSECT & t ) const {
+      const typename Base::DTable & d = super::table(t);
+      return d.nbricks() ? double(d.nready()) / d.nbricks() : 0.0;
+    }
+  };
+
+}/* namespace fields */
+
+#endif // fields_CachedField_h
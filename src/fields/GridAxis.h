@@ -0,0 +1,228 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+/** \file
+ * Monotone (possibly non-uniform) coordinate axis of a lookup table grid.
+ */
+
+#ifndef fields_GridAxis_h
+#define fields_GridAxis_h
+
+#include <xylose/except.h>
+
+#include <vector>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+namespace fields {
+
+  /** A strictly increasing set of grid coordinates along one axis.
+   * Locating the cell of a coordinate is O(1):  the axis is divided into
+   * uniform buckets no wider than the narrowest cell, and each bucket
+   * remembers the first cell that it overlaps.  A search therefore starts at
+   * most one cell away from the answer.
+   *
+   * Axes can be created from a closed-form mapping (uniform(), sinh()) or
+   * from an arbitrary table of coordinates (the constructor).
+   *
+   * @see NonUniformFieldLookup.
+   */
+  class GridAxis {
+    /* MEMBER STORAGE */
+  private:
+    /** Grid coordinates. */
+    std::vector<double> x;
+    /** 1/(x[i+1]-x[i]). */
+    std::vector<double> dx_inv;
+    /** First cell that overlaps each bucket. */
+    std::vector<unsigned int> bucket;
+    /** 1/(bucket width). */
+    double bucket_inv;
+
+    /** Maximum number of buckets per grid point.  Extremely stretched grids
+     * (cell-width ratios larger than this) lose the O(1) guarantee. */
+    static const unsigned int MAX_BUCKETS_PER_POINT = 16u;
+
+
+    /* MEMBER FUNCTIONS */
+  public:
+    /** Default constructor creates an empty axis. */
+    GridAxis() : bucket_inv(0.0) { }
+
+    /** Create an axis from an arbitrary, strictly increasing set of
+     * coordinates (at least two). */
+    GridAxis( const std::vector<double> & coords ) : bucket_inv(0.0) {
+      assign(coords);
+    }
+
+    /** Uniformly spaced axis with N points from min to max (inclusive). */
+    static GridAxis uniform( const double & min,
+                             const double & max,
+                             const unsigned int & N ) {
+      checkPoints(N);
+      std::vector<double> c(N);
+      for ( unsigned int i = 0u; i < N; ++i )
+        c[i] = min + (max - min) * i / (N - 1.0);
+      c[N-1] = max;
+      return GridAxis(c);
+    }
+
+    /** Axis with N points from min to max that are concentrated around
+     * center.  The points are given by
+     *   x(s) = center + width * sinh(s),
+     * with s uniformly spaced from asinh((min-center)/width) to
+     * asinh((max-center)/width).  The spacing is approximately
+     *   width * ds
+     * within a distance of width from center and grows exponentially away
+     * from center.  For width >> (max-min), the axis is nearly uniform.
+     */
+    static GridAxis sinh( const double & min,
+                          const double & max,
+                          const unsigned int & N,
+                          const double & center,
+                          const double & width ) {
+      checkPoints(N);
+      const double s0 = asinh( (min - center) / width );
+      const double s1 = asinh( (max - center) / width );
+      std::vector<double> c(N);
+      for ( unsigned int i = 0u; i < N; ++i )
+        c[i] = center + width * std::sinh( s0 + (s1 - s0) * i / (N - 1.0) );
+      c[0]   = min;
+      c[N-1] = max;
+      return GridAxis(c);
+    }
+
+    /** Set the coordinates of this axis (at least two, strictly
+     * increasing). */
+    void assign( const std::vector<double> & coords ) {
+      checkPoints( coords.size() );
+
+      double min_dx = coords[1] - coords[0];
+      for ( unsigned int i = 1u; i < coords.size(); ++i ) {
+        if ( !(coords[i] > coords[i-1]) )
+          THROW(std::runtime_error,"GridAxis:  coordinates not increasing");
+        min_dx = std::min( min_dx, coords[i] - coords[i-1] );
+      }
+
+      x = coords;
+      dx_inv.resize( x.size() - 1u );
+      for ( unsigned int i = 0u; i < dx_inv.size(); ++i )
+        dx_inv[i] = 1.0 / (x[i+1] - x[i]);
+
+      unsigned int nb = std::min<double>(
+        std::ceil( length() / min_dx ),
+        MAX_BUCKETS_PER_POINT * x.size()
+      );
+      nb = std::max( nb, 1u );
+      bucket_inv = nb / length();
+      bucket.resize(nb);
+      for ( unsigned int b = 0u, i = 0u; b < nb; ++b ) {
+        const double xb = x[0] + b / bucket_inv;
+        while ( i < x.size() - 2u && x[i+1] <= xb )
+          ++i;
+        bucket[b] = i;
+      }
+    }
+
+    /** Number of grid points. */
+    unsigned int size() const { return x.size(); }
+
+
+    /** Grid coordinate of point i. */
+    const double & operator[]( const unsigned int & i ) const { return x[i]; }
+
+    const double & min() const { return x.front(); }
+    const double & max() const { return x.back(); }
+    double length() const { return x.back() - x.front(); }
+
+    /** Find the cell i (x[i] <= xx < x[i+1]) and fractional position f
+     * ( (xx - x[i]) / (x[i+1] - x[i]) ) of a coordinate.  Coordinates
+     * outside of the axis are clamped to the end cells (consistent with
+     * FieldLookup which clamps to the edges of its tables).
+     */
+    inline void locate( const double & xx,
+                        unsigned int & i,
+                        double & f ) const {
+      if ( !(xx > x.front()) ) {
+        i = 0u;
+        f = 0.0;
+        return;
+      }
+
+      unsigned int b = static_cast<unsigned int>( (xx - x.front()) * bucket_inv );
+      if ( b >= bucket.size() ) {
+        i = x.size() - 2u;
+        f = std::min( 1.0, (xx - x[i]) * dx_inv[i] );
+        return;
+      }
+
+      i = bucket[b];
+      while ( i < x.size() - 2u && x[i+1] <= xx )
+        ++i;
+      f = std::min( 1.0, (xx - x[i]) * dx_inv[i] );
+    }
+
+  private:
+    /** An axis needs at least two points. */
+    static void checkPoints( const std::size_t & N ) {
+      if ( N < 2u )
+        THROW(std::runtime_error,"GridAxis:  need at least two points");
+    }
+  };
+
+  /** Write an axis as: N x0 x1 ... */
+  inline std::ostream & operator<<( std::ostream & output,
+                                    const GridAxis & axis ) {
+    output << axis.size();
+    for ( unsigned int i = 0u; i < axis.size(); ++i )
+      output << ' ' << axis[i];
+    return output;
+  }
+
+  /** Read an axis written as: N x0 x1 ... */
+  inline std::istream & operator>>( std::istream & input, GridAxis & axis ) {
+    unsigned int N = 0u;
+    input >> N;
+    std::vector<double> c(N);
+    for ( unsigned int i = 0u; i < N; ++i )
+      input >> c[i];
+    if ( input )
+      axis.assign(c);
+    return input;
+  }
+
+}/* namespace fields */
+
+#endif // fields_GridAxis_h
@@ -0,0 +1,228 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+/** \file
+ * Combine a force lookup table with the exact force that it tabulates.
+ *
+ * Lookups outside of a table are clamped to the table edges, which gives
+ * wrong forces.  HybridForce uses the table inside of its domain and
+ * calculates the force from the exact source outside of it, so that the
+ * SHELL table only needs to cover the region where speed matters.
+ *
+ * Example:
+ * <code>
+ *   typedef fields::HybridForce<
+ *     fields::ForceLookup<>,
+ *     fields::BField::BCalcs< fields::BField::ThinWireSrc >
+ *   > Force;
+ *   Force force;
+ *   force.readindata( "field.dat" );
+ *   force.currents.push_back( ... );
+ * </code>
+ */
+
+#ifndef fields_HybridForce_h
+#define fields_HybridForce_h
+
+#include <xylose/Vector.h>
+
+#include <vector>
+#include <cstddef>
+
+namespace fields {
+
+  using xylose::Vector;
+  using xylose::V3;
+
+  /** Force that uses the TableForce inside of its domain (@see
+   * FieldLookup::inDomain) and the ExactForce everywhere else.
+   *
+   * @param TableForce
+   *     The force lookup table (e.g. ForceLookup<>).
+   * @param ExactForce
+   *     The force that was tabulated (e.g. BField::BCalcs<ThinWireSrc>).
+   *     The two forces must of course use the same units.
+   */
+  template < typename TableForce, typename ExactForce >
+  struct HybridForce : TableForce, ExactForce {
+    /* TYPEDEFS */
+    typedef TableForce T;
+    typedef ExactForce E;
+
+
+    /* MEMBER FUNCTIONS */
+    HybridForce() : T(), E() { }
+
+    /** Whether r is looked up in the table. */
+    inline bool inTable( const Vector<double,3> & r ) const {
+      return T::isInitialized() && T::inDomain(r);
+    }
+
+    /** Calculate acceleration. */
+    inline void accel(       Vector<double,3> & a,
+                       const Vector<double,3> & r,
+                       const Vector<double,3> & v = V3(0.,0.,0.),
+                       const double & t = 0.0,
+                       const double & dt = 0.0,
+                       const unsigned int & species = 0u ) const {
+      if ( inTable(r) )
+        T::accel(a,r,v,t,dt,species);
+      else
+        E::accel(a,r,v,t,dt,species);
+    }
+
+    template < typename P >
+    inline void accel(       Vector<double,3> & a,
+                       const Vector<double,3> & r,
+                       const Vector<double,3> & v,
+                       const double & t,
+                       const double & dt,
+                             P & p ) const {
+      if ( inTable(r) )
+        T::accel(a,r,v,t,dt,p);
+      else
+        E::accel(a,r,v,t,dt,p);
+    }
+
+    inline double potential( const Vector<double,3> & r,
+                             const Vector<double,3> & v = V3(0.,0.,0.),
+                             const double & t = 0.0,
+                             const unsigned int & species = 0u ) const {
+      if ( inTable(r) )
+        return T::potential(r,v,t,species);
+      else
+        return E::potential(r,v,t,species);
+    }
+
+    template < typename P >
+    inline double potential( const Vector<double,3> & r,
+                             const Vector<double,3> & v,
+                             const double & t,
+                                   P & p ) const {
+      if ( inTable(r) )
+        return T::potential(r,v,t,p);
+      else
+        return E::potential(r,v,t,p);
+    }
+
+    /** Split the indices of a set of positions into those that are looked
+     * up in the table and those that are calculated from the exact source.
+     * The relative order of the indices is kept in each group. */
+    void partition( std::vector<std::size_t> & in_table,
+                    std::vector<std::size_t> & exact,
+                    const Vector<double,3> * r,
+                    const std::size_t & n ) const {
+      in_table.clear();
+      exact.clear();
+      in_table.reserve(n);
+      for ( std::size_t i = 0u; i < n; ++i ) {
+        if ( inTable(r[i]) )
+          in_table.push_back(i);
+        else
+          exact.push_back(i);
+      }
+    }
+
+    /** Calculate the acceleration of a set of particles.
+     * The particles are first partitioned into those in the table and those
+     * outside of it so that each group runs its own (branch-free) loop.
+     * @param a
+     *     Returns the accelerations [n].
+     * @param r
+     *     The positions [n].
+     * @param n
+     *     The number of particles.
+     * @param species
+     *     The species of all of the particles.
+     */
+    void accel(       Vector<double,3> * a,
+                const Vector<double,3> * r,
+                const std::size_t & n,
+                const unsigned int & species = 0u ) const {
+      std::vector<std::size_t> in_table, exact;
+      partition( in_table, exact, r, n );
+
+      const long nt = in_table.size(), ne = exact.size();
+      const Vector<double,3> v0(0.0);
+
+      #pragma omp parallel for
+      for ( long j = 0; j < nt; ++j ) {
+        const std::size_t i = in_table[j];
+        T::accel( a[i], r[i], v0, 0.0, 0.0, species );
+      }
+
+      #pragma omp parallel for schedule(dynamic,16)
+      for ( long j = 0; j < ne; ++j ) {
+        const std::size_t i = exact[j];
+        E::accel( a[i], r[i], v0, 0.0, 0.0, species );
+      }
+    }
+
+    /** Calculate the potential energy of a set of particles.
+     * @see accel(Vector<double,3>*, const Vector<double,3>*,
+     *            const std::size_t &, const unsigned int &).
+     */
+    void potential(       double * V,
+                    const Vector<double,3> * r,
+                    const std::size_t & n,
+                    const unsigned int & species = 0u ) const {
+      std::vector<std::size_t> in_table, exact;
+      partition( in_table, exact, r, n );
+
+      const long nt = in_table.size(), ne = exact.size();
+      const Vector<double,3> v0(0.0);
+
+      #pragma omp parallel for
+      for ( long j = 0; j < nt; ++j ) {
+        const std::size_t i = in_table[j];
+        V[i] = T::potential( r[i], v0, 0.0, species );
+      }
+
+      #pragma omp parallel for schedule(dynamic,16)
+      for ( long j = 0; j < ne; ++j ) {
+        const std::size_t i = exact[j];
+        V[i] = E::potential( r[i], v0, 0.0, species );
+      }
+    }
+
+    template < unsigned int ndim,
+               typename Particle >
+    inline void applyStatisticalForce(       Vector<double,ndim> & xv,
+                                       const double & t,
+                                       const double & dt,
+                                             Particle & particle ) const {
+      E::applyStatisticalForce( xv, t, dt, particle );
+    }
+  };
+
+}/* namespace fields */
+
+#endif // fields_HybridForce_h
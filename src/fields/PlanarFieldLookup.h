@@ -0,0 +1,316 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+/** \file
+ * Field lookup for fields that are invariant under translations along one
+ * axis.
+ */
+
+#ifndef fields_PlanarFieldLookup_h
+#define fields_PlanarFieldLookup_h
+
+#include <fields/field-lookup.h>
+
+#include <xylose/Vector.h>
+#include <xylose/SquareMatrix.h>
+#include <xylose/except.h>
+
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+namespace fields {
+
+  /** Field lookup for fields that do not vary along one (invariant) axis,
+   * such as those of long wire guides or planar chips.  The tables hold a
+   * single plane of the transverse grid (written with X_MIN[axis] ==
+   * X_MAX[axis] so that the table has one point along the invariant axis),
+   * and lookups are bilinear in that plane.
+   *
+   * The table frame can be rotated about the reference point r0 (the center
+   * of the CORE) with rotateField, as with AxiSymFieldLookup.  Positions are
+   * rotated into the table frame, and vector results are rotated back into
+   * the frame of the caller.  Without a rotation, positions are those of the
+   * table file (as with FieldLookup).
+   */
+  template < class Record, class Table = detail::DTable<Record> >
+  class PlanarFieldLookup : public FieldLookupBase<Record,Table> {
+  public:
+    typedef FieldLookupBase<Record,Table> super;
+
+    /** Default constructor.
+     * Does not initialize the lookup table.
+     */
+    PlanarFieldLookup() : super(), axis(Z), rotated(false) {
+      defaultR();
+    }
+
+    /** Read the tables from a file with the given invariant axis (@see
+     * setInvariantAxis). */
+    PlanarFieldLookup(const std::string & filename,
+                      const unsigned int & a = Z)
+      : super(filename), axis(Z), rotated(false) {
+      defaultR();
+      setInvariantAxis( a );
+    }
+
+    /** Read the tables (@see FieldLookupBase::readindata).  The tables must
+     * have a single point along the invariant axis, so set the axis first.
+     */
+    void readindata(const std::string & filename = "") {
+      super::readindata( filename );
+      checkPlanar();
+    }
+
+    /** @see FieldLookupBase::readindata. */
+    void readindata( const std::string & filename,
+                     const Vector<double,3> & roi_min,
+                     const Vector<double,3> & roi_max,
+                     const Vector<int,3> & stride = Vector<int,3>(1) ) {
+      super::readindata( filename, roi_min, roi_max, stride );
+      checkPlanar();
+    }
+
+    /** @see FieldLookupBase::readindata. */
+    void readindata( std::istream & infile ) {
+      super::readindata( infile );
+      checkPlanar();
+    }
+
+    /** @see FieldLookupBase::readindata. */
+    void readindata( std::istream & infile,
+                     const Vector<double,3> & roi_min,
+                     const Vector<double,3> & roi_max,
+                     const Vector<int,3> & stride = Vector<int,3>(1) ) {
+      super::readindata( infile, roi_min, roi_max, stride );
+      checkPlanar();
+    }
+
+    /** The invariant axis (in the table frame). */
+    const unsigned int & invariantAxis() const { return axis; }
+
+    /** Set the invariant axis (in the table frame, default Z).  The tables
+     * must have a single point along the axis (which is checked if they are
+     * already loaded). */
+    void setInvariantAxis( const unsigned int & a ) {
+      if ( a > Z )
+        THROW(std::runtime_error,"PlanarFieldLookup:  invalid invariant axis");
+      const unsigned int old = axis;
+      axis = a;
+      if ( super::isInitialized() ) {
+        try {
+          checkPlanar();
+        } catch (...) {
+          axis = old;
+          throw;
+        }
+      }
+      if ( rotated )
+        rotateField( k );
+    }
+
+    /** Rotate the field such that the invariant axis is along k (a unit
+     * vector). */
+    void rotateField( const Vector<double,3> & k ) {
+      this->k = k;
+      const SquareMatrix<double,3> Rz = detail::rotationInto(k);
+      /* cyclic permutation that takes z onto the invariant axis. */
+      for ( unsigned int d = 0u; d < 3u; ++d )
+        for ( unsigned int j = 0u; j < 3u; ++j )
+          R[(axis + 1u + d) % 3u][j] = Rz[d][j];
+      for ( unsigned int i = 0u; i < 3u; ++i )
+        for ( unsigned int j = 0u; j < 3u; ++j )
+          Rt[j][i] = R[i][j];
+      rotated = true;
+    }
+
+    /** Rotation matrix INTO the table frame. */
+    const SquareMatrix<double,3> & rotation() const { return R; }
+
+    /** Provide acceleration data from a file source.
+     * The following employs a 2D lever rule in the transverse plane.
+     */
+    inline void vector_lookup( Vector<double,3> & retval,
+                               const Vector<double,3> & r,
+                               const unsigned int & i ) const {
+      register unsigned int table, ui, vi;
+      register double uf, vf, uF, vF;
+      getindx(table, ui, uf, vi, vf, r);
+      uF = 1.0 - uf;
+      vF = 1.0 - vf;
+
+      retval.zero();
+      retval.addFraction(uF*vF, record(table, ui  , vi  ).vector(i));
+      retval.addFraction(uf*vF, record(table, ui+1, vi  ).vector(i));
+      retval.addFraction(uF*vf, record(table, ui  , vi+1).vector(i));
+      retval.addFraction(uf*vf, record(table, ui+1, vi+1).vector(i));
+
+      if ( rotated )
+        retval = Rt * retval;
+    }
+
+    /** Provide potential data from a file source.
+     * The following employs a 2D lever rule in the transverse plane.
+     */
+    inline double scalar_lookup( const Vector<double,3> & r,
+                                 const unsigned int & i ) const {
+      register unsigned int table, ui, vi;
+      register double uf, vf, uF, vF;
+      getindx(table, ui, uf, vi, vf, r);
+      uF = 1.0 - uf;
+      vF = 1.0 - vf;
+
+      return uF*vF * record(table, ui  , vi  ).scalar(i)
+           + uf*vF * record(table, ui+1, vi  ).scalar(i)
+           + uF*vf * record(table, ui  , vi+1).scalar(i)
+           + uf*vf * record(table, ui+1, vi+1).scalar(i);
+    }
+
+    /** Position of r in the table frame. */
+    inline Vector<double,3> tableCoords( const Vector<double,3> & r ) const {
+      if ( !rotated )
+        return r;
+      return super::r0 + R * (r - super::r0);
+    }
+
+    /** Determine which table a position is looked up in. */
+    inline unsigned int whichTable( const Vector<double,3> & r ) const {
+      return whichTableFrame( tableCoords(r) );
+    }
+
+    /** Whether r is inside of the lookup tables (in the transverse plane).
+     * @see FieldLookup::inDomain.
+     */
+    inline bool inDomain( const Vector<double,3> & r ) const {
+      const Vector<double,3> rt = tableCoords(r);
+      const unsigned int u = (axis + 1u) % 3u, v = (axis + 2u) % 3u;
+      const bool shell = whichTableFrame(rt) == super::SHELL;
+      const Vector<double,3> & min =
+        shell ? super::shell_min : super::core_min;
+      const Vector<double,3> & dx_inv =
+        shell ? super::shell_dx_inv : super::core_dx_inv;
+      const Vector<int,3> & N = shell ? super::shell_N : super::core_N;
+
+      const double uf = (rt[u] - min[u]) * dx_inv[u];
+      const double vf = (rt[v] - min[v]) * dx_inv[v];
+      return uf >= 0.0 && uf <= N[u] - 1 &&
+             vf >= 0.0 && vf <= N[v] - 1;
+    }
+
+  private:
+    /** Make sure that the tables have a single point along the invariant
+     * axis (the lookups only use the first). */
+    void checkPlanar() const {
+      if ( super::core_N[axis] != 1 || super::shell_N[axis] != 1 )
+        THROW(std::runtime_error,"PlanarFieldLookup:  the tables must have a "
+                                 "single point along the invariant axis");
+    }
+
+    inline void defaultR() {
+      R = Rt = SquareMatrix<double,3U>::identity();
+      k = V3(0,0,1);
+    }
+
+    /** Determine which table a position in the table frame is looked up
+     * in (the invariant axis is ignored). */
+    inline unsigned int whichTableFrame( const Vector<double,3> & rt ) const {
+      #ifndef DISABLE_SHELL_LOOKUP
+        const unsigned int u = (axis + 1u) % 3u, v = (axis + 2u) % 3u;
+        if ( fabs(rt[u] - super::r0[u]) > super::core_L_2[u] ||
+             fabs(rt[v] - super::r0[v]) > super::core_L_2[v]    )
+          return super::SHELL;
+      #endif
+      return super::CORE;
+    }
+
+    /** Record of the transverse grid point (ui,vi). */
+    inline typename super::DTable::const_reference
+    record( const unsigned int & table,
+            const unsigned int & ui,
+            const unsigned int & vi ) const {
+      unsigned int n[3];
+      n[axis] = 0u;
+      n[(axis + 1u) % 3u] = ui;
+      n[(axis + 2u) % 3u] = vi;
+      return super::data[table](n[X], n[Y], n[Z]);
+    }
+
+    /** Compute the table, the transverse cell, and the fractional position
+     * within the cell of r (clamped to the table).  The two transverse axes
+     * follow the invariant axis cyclically. */
+    inline void getindx ( unsigned int & table,
+                          unsigned int & ui,
+                          double       & uf,
+                          unsigned int & vi,
+                          double       & vf,
+                          const Vector<double,3> & r) const {
+      const Vector<double,3> rt = tableCoords(r);
+      const unsigned int u = (axis + 1u) % 3u, v = (axis + 2u) % 3u;
+      table = whichTableFrame(rt);
+
+      const Vector<double,3> & min =
+        table == super::CORE ? super::core_min : super::shell_min;
+      const Vector<double,3> & dx_inv =
+        table == super::CORE ? super::core_dx_inv : super::shell_dx_inv;
+      const Vector<int,3> & N =
+        table == super::CORE ? super::core_N : super::shell_N;
+
+      uf = ( (rt[u] - min[u]) * dx_inv[u] );
+      vf = ( (rt[v] - min[v]) * dx_inv[v] );
+      #ifdef FIELDS_LOOKUP_STATS
+        Vector<double,3> f = V3(0,0,0);
+        f[u] = uf;
+        f[v] = vf;
+        super::counters.record( table, f, N );
+      #endif
+      uf = std::max(0.0,std::min((double)(N[u])-1.001,uf));
+      vf = std::max(0.0,std::min((double)(N[v])-1.001,vf));
+      ui = (int) uf; uf -= ui;
+      vi = (int) vf; vf -= vi;
+    }
+
+    /** The invariant axis in the table frame. */
+    unsigned int axis;
+
+    /** Whether the table frame is rotated. */
+    bool rotated;
+
+    /** Direction of the invariant axis given to rotateField. */
+    Vector<double,3> k;
+
+    /** Rotation matrix INTO the table frame and its inverse. */
+    SquareMatrix<double,3> R, Rt;
+  };
+
+}/* namespace fields */
+
+#endif // fields_PlanarFieldLookup_h
@@ -0,0 +1,410 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+/** \file
+ * Load a force lookup table in the background, CORE first.
+ *
+ * Reading a large table file can take minutes.  Particles that start near
+ * the trap center only need the CORE table, so ProgressiveForce reads the
+ * CORE table first, makes it available, and then streams in the SHELL table
+ * on a background thread.  Until the table that covers a position has been
+ * loaded, lookups use the fallback:  they either block until the table
+ * arrives (BlockUntilLoaded, the default) or evaluate a provided direct
+ * force source.
+ *
+ * Example:
+ * <code>
+ *   typedef fields::ProgressiveForce<
+ *     fields::ForceLookup<>,
+ *     fields::BField::BCalcs< fields::BField::ThinWireSrc >
+ *   > Force;
+ *   Force force;
+ *   force.currents.push_back( ... );
+ *   const fields::TableLoad & load = force.readindataAsync( "field.dat" );
+ *   load.waitCore();  // optional:  lookups wait for the CORE themselves
+ *   ...               // start the simulation
+ *   load.wait();      // throws if the load failed
+ * </code>
+ */
+
+#ifndef fields_ProgressiveForce_h
+#define fields_ProgressiveForce_h
+
+#include <xylose/Vector.h>
+#include <xylose/except.h>
+
+#include <boost/atomic.hpp>
+
+#include <pthread.h>
+
+#include <string>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace fields {
+
+  using xylose::Vector;
+  using xylose::V3;
+
+  template < typename TableForce, typename Fallback >
+  class ProgressiveForce;
+
+  /** Fallback of ProgressiveForce:  lookups in a table that has not been
+   * loaded yet wait until it is. */
+  struct BlockUntilLoaded { };
+
+  /** Progress of an asynchronous table load (@see ProgressiveForce).
+   * This serves as the future of the load. */
+  class TableLoad {
+  public:
+    /** Stages of a load. */
+    enum Stage {
+      /** Reading the header and the CORE table. */
+      PENDING = 0,
+      /** The CORE table is available;  reading the SHELL table. */
+      CORE_LOADED = 1,
+      /** Both tables are available (or no load was started). */
+      LOADED = 2,
+      /** The load failed (@see error). */
+      FAILED = 3
+    };
+
+    TableLoad() : stage_(LOADED) {
+      pthread_mutex_init( &mutex, NULL );
+      pthread_cond_init( &cond, NULL );
+    }
+
+    ~TableLoad() {
+      pthread_cond_destroy( &cond );
+      pthread_mutex_destroy( &mutex );
+    }
+
+    /** The current stage. */
+    inline Stage stage() const {
+      return Stage( stage_.load(boost::memory_order_acquire) );
+    }
+
+    /** Whether the CORE table is available. */
+    inline bool coreReady() const {
+      const Stage s = stage();
+      return s == CORE_LOADED || s == LOADED;
+    }
+
+    /** Whether both tables are available. */
+    inline bool ready() const { return stage() == LOADED; }
+
+    /** Whether the load failed. */
+    inline bool failed() const { return stage() == FAILED; }
+
+    /** The error of a failed load. */
+    const std::string & error() const { return message; }
+
+    /** Wait until the CORE table is available.
+     * @throws std::runtime_error if the load failed. */
+    void waitCore() const { waitFor( CORE_LOADED ); }
+
+    /** Wait until both tables are available.
+     * @throws std::runtime_error if the load failed. */
+    void wait() const { waitFor( LOADED ); }
+
+  private:
+    template < typename, typename > friend class ProgressiveForce;
+
+    boost::atomic<int> stage_;
+    std::string message;
+    mutable pthread_mutex_t mutex;
+    mutable pthread_cond_t cond;
+
+    void set( const Stage & s, const std::string & msg = "" ) {
+      pthread_mutex_lock( &mutex );
+      message = msg;
+      stage_.store( s, boost::memory_order_release );
+      pthread_cond_broadcast( &cond );
+      pthread_mutex_unlock( &mutex );
+    }
+
+    void waitFor( const Stage & s ) const {
+      Stage now = stage();
+      if ( now < s ) {
+        pthread_mutex_lock( &mutex );
+        while ( (now = stage()) < s )
+          pthread_cond_wait( &cond, &mutex );
+        pthread_mutex_unlock( &mutex );
+      }
+      if ( now == FAILED )
+        THROW(std::runtime_error,"ProgressiveForce:  " + message);
+    }
+
+    /* not copyable. */
+    TableLoad( const TableLoad & );
+    const TableLoad & operator=( const TableLoad & );
+  };
+
+  /** Force lookup table that can be loaded in the background (@see
+   * readindataAsync).
+   *
+   * @param TableForce
+   *     The force lookup table (e.g. ForceLookup<> or
+   *     ForceLookup< 3, AxiSymFieldLookup<...> >).
+   * @param Fallback
+   *     What lookups do in a table that has not been loaded yet.  Either
+   *     BlockUntilLoaded [Default] or a force (e.g. the exact force that was
+   *     tabulated) that is evaluated instead.  The forces must of course use
+   *     the same units.
+   */
+  template < typename TableForce, typename Fallback = BlockUntilLoaded >
+  class ProgressiveForce : public TableForce, public Fallback {
+    /* TYPEDEFS */
+  public:
+    typedef TableForce T;
+    typedef Fallback F;
+
+
+    /* MEMBER STORAGE */
+  private:
+    TableLoad load;
+    std::ifstream * file;
+    typename T::FileLayout layout;
+    bool running;
+    pthread_t thread;
+
+
+    /* MEMBER FUNCTIONS */
+  public:
+    ProgressiveForce() : T(), F(), file(NULL), running(false) { }
+
+    ~ProgressiveForce() {
+      join();
+    }
+
+    /** Start loading the tables from a file in the background.  The header
+     * of the file is read and the tables are allocated on the background
+     * thread as well, so this returns immediately.  A previous load is
+     * waited for first.  The lookup must not be re-read (with readindata)
+     * while a load is in progress.
+     * @param filename
+     *     The table file (text or binary).
+     * @param roi_min
+     *     Lower corner of the region of interest [Default:  everything].
+     * @param roi_max
+     *     Upper corner of the region of interest [Default:  everything].
+     * @param stride
+     *     Decimation stride [Default:  1].
+     * @see FieldLookupBase::readindata.
+     * @return The progress of the load.
+     */
+    const TableLoad & readindataAsync(
+      const std::string & filename,
+      const Vector<double,3> & roi_min =
+        Vector<double,3>( -std::numeric_limits<double>::max() ),
+      const Vector<double,3> & roi_max =
+        Vector<double,3>(  std::numeric_limits<double>::max() ),
+      const Vector<int,3> & stride = Vector<int,3>(1) ) {
+      join();
+
+      file = new std::ifstream( filename.c_str(),
+                                std::ios::in | std::ios::binary );
+      if ( !file->good() ) {
+        delete file;
+        file = NULL;
+        THROW(std::runtime_error,"ProgressiveForce:  invalid filename.");
+      }
+
+      this->roi_min = roi_min;
+      this->roi_max = roi_max;
+      this->stride = stride;
+      load.set( TableLoad::PENDING );
+      if ( pthread_create( &thread, NULL, &ProgressiveForce::run, this ) ) {
+        load.set( TableLoad::FAILED, "could not start thread" );
+        cleanupFile();
+        THROW(std::runtime_error,"ProgressiveForce:  could not start thread");
+      }
+      running = true;
+      return load;
+    }
+
+    /** The progress of the last load. */
+    const TableLoad & loadStatus() const { return load; }
+
+    /** Whether r is looked up in the table (rather than the fallback).
+     * With BlockUntilLoaded, this waits for the table that covers r.
+     * @throws std::runtime_error if the load failed. */
+    inline bool useTable( const Vector<double,3> & r ) const {
+      if ( load.ready() )
+        return true;
+      return available( r, static_cast<const F*>(this) );
+    }
+
+    /** Calculate acceleration. */
+    inline void accel(       Vector<double,3> & a,
+                       const Vector<double,3> & r,
+                       const Vector<double,3> & v = V3(0.,0.,0.),
+                       const double & t = 0.0,
+                       const double & dt = 0.0,
+                       const unsigned int & species = 0u ) const {
+      if ( useTable(r) )
+        T::accel(a,r,v,t,dt,species);
+      else
+        fallbackAccel(a,r,v,t,dt,species, static_cast<const F*>(this));
+    }
+
+    template < typename P >
+    inline void accel(       Vector<double,3> & a,
+                       const Vector<double,3> & r,
+                       const Vector<double,3> & v,
+                       const double & t,
+                       const double & dt,
+                             P & p ) const {
+      if ( useTable(r) )
+        T::accel(a,r,v,t,dt,p);
+      else
+        fallbackAccel(a,r,v,t,dt,p, static_cast<const F*>(this));
+    }
+
+    inline double potential( const Vector<double,3> & r,
+                             const Vector<double,3> & v = V3(0.,0.,0.),
+                             const double & t = 0.0,
+                             const unsigned int & species = 0u ) const {
+      if ( useTable(r) )
+        return T::potential(r,v,t,species);
+      else
+        return fallbackPotential(r,v,t,species, static_cast<const F*>(this));
+    }
+
+    template < typename P >
+    inline double potential( const Vector<double,3> & r,
+                             const Vector<double,3> & v,
+                             const double & t,
+                                   P & p ) const {
+      if ( useTable(r) )
+        return T::potential(r,v,t,p);
+      else
+        return fallbackPotential(r,v,t,p, static_cast<const F*>(this));
+    }
+
+  private:
+    Vector<double,3> roi_min, roi_max;
+    Vector<int,3> stride;
+
+    /** Wait for the table that covers r. */
+    inline bool available( const Vector<double,3> & r,
+                           const BlockUntilLoaded * ) const {
+      load.waitCore();
+      if ( T::whichTable(r) != T::CORE )
+        load.wait();
+      return true;
+    }
+
+    /** Whether the table that covers r is loaded. */
+    template < typename Force >
+    inline bool available( const Vector<double,3> & r, const Force * ) const {
+      if ( load.failed() )
+        load.wait(); /* throws */
+      return load.coreReady() && T::whichTable(r) == T::CORE;
+    }
+
+    template < typename S >
+    static inline void fallbackAccel( Vector<double,3> &,
+                                      const Vector<double,3> &,
+                                      const Vector<double,3> &,
+                                      const double &, const double &,
+                                      S &, const BlockUntilLoaded * ) { }
+
+    template < typename S, typename Force >
+    static inline void fallbackAccel(       Vector<double,3> & a,
+                                      const Vector<double,3> & r,
+                                      const Vector<double,3> & v,
+                                      const double & t,
+                                      const double & dt,
+                                            S & s,
+                                      const Force * f ) {
+      f->Force::accel(a,r,v,t,dt,s);
+    }
+
+    template < typename S >
+    static inline double fallbackPotential( const Vector<double,3> &,
+                                            const Vector<double,3> &,
+                                            const double &,
+                                            S &, const BlockUntilLoaded * ) {
+      return 0.0;
+    }
+
+    template < typename S, typename Force >
+    static inline double fallbackPotential( const Vector<double,3> & r,
+                                            const Vector<double,3> & v,
+                                            const double & t,
+                                                  S & s,
+                                            const Force * f ) {
+      return f->Force::potential(r,v,t,s);
+    }
+
+    /** Body of the background thread. */
+    static void * run( void * arg ) {
+      ProgressiveForce & self = *static_cast<ProgressiveForce*>(arg);
+      try {
+        self.T::readHeader( *self.file, self.roi_min, self.roi_max,
+                            self.stride, self.layout );
+        self.T::readSection( *self.file, T::CORE, self.layout );
+        self.load.set( TableLoad::CORE_LOADED );
+        #ifndef DISABLE_SHELL_LOOKUP
+          self.T::readSection( *self.file, T::SHELL, self.layout );
+        #endif
+        self.cleanupFile();
+        self.load.set( TableLoad::LOADED );
+      } catch ( std::exception & e ) {
+        self.cleanupFile();
+        self.load.set( TableLoad::FAILED, e.what() );
+      }
+      return NULL;
+    }
+
+    void cleanupFile() {
+      delete file;
+      file = NULL;
+    }
+
+    /** Wait for the background thread (if any) to finish. */
+    void join() {
+      if ( running ) {
+        pthread_join( thread, NULL );
+        running = false;
+      }
+    }
+
+    /* not copyable. */
+    ProgressiveForce( const ProgressiveForce & );
+    const ProgressiveForce & operator=( const ProgressiveForce & );
+  };
+
+}/* namespace fields */
+
+#endif // fields_ProgressiveForce_h
@@ -0,0 +1,213 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+/** \file
+ * Rigid-body transformations (optionally time dependent) of field lookups.
+ */
+
+#ifndef fields_RigidTransform_h
+#define fields_RigidTransform_h
+
+#include <xylose/Vector.h>
+#include <xylose/SquareMatrix.h>
+#include <xylose/timing/Timing.h>
+#include <xylose/timing/element/PowerLaw.h>
+
+#include <string>
+#include <limits>
+#include <cmath>
+
+namespace fields {
+
+  namespace timing = xylose::timing;
+  using xylose::SquareMatrix;
+  using xylose::Vector;
+  using xylose::V3;
+
+  /** Place a lookup table (e.g. FieldLookup) at an arbitrary pose, such that
+   * one precomputed table serves a coil assembly that is translated or
+   * rotated.  A point p of the table frame is placed at
+   *    pivot + timed(displacement) + Rot(axis, timed(angle)) (p - pivot)
+   * where the displacement and the angle are scaled by translation_timing
+   * and rotation_timing respectively (unity by default, as for ScaleField).
+   * Query points are mapped into the table frame, and vector results are
+   * rotated back.
+   *
+   * The pose is cached:  call set_time (or updatePose after changing the
+   * timings directly) to move the table.  Only the plain
+   * vector_lookup/scalar_lookup methods of the table are transformed (the
+   * others are hidden).
+   *
+   * Example:
+   * <code>
+   *   ForceLookup< 3u, RigidTransform< FieldLookup< ForceRecord<3u> > > > f;
+   * </code>
+   */
+  template < class T >
+  class RigidTransform : public T {
+    /* TYPEDEFS */
+  public:
+    typedef T super;
+
+    /* MEMBER STORAGE */
+    /** Timing of the displacement. */
+    timing::Timing translation_timing;
+
+    /** Timing of the rotation angle. */
+    timing::Timing rotation_timing;
+
+  private:
+    Vector<double,3> displacement, pivot, axis;
+    double angle;
+
+    /** Current rotation INTO the table frame and its inverse. */
+    SquareMatrix<double,3> R, Rinv;
+
+    /** Current offset:  pivot + timed(displacement). */
+    Vector<double,3> offset;
+
+    /** Whether the current pose is not the identity. */
+    bool moved;
+
+    /** Default timing element applys a unity scaling. */
+    static timing::element::PowerLaw * mkDefaultTiming() {
+      return new timing::element::PowerLaw(
+        -std::numeric_limits<double>::infinity(), 1.0, 1.0, 1.0
+      );
+    }
+
+    /* MEMBER FUNCTIONS */
+  public:
+    /** Default constructor.  The table is not moved. */
+    RigidTransform() : super() {
+      init();
+    }
+
+    RigidTransform(const std::string & filename) : super(filename) {
+      init();
+    }
+
+    /** Set the displacement of the table. */
+    void setTranslation( const Vector<double,3> & d ) {
+      displacement = d;
+      updatePose();
+    }
+
+    /** Set the rotation of the table by angle (radians) about the unit
+     * vector axis (through the pivot point). */
+    void setRotation( const Vector<double,3> & axis, const double & angle ) {
+      this->axis = axis;
+      this->angle = angle;
+      updatePose();
+    }
+
+    /** Set the pivot point of the rotation (in the table frame). */
+    void setPivot( const Vector<double,3> & p ) {
+      pivot = p;
+      updatePose();
+    }
+
+    /** Set the time of both timings and move the table accordingly. */
+    void set_time( const double & t ) {
+      translation_timing.set_time(t);
+      rotation_timing.set_time(t);
+      updatePose();
+    }
+
+    /** Recompute the pose from the current values of the timings. */
+    void updatePose() {
+      const double a = angle * rotation_timing.getVal();
+      const double c = std::cos(a), s = std::sin(a), C = 1.0 - c;
+      const Vector<double,3> & k = axis;
+
+      /* Rodrigues' formula for the rotation OUT OF the table frame. */
+      const double rot[3][3] =
+        {{ c + k[0]*k[0]*C,      k[0]*k[1]*C - k[2]*s, k[0]*k[2]*C + k[1]*s },
+         { k[1]*k[0]*C + k[2]*s, c + k[1]*k[1]*C,      k[1]*k[2]*C - k[0]*s },
+         { k[2]*k[0]*C - k[1]*s, k[2]*k[1]*C + k[0]*s, c + k[2]*k[2]*C      }};
+      for ( unsigned int i = 0u; i < 3u; ++i )
+        for ( unsigned int j = 0u; j < 3u; ++j ) {
+          Rinv[i][j] = rot[i][j];
+          R[j][i] = rot[i][j];
+        }
+
+      const Vector<double,3> d = displacement * translation_timing.getVal();
+      offset = pivot + d;
+      moved = a != 0.0 || d[0] != 0.0 || d[1] != 0.0 || d[2] != 0.0;
+    }
+
+    /** Position of r in the table frame. */
+    inline Vector<double,3> tableCoords( const Vector<double,3> & r ) const {
+      if ( !moved )
+        return r;
+      return pivot + R * (r - offset);
+    }
+
+    /** Look up a vector at r, rotated out of the table frame. */
+    inline void vector_lookup( Vector<double,3> & retval,
+                               const Vector<double,3> & r,
+                               const unsigned int & i ) const {
+      super::vector_lookup( retval, tableCoords(r), i );
+      if ( moved )
+        retval = Rinv * retval;
+    }
+
+    /** Look up a scalar at r. */
+    inline double scalar_lookup( const Vector<double,3> & r,
+                                 const unsigned int & i ) const {
+      return super::scalar_lookup( tableCoords(r), i );
+    }
+
+    /** Determine which table a position is looked up in. */
+    inline unsigned int whichTable( const Vector<double,3> & r ) const {
+      return super::whichTable( tableCoords(r) );
+    }
+
+    /** Whether r is inside of the lookup tables. */
+    inline bool inDomain( const Vector<double,3> & r ) const {
+      return super::inDomain( tableCoords(r) );
+    }
+
+  private:
+    void init() {
+      displacement = pivot = V3(0,0,0);
+      axis = V3(0,0,1);
+      angle = 0.0;
+      /* default to having no timing effect. */
+      translation_timing.timings.push_back( mkDefaultTiming() );
+      rotation_timing.timings.push_back( mkDefaultTiming() );
+      set_time(0.0);
+    }
+  };
+
+}/* namespace fields */
+
+#endif // fields_RigidTransform_h
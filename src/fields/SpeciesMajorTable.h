@@ -0,0 +1,345 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+/** \file
+ * Species-major (structure of arrays) storage for multi-species ForceRecord
+ * lookup tables.
+ */
+
+#ifndef fields_SpeciesMajorTable_h
+#define fields_SpeciesMajorTable_h
+
+#include <fields/force-lookup.h>
+#include <fields/table-allocation.h>
+#include <fields/detail/DTable.h>
+#include <fields/detail/table-io.h>
+
+#include <chimp/RuntimeDB.h>
+
+#include <xylose/Vector.h>
+#include <xylose/except.h>
+
+#include <vector>
+#include <istream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+
+namespace fields {
+
+  using xylose::Vector;
+
+  namespace detail {
+
+    /** The accelerations of S species at one grid point. */
+    template < unsigned int L, unsigned int S >
+    struct VectorChannel {
+      Vector<double,L> a[S];
+    };
+
+    /** The potentials of S species at one grid point. */
+    template < unsigned int S >
+    struct ScalarChannel {
+      double V[S];
+    };
+
+  }/* namespace fields::detail */
+
+  /** Storage for a table of ForceRecord<L,N> elements where each species and
+   * each of the acceleration and potential live in separate, contiguous
+   * planes.
+   *
+   * ForceRecord<L,N> interleaves the data of all N species such that a lookup
+   * for one species pulls the data of all species through the cache.  With
+   * this storage, a lookup for one species touches only the planes of that
+   * species (and scalar lookups touch only the potential plane).  In
+   * addition, only a selected set of species need be loaded at all
+   * (@see selectSpecies).  Each plane is a detail::DTable and so honors the
+   * allocation options (@see setAllocation).  The file formats are
+   * unchanged.
+   *
+   * With split_species=false, only the accelerations (vector channel) and
+   * the potentials (scalar channel) are separated, and each keeps the data
+   * of all species together.  A potential-only lookup (e.g. for energy
+   * diagnostics or for initializing a distribution) then still reads only
+   * the potentials.  (For N=1, both modes are the same.)  Species are then
+   * loaded all or none.
+   *
+   * Use this as the Table parameter of FieldLookup or AxiSymFieldLookup:
+   * <code>
+   *   typedef ForceRecord<3,4> Record;
+   *   typedef ForceLookup< 3, FieldLookup< Record, SpeciesMajorTable<3,4> > >
+   *     Lookup;
+   *   Lookup lookup;
+   *   selectSpecies( lookup, db ); // optional
+   *   lookup.readindata( filename );
+   * </code>
+   *
+   * Looking up a species that was not loaded throws a std::runtime_error.
+   */
+  template < unsigned int L, unsigned int N, bool split_species = true >
+  class SpeciesMajorTable {
+    /* TYPEDEFS */
+  public:
+    typedef ForceRecord<L,N> Record;
+    typedef Record value_type;
+
+    /** Number of species in each plane. */
+    static const unsigned int SPECIES_PER_PLANE = split_species ? 1u : N;
+    /** Number of planes of each channel. */
+    static const unsigned int PLANES = split_species ? N : 1u;
+
+    typedef detail::VectorChannel<L,SPECIES_PER_PLANE> VectorRecord;
+    typedef detail::ScalarChannel<SPECIES_PER_PLANE> ScalarRecord;
+
+    /** Read-only reference to the species data at a single grid point. */
+    class const_reference {
+    public:
+      const_reference( const SpeciesMajorTable & t,
+                       const unsigned int & xi,
+                       const unsigned int & yi,
+                       const unsigned int & zi )
+        : t(t), xi(xi), yi(yi), zi(zi) { }
+
+      /** For using the FieldLookup::vector_lookup routine. */
+      inline const Vector<double,L> & vector(const unsigned int & i) const {
+        const unsigned int p = i / SPECIES_PER_PLANE;
+        if ( !t.loaded[p] )
+          notLoaded(i);
+        return t.a[p](xi,yi,zi).a[i % SPECIES_PER_PLANE];
+      }
+
+      /** For using the FieldLookup::scalar_lookup routine. */
+      inline const double & scalar(const unsigned int & i) const {
+        const unsigned int p = i / SPECIES_PER_PLANE;
+        if ( !t.loaded[p] )
+          notLoaded(i);
+        return t.V[p](xi,yi,zi).V[i % SPECIES_PER_PLANE];
+      }
+
+    private:
+      const SpeciesMajorTable & t;
+      const unsigned int xi, yi, zi;
+    };
+
+    /** Reference to the species data at a single grid point. */
+    class reference {
+    public:
+      reference( SpeciesMajorTable & t,
+                 const unsigned int & xi,
+                 const unsigned int & yi,
+                 const unsigned int & zi )
+        : t(t), xi(xi), yi(yi), zi(zi) { }
+
+      inline Vector<double,L> & vector(const unsigned int & i) const {
+        const unsigned int p = i / SPECIES_PER_PLANE;
+        if ( !t.loaded[p] )
+          notLoaded(i);
+        return t.a[p](xi,yi,zi).a[i % SPECIES_PER_PLANE];
+      }
+
+      inline double & scalar(const unsigned int & i) const {
+        const unsigned int p = i / SPECIES_PER_PLANE;
+        if ( !t.loaded[p] )
+          notLoaded(i);
+        return t.V[p](xi,yi,zi).V[i % SPECIES_PER_PLANE];
+      }
+
+      /** Store the loaded species of a complete record. */
+      const reference & operator=( const Record & rec ) const {
+        for ( unsigned int i = 0u; i < N; ++i ) {
+          const unsigned int p = i / SPECIES_PER_PLANE;
+          if ( t.loaded[p] ) {
+            t.a[p](xi,yi,zi).a[i % SPECIES_PER_PLANE] = rec.vector(i);
+            t.V[p](xi,yi,zi).V[i % SPECIES_PER_PLANE] = rec.scalar(i);
+          }
+        }
+        return *this;
+      }
+
+    private:
+      SpeciesMajorTable & t;
+      const unsigned int xi, yi, zi;
+    };
+
+
+    /* MEMBER STORAGE */
+  private:
+    /** Acceleration planes. */
+    detail::DTable<VectorRecord> a[PLANES];
+    /** Potential planes. */
+    detail::DTable<ScalarRecord> V[PLANES];
+    /** Which species are to be loaded. */
+    bool selected[N];
+    /** Which planes are allocated/loaded. */
+    bool loaded[PLANES];
+
+  public:
+    unsigned int xlen, ylen, zlen, xlen_times_ylen;
+
+
+    /* MEMBER FUNCTIONS */
+  public:
+    SpeciesMajorTable() : xlen(0), ylen(0), zlen(0), xlen_times_ylen(0) {
+      std::fill( selected, selected+N, true );
+      std::fill( loaded, loaded+PLANES, false );
+    }
+
+    /** Select which species will be allocated and loaded by subsequent calls
+     * to initialize/readindata.  By default, all species are selected.  With
+     * split_species=false, all species are loaded if any one is selected.
+     * @param mask
+     *     mask[i] is true if species i is to be loaded.  Species beyond the
+     *     end of mask are not loaded.
+     */
+    void selectSpecies( const std::vector<bool> & mask ) {
+      for ( unsigned int i = 0u; i < N; ++i )
+        selected[i] = i < mask.size() && mask[i];
+    }
+
+    /** Whether species i is selected (for loading). */
+    bool isSelected( const unsigned int & i ) const { return selected[i]; }
+
+    /** Set the allocation options of all planes (before calling
+     * initialize). */
+    inline void setAllocation( const TableAllocation & alloc ) {
+      for ( unsigned int p = 0u; p < PLANES; ++p ) {
+        a[p].setAllocation(alloc);
+        V[p].setAllocation(alloc);
+      }
+    }
+
+    /** The allocation options. */
+    inline const TableAllocation & getAllocation() const {
+      return a[0].getAllocation();
+    }
+
+    inline void initialize ( const unsigned int & Nx,
+                             const unsigned int & Ny,
+                             const unsigned int & Nz ) {
+      cleanup();
+
+      for ( unsigned int i = 0u; i < N; ++i )
+        loaded[i / SPECIES_PER_PLANE] |= selected[i];
+
+      for ( unsigned int p = 0u; p < PLANES; ++p )
+        if ( loaded[p] ) {
+          a[p].initialize(Nx, Ny, Nz);
+          V[p].initialize(Nx, Ny, Nz);
+        }
+
+      xlen = Nx;
+      ylen = Ny;
+      zlen = Nz;
+      xlen_times_ylen = Nx*Ny;
+    }
+
+    inline void cleanup () {
+      for ( unsigned int p = 0u; p < PLANES; ++p ) {
+        a[p].cleanup();
+        V[p].cleanup();
+        loaded[p] = false;
+      }
+
+      xlen = ylen = zlen = xlen_times_ylen = 0;
+    }
+
+    /** Copy the loaded planes to their NUMA replicas (@see
+     * detail::DTable::sync). */
+    inline void sync() {
+      for ( unsigned int p = 0u; p < PLANES; ++p ) {
+        a[p].sync();
+        V[p].sync();
+      }
+    }
+
+    /** Read the records of the table, keeping only the loaded species. */
+    inline std::istream & readindata(std::istream & in) {
+      detail::readTextTable( *this, in );
+      sync();
+      return in;
+    }
+
+    inline const_reference operator()( const unsigned int & xi,
+                                       const unsigned int & yi,
+                                       const unsigned int & zi ) const {
+      return const_reference( *this, xi, yi, zi );
+    }
+
+    inline reference operator()( const unsigned int & xi,
+                                 const unsigned int & yi,
+                                 const unsigned int & zi ) {
+      return reference( *this, xi, yi, zi );
+    }
+
+  private:
+    /** Report a lookup of a species that is not loaded. */
+    static void notLoaded( const unsigned int & i ) {
+      std::ostringstream msg;
+      msg << "SpeciesMajorTable:  species " << i << " is not loaded";
+      THROW(std::runtime_error, msg.str());
+    }
+
+    /* not copyable. */
+    SpeciesMajorTable( const SpeciesMajorTable & );
+    const SpeciesMajorTable & operator=( const SpeciesMajorTable & );
+  };
+
+  template < unsigned int L, unsigned int N, bool split_species >
+  const unsigned int SpeciesMajorTable<L,N,split_species>::SPECIES_PER_PLANE;
+
+  template < unsigned int L, unsigned int N, bool split_species >
+  const unsigned int SpeciesMajorTable<L,N,split_species>::PLANES;
+
+  /** Select which species are loaded into both tables of a FieldLookup (or
+   * AxiSymFieldLookup) that uses SpeciesMajorTable storage.  This must be
+   * called before reading in the table data.
+   * @see SpeciesMajorTable::selectSpecies.
+   */
+  template < typename Lookup >
+  void selectSpecies( Lookup & lookup, const std::vector<bool> & mask ) {
+    lookup.table(Lookup::CORE).selectSpecies(mask);
+    lookup.table(Lookup::SHELL).selectSpecies(mask);
+  }
+
+  /** Load only the species that a run declares in its ChimpDB.  Species i of
+   * the table is taken to be species i of db, so the table species beyond
+   * the number of species in db are not loaded.
+   */
+  template < typename Lookup, typename options >
+  void selectSpecies( Lookup & lookup, const chimp::RuntimeDB<options> & db ) {
+    std::vector<bool> mask( db.getProps().size(), true );
+    selectSpecies( lookup, mask );
+  }
+
+}/* namespace fields */
+
+#endif // fields_SpeciesMajorTable_h
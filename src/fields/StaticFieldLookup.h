@@ -0,0 +1,337 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+
+/** \file
+ * Field lookup with a table whose dimensions are fixed at compile time.
+ */
+
+#ifndef fields_StaticFieldLookup_h
+#define fields_StaticFieldLookup_h
+
+#include <fields/field-lookup.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+#include <xylose/except.h>
+#include <xylose/strutil.h>
+
+#include <boost/static_assert.hpp>
+
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+namespace fields {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace indices;
+
+  namespace detail {
+
+    /** Three dimensional table of records with compile-time dimensions that
+     * is stored within the object.  The records are stored in the order of
+     * DTable (y varying fastest, then x, then z). */
+    template < class Record,
+               unsigned int Nx, unsigned int Ny, unsigned int Nz >
+    struct StaticTable {
+      typedef Record value_type;
+      typedef Record & reference;
+      typedef const Record & const_reference;
+
+      static const unsigned int xlen = Nx;
+      static const unsigned int ylen = Ny;
+      static const unsigned int zlen = Nz;
+      static const unsigned int xlen_times_ylen = Nx * Ny;
+
+      inline const_reference operator()( const unsigned int & xi,
+                                         const unsigned int & yi,
+                                         const unsigned int & zi ) const {
+        return data[zi*xlen_times_ylen + xi*ylen + yi];
+      }
+
+      inline reference operator()( const unsigned int & xi,
+                                   const unsigned int & yi,
+                                   const unsigned int & zi ) {
+        return data[zi*xlen_times_ylen + xi*ylen + yi];
+      }
+
+      Record data[Nx * Ny * Nz];
+    };
+
+    template < class Record,
+               unsigned int Nx, unsigned int Ny, unsigned int Nz >
+    const unsigned int StaticTable<Record,Nx,Ny,Nz>::xlen;
+
+    template < class Record,
+               unsigned int Nx, unsigned int Ny, unsigned int Nz >
+    const unsigned int StaticTable<Record,Nx,Ny,Nz>::ylen;
+
+    template < class Record,
+               unsigned int Nx, unsigned int Ny, unsigned int Nz >
+    const unsigned int StaticTable<Record,Nx,Ny,Nz>::zlen;
+
+    template < class Record,
+               unsigned int Nx, unsigned int Ny, unsigned int Nz >
+    const unsigned int StaticTable<Record,Nx,Ny,Nz>::xlen_times_ylen;
+
+  }/* namespace fields::detail */
+
+  /** Lookup of a single small table whose dimensions are template
+   * parameters.
+   *
+   * The table is stored within the object (no pointer to follow) and all of
+   * the index arithmetic involves compile-time constants, so that (for
+   * example with power-of-two dimensions) it reduces to shifts.  The
+   * interpolation and the clamping at the table edges are those of
+   * FieldLookup (without a SHELL table).  This is meant for small, heavily
+   * used tables, such as one covering the center of a trap;  since the
+   * table is part of the object, large instances should be allocated
+   * dynamically (or statically) rather than on the stack.
+   *
+   * The table can be filled from a source, copied from a table of
+   * FieldLookup with the same dimensions, or read (via FieldLookup) from a
+   * region of interest of a field file:
+   * <code>
+   *   typedef ForceLookup< 3, StaticFieldLookup< ForceRecord<3>, 32, 32, 32 > >
+   *     CenterLookup;
+   *   CenterLookup * center = new CenterLookup;
+   *   center->readindata( "field.dat", roi_min, roi_max );
+   * </code>
+   *
+   * @param Record
+   *     Type of the table records (with vector(i) and scalar(i)).
+   * @param Nx, Ny, Nz
+   *     Number of grid points along each axis (at least 2 each).
+   */
+  template < class Record,
+             unsigned int Nx, unsigned int Ny, unsigned int Nz >
+  class StaticFieldLookup {
+    /* interpolation needs two grid points along each axis. */
+    BOOST_STATIC_ASSERT( Nx >= 2u && Ny >= 2u && Nz >= 2u );
+
+    /* TYPEDEFS */
+  public:
+    typedef Record record_type;
+    typedef detail::StaticTable<Record,Nx,Ny,Nz> table_type;
+
+
+    /* MEMBER FUNCTIONS */
+  public:
+    /** Default constructor.  Does not initialize the table. */
+    StaticFieldLookup() : min(0.0), dx(1.0), dx_inv(1.0) { }
+
+    /** Dimensions of the table. */
+    static Vector<int,3> dimensions() {
+      Vector<int,3> N;
+      N[X] = Nx;
+      N[Y] = Ny;
+      N[Z] = Nz;
+      return N;
+    }
+
+    /** Set the position of the first grid point and the grid spacing. */
+    void setGeometry( const Vector<double,3> & _min,
+                      const Vector<double,3> & _dx ) {
+      min = _min;
+      dx = _dx;
+      dx_inv = 1.0; dx_inv.compDiv(dx);
+    }
+
+    /** Grid geometry of the table. */
+    TableGeometry geometry() const {
+      return TableGeometry( dimensions(), dx, min,
+                            min + compMult( (dimensions() - 1).to_type<double>(),
+                                            dx ) );
+    }
+
+    /** Access to the table. */
+    table_type & table() { return data; }
+
+    /** Access to the table. */
+    const table_type & table() const { return data; }
+
+    /** Fill the table from a source (with getRecord(r), as for
+     * createFieldFile). */
+    template < class Src >
+    void fill( const Src & src,
+               const Vector<double,3> & _min,
+               const Vector<double,3> & _dx ) {
+      setGeometry( _min, _dx );
+      #pragma omp parallel for
+      for ( int k = 0; k < int(Nz); ++k )
+        for ( unsigned int i = 0u; i < Nx; ++i )
+          for ( unsigned int j = 0u; j < Ny; ++j )
+            data(i,j,k) = src.getRecord(
+              min + compMult( V3( double(i), double(j), double(k) ), dx ) );
+    }
+
+    /** Copy one of the tables of a FieldLookup (of records of this type),
+     * which must have the dimensions of this table. */
+    template < class Lookup >
+    void load( const Lookup & lookup, const typename Lookup::DSECT & t ) {
+      const TableGeometry g = lookup.geometry(t);
+      if ( !( g.N == dimensions() ) )
+        THROW(std::runtime_error,
+              "StaticFieldLookup::load:  table dimensions (" +
+              xylose::to_string(g.N) + ") do not match (" +
+              xylose::to_string(dimensions()) + ')' );
+
+      setGeometry( g.min, g.dx );
+      const typename Lookup::table_type & src = lookup.table(t);
+      for ( unsigned int k = 0u; k < Nz; ++k )
+        for ( unsigned int i = 0u; i < Nx; ++i )
+          for ( unsigned int j = 0u; j < Ny; ++j )
+            data(i,j,k) = src(i,j,k);
+    }
+
+    /** Read the CORE table of a field file (@see FieldLookup::readindata).
+     * @see load.
+     */
+    void readindata( const std::string & filename ) {
+      FieldLookup<Record> lookup;
+      lookup.readindata( filename );
+      load( lookup, FieldLookup<Record>::CORE );
+    }
+
+    /** Read the CORE table of a region of interest of a field file (@see
+     * FieldLookup::readindata).  The region must cover Nx*Ny*Nz grid points
+     * of the CORE table.
+     * @see load.
+     */
+    void readindata( const std::string & filename,
+                     const Vector<double,3> & roi_min,
+                     const Vector<double,3> & roi_max,
+                     const Vector<int,3> & stride = Vector<int,3>(1) ) {
+      FieldLookup<Record> lookup;
+      lookup.readindata( filename, roi_min, roi_max, stride );
+      load( lookup, FieldLookup<Record>::CORE );
+    }
+
+    /** Whether r is inside of the table.  Lookups of positions outside of
+     * the table are clamped to the table edges. */
+    inline bool inDomain( const Vector<double,3> & r ) const {
+      const Vector<int,3> N = dimensions();
+      for ( unsigned int d = 0u; d < 3u; ++d ) {
+        const double f = (r[d] - min[d]) * dx_inv[d];
+        if ( f < 0.0 || f > N[d] - 1 )
+          return false;
+      }
+      return true;
+    }
+
+    /** Provide acceleration data (@see FieldLookup::vector_lookup). */
+    inline void vector_lookup( Vector<double,3> & retval,
+                               const Vector<double,3> & r,
+                               const unsigned int & i ) const {
+      register unsigned int xi, yi, zi;
+      register double xf, yf, zf, xF, yF, zF;
+      getindx(xi, xf, yi, yf, zi, zf, r);
+      xF = 1.0 - xf;
+      yF = 1.0 - yf;
+      zF = 1.0 - zf;
+
+      retval.zero();
+      retval.addFraction(xF*yF*zF, data(xi  ,yi  ,zi  ).vector(i));
+      retval.addFraction(xf*yF*zF, data(xi+1,yi  ,zi  ).vector(i));
+      retval.addFraction(xF*yf*zF, data(xi  ,yi+1,zi  ).vector(i));
+      retval.addFraction(xf*yf*zF, data(xi+1,yi+1,zi  ).vector(i));
+      retval.addFraction(xF*yF*zf, data(xi  ,yi  ,zi+1).vector(i));
+      retval.addFraction(xf*yF*zf, data(xi+1,yi  ,zi+1).vector(i));
+      retval.addFraction(xF*yf*zf, data(xi  ,yi+1,zi+1).vector(i));
+      retval.addFraction(xf*yf*zf, data(xi+1,yi+1,zi+1).vector(i));
+    }
+
+    /** Provide potential data (@see FieldLookup::scalar_lookup). */
+    inline double scalar_lookup( const Vector<double,3> & r,
+                                 const unsigned int & i ) const {
+      register unsigned int xi, yi, zi;
+      register double xf, yf, zf, xF, yF, zF;
+      getindx(xi, xf, yi, yf, zi, zf, r);
+      xF = 1.0 - xf;
+      yF = 1.0 - yf;
+      zF = 1.0 - zf;
+
+      return xF*yF*zF * data(xi  ,yi  ,zi  ).scalar(i)
+           + xf*yF*zF * data(xi+1,yi  ,zi  ).scalar(i)
+           + xF*yf*zF * data(xi  ,yi+1,zi  ).scalar(i)
+           + xf*yf*zF * data(xi+1,yi+1,zi  ).scalar(i)
+           + xF*yF*zf * data(xi  ,yi  ,zi+1).scalar(i)
+           + xf*yF*zf * data(xi+1,yi  ,zi+1).scalar(i)
+           + xF*yf*zf * data(xi  ,yi+1,zi+1).scalar(i)
+           + xf*yf*zf * data(xi+1,yi+1,zi+1).scalar(i);
+    }
+
+  private:
+    /** Compute the cell and the fractional position within the cell of r
+     * (clamped to the table). */
+    inline void getindx ( unsigned int & xi,
+                          double       & xf,
+                          unsigned int & yi,
+                          double       & yf,
+                          unsigned int & zi,
+                          double       & zf,
+                          const Vector<double,3> & r) const {
+      xf = ( (r[X]-min[X]) * dx_inv[X] );
+      yf = ( (r[Y]-min[Y]) * dx_inv[Y] );
+      zf = ( (r[Z]-min[Z]) * dx_inv[Z] );
+      #if !defined(NOTRUNCX)
+        xf = std::max(0.0,std::min(double(Nx)-1.001,xf));
+      #endif
+      #if !defined(NOTRUNCY)
+        yf = std::max(0.0,std::min(double(Ny)-1.001,yf));
+      #endif
+      #if !defined(NOTRUNCZ)
+        zf = std::max(0.0,std::min(double(Nz)-1.001,zf));
+      #endif
+      xi = (int) xf; xf -= xi;
+      yi = (int) yf; yf -= yi;
+      zi = (int) zf; zf -= zi;
+    }
+
+
+    /* MEMBER STORAGE */
+  private:
+    /** Position of the first grid point. */
+    Vector<double,3> min;
+    /** Grid spacing. */
+    Vector<double,3> dx;
+    /** Inverse of the grid spacing. */
+    Vector<double,3> dx_inv;
+
+    table_type data;
+  };
+
+}/* namespace fields */
+
+#endif // fields_StaticFieldLookup_h
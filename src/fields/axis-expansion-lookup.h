@@ -0,0 +1,493 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+/** \file
+ * Off-axis power-series lookup of axially symmetric magnetic fields.
+ *
+ * Inside a current-free region, an axially symmetric field is completely
+ * determined by the field on the axis:
+ * \f[
+ *   B_z(\rho,z) = \sum_n \frac{(-1)^n}{(n!)^2}
+ *                 \left(\frac{\rho}{2}\right)^{2n} b^{(2n)}(z), \qquad
+ *   B_\rho(\rho,z) = \sum_n \frac{(-1)^{n+1}}{n!(n+1)!}
+ *                 \left(\frac{\rho}{2}\right)^{2n+1} b^{(2n+1)}(z),
+ * \f]
+ * where \f$b^{(k)}\f$ is the k-th derivative of the on-axis field.
+ * AxisExpansionLookup stores only 1D arrays of these derivatives and
+ * reconstructs the field, its magnitude, the gradient of the magnitude and
+ * the potential from them inside of a paraxial region.  Outside of the
+ * paraxial region, it falls back to the (rho,z) table of AxiSymFieldLookup.
+ */
+
+#ifndef fields_axis_expansion_lookup_h
+#define fields_axis_expansion_lookup_h
+
+#include <fields/field-lookup.h>
+
+#include <xylose/Vector.h>
+#include <xylose/except.h>
+#include <xylose/power.h>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+namespace fields {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using xylose::SQR;
+
+  /** Lookup of an axially symmetric magnetic force from the derivatives of
+   * the on-axis field.
+   *
+   * For species i, the potential is V = mu[i] |B| and the acceleration is
+   * a = -(mu[i]/mass[i]) grad|B| (@see setMoment).  The (rho,z) table of the
+   * base class must hold the same force (e.g. as written by createFieldFile
+   * for BCalcs); it is only used outside of the paraxial region.
+   *
+   * Example:
+   * <code>
+   *   typedef ForceLookup< 3u,
+   *     AxisExpansionLookup< ForceRecord<3u> > > Force;
+   *   Force force;
+   *   force.readindata( "table.dat" );   // (rho,z) fallback table
+   *   force.rotateField( axis );
+   *   force.setMoment( 0u, mu, mass );
+   *   force.fitAxis( bsrc, -0.01, 0.01, 201u, 6u, 0.002 );
+   * </code>
+   */
+  template < class Record, class Table = detail::DTable<Record> >
+  class AxisExpansionLookup : public AxiSymFieldLookup<Record,Table> {
+    /* TYPEDEFS */
+  public:
+    typedef AxiSymFieldLookup<Record,Table> super;
+    typedef typename super::super base;
+
+    /** Maximum order of the expansion. */
+    static const unsigned int MAX_ORDER = 16u;
+
+
+    /* MEMBER STORAGE */
+  private:
+    /** Order of the expansion in rho. */
+    unsigned int order;
+
+    /** Number of stored derivatives per node (order + 2, such that the z
+     * derivatives of the order'th terms are available). */
+    unsigned int nderivs;
+
+    double z_min, dz, dz_inv;
+    unsigned int nz;
+
+    /** Radius of the paraxial region. */
+    double rho_max;
+
+    /** derivs[node*nderivs + k] = k-th derivative of B_z on the axis. */
+    std::vector<double> derivs;
+
+    /** Magnetic moment of each species. */
+    std::vector<double> mu;
+    /** Magnetic moment / mass of each species. */
+    std::vector<double> mu_over_m;
+
+
+    /* MEMBER FUNCTIONS */
+  public:
+    /** Default constructor.
+     * Does not initialize the lookup table or the axis expansion.
+     */
+    AxisExpansionLookup() : super() {
+      base::r0.zero();
+      init();
+    }
+
+    AxisExpansionLookup(const std::string & filename) : super(filename) {
+      init();
+    }
+
+    /** Set the moment of species i. */
+    void setMoment( const unsigned int & i,
+                    const double & _mu,
+                    const double & mass ) {
+      if ( i >= mu.size() ) {
+        mu.resize( i+1, 1.0 );
+        mu_over_m.resize( i+1, 1.0 );
+      }
+      mu[i] = _mu;
+      mu_over_m[i] = _mu / mass;
+    }
+
+    /** Set the on-axis derivatives directly.
+     * @param _order
+     *     Order of the expansion in rho.
+     * @param _z_min
+     *     Position of the first node along the axis (in the frame of the
+     *     lookup, i.e. relative to r0 along the rotated z-axis;  r0 is the
+     *     origin unless a table has been read in).
+     * @param _dz
+     *     Spacing of the nodes.
+     * @param _derivs
+     *     _derivs[node*(_order+2) + k] is the k-th z-derivative of B_z on the
+     *     axis at the node.
+     * @param _rho_max
+     *     Radius of the paraxial region.
+     */
+    void initializeAxis( const unsigned int & _order,
+                         const double & _z_min,
+                         const double & _dz,
+                         const std::vector<double> & _derivs,
+                         const double & _rho_max ) {
+      if ( _order > MAX_ORDER || !(_dz > 0.0) ||
+           _derivs.size() < (_order + 2u) ||
+           _derivs.size() % (_order + 2u) != 0u )
+        THROW(std::runtime_error,"axis-expansion-lookup:  invalid axis");
+      order = _order;
+      nderivs = order + 2u;
+      z_min = _z_min;
+      dz = _dz;
+      dz_inv = 1.0 / dz;
+      nz = _derivs.size() / nderivs;
+      rho_max = _rho_max;
+      derivs = _derivs;
+    }
+
+    /** Compute the on-axis derivatives from a magnetic field source.
+     * The on-axis field is interpolated by a Chebyshev series (of the given
+     * degree) which is then differentiated analytically.
+     * @param bsrc
+     *     Magnetic field;  provides operator()(Vector<double,3> & B,
+     *     const Vector<double,3> & r) (in the lab frame).
+     * @param z0
+     *     Beginning of the axis (in the frame of the lookup).
+     * @param z1
+     *     End of the axis.
+     * @param _nz
+     *     Number of nodes along the axis (>= 2).
+     * @param _order
+     *     Order of the expansion in rho.
+     * @param _rho_max
+     *     Radius of the paraxial region.
+     * @param degree
+     *     Degree of the Chebyshev series [Default 64].
+     */
+    template < typename BSrc >
+    void fitAxis( const BSrc & bsrc,
+                  const double & z0,
+                  const double & z1,
+                  const unsigned int & _nz,
+                  const unsigned int & _order,
+                  const double & _rho_max,
+                  const unsigned int & degree = 64u ) {
+      if ( _nz < 2u || !(z1 > z0) || degree < _order + 2u )
+        THROW(std::runtime_error,"axis-expansion-lookup:  invalid axis");
+
+      const double pi = 4.0 * std::atan(1.0);
+      const unsigned int n = degree + 1u;
+      const Vector<double,3> axis = fromLookupFrame( V3(0.,0.,1.) );
+
+      /* sample B_z at the Chebyshev nodes and transform. */
+      std::vector<double> f(n), c(n, 0.0);
+      for ( unsigned int j = 0u; j < n; ++j ) {
+        const double u = std::cos( pi * (j + 0.5) / n );
+        Vector<double,3> B;
+        bsrc( B, base::r0 + (0.5*(z0 + z1) + 0.5*(z1 - z0)*u) * axis );
+        f[j] = B * axis;
+      }
+      for ( unsigned int k = 0u; k < n; ++k ) {
+        for ( unsigned int j = 0u; j < n; ++j )
+          c[k] += f[j] * std::cos( pi * k * (j + 0.5) / n );
+        c[k] *= (k ? 2.0 : 1.0) / n;
+      }
+
+      const unsigned int K = _order + 2u;
+      const double scale = 2.0 / (z1 - z0);
+      const double _dz = (z1 - z0) / (_nz - 1u);
+      std::vector<double> d( _nz * K );
+      for ( unsigned int k = 0u; k < K; ++k ) {
+        for ( unsigned int node = 0u; node < _nz; ++node )
+          d[node*K + k] = clenshaw( c, 2.0*node/(_nz - 1u) - 1.0 );
+
+        /* differentiate the series:  c'[k-1] = c'[k+1] + 2 k c[k]. */
+        std::vector<double> cd(n, 0.0);
+        for ( int m = int(n) - 1; m >= 1; --m )
+          cd[m-1] = (m+1 < int(n) ? cd[m+1] : 0.0) + 2.0 * m * c[m] * scale;
+        cd[0] *= 0.5;
+        c.swap(cd);
+      }
+
+      initializeAxis( _order, z0, _dz, d, _rho_max );
+    }
+
+    /** Whether the axis expansion has been initialized. */
+    bool axisInitialized() const { return !derivs.empty(); }
+
+    /** Order of the expansion. */
+    const unsigned int & getOrder() const { return order; }
+
+    /** Radius of the paraxial region. */
+    const double & getParaxialRadius() const { return rho_max; }
+
+    /** Whether r is inside of the paraxial region. */
+    inline bool inParaxialRegion( const Vector<double,3> & r ) const {
+      double rho, z;
+      super::getRotatedRelativeCoords(r, rho, z);
+      return paraxial(rho, z);
+    }
+
+    /** Magnetic field at r (inside of the paraxial region). */
+    inline void field( Vector<double,3> & B, const Vector<double,3> & r ) const {
+      Terms t;
+      const Vector<double,3> r_rel = evaluate( t, r );
+      B = fromLookupFrame( radial( r_rel, t.Brho, t.Bz ) );
+    }
+
+    /** Magnitude of the magnetic field at r (inside of the paraxial region). */
+    inline double magnitude( const Vector<double,3> & r ) const {
+      Terms t;
+      evaluate( t, r );
+      return std::sqrt( SQR(t.Brho) + SQR(t.Bz) );
+    }
+
+    /** Gradient of the magnitude of the magnetic field at r (inside of the
+     * paraxial region). */
+    inline void gradientOfMagnitude( Vector<double,3> & g,
+                                     const Vector<double,3> & r ) const {
+      Terms t;
+      const Vector<double,3> r_rel = evaluate( t, r );
+      const double B = std::sqrt( SQR(t.Brho) + SQR(t.Bz) );
+      if ( B == 0.0 ) {
+        g.zero();
+        return;
+      }
+      g = fromLookupFrame( radial( r_rel,
+                                   (t.Brho*t.dBrho_drho + t.Bz*t.dBz_drho) / B,
+                                   (t.Brho*t.dBrho_dz   + t.Bz*t.dBz_dz  ) / B ) );
+    }
+
+    /** Provide acceleration data, using the expansion inside of the paraxial
+     * region and the (rho,z) table elsewhere. */
+    inline void vector_lookup( Vector<double,3> & retval,
+                               const Vector<double,3> & r,
+                               const unsigned int & i ) const {
+      double rho, z;
+      super::getRotatedRelativeCoords(r, rho, z);
+      if ( !paraxial(rho, z) ) {
+        super::vector_lookup( retval, r, i );
+        return;
+      }
+
+      gradientOfMagnitude( retval, r );
+      retval *= - (i < mu_over_m.size() ? mu_over_m[i] : 1.0);
+    }
+
+    /** Provide potential data, using the expansion inside of the paraxial
+     * region and the (rho,z) table elsewhere. */
+    inline double scalar_lookup( const Vector<double,3> & r,
+                                 const unsigned int & i ) const {
+      double rho, z;
+      super::getRotatedRelativeCoords(r, rho, z);
+      if ( !paraxial(rho, z) )
+        return super::scalar_lookup( r, i );
+
+      return (i < mu.size() ? mu[i] : 1.0) * magnitude( r );
+    }
+
+    /** Write the on-axis derivatives to a stream.  The format is
+     *   # AXIS : \n
+     *   # {order} {nz} {z_min} {dz} {rho_max} \n
+     *   # \n
+     *   <one line per node:  b, b', b'', ...>
+     */
+    void writeAxis( std::ostream & out ) const {
+      out << "# AXIS : \n"
+             "# " << order << '\t' << nz << '\t' << z_min << '\t'
+                  << dz << '\t' << rho_max << "\n"
+             "# \n";
+      for ( unsigned int node = 0u; node < nz; ++node ) {
+        for ( unsigned int k = 0u; k < nderivs; ++k )
+          out << (k ? "\t" : "") << derivs[node*nderivs + k];
+        out << '\n';
+      }
+    }
+
+    /** Write the on-axis derivatives to a file. */
+    void writeAxis( const std::string & filename ) const {
+      std::ofstream out(filename.c_str());
+      out.precision(17);
+      writeAxis(out);
+    }
+
+    /** Read the on-axis derivatives from a stream (@see writeAxis). */
+    void readAxis( std::istream & in ) {
+      char pound;
+      std::string line;
+      unsigned int _order, _nz;
+      double _z_min, _dz, _rho_max;
+      in >> pound; std::getline(in, line);                /* # AXIS : */
+      in >> pound >> _order >> _nz >> _z_min >> _dz >> _rho_max;
+      std::getline(in, line);
+      in >> pound; std::getline(in, line);                /* # */
+      if ( !in || _order > MAX_ORDER )
+        THROW(std::runtime_error,"axis-expansion-lookup:  invalid header");
+
+      std::vector<double> d( std::size_t(_nz) * (_order + 2u) );
+      for ( std::size_t k = 0u; k < d.size(); ++k )
+        in >> d[k];
+      if ( !in )
+        THROW(std::runtime_error,"axis-expansion-lookup:  truncated data");
+      initializeAxis( _order, _z_min, _dz, d, _rho_max );
+    }
+
+    /** Read the on-axis derivatives from a file. */
+    void readAxis( const std::string & filename ) {
+      std::ifstream in(filename.c_str());
+      if ( !in.good() )
+        THROW(std::runtime_error,"axis-expansion-lookup:  invalid filename.");
+      readAxis(in);
+    }
+
+  private:
+    /** The field and its derivatives in the (rho,z) plane. */
+    struct Terms {
+      double Brho, Bz, dBrho_drho, dBrho_dz, dBz_drho, dBz_dz;
+    };
+
+    void init() {
+      order = nderivs = nz = 0u;
+      z_min = dz = dz_inv = rho_max = 0.0;
+      mu.assign( 1u, 1.0 );
+      mu_over_m.assign( 1u, 1.0 );
+    }
+
+    inline bool paraxial( const double & rho, const double & z ) const {
+      return !derivs.empty() && rho <= rho_max &&
+             z >= z_min && z <= z_min + (nz - 1u) * dz;
+    }
+
+    /** Rotate a vector from the lookup frame back into the lab frame. */
+    inline Vector<double,3> fromLookupFrame( const Vector<double,3> & v ) const {
+      Vector<double,3> retval;
+      for ( unsigned int j = 0u; j < 3u; ++j )
+        retval[j] = super::R[X][j] * v[X]
+                  + super::R[Y][j] * v[Y]
+                  + super::R[Z][j] * v[Z];
+      return retval;
+    }
+
+    /** Cartesian (lookup frame) vector from (rho,z) components at r_rel. */
+    static inline Vector<double,3> radial( const Vector<double,3> & r_rel,
+                                           const double & vrho,
+                                           const double & vz ) {
+      const double rho = std::sqrt( SQR(r_rel[X]) + SQR(r_rel[Y]) );
+      if ( rho == 0.0 )
+        return V3( 0., 0., vz );
+      return V3( vrho * r_rel[X] / rho, vrho * r_rel[Y] / rho, vz );
+    }
+
+    /** Evaluate the expansion at r and return the position of r in the
+     * lookup frame. */
+    inline Vector<double,3> evaluate( Terms & t,
+                                      const Vector<double,3> & r ) const {
+      const Vector<double,3> r_rel = super::R * (r - base::r0);
+      const double rho = std::sqrt( SQR(r_rel[X]) + SQR(r_rel[Y]) );
+
+      /* derivatives at z from a Taylor series about the nearest node. */
+      double zf = (r_rel[Z] - z_min) * dz_inv;
+      zf = std::max( 0.0, std::min( double(nz - 1u), zf ) );
+      const unsigned int node = (unsigned int)(zf + 0.5);
+      const double h = r_rel[Z] - (z_min + node * dz);
+      const double * D = &derivs[node * nderivs];
+
+      double d[MAX_ORDER + 2u];
+      for ( unsigned int k = 0u; k < nderivs; ++k ) {
+        double s = 0.0;
+        for ( int j = int(nderivs - 1u - k); j >= 0; --j )
+          s = D[k + j] + s * h / (j + 1);
+        d[k] = s;
+      }
+
+      /* power series in rho/2. */
+      const double x = 0.5 * rho;
+      t.Brho = t.Bz = t.dBrho_drho = t.dBrho_dz = t.dBz_drho = t.dBz_dz = 0.0;
+      double xp = 1.0;          /* x^(2n) */
+      double xq = 0.0;          /* x^(2n-1) */
+      double fn = 1.0;          /* n! */
+      double sign = 1.0;        /* (-1)^n */
+      for ( unsigned int n = 0u; 2u*n <= order; ++n ) {
+        /* B_z term:  (-1)^n / (n!)^2 x^(2n) d[2n] */
+        const double cz = sign / (fn * fn);
+        t.Bz     += cz * xp * d[2u*n];
+        t.dBz_dz += cz * xp * d[2u*n + 1u];
+        if ( n )
+          t.dBz_drho += cz * n * xq * d[2u*n];
+
+        if ( 2u*n + 1u > order )
+          break;
+
+        /* B_rho term:  (-1)^(n+1) / (n! (n+1)!) x^(2n+1) d[2n+1] */
+        const double cr = -sign / (fn * fn * (n + 1u));
+        t.Brho       += cr * xp * x * d[2u*n + 1u];
+        t.dBrho_dz   += cr * xp * x * d[2u*n + 2u];
+        t.dBrho_drho += cr * 0.5 * (2u*n + 1u) * xp * d[2u*n + 1u];
+
+        xq = xp * x;
+        xp *= x * x;
+        fn *= n + 1u;
+        sign = -sign;
+      }
+
+      return r_rel;
+    }
+
+    /** Sum of a Chebyshev series at u in [-1,1]. */
+    static double clenshaw( const std::vector<double> & c, const double & u ) {
+      double b1 = 0.0, b2 = 0.0;
+      for ( int k = int(c.size()) - 1; k >= 1; --k ) {
+        const double b0 = 2.0 * u * b1 - b2 + c[k];
+        b2 = b1;
+        b1 = b0;
+      }
+      return u * b1 - b2 + c[0];
+    }
+  };
+
+  template < class Record, class Table >
+  const unsigned int AxisExpansionLookup<Record,Table>::MAX_ORDER;
+
+}/* namespace fields */
+
+#endif // fields_axis_expansion_lookup_h
@@ -0,0 +1,261 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+/** \file
+ * Utilities to sort particles spatially by the field-lookup table cell they
+ * occupy.
+ *
+ * Large ensembles of particles in random memory order cause successive table
+ * lookups to jump across the entire table.  Sorting the particles by their
+ * table cell (FieldLookup::cellIndex) or by the Morton index of their table
+ * cell (FieldLookup::mortonIndex) makes successive lookups hit the same or
+ * neighboring cells.  The sort produces a permutation that can be used to
+ * reorder any number of particle (SoA) arrays.
+ *
+ * Example:
+ * <code>
+ *   std::vector<unsigned long long> keys;
+ *   std::vector<std::size_t> perm;
+ *   fields::cellKeys( keys, lookup, &r[0], r.size(), fields::MORTON_ORDER );
+ *   fields::radixSortPermutation( perm, keys );
+ *   fields::applyPermutation( r_sorted, perm, r );
+ *   fields::applyPermutation( v_sorted, perm, v );
+ *   fields::sortedVectorLookup( &a[0], lookup, &r_sorted[0], r.size(), 0u );
+ * </code>
+ */
+
+#ifndef fields_cell_sort_h
+#define fields_cell_sort_h
+
+#include <fields/detail/omp.h>
+
+#include <xylose/Vector.h>
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace fields {
+
+  using xylose::Vector;
+
+  /** Ordering used to compute cell keys. */
+  enum CellOrder {
+    /** Memory order of the table (FieldLookup::cellIndex). */
+    TABLE_ORDER,
+    /** Z-order curve of the table cells (FieldLookup::mortonIndex). */
+    MORTON_ORDER
+  };
+
+  /** Compute the sort key of each position.
+   * @param keys
+   *     Resized to n and filled with the cell keys.
+   * @param lookup
+   *     The lookup table (must implement cellIndex(r) and mortonIndex(r)).
+   * @param r
+   *     Array of n positions.
+   * @param n
+   *     Number of positions.
+   * @param order
+   *     Whether to use table order or Morton order [Default TABLE_ORDER].
+   */
+  template < typename Lookup >
+  void cellKeys( std::vector<unsigned long long> & keys,
+                 const Lookup & lookup,
+                 const Vector<double,3> * r,
+                 const std::size_t & n,
+                 const CellOrder & order = TABLE_ORDER ) {
+    keys.resize(n);
+    const long N = n;
+    if ( order == MORTON_ORDER ) {
+      #pragma omp parallel for
+      for ( long i = 0; i < N; ++i )
+        keys[i] = lookup.mortonIndex(r[i]);
+    } else {
+      #pragma omp parallel for
+      for ( long i = 0; i < N; ++i )
+        keys[i] = lookup.cellIndex(r[i]);
+    }
+  }
+
+  /** Stable, parallel, least-significant-digit radix sort of the given keys.
+   * The keys themselves are not modified.  Radix passes over digits that are
+   * identical for all keys are skipped, so small tables require fewer passes.
+   *
+   * @param perm
+   *     Resized to keys.size() and filled such that keys[perm[0]],
+   *     keys[perm[1]], ... is in ascending order.
+   * @param keys
+   *     The sort keys.
+   */
+  inline void radixSortPermutation( std::vector<std::size_t> & perm,
+                                    const std::vector<unsigned long long> & keys ) {
+    const std::size_t n = keys.size();
+    const int RADIX_BITS = 8;
+    const unsigned int RADIX = 1u << RADIX_BITS;
+
+    perm.resize(n);
+    for ( std::size_t i = 0u; i < n; ++i )
+      perm[i] = i;
+    if ( n < 2u )
+      return;
+
+    /* find which digits actually differ between keys. */
+    unsigned long long all_or = 0ull, all_and = ~0ull;
+    for ( std::size_t i = 0u; i < n; ++i ) {
+      all_or  |= keys[i];
+      all_and &= keys[i];
+    }
+    const unsigned long long differ = all_or ^ all_and;
+
+    std::vector<unsigned long long> key_a(keys), key_b(n);
+    std::vector<std::size_t> perm_b(n);
+    const int max_threads = detail::max_threads();
+    std::vector<std::size_t> count( max_threads * RADIX );
+
+    for ( int shift = 0; shift < 64; shift += RADIX_BITS ) {
+      if ( ((differ >> shift) & (RADIX - 1u)) == 0ull )
+        continue;
+
+      #pragma omp parallel
+      {
+        const int nt  = detail::num_threads();
+        const int tid = detail::thread_num();
+        const std::size_t lo = n *  tid      / nt;
+        const std::size_t hi = n * (tid + 1) / nt;
+        std::size_t * c = &count[tid * RADIX];
+
+        std::fill( c, c + RADIX, 0u );
+        for ( std::size_t i = lo; i < hi; ++i )
+          ++c[ (key_a[i] >> shift) & (RADIX - 1u) ];
+
+        #pragma omp barrier
+        #pragma omp single
+        {
+          /* convert counts to (exclusive) offsets:  digit-major, thread-minor
+           * to keep the sort stable. */
+          std::size_t offset = 0u;
+          for ( unsigned int d = 0u; d < RADIX; ++d )
+            for ( int t = 0; t < nt; ++t ) {
+              std::size_t & ctd = count[t * RADIX + d];
+              const std::size_t tmp = ctd;
+              ctd = offset;
+              offset += tmp;
+            }
+        }/* implicit barrier */
+
+        for ( std::size_t i = lo; i < hi; ++i ) {
+          const std::size_t dst = c[ (key_a[i] >> shift) & (RADIX - 1u) ]++;
+          key_b[dst]  = key_a[i];
+          perm_b[dst] = perm[i];
+        }
+      }
+
+      key_a.swap(key_b);
+      perm.swap(perm_b);
+    }
+  }
+
+  /** Gather an array into sorted order:  out[i] = in[perm[i]].
+   * @param out
+   *     Resized to perm.size().
+   */
+  template < typename T >
+  void applyPermutation( std::vector<T> & out,
+                         const std::vector<std::size_t> & perm,
+                         const std::vector<T> & in ) {
+    out.resize( perm.size() );
+    const long N = perm.size();
+    #pragma omp parallel for
+    for ( long i = 0; i < N; ++i )
+      out[i] = in[ perm[i] ];
+  }
+
+  /** Batched vector lookup for positions sorted by table cell.
+   * Each thread keeps a single lookup context over a contiguous range of
+   * particles so that consecutive particles in the same cell reuse the corner
+   * values of the previous lookup.  This works for unsorted input as well,
+   * just without the benefit.
+   *
+   * @param retval
+   *     Array of n returned vectors.
+   * @param lookup
+   *     The lookup table (must provide LookupContext, such as FieldLookup).
+   * @param r
+   *     Array of n positions (preferably sorted by cell).
+   * @param n
+   *     Number of positions.
+   * @param i
+   *     Species (or vector) index.
+   */
+  template < typename Lookup >
+  void sortedVectorLookup( Vector<double,3> * retval,
+                           const Lookup & lookup,
+                           const Vector<double,3> * r,
+                           const std::size_t & n,
+                           const unsigned int & i ) {
+    #pragma omp parallel
+    {
+      const int nt  = detail::num_threads();
+      const int tid = detail::thread_num();
+      const std::size_t lo = n *  tid      / nt;
+      const std::size_t hi = n * (tid + 1) / nt;
+
+      typename Lookup::LookupContext ctx;
+      for ( std::size_t k = lo; k < hi; ++k )
+        lookup.vector_lookup( retval[k], r[k], i, ctx );
+    }
+  }
+
+  /** Batched scalar lookup for positions sorted by table cell.
+   * @see sortedVectorLookup.
+   */
+  template < typename Lookup >
+  void sortedScalarLookup( double * retval,
+                           const Lookup & lookup,
+                           const Vector<double,3> * r,
+                           const std::size_t & n,
+                           const unsigned int & i ) {
+    #pragma omp parallel
+    {
+      const int nt  = detail::num_threads();
+      const int tid = detail::thread_num();
+      const std::size_t lo = n *  tid      / nt;
+      const std::size_t hi = n * (tid + 1) / nt;
+
+      typename Lookup::LookupContext ctx;
+      for ( std::size_t k = lo; k < hi; ++k )
+        retval[k] = lookup.scalar_lookup( r[k], i, ctx );
+    }
+  }
+
+}/* namespace fields */
+
+#endif // fields_cell_sort_h
@@ -0,0 +1,472 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+/** \file
+ * Block-wise Chebyshev representation of force fields.
+ *
+ * For smooth fields (e.g. the SHELL region far from the sources), a point
+ * table streams large amounts of memory for little information.  Here, the
+ * domain is split into equal blocks and each block stores a low-order 3D
+ * Chebyshev expansion of the acceleration and the potential.  The order of
+ * each block is chosen (at fitting time) as the lowest one that meets the
+ * requested tolerances.  A lookup evaluates the expansion of one block,
+ * which needs only a small, cache-resident, set of coefficients.
+ *
+ * Example:
+ * <code>
+ *   typedef fields::ForceLookup< 3u, fields::ChebyshevFieldLookup<> > Force;
+ *   Force force;
+ *   force.fit( fields::ForceTableWrapper<BForce>(),
+ *              shell_min, shell_max, V3(8,8,8), 1e-3, 1e-30 );
+ *   force.writedata( "shell.cheb" );
+ * </code>
+ * To use a point table for the CORE and the Chebyshev blocks elsewhere,
+ * combine them with HybridForce< ForceLookup<>, Force >.
+ */
+
+#ifndef fields_chebyshev_lookup_h
+#define fields_chebyshev_lookup_h
+
+#include <fields/force-lookup.h>
+
+#include <xylose/Vector.h>
+#include <xylose/except.h>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+namespace fields {
+
+  using xylose::Vector;
+  using xylose::V3;
+
+  /** Lookup from block-wise Chebyshev expansions of a force.
+   * @param L
+   *     Length of the vectors [Default 3].
+   * @param N
+   *     Number of species [Default 1].
+   */
+  template < unsigned int L = 3u, unsigned int N = 1u >
+  class ChebyshevFieldLookup {
+    /* TYPEDEFS */
+  public:
+    /** Maximum order of the expansion of a block. */
+    static const unsigned int MAX_ORDER = 15u;
+
+  private:
+    /** Number of expanded quantities (a and V of each species). */
+    static const unsigned int NCOMP = N * (L + 1u);
+
+
+    /* MEMBER STORAGE */
+  private:
+    Vector<double,3> min;
+    Vector<double,3> max;
+    Vector<int,3> nblocks;
+    Vector<double,3> block_L_inv;
+
+    /** Order of each block. */
+    std::vector<unsigned int> order;
+
+    /** Offset of the coefficients of each block. */
+    std::vector<std::size_t> offset;
+
+    /** Coefficients c[block][comp][kz][kx][ky]. */
+    std::vector<double> coeffs;
+
+
+    /* MEMBER FUNCTIONS */
+  public:
+    ChebyshevFieldLookup() : min(0.0), max(0.0), nblocks(0), block_L_inv(0.0) { }
+
+    ChebyshevFieldLookup( const std::string & filename )
+      : min(0.0), max(0.0), nblocks(0), block_L_inv(0.0) {
+      readindata(filename);
+    }
+
+    /** Fit the expansions to a source.
+     * @param src
+     *     Provides ForceRecord<L,N> getRecord(const Vector<double,3> &) const
+     *     (e.g. ForceTableWrapper; the same sources as createFieldFile).
+     * @param _min
+     *     Lower corner of the domain.
+     * @param _max
+     *     Upper corner of the domain.
+     * @param _nblocks
+     *     Number of blocks along each axis.
+     * @param vector_tol
+     *     Maximum absolute error of each component of the acceleration.
+     * @param scalar_tol
+     *     Maximum absolute error of the potential.
+     * @param max_order
+     *     Maximum order of a block [Default 8].  Blocks that do not meet the
+     *     tolerances with this order use it anyway.
+     */
+    template < typename Source >
+    void fit( const Source & src,
+              const Vector<double,3> & _min,
+              const Vector<double,3> & _max,
+              const Vector<int,3> & _nblocks,
+              const double & vector_tol,
+              const double & scalar_tol,
+              const unsigned int & max_order = 8u ) {
+      if ( max_order < 1u || max_order > MAX_ORDER )
+        THROW(std::runtime_error,"chebyshev-lookup:  invalid maximum order");
+
+      setGeometry( _min, _max, _nblocks );
+      const int nb = nblocks.prod();
+      std::vector< std::vector<double> > bc(nb);
+      order.assign( nb, 0u );
+
+      #pragma omp parallel for schedule(dynamic)
+      for ( int b = 0; b < nb; ++b ) {
+        for ( unsigned int p = 1u; p <= max_order; ++p ) {
+          fitBlock( bc[b], src, b, p );
+          order[b] = p;
+          if ( blockError( bc[b], src, b, p, vector_tol, scalar_tol ) )
+            break;
+        }
+      }
+
+      offset.resize(nb);
+      coeffs.clear();
+      for ( int b = 0; b < nb; ++b ) {
+        offset[b] = coeffs.size();
+        coeffs.insert( coeffs.end(), bc[b].begin(), bc[b].end() );
+      }
+    }
+
+    /** Provide acceleration data. */
+    inline void vector_lookup( Vector<double,L> & retval,
+                               const Vector<double,3> & r,
+                               const unsigned int & i ) const {
+      unsigned int b;
+      double T[3][MAX_ORDER + 1u];
+      basis( b, T, r );
+      const unsigned int p1 = order[b] + 1u, n = p1*p1*p1;
+      const double * c = &coeffs[offset[b]] + i * (L + 1u) * n;
+      for ( unsigned int l = 0u; l < L; ++l, c += n )
+        retval[l] = sum( c, T, p1 );
+    }
+
+    /** Provide potential data. */
+    inline double scalar_lookup( const Vector<double,3> & r,
+                                 const unsigned int & i ) const {
+      unsigned int b;
+      double T[3][MAX_ORDER + 1u];
+      basis( b, T, r );
+      const unsigned int p1 = order[b] + 1u, n = p1*p1*p1;
+      return sum( &coeffs[offset[b]] + (i * (L + 1u) + L) * n, T, p1 );
+    }
+
+    /** Whether r is inside of the domain (outside, the expansions of the
+     * edge blocks are evaluated at the closest point of the domain). */
+    inline bool inDomain( const Vector<double,3> & r ) const {
+      for ( unsigned int d = 0u; d < 3u; ++d )
+        if ( r[d] < min[d] || r[d] > max[d] )
+          return false;
+      return !order.empty();
+    }
+
+    /** Whether the expansions have been fit or read in. */
+    bool isInitialized() const { return !order.empty(); }
+
+    /** Order of each block. */
+    const std::vector<unsigned int> & getOrders() const { return order; }
+
+    /** Number of stored coefficients. */
+    std::size_t size() const { return coeffs.size(); }
+
+    /** Write the expansions to a stream.  The format is
+     *   # CHEBYSHEV : \n
+     *   # {nblocks_i \w} {min_i \w} {max_i \w} \n
+     *   # \n
+     *   <one line per block:  order coefficients...>
+     */
+    void writedata( std::ostream & out ) const {
+      out << "# CHEBYSHEV : \n"
+             "# " << nblocks << '\t' << min << '\t' << max << "\n"
+             "# \n";
+      for ( std::size_t b = 0u; b < order.size(); ++b ) {
+        const unsigned int p1 = order[b] + 1u;
+        const std::size_t n = NCOMP * p1*p1*p1;
+        out << order[b];
+        for ( std::size_t k = 0u; k < n; ++k )
+          out << '\t' << coeffs[offset[b] + k];
+        out << '\n';
+      }
+    }
+
+    /** Write the expansions to a file. */
+    void writedata( const std::string & filename ) const {
+      std::ofstream out(filename.c_str());
+      out.precision(17);
+      writedata(out);
+    }
+
+    /** Read the expansions from a stream (@see writedata). */
+    void readindata( std::istream & in ) {
+      char pound;
+      std::string line;
+      Vector<int,3> _nblocks;
+      Vector<double,3> _min, _max;
+      in >> pound; std::getline(in, line);              /* # CHEBYSHEV : */
+      in >> pound >> _nblocks >> _min >> _max;
+      std::getline(in, line);                           /* remainder */
+      in >> pound; std::getline(in, line);              /* # */
+      if ( !in )
+        THROW(std::runtime_error,"chebyshev-lookup:  invalid header");
+
+      setGeometry( _min, _max, _nblocks );
+      const int nb = nblocks.prod();
+      order.resize(nb);
+      offset.resize(nb);
+      coeffs.clear();
+      for ( int b = 0; b < nb; ++b ) {
+        in >> order[b];
+        if ( !in || order[b] < 1u || order[b] > MAX_ORDER )
+          THROW(std::runtime_error,"chebyshev-lookup:  invalid block order");
+        const unsigned int p1 = order[b] + 1u;
+        offset[b] = coeffs.size();
+        coeffs.resize( offset[b] + NCOMP * p1*p1*p1 );
+        for ( std::size_t k = offset[b]; k < coeffs.size(); ++k )
+          in >> coeffs[k];
+      }
+      if ( !in )
+        THROW(std::runtime_error,"chebyshev-lookup:  truncated data");
+    }
+
+    /** Read the expansions from a file. */
+    void readindata( const std::string & filename ) {
+      std::ifstream in(filename.c_str());
+      if ( !in.good() )
+        THROW(std::runtime_error,"chebyshev-lookup:  invalid filename.");
+      readindata(in);
+    }
+
+  private:
+    void setGeometry( const Vector<double,3> & _min,
+                      const Vector<double,3> & _max,
+                      const Vector<int,3> & _nblocks ) {
+      for ( unsigned int d = 0u; d < 3u; ++d )
+        if ( _nblocks[d] < 1 || !(_max[d] > _min[d]) )
+          THROW(std::runtime_error,"chebyshev-lookup:  invalid geometry");
+      min = _min;
+      max = _max;
+      nblocks = _nblocks;
+      for ( unsigned int d = 0u; d < 3u; ++d )
+        block_L_inv[d] = nblocks[d] / (max[d] - min[d]);
+    }
+
+    /** Lower corner and size of a block. */
+    void blockGeometry( const int & b,
+                        Vector<double,3> & lo,
+                        Vector<double,3> & len ) const {
+      const int by = b % nblocks[1];
+      const int bx = (b / nblocks[1]) % nblocks[0];
+      const int bz = b / (nblocks[1] * nblocks[0]);
+      for ( unsigned int d = 0u; d < 3u; ++d )
+        len[d] = 1.0 / block_L_inv[d];
+      lo = min + V3( bx * len[0], by * len[1], bz * len[2] );
+    }
+
+    /** Position of the local coordinates u in [-1,1] within a block. */
+    static Vector<double,3> local( const Vector<double,3> & lo,
+                                   const Vector<double,3> & len,
+                                   const double & ux,
+                                   const double & uy,
+                                   const double & uz ) {
+      return lo + 0.5 * V3( len[0] * (ux + 1.0),
+                            len[1] * (uy + 1.0),
+                            len[2] * (uz + 1.0) );
+    }
+
+    /** Find the block of r and the Chebyshev polynomials T[axis][k] at the
+     * position of r within the block. */
+    inline void basis( unsigned int & b,
+                       double (&T)[3][MAX_ORDER + 1u],
+                       const Vector<double,3> & r ) const {
+      int bi[3];
+      double u[3];
+      for ( unsigned int d = 0u; d < 3u; ++d ) {
+        double f = (r[d] - min[d]) * block_L_inv[d];
+        f = std::max( 0.0, std::min( double(nblocks[d]), f ) );
+        bi[d] = std::min( int(f), nblocks[d] - 1 );
+        u[d] = 2.0 * (f - bi[d]) - 1.0;
+      }
+      b = (bi[2] * nblocks[0] + bi[0]) * nblocks[1] + bi[1];
+
+      const unsigned int p = order[b];
+      for ( unsigned int d = 0u; d < 3u; ++d ) {
+        T[d][0] = 1.0;
+        T[d][1] = u[d];
+        for ( unsigned int k = 2u; k <= p; ++k )
+          T[d][k] = 2.0 * u[d] * T[d][k-1] - T[d][k-2];
+      }
+    }
+
+    /** Sum of one expansion. */
+    static inline double sum( const double * c,
+                              const double (&T)[3][MAX_ORDER + 1u],
+                              const unsigned int & p1 ) {
+      double retval = 0.0;
+      for ( unsigned int kz = 0u; kz < p1; ++kz ) {
+        double sz = 0.0;
+        for ( unsigned int kx = 0u; kx < p1; ++kx ) {
+          double sx = 0.0;
+          for ( unsigned int ky = 0u; ky < p1; ++ky, ++c )
+            sx += *c * T[1][ky];
+          sz += sx * T[0][kx];
+        }
+        retval += sz * T[2][kz];
+      }
+      return retval;
+    }
+
+    /** Fit the expansions of order p of block b by sampling the source at
+     * the Chebyshev nodes. */
+    template < typename Source >
+    void fitBlock( std::vector<double> & c,
+                   const Source & src,
+                   const int & b,
+                   const unsigned int & p ) const {
+      const unsigned int p1 = p + 1u, n = p1*p1*p1;
+      Vector<double,3> lo, len;
+      blockGeometry( b, lo, len );
+
+      /* cos(pi k (j+1/2) / p1) */
+      const double pi = 4.0 * std::atan(1.0);
+      std::vector<double> C(p1*p1), x(p1);
+      for ( unsigned int j = 0u; j < p1; ++j ) {
+        x[j] = std::cos( pi * (j + 0.5) / p1 );
+        for ( unsigned int k = 0u; k < p1; ++k )
+          C[k*p1 + j] = std::cos( pi * k * (j + 0.5) / p1 )
+                      * (k ? 2.0 : 1.0) / p1;
+      }
+
+      /* samples f[comp][jz][jx][jy] */
+      std::vector<double> f( NCOMP * n ), tmp( NCOMP * n );
+      for ( unsigned int jz = 0u; jz < p1; ++jz )
+        for ( unsigned int jx = 0u; jx < p1; ++jx )
+          for ( unsigned int jy = 0u; jy < p1; ++jy ) {
+            const Vector<double,3> r = local( lo, len, x[jx], x[jy], x[jz] );
+            const ForceRecord<L,N> rec = src.getRecord(r);
+            const std::size_t e = (jz*p1 + jx)*p1 + jy;
+            for ( unsigned int i = 0u; i < N; ++i ) {
+              for ( unsigned int l = 0u; l < L; ++l )
+                f[ (i*(L+1u) + l)*n + e ] = rec.vector(i)[l];
+              f[ (i*(L+1u) + L)*n + e ] = rec.scalar(i);
+            }
+          }
+
+      /* separable transform along y, then x, then z. */
+      c.assign( NCOMP * n, 0.0 );
+      for ( unsigned int m = 0u; m < NCOMP; ++m ) {
+        double * F = &f[m*n], * G = &tmp[m*n], * H = &c[m*n];
+        for ( unsigned int a = 0u; a < p1*p1; ++a )          /* y */
+          for ( unsigned int k = 0u; k < p1; ++k ) {
+            double s = 0.0;
+            for ( unsigned int j = 0u; j < p1; ++j )
+              s += C[k*p1 + j] * F[a*p1 + j];
+            G[a*p1 + k] = s;
+          }
+        for ( unsigned int z = 0u; z < p1; ++z )             /* x */
+          for ( unsigned int k = 0u; k < p1; ++k )
+            for ( unsigned int y = 0u; y < p1; ++y ) {
+              double s = 0.0;
+              for ( unsigned int j = 0u; j < p1; ++j )
+                s += C[k*p1 + j] * G[(z*p1 + j)*p1 + y];
+              F[(z*p1 + k)*p1 + y] = s;
+            }
+        for ( unsigned int k = 0u; k < p1; ++k )             /* z */
+          for ( unsigned int xy = 0u; xy < p1*p1; ++xy ) {
+            double s = 0.0;
+            for ( unsigned int j = 0u; j < p1; ++j )
+              s += C[k*p1 + j] * F[j*p1*p1 + xy];
+            H[k*p1*p1 + xy] = s;
+          }
+      }
+    }
+
+    /** Whether the expansions of block b meet the tolerances at a 5x5x5 grid
+     * of check points (including the faces of the block). */
+    template < typename Source >
+    bool blockError( const std::vector<double> & c,
+                     const Source & src,
+                     const int & b,
+                     const unsigned int & p,
+                     const double & vector_tol,
+                     const double & scalar_tol ) const {
+      const unsigned int p1 = p + 1u, n = p1*p1*p1;
+      Vector<double,3> lo, len;
+      blockGeometry( b, lo, len );
+
+      double T[3][MAX_ORDER + 1u];
+      for ( unsigned int cz = 0u; cz < 5u; ++cz )
+        for ( unsigned int cx = 0u; cx < 5u; ++cx )
+          for ( unsigned int cy = 0u; cy < 5u; ++cy ) {
+            const double u[3] = { 0.5*cx - 1.0, 0.5*cy - 1.0, 0.5*cz - 1.0 };
+            for ( unsigned int d = 0u; d < 3u; ++d ) {
+              T[d][0] = 1.0;
+              T[d][1] = u[d];
+              for ( unsigned int k = 2u; k <= p; ++k )
+                T[d][k] = 2.0 * u[d] * T[d][k-1] - T[d][k-2];
+            }
+
+            const Vector<double,3> r = local( lo, len, u[0], u[1], u[2] );
+            const ForceRecord<L,N> rec = src.getRecord(r);
+            for ( unsigned int i = 0u; i < N; ++i ) {
+              const double * ci = &c[0] + i * (L + 1u) * n;
+              for ( unsigned int l = 0u; l < L; ++l )
+                if ( std::abs( sum(ci + l*n, T, p1) - rec.vector(i)[l] )
+                     > vector_tol )
+                  return false;
+              if ( std::abs( sum(ci + L*n, T, p1) - rec.scalar(i) )
+                   > scalar_tol )
+                return false;
+            }
+          }
+      return true;
+    }
+  };
+
+  template < unsigned int L, unsigned int N >
+  const unsigned int ChebyshevFieldLookup<L,N>::MAX_ORDER;
+
+}/* namespace fields */
+
+#endif // fields_chebyshev_lookup_h
@@ -38,6 +38,9 @@
 
 
 #include <fields/indices.h>
+#include <fields/GridAxis.h>
+#include <fields/detail/table-io.h>
+#include <fields/detail/npy.h>
 
 #include <xylose/except.h>
 #include <xylose/Vector.h>
@@ -51,13 +54,230 @@
 namespace fields {
   using namespace indices;
   using xylose::Vector;
+  using xylose::V3;
+
+  /** Format of the data-blocks of a field file. */
+  enum FileFormat {
+    /** One text record per line (default). */
+    TEXT_FILE = 0,
+    /** Raw records, which are faster to read and allow regions of interest
+     * to be read without reading the whole file.  Binary files are not
+     * portable between architectures. */
+    BINARY_FILE = 1,
+    /** The file holds only the header;  the data-blocks are written as NumPy
+     * arrays to <file>.core.npy and <file>.shell.npy (with the shape
+     * (Nz,Nx,Ny,sizeof(Record)/sizeof(double))).  Tables that are read whole
+     * are mapped from these files without copying.  Only available when
+     * writing to a named file. */
+    NPY_FILE = 2
+  };
+
+  /** A grid point of a table being written, together with the spacing of
+   * the grid.  The table writers ask the source for the records of the grid
+   * points through getRecord(GridPoint).  Since a GridPoint is a
+   * Vector<double,3>, sources usually need only getRecord(Vector<double,3>);
+   * sources whose records depend on the grid spacing overload getRecord for
+   * GridPoint (@see HermiteTableWrapper).
+   */
+  struct GridPoint : Vector<double,3> {
+    GridPoint( const Vector<double,3> & r, const Vector<double,3> & dx )
+      : Vector<double,3>(r), dx(dx) { }
+
+    /** Spacing of the grid. */
+    Vector<double,3> dx;
+  };
 
   template <class FieldTable>
   int spitfieldout(std::ostream & output,
                    const FieldTable & ftable,
                    const Vector<double,3> & xi,
                    const Vector<double,3> & xf,
-                   const Vector<double,3> & dx );
+                   const Vector<double,3> & dx,
+                   const FileFormat & format = TEXT_FILE );
+
+  namespace detail {
+    /** @see fields::spitfieldplanes (the prototype gives the Record type). */
+    template < class FieldTable, class Record >
+    long spitfieldplanes( std::ostream & output,
+                          const FieldTable & ftable,
+                          const Vector<double,3> & xi,
+                          const Vector<int,3> & N,
+                          const Vector<double,3> & dx,
+                          const FileFormat & format,
+                          const Record & ) {
+      std::vector<Record> plane( std::size_t(N[X]) * N[Y] );
+      long n = 0;
+      for ( int k = 0; k < N[Z]; ++k ) {
+        #pragma omp parallel for schedule(dynamic)
+        for ( int i = 0; i < N[X]; ++i )
+          for ( int j = 0; j < N[Y]; ++j )
+            plane[ std::size_t(i)*N[Y] + j ] =
+              ftable.getRecord(
+                GridPoint( xi + V3( i*dx[X], j*dx[Y], k*dx[Z] ), dx ) );
+
+        for ( std::size_t e = 0u; e < plane.size(); ++e, ++n ) {
+          if ( format == BINARY_FILE )
+            writeBinary( output, plane[e] );
+          else
+            output << plane[e] << '\n';
+        }
+
+        if ( format == TEXT_FILE )
+          output << '\n';
+      }
+      return n;
+    }
+  }/* namespace fields::detail */
+
+  /** Write the header of a field file (up to the first data-block).
+   * @param fieldout
+   *     The place to store this all.
+   * @param r0
+   *     The reference point (usually the center of the CORE table).
+   * @param Nc
+   *     Number of CORE grid points along each axis.
+   * @param dxc
+   *     The core stepsize.
+   * @param X_MINc
+   *     The core minima.
+   * @param X_MAXc
+   *     The core maxima.
+   * @param Ns
+   *     Number of SHELL grid points along each axis.
+   * @param dxs
+   *     The shell stepsize.
+   * @param X_MINs
+   *     The shell minima.
+   * @param X_MAXs
+   *     The shell maxima.
+   * @param comments
+   *     A set of lines that begin with '#' each.
+   * @param format
+   *     Format of the data-blocks.
+   * @param record_size
+   *     Size of the records (only used for BINARY_FILE).
+   */
+  inline void writeFieldHeader( std::ostream & fieldout,
+                                const Vector<double,3> & r0,
+                                const Vector<int,3> & Nc,
+                                const Vector<double,3> & dxc,
+                                const Vector<double,3> & X_MINc,
+                                const Vector<double,3> & X_MAXc,
+                                const Vector<int,3> & Ns,
+                                const Vector<double,3> & dxs,
+                                const Vector<double,3> & X_MINs,
+                                const Vector<double,3> & X_MAXs,
+                                const std::string & comments,
+                                const FileFormat & format,
+                                const std::size_t & record_size ) {
+    fieldout << "# center \n"
+                "# " << r0 << "\n"
+                "# CORE : \n"
+                "# " << Nc << '\t'
+                     << dxc << '\t'
+                     << X_MINc << '\t'
+                     << X_MAXc << "\n"
+                "# SHELL : \n"
+                "# " << Ns << '\t'
+                     << dxs << '\t'
+                     << X_MINs << '\t'
+                     << X_MAXs << "\n"
+                "# \n"
+             << comments;
+
+    if ( format == BINARY_FILE )
+      fieldout << detail::binaryMarker() << ' ' << record_size << '\n';
+    else if ( format == TEXT_FILE )
+      fieldout << "# \n";
+    /* (the last comment of NPY_FILE headers names the array files.) */
+  }
+
+  /** Write the data-block of one table, computing the records of each
+   * z-plane in parallel (with OpenMP).  Only one plane of records is held
+   * in memory at a time, so this also works for tables that are larger than
+   * the memory.  The getRecord function of ftable must be thread-safe.  The
+   * layout is the same as that of spitfieldout.
+   * @param output
+   *     The place to store this all.
+   * @param ftable
+   *     The source of field calculation.
+   * @param xi
+   *     The position of the first grid point.
+   * @param N
+   *     Number of grid points along each axis.
+   * @param dx
+   *     The stepsize.
+   * @param format
+   *     Format of the data-block [Default TEXT_FILE].
+   * @return The number of records written.
+   */
+  template <class FieldTable>
+  long spitfieldplanes( std::ostream & output,
+                        const FieldTable & ftable,
+                        const Vector<double,3> & xi,
+                        const Vector<int,3> & N,
+                        const Vector<double,3> & dx,
+                        const FileFormat & format = TEXT_FILE ) {
+    return detail::spitfieldplanes( output, ftable, xi, N, dx, format,
+                                    ftable.getRecord( GridPoint(xi, dx) ) );
+  }
+
+  namespace detail {
+    /** Write the header of an NPY_FILE field file to fieldout and the
+     * data-blocks to the array files next to it (@see createFieldFile).  The
+     * prototype gives the Record type. */
+    template < class FieldTable, class Record >
+    void createNpyFieldFile( const FieldTable & ftable,
+                             const Vector<double,3> & X_MINc,
+                             const Vector<double,3> & X_MAXc,
+                             const Vector<double,3> & dxc,
+                             const Vector<double,3> & X_MINs,
+                             const Vector<double,3> & X_MAXs,
+                             const Vector<double,3> & dxs,
+                             const std::string & filename,
+                             std::ostream & fieldout,
+                             const std::string & comments,
+                             const Record & ) {
+      if ( sizeof(Record) % sizeof(double) != 0u )
+        THROW(std::runtime_error,"createFieldFile:  NPY_FILE needs records "
+                                 "made of doubles");
+
+      Vector<int,3> N[2];
+      N[0] = compDiv( X_MAXc - X_MINc, dxc ) + 1.0;
+      N[1] = compDiv( X_MAXs - X_MINs, dxs ) + 1.0;
+      const Vector<double,3> min[2] = { X_MINc, X_MINs };
+      const Vector<double,3> dx[2]  = { dxc, dxs };
+
+      /* the array files are named relative to the header file. */
+      const std::string::size_type slash = filename.rfind('/');
+      const std::string dir = slash == std::string::npos
+                            ? "" : filename.substr( 0, slash + 1u );
+      const std::string base = filename.substr( dir.length() );
+      const std::string npy[2] = { base + ".core.npy", base + ".shell.npy" };
+
+      writeFieldHeader( fieldout, X_MINc + 0.5*(X_MAXc - X_MINc),
+                        N[0], dxc, X_MINc, X_MAXc,
+                        N[1], dxs, X_MINs, X_MAXs,
+                        comments + npyMarker() + ' ' + npy[0] + ' ' + npy[1]
+                                 + '\n',
+                        NPY_FILE, sizeof(Record) );
+
+      for ( int t = 0; t < 2; ++t ) {
+        std::ofstream out( (dir + npy[t]).c_str(),
+                           std::ios::out | std::ios::binary );
+        std::vector<std::size_t> shape(4);
+        shape[0] = N[t][Z];
+        shape[1] = N[t][X];
+        shape[2] = N[t][Y];
+        shape[3] = sizeof(Record) / sizeof(double);
+        writeNpyHeader( out, shape );
+        spitfieldplanes( out, ftable, min[t], N[t], dx[t], BINARY_FILE );
+        if ( !out.good() )
+          THROW(std::runtime_error,"createFieldFile:  could not write '" +
+                                   dir + npy[t] + '\'');
+      }
+    }
+  }/* namespace fields::detail */
 
   /** Create the field file from the given parameters.
    * @param ftable
@@ -78,6 +298,10 @@ namespace fields {
    *     The place to store this all.
    * @param comments
    *     A set of lines that begin with '#' each [Default ""].
+   * @param format
+   *     Format of the data-blocks [Default TEXT_FILE].  For BINARY_FILE, the
+   *     stream should be opened in binary mode.  NPY_FILE is not available
+   *     here.
    */
   template <class FieldTable>
   void createFieldFile(const FieldTable & ftable,
@@ -88,7 +312,10 @@ namespace fields {
                   const Vector<double,3> & X_MAXs,
                   const Vector<double,3> & dxs,
                   std::ostream & fieldout,
-                  const std::string & comments = "") {
+                  const std::string & comments = "",
+                  const FileFormat & format = TEXT_FILE) {
+    if ( format == NPY_FILE )
+      THROW(std::runtime_error,"createFieldFile:  NPY_FILE needs a filename");
 
     Vector<double,3> r0(0.0), dlc, dls;
     Vector<int,3> Nc, Ns;
@@ -99,32 +326,25 @@ namespace fields {
     Nc    = compDiv(dlc, dxc) + 1.0;
     Ns    = compDiv(dls, dxs) + 1.0;
 
-    fieldout << "# center \n"
-                "# " << r0 << "\n"
-                "# CORE : \n"
-                "# " << Nc << '\t'
-                     << dxc << '\t'
-                     << X_MINc << '\t'
-                     << X_MAXc << "\n"
-                "# SHELL : \n"
-                "# " << Ns << '\t'
-                     << dxs << '\t'
-                     << X_MINs << '\t'
-                     << X_MAXs << "\n"
-                "# \n"
-             << comments << "# \n";
+    writeFieldHeader( fieldout, r0,
+                      Nc, dxc, X_MINc, X_MAXc,
+                      Ns, dxs, X_MINs, X_MAXs,
+                      comments, format,
+                      detail::recordSize(
+                        ftable.getRecord( GridPoint(X_MINc, dxc) ) ) );
 
 
     try {
       using xylose::to_string;
       /** do core data first */
       int N = 0;
-      if ( (N =spitfieldout(fieldout, ftable, X_MINc, X_MAXc, dxc)) != Nc.prod()) {
+      if ( (N =spitfieldout(fieldout, ftable, X_MINc, X_MAXc, dxc, format)) != Nc.prod()) {
         THROW(std::runtime_error,"wrote out " + to_string(N) + ", should have been " + to_string(Nc.prod()));
       }
-      fieldout << '\n';
+      if ( format == TEXT_FILE )
+        fieldout << '\n';
       /** do shell data second */
-      if ( (N=spitfieldout(fieldout, ftable, X_MINs, X_MAXs, dxs)) != Ns.prod()) {
+      if ( (N=spitfieldout(fieldout, ftable, X_MINs, X_MAXs, dxs, format)) != Ns.prod()) {
         THROW(std::runtime_error,"didn't write out " + to_string(N) + ", should have been " + to_string(Ns.prod()));
       }
     } catch (std::exception & e) {
@@ -152,6 +372,9 @@ namespace fields {
    *     The place to store this all.
    * @param comments
    *     A set of lines that begin with '#' each [Default ""].
+   * @param format
+   *     Format of the data-blocks [Default TEXT_FILE].  For NPY_FILE, the
+   *     array files are written next to filename.
    */
   template <class FieldTable>
   void createFieldFile(const FieldTable & ftable,
@@ -162,15 +385,98 @@ namespace fields {
                   const Vector<double,3> & X_MAXs,
                   const Vector<double,3> & dxs,
                   const std::string & filename,
-                  const std::string & comments = "") {
-    std::ofstream fieldout(filename.c_str());
+                  const std::string & comments = "",
+                  const FileFormat & format = TEXT_FILE) {
+    std::ofstream fieldout(filename.c_str(), std::ios::out | std::ios::binary);
     fieldout.precision(8);
     fieldout << std::scientific;
+    if ( format == NPY_FILE ) {
+      detail::createNpyFieldFile( ftable,
+                                  X_MINc, X_MAXc, dxc,
+                                  X_MINs, X_MAXs, dxs,
+                                  filename, fieldout, comments,
+                                  ftable.getRecord( GridPoint(X_MINc, dxc) ) );
+      return;
+    }
     createFieldFile( ftable,
                      X_MINc, X_MAXc, dxc,
                      X_MINs, X_MAXs, dxs,
                      fieldout,
-                     comments );
+                     comments,
+                     format );
+    fieldout.flush();
+    fieldout.close();
+  }
+
+
+  /** Create the field file for a non-uniform grid.
+   * @param ftable
+   *     The source of field calculation.
+   * @param x
+   *     The grid coordinates along x.
+   * @param y
+   *     The grid coordinates along y.
+   * @param z
+   *     The grid coordinates along z.
+   * @param fieldout
+   *     The place to store this all.
+   * @param comments
+   *     A set of lines that begin with '#' each [Default ""].
+   *
+   * @see NonUniformFieldLookup.
+   */
+  template <class FieldTable>
+  void createFieldFile(const FieldTable & ftable,
+                  const GridAxis & x,
+                  const GridAxis & y,
+                  const GridAxis & z,
+                  std::ostream & fieldout,
+                  const std::string & comments = "") {
+    fieldout << "# GRID : \n"
+                "# " << x << "\n"
+                "# " << y << "\n"
+                "# " << z << "\n"
+                "# \n"
+             << comments << "# \n";
+
+    for (unsigned int k = 0; k < z.size(); ++k) {
+      for (unsigned int i = 0; i < x.size(); ++i) {
+        for (unsigned int j = 0; j < y.size(); ++j) {
+          fieldout << ftable.getRecord(V3(x[i], y[j], z[k])) << '\n';
+        }
+      }
+      fieldout << '\n';
+    }
+  }
+
+
+  /** Create the field file for a non-uniform grid.
+   * @param ftable
+   *     The source of field calculation.
+   * @param x
+   *     The grid coordinates along x.
+   * @param y
+   *     The grid coordinates along y.
+   * @param z
+   *     The grid coordinates along z.
+   * @param filename
+   *     The place to store this all.
+   * @param comments
+   *     A set of lines that begin with '#' each [Default ""].
+   *
+   * @see NonUniformFieldLookup.
+   */
+  template <class FieldTable>
+  void createFieldFile(const FieldTable & ftable,
+                  const GridAxis & x,
+                  const GridAxis & y,
+                  const GridAxis & z,
+                  const std::string & filename,
+                  const std::string & comments = "") {
+    std::ofstream fieldout(filename.c_str());
+    fieldout.precision(8);
+    fieldout << std::scientific;
+    createFieldFile( ftable, x, y, z, fieldout, comments );
     fieldout.flush();
     fieldout.close();
   }
@@ -181,14 +487,19 @@ namespace fields {
                    const FieldTable & ftable,
                    const Vector<double,3> & xi,
                    const Vector<double,3> & xf,
-                   const Vector<double,3> & dx ) {
+                   const Vector<double,3> & dx,
+                   const FileFormat & format ) {
     int Nx = 0, Ny = 0, Nz = 0, N = 0;
     for (Vector<double,3> x = xi; x[Z] <= xf[Z]; x[Z] += dx[Z]) {
         Nx = 0;
         for (x[X] = xi[X]; x[X] <= xf[X]; x[X]+= dx[X]) {
             Ny = 0;
             for (x[Y] = xi[Y]; x[Y] <= xf[Y]; x[Y] += dx[Y]) {
-                output << ftable.getRecord(x) << '\n';
+                if ( format == BINARY_FILE )
+                  detail::writeBinary( output,
+                                       ftable.getRecord( GridPoint(x, dx) ) );
+                else
+                  output << ftable.getRecord( GridPoint(x, dx) ) << '\n';
                 N++;
                 Ny++;
             }
@@ -197,7 +508,8 @@ namespace fields {
         }/*for */
         Nz++;
 
-        output << '\n';
+        if ( format == TEXT_FILE )
+          output << '\n';
     }
     return N;
   }
@@ -0,0 +1,242 @@
+
+#ifndef fields_detail_DTable_h
+#define fields_detail_DTable_h
+
+#include <fields/table-allocation.h>
+#include <fields/detail/table-io.h>
+
+#include <xylose/except.h>
+
+#include <istream>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <new>
+
+#ifdef __linux__
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+namespace fields {
+  namespace detail {
+
+    /** Three dimensional table of records.
+     * The records are stored with y varying fastest, then x, then z (the order
+     * in which createFieldFile writes them).
+     *
+     * The memory of the table can be backed by huge pages and replicated on
+     * each NUMA node (@see setAllocation), or be mapped directly from a file
+     * (@see map).
+     */
+    template < class Record >
+    class DTable {
+    private:
+      /** The (first replica of the) table;  all writes go here. */
+      Record * data;
+
+      /** The replicas of the table (replica[0] == data). */
+      Record * replica[FIELDS_MAX_NUMA_NODES];
+      int nreplicas;
+
+      TableAllocation alloc;
+      std::size_t mapped;
+
+      /** The mapping of a file that holds the table (@see map). */
+      void * file_map;
+      std::size_t file_mapped;
+
+    public:
+      typedef Record value_type;
+      typedef Record & reference;
+      typedef const Record & const_reference;
+
+      inline DTable () : data(NULL), nreplicas(0), alloc(), mapped(0),
+                         file_map(NULL), file_mapped(0),
+                         xlen(0), ylen(0), zlen(0), xlen_times_ylen(0) {}
+
+      /** Set the allocation options (before calling initialize). */
+      inline void setAllocation( const TableAllocation & a ) { alloc = a; }
+
+      /** The allocation options. */
+      inline const TableAllocation & getAllocation() const { return alloc; }
+
+      /** Number of replicas of the table. */
+      inline int replicas() const { return nreplicas; }
+
+      inline void initialize ( const unsigned int & Nx,
+                               const unsigned int & Ny,
+                               const unsigned int & Nz ) {
+        cleanup();
+
+        xlen = Nx;
+        ylen = Ny;
+        zlen = Nz;
+        xlen_times_ylen = Nx*Ny;
+
+        const std::size_t n = std::size_t(xlen)*ylen*zlen;
+        if ( alloc.isDefault() ) {
+          data = new Record[n];
+          nreplicas = 1;
+        } else {
+          const int nr = alloc.numa_replicas ? numaNodes() : 1;
+          std::size_t m = 0u;
+          for ( nreplicas = 0; nreplicas < nr; ++nreplicas ) {
+            try {
+              replica[nreplicas] = static_cast<Record*>(
+                allocTable( n * sizeof(Record), alloc.pages,
+                            alloc.numa_replicas ? nreplicas : -1, m )
+              );
+            } catch (...) {
+              /* release the replicas that were already allocated. */
+              data = nreplicas ? replica[0] : NULL;
+              mapped = m;
+              cleanup();
+              throw;
+            }
+            for ( std::size_t i = 0u; i < n; ++i )
+              new (replica[nreplicas] + i) Record();
+          }
+          mapped = m;
+          data = replica[0];
+        }
+        replica[0] = data;
+      }
+
+      /** Whether tables can be mapped from files on this platform. */
+      static bool canMap() {
+        #ifdef __linux__
+          return true;
+        #else
+          return false;
+        #endif
+      }
+
+      /** Use the records stored in a file as the table, without copying
+       * them.  The file is mapped privately:  the pages are loaded on demand
+       * and shared with the page cache, and writes to the table do not
+       * modify the file.  The file must not be truncated or rewritten while
+       * it is mapped.  The table is not replicated and its allocation options
+       * are ignored.
+       * @param filename
+       *     The file.
+       * @param offset
+       *     Offset of the first record in the file (which must be aligned
+       *     for Record).  The records must be stored in the order of the
+       *     table.
+       */
+      inline void map( const std::string & filename,
+                       const std::size_t & offset,
+                       const unsigned int & Nx,
+                       const unsigned int & Ny,
+                       const unsigned int & Nz ) {
+        cleanup();
+
+        #ifdef __linux__
+          const std::size_t bytes =
+            offset + std::size_t(Nx)*Ny*Nz * sizeof(Record);
+          const int fd = open( filename.c_str(), O_RDONLY );
+          if ( fd < 0 )
+            THROW(std::runtime_error,"DTable::map:  could not open '" +
+                                     filename + '\'');
+          struct stat st;
+          if ( fstat( fd, &st ) != 0 || std::size_t(st.st_size) < bytes ) {
+            close( fd );
+            THROW(std::runtime_error,"DTable::map:  '" + filename +
+                                     "' is too short");
+          }
+          void * p = mmap( NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                           fd, 0 );
+          close( fd );
+          if ( p == MAP_FAILED )
+            THROW(std::runtime_error,"DTable::map:  could not map '" +
+                                     filename + '\'');
+
+          file_map = p;
+          file_mapped = bytes;
+          data = reinterpret_cast<Record*>( static_cast<char*>(p) + offset );
+          replica[0] = data;
+          nreplicas = 1;
+
+          xlen = Nx;
+          ylen = Ny;
+          zlen = Nz;
+          xlen_times_ylen = Nx*Ny;
+        #else
+          THROW(std::runtime_error,"DTable::map:  not supported");
+        #endif
+      }
+
+      /** Whether the table is mapped from a file. */
+      inline bool isMapped() const { return file_map != NULL; }
+
+      inline void cleanup () {
+        #ifdef __linux__
+          if ( file_map ) {
+            munmap( file_map, file_mapped );
+            file_map = NULL;
+            file_mapped = 0;
+            data = NULL;
+          }
+        #endif
+
+        if (data) {
+          if ( mapped ) {
+            const std::size_t n = std::size_t(xlen)*ylen*zlen;
+            for ( int r = 0; r < nreplicas; ++r ) {
+              for ( std::size_t i = 0u; i < n; ++i )
+                replica[r][i].~Record();
+              freeTable( replica[r], mapped );
+            }
+            mapped = 0;
+          } else
+            delete[] data;
+          data = NULL;
+        }
+
+        nreplicas = 0;
+        xlen = ylen = zlen = xlen_times_ylen = 0;
+      }
+
+      /** Copy the table to all of the other NUMA replicas.  This must be
+       * called after records are written directly into a replicated table
+       * (readindata does so itself). */
+      inline void sync() {
+        const std::size_t n = std::size_t(xlen)*ylen*zlen;
+        for ( int r = 1; r < nreplicas; ++r )
+          std::copy( data, data + n, replica[r] );
+      }
+
+      inline ~DTable () {
+        cleanup();
+      }
+
+      inline std::istream & readindata(std::istream & in) {
+        readTextTable( *this, in );
+        sync();
+        return in;
+      }
+
+      inline const_reference operator()( const unsigned int & xi,
+                                         const unsigned int & yi,
+                                         const unsigned int & zi ) const {
+        const Record * d =
+          nreplicas > 1 ? replica[ numaNode() % nreplicas ] : data;
+        return d[zi*(xlen_times_ylen) + xi*ylen + yi];
+      }
+
+      inline reference operator()( const unsigned int & xi,
+                                   const unsigned int & yi,
+                                   const unsigned int & zi ) {
+        return data[zi*(xlen_times_ylen) + xi*ylen + yi];
+      }
+
+      unsigned int xlen, ylen, zlen, xlen_times_ylen;
+    };
+
+  }/* namespace fields::detail */
+}/* namespace fields */
+
+#endif // fields_detail_DTable_h
@@ -0,0 +1,255 @@
+#ifndef fields_detail_LazyTable_h
+#define fields_detail_LazyTable_h
+
+#include <fields/detail/DTable.h>
+
+#include <xylose/Vector.h>
+
+#include <boost/atomic.hpp>
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+#ifdef __linux__
+#  include <sched.h>
+#endif
+
+#include <istream>
+#include <algorithm>
+
+namespace fields {
+  namespace detail {
+    using xylose::Vector;
+
+    /** Three dimensional table of records that are computed on demand.
+     * The table is divided into cubic bricks of 2^brick_bits nodes along each
+     * axis.  The first access to any node of a brick computes all of the
+     * records of the brick from the source (Source::getRecord).
+     *
+     * Each brick has a state flag (EMPTY, CLAIMED, READY).  The thread that
+     * moves a brick from EMPTY to CLAIMED (by compare-and-swap) computes it
+     * and publishes it by setting READY (with release semantics); any other
+     * thread that needs the brick meanwhile waits for READY.  A brick is
+     * therefore never computed twice and, once READY, reads cost only one
+     * extra (acquire) load of the flag.
+     *
+     * @param Record
+     *     The type of record stored at each grid point.
+     * @param Source
+     *     Provides Record getRecord(const Vector<double,3> & r) const.
+     * @param brick_bits
+     *     log2 of the brick size [Default 3, i.e. 8x8x8 nodes].
+     */
+    template < class Record, class Source, unsigned int brick_bits = 3u >
+    class LazyTable {
+      /* TYPEDEFS */
+    public:
+      typedef Record value_type;
+      typedef Record & reference;
+      typedef const Record & const_reference;
+
+      /** State of a brick. */
+      enum BrickState {
+        EMPTY = 0,
+        CLAIMED = 1,
+        READY = 2
+      };
+
+    private:
+      typedef boost::atomic<unsigned char> Flag;
+
+      /* MEMBER STORAGE */
+    private:
+      DTable<Record> data;
+      Flag * state;
+      unsigned int nbx, nby, nbz;
+
+      const Source * src;
+      Vector<double,3> min;
+      Vector<double,3> dx;
+
+    public:
+      unsigned int xlen, ylen, zlen, xlen_times_ylen;
+
+      /* MEMBER FUNCTIONS */
+    public:
+      LazyTable() : state(NULL), nbx(0u), nby(0u), nbz(0u), src(NULL),
+                    min(0.0), dx(0.0),
+                    xlen(0u), ylen(0u), zlen(0u), xlen_times_ylen(0u) {}
+
+      ~LazyTable() { cleanup(); }
+
+      /** Allocate an (empty) table.  The table is unbound from its source
+       * (@see bind); an unbound table behaves like DTable. */
+      void initialize( const unsigned int & Nx,
+                       const unsigned int & Ny,
+                       const unsigned int & Nz ) {
+        cleanup();
+        src = NULL;
+        data.initialize(Nx, Ny, Nz);
+        xlen = Nx;
+        ylen = Ny;
+        zlen = Nz;
+        xlen_times_ylen = Nx*Ny;
+
+        const unsigned int B = 1u << brick_bits;
+        nbx = (Nx + B - 1u) >> brick_bits;
+        nby = (Ny + B - 1u) >> brick_bits;
+        nbz = (Nz + B - 1u) >> brick_bits;
+        state = new Flag[nbricks()];
+        clear();
+      }
+
+      void cleanup() {
+        data.cleanup();
+        delete[] state;
+        state = NULL;
+        nbx = nby = nbz = 0u;
+        xlen = ylen = zlen = xlen_times_ylen = 0u;
+      }
+
+      /** Set the source of the records and the position of the grid.
+       * @param source
+       *     The source (which must outlive this table).
+       * @param _min
+       *     Position of node (0,0,0).
+       * @param _dx
+       *     Spacing of the nodes.
+       */
+      void bind( const Source & source,
+                 const Vector<double,3> & _min,
+                 const Vector<double,3> & _dx ) {
+        src = &source;
+        min = _min;
+        dx = _dx;
+      }
+
+      /** Forget all computed bricks.  This must not be called while other
+       * threads are using the table. */
+      void clear() {
+        for ( unsigned int b = 0u; b < nbricks(); ++b )
+          state[b].store( EMPTY, boost::memory_order_relaxed );
+        boost::atomic_thread_fence( boost::memory_order_release );
+      }
+
+      /** Total number of bricks. */
+      unsigned int nbricks() const { return nbx * nby * nbz; }
+
+      /** Number of bricks that have been computed. */
+      unsigned int nready() const {
+        unsigned int n = 0u;
+        for ( unsigned int b = 0u; b < nbricks(); ++b )
+          n += ( state[b].load( boost::memory_order_acquire ) == READY );
+        return n;
+      }
+
+      /** Nothing to do since the table is not replicated (@see
+       * DTable::sync). */
+      void sync() { }
+
+      /** Read the whole table from a text data-block (which makes all bricks
+       * READY). */
+      std::istream & readindata( std::istream & in ) {
+        data.readindata(in);
+        for ( unsigned int b = 0u; b < nbricks(); ++b )
+          state[b].store( READY, boost::memory_order_release );
+        return in;
+      }
+
+      inline const_reference operator()( const unsigned int & xi,
+                                         const unsigned int & yi,
+                                         const unsigned int & zi ) const {
+        ensure( xi, yi, zi );
+        return data(xi,yi,zi);
+      }
+
+      /** Writable access to a node.  The node is computed first (if
+       * necessary) so that the written value is not overwritten later. */
+      inline reference operator()( const unsigned int & xi,
+                                   const unsigned int & yi,
+                                   const unsigned int & zi ) {
+        ensure( xi, yi, zi );
+        return data(xi,yi,zi);
+      }
+
+    private:
+      /* not copyable. */
+      LazyTable( const LazyTable & );
+      LazyTable & operator= ( const LazyTable & );
+
+      /** Make sure that the brick of the node is computed. */
+      inline void ensure( const unsigned int & xi,
+                          const unsigned int & yi,
+                          const unsigned int & zi ) const {
+        if ( !src )
+          return;
+        const unsigned int b = ( (zi >> brick_bits) * nbx
+                               + (xi >> brick_bits) ) * nby
+                             + (yi >> brick_bits);
+        if ( state[b].load( boost::memory_order_acquire ) != READY )
+          fill( b );
+      }
+
+      /** Wait a little while another thread computes a brick:  spin
+       * briefly (computing a brick takes a while, but the lookups of the
+       * waiting thread are stalled anyway) and then give up the CPU so that
+       * the computing thread is not starved on an oversubscribed machine. */
+      static void backoff( const unsigned int & spins ) {
+        if ( spins < 64u ) {
+          #if defined(__SSE2__)
+            _mm_pause();
+          #endif
+        } else {
+          #ifdef __linux__
+            sched_yield();
+          #endif
+        }
+      }
+
+      /** Compute brick b (or wait for another thread to compute it). */
+      void fill( const unsigned int & b ) const {
+        for ( unsigned int spins = 0u; ; ++spins ) {
+          unsigned char s = state[b].load( boost::memory_order_acquire );
+          if ( s == READY )
+            return;
+          /* if another thread has claimed the brick, wait for it (it is
+           * released back to EMPTY if its computation fails). */
+          if ( s == EMPTY ) {
+            if ( state[b].compare_exchange_weak( s, CLAIMED,
+                                                 boost::memory_order_acq_rel ) )
+              break;
+          } else
+            backoff( spins );
+        }
+
+        const unsigned int by = b % nby;
+        const unsigned int bx = (b / nby) % nbx;
+        const unsigned int bz = b / (nby * nbx);
+        const unsigned int B = 1u << brick_bits;
+
+        DTable<Record> & d = const_cast< DTable<Record> & >(data);
+        try {
+          for ( unsigned int k = bz*B; k < std::min(zlen, (bz+1u)*B); ++k )
+            for ( unsigned int i = bx*B; i < std::min(xlen, (bx+1u)*B); ++i )
+              for ( unsigned int j = by*B; j < std::min(ylen, (by+1u)*B); ++j ) {
+                Vector<double,3> r = min;
+                r[0] += i * dx[0];
+                r[1] += j * dx[1];
+                r[2] += k * dx[2];
+                d(i,j,k) = src->getRecord(r);
+              }
+        } catch (...) {
+          /* let the next thread try again. */
+          state[b].store( EMPTY, boost::memory_order_release );
+          throw;
+        }
+
+        state[b].store( READY, boost::memory_order_release );
+      }
+    };
+
+  }/* namespace fields::detail */
+}/* namespace fields */
+
+#endif // fields_detail_LazyTable_h
@@ -0,0 +1,339 @@
+
+#ifndef fields_detail_npy_h
+#define fields_detail_npy_h
+
+#include <fields/detail/DTable.h>
+
+#include <xylose/Vector.h>
+#include <xylose/except.h>
+#include <xylose/strutil.h>
+
+#include <vector>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+namespace fields {
+  namespace detail {
+    using xylose::Vector;
+
+    /** Marker of a field-file header whose data-blocks are stored in NumPy
+     * (.npy) files.  The marker is followed by the names of the CORE and
+     * SHELL array files (relative to the directory of the header file). */
+    inline const char * npyMarker() { return "# NPY"; }
+
+    /** Whether this machine is little-endian. */
+    inline bool littleEndian() {
+      const unsigned short one = 1u;
+      return *reinterpret_cast<const unsigned char*>(&one) == 1u;
+    }
+
+    /** NumPy type descriptor of native doubles. */
+    inline std::string npyDoubleDescr() {
+      return littleEndian() ? "<f8" : ">f8";
+    }
+
+    /** NumPy type descriptor of native floats. */
+    inline std::string npyFloatDescr() {
+      return littleEndian() ? "<f4" : ">f4";
+    }
+
+    /** Header of a NumPy array file. */
+    struct NpyHeader {
+      NpyHeader() : fortran_order(false), offset(0u) { }
+
+      /** Type descriptor (e.g. "<f8"). */
+      std::string descr;
+      /** Whether the array is stored in column-major order. */
+      bool fortran_order;
+      /** Dimensions of the array. */
+      std::vector<std::size_t> shape;
+      /** Offset of the array data in the file. */
+      std::size_t offset;
+
+      /** Number of elements. */
+      std::size_t size() const {
+        std::size_t n = 1u;
+        for ( std::size_t i = 0u; i < shape.size(); ++i )
+          n *= shape[i];
+        return n;
+      }
+
+      /** Whether the data has the layout of a table of records of K native
+       * doubles with dimensions N (z slowest, then x, then y). */
+      bool isTable( const Vector<int,3> & N, const std::size_t & K ) const {
+        return shape.size() == 4u &&
+               shape[0] == std::size_t(N[2]) &&
+               shape[1] == std::size_t(N[0]) &&
+               shape[2] == std::size_t(N[1]) &&
+               shape[3] == K;
+      }
+
+      /** Whether the data can be used without conversion. */
+      bool isNative() const {
+        return !fortran_order && descr == npyDoubleDescr();
+      }
+    };
+
+    /** Write the header (format version 1.0) of an array of doubles (or of
+     * the given type).  The array data must follow immediately, in row-major
+     * order.  The header is padded such that the data is 64-byte aligned. */
+    inline void writeNpyHeader( std::ostream & out,
+                                const std::vector<std::size_t> & shape,
+                                const std::string & descr = npyDoubleDescr() ) {
+      std::ostringstream dict;
+      dict << "{'descr': '" << descr << "', "
+              "'fortran_order': False, 'shape': (";
+      for ( std::size_t i = 0u; i < shape.size(); ++i )
+        dict << shape[i] << ( shape.size() == 1u || i + 1u < shape.size()
+                              ? "," : "" )
+             << ( i + 1u < shape.size() ? " " : "" );
+      dict << "), }";
+
+      std::string h = dict.str();
+      const std::size_t preamble = 10u; /* magic, version, length */
+      h.append( 63u - (preamble + h.size()) % 64u, ' ' );
+      h += '\n';
+
+      const unsigned short len = h.size();
+      const char magic[8] = { '\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0 };
+      out.write( magic, sizeof(magic) );
+      out.put( char(len & 0xff) );
+      out.put( char(len >> 8) );
+      out << h;
+    }
+
+    /** Read the header of an array file (format version 1, 2, or 3).  The
+     * stream is left at the beginning of the array data. */
+    inline void readNpyHeader( std::istream & in, NpyHeader & h ) {
+      unsigned char pre[8];
+      in.read( reinterpret_cast<char*>(pre), sizeof(pre) );
+      if ( !in || std::memcmp( pre, "\x93NUMPY", 6 ) != 0 )
+        THROW(std::runtime_error,"npy:  not a NumPy array file");
+
+      const unsigned int nlen = pre[6] == 1u ? 2u : 4u;
+      unsigned char l[4] = { 0u, 0u, 0u, 0u };
+      in.read( reinterpret_cast<char*>(l), nlen );
+      const std::size_t len = l[0] | (l[1] << 8) | (l[2] << 16)
+                            | (std::size_t(l[3]) << 24);
+      std::string dict( len, ' ' );
+      in.read( &dict[0], len );
+      if ( !in )
+        THROW(std::runtime_error,"npy:  truncated header");
+      h.offset = 6u + 2u + nlen + len;
+
+      /* the header is a python dict literal (as written by numpy). */
+      std::string::size_type p = dict.find("'descr'");
+      std::string::size_type q;
+      if ( p == std::string::npos ||
+           (p = dict.find( '\'', p + 7u )) == std::string::npos ||
+           (q = dict.find( '\'', p + 1u )) == std::string::npos )
+        THROW(std::runtime_error,"npy:  missing descr");
+      h.descr = dict.substr( p + 1u, q - p - 1u );
+
+      p = dict.find("'fortran_order'");
+      if ( p == std::string::npos )
+        THROW(std::runtime_error,"npy:  missing fortran_order");
+      h.fortran_order = dict.find( "True", p ) < dict.find( ',', p );
+
+      p = dict.find("'shape'");
+      if ( p == std::string::npos ||
+           (p = dict.find( '(', p )) == std::string::npos ||
+           (q = dict.find( ')', p )) == std::string::npos )
+        THROW(std::runtime_error,"npy:  missing shape");
+      std::string dims = dict.substr( p + 1u, q - p - 1u );
+      std::replace( dims.begin(), dims.end(), ',', ' ' );
+      std::istringstream ds( dims );
+      h.shape.clear();
+      for ( std::size_t n; ds >> n; )
+        h.shape.push_back(n);
+    }
+
+    /** Size (in bytes) of the elements of an array of doubles or floats. */
+    inline std::size_t npyElementSize( const NpyHeader & h ) {
+      const std::string type = h.descr.size() > 1u ? h.descr.substr(1) : "";
+      if ( type != "f8" && type != "f4" )
+        THROW(std::runtime_error,"npy:  unsupported dtype '" + h.descr + '\'');
+      return type == "f8" ? 8u : 4u;
+    }
+
+    /** Read n consecutive elements of the array data into v as native
+     * doubles.  The elements are read into v as they are stored and then
+     * converted in place (from single precision or the other byte order).
+     */
+    inline void readNpyElements( std::istream & in,
+                                 const NpyHeader & h,
+                                 double * v,
+                                 const std::size_t & n ) {
+      const std::size_t size = npyElementSize( h );
+      const char order = h.descr[0];
+      const bool swap = ( order == '<' && !littleEndian() ) ||
+                        ( order == '>' &&  littleEndian() );
+
+      char * raw = reinterpret_cast<char*>(v);
+      if ( n )
+        in.read( raw, n * size );
+      if ( !in )
+        THROW(std::runtime_error,"npy:  truncated array data");
+
+      if ( size == 8u ) {
+        if ( swap )
+          for ( std::size_t i = 0u; i < n; ++i )
+            std::reverse( raw + 8u*i, raw + 8u*(i+1u) );
+      } else {
+        /* back to front, since each double overwrites the floats at and
+         * after its own index. */
+        for ( std::size_t i = n; i-- > 0u; ) {
+          char * e = raw + 4u*i;
+          if ( swap )
+            std::reverse( e, e + 4u );
+          float f;
+          std::memcpy( &f, e, 4u );
+          v[i] = f;
+        }
+      }
+    }
+
+    /** Read the array data as native doubles in row-major order (converting
+     * from single precision, the other byte order, or column-major order as
+     * needed).  The stream must be at the beginning of the array data. */
+    inline void readNpyDoubles( std::istream & in,
+                                const NpyHeader & h,
+                                std::vector<double> & v ) {
+      const std::size_t n = h.size();
+      if ( !h.fortran_order ) {
+        v.resize( n );
+        if ( n )
+          readNpyElements( in, h, &v[0], n );
+        return;
+      }
+
+      std::vector<double> flat( n );
+      if ( n )
+        readNpyElements( in, h, &flat[0], n );
+
+      /* transpose from column-major to row-major order. */
+      const std::size_t nd = h.shape.size();
+      v.resize( n );
+      std::vector<std::size_t> idx( nd, 0u );
+      for ( std::size_t c = 0u; c < n; ++c ) {
+        std::size_t f = 0u;
+        for ( std::size_t d = nd; d-- > 0u; )
+          f = f * h.shape[d] + idx[d];
+        v[c] = flat[f];
+
+        /* next row-major index. */
+        for ( std::size_t d = nd; d-- > 0u; ) {
+          if ( ++idx[d] < h.shape[d] )
+            break;
+          idx[d] = 0u;
+        }
+      }
+    }
+
+    /** Copy the records of a (sub-volume of a) table from row-major array
+     * data of K doubles per record.
+     * @see readTextTable for a description of the parameters.
+     */
+    template < class Table >
+    void copyNpyTable( Table & t,
+                       const std::vector<double> & v,
+                       const Vector<int,3> & N,
+                       const Vector<int,3> & first,
+                       const Vector<int,3> & stride ) {
+      typedef typename Table::value_type Record;
+      const std::size_t K = sizeof(Record) / sizeof(double);
+      Record rec;
+      for ( unsigned int kk = 0u; kk < t.zlen; ++kk ) {
+        const std::size_t k = first[2] + kk * stride[2];
+        for ( unsigned int ii = 0u; ii < t.xlen; ++ii ) {
+          const std::size_t i = first[0] + ii * stride[0];
+          for ( unsigned int jj = 0u; jj < t.ylen; ++jj ) {
+            const std::size_t j = first[1] + jj * stride[1];
+            const std::size_t elt = (k * N[0] + i) * N[1] + j;
+            std::memcpy( static_cast<void*>(&rec), &v[elt*K], sizeof(Record) );
+            t(ii,jj,kk) = rec;
+          }
+        }
+      }
+    }
+
+    /** Read a (sub-volume of a) table from array data that is not stored as
+     * native doubles (@see readNpyDoubles).  Row-major data is read one
+     * z-plane at a time, and only the z-planes of the sub-volume are read
+     * (using seeks).  The stream must be at the beginning of the array data.
+     * @see readTextTable for a description of the parameters.
+     */
+    template < class Table >
+    void readNpyTable( Table & t,
+                       std::istream & in,
+                       const NpyHeader & h,
+                       const Vector<int,3> & N,
+                       const Vector<int,3> & first,
+                       const Vector<int,3> & stride ) {
+      if ( h.fortran_order ) {
+        std::vector<double> v;
+        readNpyDoubles( in, h, v );
+        copyNpyTable( t, v, N, first, stride );
+        return;
+      }
+
+      typedef typename Table::value_type Record;
+      const std::size_t K = sizeof(Record) / sizeof(double);
+      const std::size_t n = std::size_t(N[0]) * N[1] * K;
+      const std::size_t size = npyElementSize( h );
+      const std::streampos base = in.tellg();
+      std::vector<double> plane( n );
+      Record rec;
+      for ( unsigned int kk = 0u; kk < t.zlen; ++kk ) {
+        const std::size_t k = first[2] + kk * stride[2];
+        in.seekg( base + std::streamoff( k * n * size ) );
+        readNpyElements( in, h, &plane[0], n );
+        for ( unsigned int ii = 0u; ii < t.xlen; ++ii ) {
+          const std::size_t i = first[0] + ii * stride[0];
+          for ( unsigned int jj = 0u; jj < t.ylen; ++jj ) {
+            const std::size_t j = first[1] + jj * stride[1];
+            std::memcpy( static_cast<void*>(&rec), &plane[(i * N[1] + j)*K],
+                         sizeof(Record) );
+            t(ii,jj,kk) = rec;
+          }
+        }
+      }
+    }
+
+    /** Whether a table can be mapped directly from a file (@see
+     * DTable::map).  Tables with non-default allocation options are copied
+     * so that the options are honored. */
+    template < class Record >
+    inline bool mappable( const DTable<Record> & t ) {
+      return DTable<Record>::canMap() && t.getAllocation().isDefault();
+    }
+
+    template < class Table >
+    inline bool mappable( const Table & ) { return false; }
+
+    /** Map a table from a file (@see DTable::map). */
+    template < class Record >
+    inline void mapTable( DTable<Record> & t,
+                          const std::string & filename,
+                          const std::size_t & offset,
+                          const Vector<int,3> & N ) {
+      t.map( filename, offset, N[0], N[1], N[2] );
+    }
+
+    template < class Table >
+    inline void mapTable( Table &,
+                          const std::string &,
+                          const std::size_t &,
+                          const Vector<int,3> & ) {
+      THROW(std::runtime_error,"npy:  this table storage cannot be mapped");
+    }
+
+  }/* namespace fields::detail */
+}/* namespace fields */
+
+#endif // fields_detail_npy_h
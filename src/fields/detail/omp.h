@@ -0,0 +1,43 @@
+
+#ifndef fields_detail_omp_h
+#define fields_detail_omp_h
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+namespace fields {
+  namespace detail {
+
+    /** Thread number within the current OpenMP team (0 without OpenMP). */
+    inline int thread_num() {
+      #ifdef _OPENMP
+        return omp_get_thread_num();
+      #else
+        return 0;
+      #endif
+    }
+
+    /** Number of threads in the current OpenMP team (1 without OpenMP). */
+    inline int num_threads() {
+      #ifdef _OPENMP
+        return omp_get_num_threads();
+      #else
+        return 1;
+      #endif
+    }
+
+    /** Maximum number of threads that a parallel region will use (1 without
+     * OpenMP). */
+    inline int max_threads() {
+      #ifdef _OPENMP
+        return omp_get_max_threads();
+      #else
+        return 1;
+      #endif
+    }
+
+  }/* namespace fields::detail */
+}/* namespace fields */
+
+#endif // fields_detail_omp_h
@@ -0,0 +1,26 @@
+#ifndef fields_detail_prefetch_h
+#define fields_detail_prefetch_h
+
+#include <sys/time.h>
+
+namespace fields {
+  namespace detail {
+
+    /** Hint that the memory at p will be read soon. */
+    inline void prefetch( const void * p ) {
+      #if defined(__GNUC__)
+        __builtin_prefetch( p, 0, 3 );
+      #endif
+    }
+
+    /** Wall-clock time in seconds (for calibrating). */
+    inline double wallTime() {
+      struct timeval tv;
+      gettimeofday( &tv, NULL );
+      return tv.tv_sec + 1e-6 * tv.tv_usec;
+    }
+
+  }/* namespace fields::detail */
+}/* namespace fields */
+
+#endif // fields_detail_prefetch_h
@@ -0,0 +1,150 @@
+
+#ifndef fields_detail_table_io_h
+#define fields_detail_table_io_h
+
+#include <xylose/Vector.h>
+#include <xylose/except.h>
+
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+
+namespace fields {
+  namespace detail {
+    using xylose::Vector;
+
+    /** Last line of the header of a binary field file.  The marker is
+     * followed by the size of each record (in bytes) and a newline; the raw
+     * records follow immediately. */
+    inline const char * binaryMarker() { return "# BINARY"; }
+
+    /** Write the raw bytes of a record. */
+    template < class Record >
+    inline std::ostream & writeBinary( std::ostream & output,
+                                       const Record & rec ) {
+      return output.write( reinterpret_cast<const char*>(&rec), sizeof(Record) );
+    }
+
+    /** Size of the given record. */
+    template < class Record >
+    inline std::size_t recordSize( const Record & ) { return sizeof(Record); }
+
+    /** Whether index i (of the full table) is kept when taking every
+     * stride'th index, starting at first, for n indices.  Sets ii to the
+     * index within the sub-table. */
+    inline bool keepIndex( const int & i,
+                           const int & first,
+                           const int & stride,
+                           const unsigned int & n,
+                           unsigned int & ii ) {
+      const int d = i - first;
+      if ( d < 0 || d % stride != 0 )
+        return false;
+      ii = d / stride;
+      return ii < n;
+    }
+
+    /** Read a (sub-volume of a) text data-block into a table.
+     * The full data-block (N[X]*N[Y]*N[Z] records) is always consumed from
+     * the stream, but only the records that belong to the table are parsed.
+     * @param t
+     *     The table.  Its dimensions (xlen, ylen, zlen) must already be set
+     *     to the size of the sub-volume.
+     * @param in
+     *     The stream, positioned at the start of the data-block.
+     * @param N
+     *     The dimensions of the data-block in the stream.
+     * @param first
+     *     Index (in the data-block) of the first element of the sub-volume.
+     * @param stride
+     *     Stride (in the data-block) between elements of the sub-volume.
+     */
+    template < class Table >
+    std::istream & readTextTable( Table & t,
+                                  std::istream & in,
+                                  const Vector<int,3> & N,
+                                  const Vector<int,3> & first,
+                                  const Vector<int,3> & stride ) {
+      typename Table::value_type rec;
+      char line[512] = {0};
+      for (int k = 0; k < N[2]; k++) {
+        unsigned int kk = 0u;
+        const bool keep_k = keepIndex(k, first[2], stride[2], t.zlen, kk);
+        for (int i = 0; i < N[0]; i++) {
+          unsigned int ii = 0u;
+          const bool keep_i = keep_k &&
+                              keepIndex(i, first[0], stride[0], t.xlen, ii);
+          for (int j = 0; j < N[1]; j++) {
+            line[0] = 0x0;
+            while (in.good() && strlen(line) == 0) {
+              in.getline(line,sizeof(line));
+            }
+
+            unsigned int jj = 0u;
+            if ( keep_i && keepIndex(j, first[1], stride[1], t.ylen, jj) ) {
+              std::istringstream ins(line);
+              ins >> rec;
+              t(ii,jj,kk) = rec;
+            }
+          }/* for */
+        }/* for */
+      }/* for */
+
+      return in;
+    }
+
+    /** Read a whole text data-block (of the dimensions of the table) into a
+     * table. */
+    template < class Table >
+    std::istream & readTextTable( Table & t, std::istream & in ) {
+      Vector<int,3> N;
+      N[0] = t.xlen;
+      N[1] = t.ylen;
+      N[2] = t.zlen;
+      return readTextTable( t, in, N, Vector<int,3>(0), Vector<int,3>(1) );
+    }
+
+    /** Read a (sub-volume of a) binary data-block into a table.
+     * Only the rows that intersect the sub-volume are read (using seeks), so
+     * the cost scales with the size of the sub-volume.  Upon return, the
+     * stream is positioned at the end of the data-block.
+     * @see readTextTable for a description of the parameters.
+     */
+    template < class Table >
+    std::istream & readBinaryTable( Table & t,
+                                    std::istream & in,
+                                    const Vector<int,3> & N,
+                                    const Vector<int,3> & first,
+                                    const Vector<int,3> & stride ) {
+      typedef typename Table::value_type Record;
+      const std::streampos base = in.tellg();
+      const std::size_t span = (t.ylen - 1u) * stride[1] + 1u;
+      std::vector<Record> row(span);
+
+      for (unsigned int kk = 0u; kk < t.zlen; ++kk) {
+        const std::size_t k = first[2] + kk * stride[2];
+        for (unsigned int ii = 0u; ii < t.xlen; ++ii) {
+          const std::size_t i = first[0] + ii * stride[0];
+          const std::size_t elt = (k * N[0] + i) * N[1] + first[1];
+          in.seekg( base + std::streamoff(elt * sizeof(Record)) );
+          in.read( reinterpret_cast<char*>(&row[0]), span * sizeof(Record) );
+          if ( !in )
+            THROW(std::runtime_error,"field-lookup::readindata:  truncated binary data");
+          for (unsigned int jj = 0u; jj < t.ylen; ++jj)
+            t(ii,jj,kk) = row[jj * stride[1]];
+        }
+      }
+
+      in.seekg( base + std::streamoff(
+        std::size_t(N[0]) * N[1] * N[2] * sizeof(Record)
+      ) );
+      return in;
+    }
+
+  }/* namespace fields::detail */
+}/* namespace fields */
+
+#endif // fields_detail_table_io_h
@@ -0,0 +1,372 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+
+/** \file
+ * Multi-threaded accuracy check of a lookup table against the source that
+ * it was calculated from.
+ *
+ * The lookup and the source are compared at random (or stratified random)
+ * sample points that cover the SHELL table.  The errors of the acceleration
+ * and of the potential are relative to the largest magnitude of the source
+ * values at all sample points.  They are summarized (maximum, RMS, and
+ * percentiles) separately for the CORE, the SHELL, and the points near the
+ * boundaries (within one cell of the boundary of the table that serves
+ * them), where the lookups are clamped:
+ * <code>
+ *   fields::ErrorMapOptions opts;
+ *   opts.samples = 1000000;
+ *   fields::ErrorMap m = fields::mapErrors( src, lookup, opts );
+ *   std::cout << m << std::endl;
+ *   if ( !m.within( 1e-3, 1e-3 ) )
+ *     return EXIT_FAILURE;
+ * </code>
+ * The sample points depend only on their number and the seed (not on the
+ * number of threads), so runs are reproducible.
+ */
+
+#ifndef fields_error_map_h
+#define fields_error_map_h
+
+#include <fields/field-lookup.h>
+#include <fields/detail/npy.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <vector>
+#include <ostream>
+#include <algorithm>
+#include <cmath>
+
+namespace fields {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace indices;
+
+  /** Regions of a table for which the errors are summarized separately. */
+  enum ErrorRegion {
+    /** Inside the CORE table (away from its boundary). */
+    CORE_REGION = 0,
+    /** Inside the SHELL table, outside of the CORE (away from the
+     * boundaries). */
+    SHELL_REGION = 1,
+    /** Within one cell of the boundary of the CORE (inside of the CORE) or
+     * of the outer boundary of the SHELL. */
+    BOUNDARY_REGION = 2,
+    N_ERROR_REGIONS = 3
+  };
+
+  /** How the sample points are chosen. */
+  enum ErrorSampling {
+    /** Uniformly random points. */
+    RANDOM_SAMPLES,
+    /** One random point in each cell of an m x m x m division of the table
+     * (m^3 <= samples). */
+    STRATIFIED_SAMPLES
+  };
+
+  /** Parameters of mapErrors. */
+  struct ErrorMapOptions {
+    ErrorMapOptions()
+      : samples(100000), sampling(RANDOM_SAMPLES), seed(1u), species(0u),
+        volume(0) { }
+
+    /** Number of sample points. */
+    long samples;
+    /** How the sample points are chosen. */
+    ErrorSampling sampling;
+    /** Seed of the sample points. */
+    unsigned int seed;
+    /** Species passed to accel and potential. */
+    unsigned int species;
+    /** Dimensions of the error volume (none if any is zero).  Each cell of
+     * the volume holds the largest relative errors of the samples in it. */
+    Vector<int,3> volume;
+  };
+
+  /** Summary of the errors in one region. */
+  struct ErrorStats {
+    ErrorStats() : n(0ul), max(0.0), rms(0.0), p50(0.0), p90(0.0), p99(0.0) { }
+
+    /** Number of samples. */
+    unsigned long n;
+    double max, rms, p50, p90, p99;
+  };
+
+  /** Result of mapErrors. */
+  struct ErrorMap {
+    /** Relative errors of the acceleration, per region. */
+    ErrorStats a[N_ERROR_REGIONS];
+    /** Relative errors of the potential, per region. */
+    ErrorStats V[N_ERROR_REGIONS];
+    /** Largest magnitude of the acceleration of the source. */
+    double a_scale;
+    /** Largest magnitude of the potential of the source. */
+    double V_scale;
+    /** Dimensions of the error volume. */
+    Vector<int,3> volume_N;
+    /** Largest relative errors of a and V in each cell of the volume
+     * (z slowest, then x, then y, as the tables). */
+    std::vector<double> volume;
+
+    ErrorMap() : a_scale(0.0), V_scale(0.0), volume_N(0) { }
+
+    /** Whether the largest errors of all regions are within the given
+     * thresholds. */
+    bool within( const double & max_a, const double & max_V ) const {
+      for ( int r = 0; r < N_ERROR_REGIONS; ++r )
+        if ( a[r].max > max_a || V[r].max > max_V )
+          return false;
+      return true;
+    }
+  };
+
+  /** Print a compact summary of the errors. */
+  inline std::ostream & operator<< ( std::ostream & out, const ErrorMap & m ) {
+    const char * names[N_ERROR_REGIONS] = { "CORE    ", "SHELL   ", "BOUNDARY" };
+    const ErrorStats * stats[2] = { m.a, m.V };
+    const char * quantity[2] = { "a", "V" };
+    out << "relative errors (|a| <= " << m.a_scale
+        << ", |V| <= " << m.V_scale << ")\n"
+           "        region  samples  max  rms  p50  p90  p99";
+    for ( int q = 0; q < 2; ++q )
+      for ( int r = 0; r < N_ERROR_REGIONS; ++r ) {
+        const ErrorStats & s = stats[q][r];
+        out << '\n' << quantity[q] << "  " << names[r] << "  " << s.n
+            << "  " << s.max << "  " << s.rms
+            << "  " << s.p50 << "  " << s.p90 << "  " << s.p99;
+      }
+    return out;
+  }
+
+  /** Write the error volume as a NumPy array of shape (Nz,Nx,Ny,2). */
+  inline void writeErrorVolume( std::ostream & out, const ErrorMap & m ) {
+    std::vector<std::size_t> shape;
+    shape.push_back( m.volume_N[Z] );
+    shape.push_back( m.volume_N[X] );
+    shape.push_back( m.volume_N[Y] );
+    shape.push_back( 2u );
+    detail::writeNpyHeader( out, shape );
+    if ( !m.volume.empty() )
+      out.write( reinterpret_cast<const char*>( &m.volume[0] ),
+                 m.volume.size() * sizeof(double) );
+  }
+
+  namespace detail {
+
+    /** Uniform deviate in [0,1) for the given seed and counter (splitmix64),
+     * so that sample points do not depend on the order of evaluation. */
+    inline double hashUniform( const unsigned int & seed,
+                               const unsigned long long & i ) {
+      unsigned long long z = (i + 1ull) * 0x9E3779B97F4A7C15ull
+                           + (0xD1B54A32D192ED03ull * seed);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      z ^= (z >> 31);
+      return (z >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    /** Sample point i within [lo,hi]. */
+    inline Vector<double,3> errorSample( const ErrorMapOptions & opts,
+                                         const int & m,
+                                         const long & i,
+                                         const Vector<double,3> & lo,
+                                         const Vector<double,3> & hi ) {
+      Vector<double,3> f;
+      for ( int d = X; d <= Z; ++d )
+        f[d] = hashUniform( opts.seed, 3ull * i + d );
+      if ( opts.sampling == STRATIFIED_SAMPLES ) {
+        const long cell[3] = { i % m, (i / m) % m, i / (long(m) * m) };
+        for ( int d = X; d <= Z; ++d )
+          f[d] = (cell[d] + f[d]) / m;
+      }
+      return lo + compMult( hi - lo, f );
+    }
+
+    /** Region of a point. */
+    inline ErrorRegion errorRegion( const Vector<double,3> & r,
+                                    const TableGeometry & core,
+                                    const TableGeometry & shell ) {
+      const Vector<double,3> core_hi =
+        core.min + compMult( (core.N - 1).to_type<double>(), core.dx );
+      const Vector<double,3> shell_hi =
+        shell.min + compMult( (shell.N - 1).to_type<double>(), shell.dx );
+
+      bool in_core = true;
+      for ( int d = X; d <= Z; ++d )
+        in_core = in_core && core.min[d] <= r[d] && r[d] <= core_hi[d];
+
+      const TableGeometry & t = in_core ? core : shell;
+      const Vector<double,3> & hi = in_core ? core_hi : shell_hi;
+      for ( int d = X; d <= Z; ++d )
+        if ( r[d] < t.min[d] + t.dx[d] || r[d] > hi[d] - t.dx[d] )
+          return BOUNDARY_REGION;
+      return in_core ? CORE_REGION : SHELL_REGION;
+    }
+
+    /** Summarize the errors of one region (the errors are reordered). */
+    inline ErrorStats errorStats( std::vector<double> & e ) {
+      ErrorStats s;
+      s.n = e.size();
+      if ( e.empty() )
+        return s;
+
+      double sum2 = 0.0;
+      for ( std::size_t i = 0u; i < e.size(); ++i ) {
+        s.max = std::max( s.max, e[i] );
+        sum2 += e[i] * e[i];
+      }
+      s.rms = std::sqrt( sum2 / e.size() );
+
+      const double p[3] = { .50, .90, .99 };
+      double * v[3] = { &s.p50, &s.p90, &s.p99 };
+      for ( int k = 0; k < 3; ++k ) {
+        std::vector<double>::iterator nth =
+          e.begin() + std::size_t( p[k] * (e.size() - 1) );
+        std::nth_element( e.begin(), nth, e.end() );
+        *v[k] = *nth;
+      }
+      return s;
+    }
+
+  }/* namespace fields::detail */
+
+  /** Compare a lookup with its source at sample points that cover the SHELL
+   * table with the given CORE and SHELL geometry.
+   * @param src
+   *     The exact force (with accel(a,r,v,t,dt,species) and
+   *     potential(r,v,t,species)).
+   * @param lookup
+   *     The force to check (e.g. ForceLookup).
+   * @param core
+   *     Geometry of the CORE table.
+   * @param shell
+   *     Geometry of the SHELL table.
+   * @param opts
+   *     Sampling parameters.
+   */
+  template < class Src, class Lookup >
+  ErrorMap mapErrors( const Src & src,
+                      const Lookup & lookup,
+                      const TableGeometry & core,
+                      const TableGeometry & shell,
+                      const ErrorMapOptions & opts = ErrorMapOptions() ) {
+    const Vector<double,3> lo = shell.min,
+                           hi = shell.min + compMult(
+                             (shell.N - 1).to_type<double>(), shell.dx );
+
+    int m = 1;
+    long n = opts.samples;
+    if ( opts.sampling == STRATIFIED_SAMPLES ) {
+      m = int( std::pow( double(n), 1.0 / 3.0 ) + 1e-9 );
+      m = std::max( 1, m );
+      n = long(m) * m * m;
+    }
+
+    /* absolute errors and magnitudes at all samples. */
+    std::vector<double> ea( n ), eV( n ), ma( n ), mV( n );
+    std::vector<char> region( n );
+    #pragma omp parallel for schedule(static)
+    for ( long i = 0; i < n; ++i ) {
+      const Vector<double,3> r = detail::errorSample( opts, m, i, lo, hi );
+      const Vector<double,3> v(0.0);
+      Vector<double,3> a0, a1;
+      src.accel( a0, r, v, 0.0, 0.0, opts.species );
+      lookup.accel( a1, r, v, 0.0, 0.0, opts.species );
+      const double V0 = src.potential( r, v, 0.0, opts.species );
+      const double V1 = lookup.potential( r, v, 0.0, opts.species );
+
+      ea[i] = (a1 - a0).abs();
+      eV[i] = std::abs( V1 - V0 );
+      ma[i] = a0.abs();
+      mV[i] = std::abs( V0 );
+      region[i] = char( detail::errorRegion( r, core, shell ) );
+    }
+
+    ErrorMap result;
+    for ( long i = 0; i < n; ++i ) {
+      result.a_scale = std::max( result.a_scale, ma[i] );
+      result.V_scale = std::max( result.V_scale, mV[i] );
+    }
+    const double sa = result.a_scale > 0.0 ? 1.0 / result.a_scale : 0.0;
+    const double sV = result.V_scale > 0.0 ? 1.0 / result.V_scale : 0.0;
+
+    bool volume = true;
+    for ( int d = X; d <= Z; ++d )
+      volume = volume && opts.volume[d] > 0;
+    if ( volume ) {
+      result.volume_N = opts.volume;
+      result.volume.assign( 2u * std::size_t(opts.volume.prod()), 0.0 );
+    }
+
+    std::vector<double> per_region[2][N_ERROR_REGIONS];
+    for ( long i = 0; i < n; ++i ) {
+      const double a = ea[i] * sa, V = eV[i] * sV;
+      per_region[0][int(region[i])].push_back( a );
+      per_region[1][int(region[i])].push_back( V );
+
+      if ( volume ) {
+        const Vector<double,3> r = detail::errorSample( opts, m, i, lo, hi );
+        Vector<int,3> c;
+        for ( int d = X; d <= Z; ++d )
+          c[d] = std::min( opts.volume[d] - 1,
+                           int( (r[d] - lo[d]) / (hi[d] - lo[d])
+                                * opts.volume[d] ) );
+        double * cell = &result.volume[
+          2u * ( (std::size_t(c[Z]) * opts.volume[X] + c[X])
+                 * opts.volume[Y] + c[Y] ) ];
+        cell[0] = std::max( cell[0], a );
+        cell[1] = std::max( cell[1], V );
+      }
+    }
+
+    for ( int r = 0; r < N_ERROR_REGIONS; ++r ) {
+      result.a[r] = detail::errorStats( per_region[0][r] );
+      result.V[r] = detail::errorStats( per_region[1][r] );
+    }
+    return result;
+  }
+
+  /** Compare a FieldLookup (or ForceLookup) with its source (@see
+   * mapErrors above). */
+  template < class Src, class Lookup >
+  ErrorMap mapErrors( const Src & src,
+                      const Lookup & lookup,
+                      const ErrorMapOptions & opts = ErrorMapOptions() ) {
+    return mapErrors( src, lookup, lookup.geometry( Lookup::CORE ),
+                      lookup.geometry( Lookup::SHELL ), opts );
+  }
+
+}/* namespace fields */
+
+#endif // fields_error_map_h
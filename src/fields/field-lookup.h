@@ -40,6 +40,11 @@
 #define fields_field_lookup_h
 
 #include <fields/indices.h>
+#include <fields/detail/DTable.h>
+#include <fields/detail/table-io.h>
+#include <fields/detail/npy.h>
+#include <fields/detail/prefetch.h>
+#include <fields/lookup-stats.h>
 
 #include <xylose/power.h>
 #include <xylose/Vector.h>
@@ -50,6 +55,8 @@
 #include <string>
 #include <sstream>
 #include <stdexcept>
+#include <limits>
+#include <vector>
 #include <cmath>
 
 namespace fields {
@@ -57,8 +64,46 @@ namespace fields {
 
   using xylose::SquareMatrix;
   using xylose::Vector;
+  using xylose::V3;
   using xylose::SQR;
 
+  namespace detail {
+    /** Spread the 21 least significant bits of v such that there are two
+     * zero bits between each (for building Morton indices). */
+    inline unsigned long long spreadBits3( const unsigned int & v ) {
+      register unsigned long long x = v & 0x1fffffu;
+      x = (x | x << 32) & 0x1f00000000ffffull;
+      x = (x | x << 16) & 0x1f0000ff0000ffull;
+      x = (x | x <<  8) & 0x100f00f00f00f00full;
+      x = (x | x <<  4) & 0x10c30c30c30c30c3ull;
+      x = (x | x <<  2) & 0x1249249249249249ull;
+      return x;
+    }
+  }/* namespace fields::detail */
+
+  /** Grid geometry of a lookup table. */
+  struct TableGeometry {
+    /** Number of grid points along each axis. */
+    Vector<int,3> N;
+    /** Grid spacing. */
+    Vector<double,3> dx;
+    /** Position of the first grid point. */
+    Vector<double,3> min;
+    /** Upper bound of the table (as given in the file header). */
+    Vector<double,3> max;
+
+    TableGeometry() : N(0), dx(0.0), min(0.0), max(0.0) { }
+
+    TableGeometry( const Vector<int,3> & N,
+                   const Vector<double,3> & dx,
+                   const Vector<double,3> & min,
+                   const Vector<double,3> & max )
+      : N(N), dx(dx), min(min), max(max) { }
+
+    /** Number of grid points. */
+    std::size_t size() const { return std::size_t(N[0]) * N[1] * N[2]; }
+  };
+
   /**
    * Field-lookup class.
    * This class loads a table (from flat file created by createFieldFile.h
@@ -66,16 +111,31 @@ namespace fields {
    * The returned values are interpolated using the triangle interpolant
    * described in Jackson's "Electricity and Magnetism" book.  
    *
+   * @param Record
+   *     The type of record stored at each grid point.
+   * @param Table
+   *     The storage of the records [Default detail::DTable<Record>].  Any
+   *     storage that provides the same interface as detail::DTable can be
+   *     used (@see SpeciesMajorTable).  Allocation options (huge pages, NUMA
+   *     replicas) of the default storage can be set through table() before
+   *     reading the data (@see table-allocation.h).
+   *
    * @see createFieldFile.h for routines to help creating the field-lookup table
    * file.
    */
-  template <class Record>
+  template < class Record, class Table = detail::DTable<Record> >
   class FieldLookupBase {
   private:
     std::string fname;
     bool initialized;
 
   public:
+    /** The type of the records of the tables (as stored in files). */
+    typedef Record record_type;
+
+    /** The storage type of the tables. */
+    typedef Table table_type;
+
     /** Default constructor.
      * Does not initialize the lookup table.
      */
@@ -102,6 +162,23 @@ namespace fields {
                      const Vector<double,3> & _shell_dx,
                      const Vector<double,3> & _shell_min,
                      const Vector<double,3> & _shell_max ) {
+      setGeometry( _r0, _core_dx, _core_min, _core_max,
+                   _shell_dx, _shell_min, _shell_max );
+      data[CORE].initialize(core_N[X], core_N[Y], core_N[Z]);
+      #ifndef DISABLE_SHELL_LOOKUP
+        data[SHELL].initialize(shell_N[X], shell_N[Y], shell_N[Z]);
+      #endif
+    }
+
+  private:
+    /** Set the geometry of the tables (without allocating them). */
+    void setGeometry( const Vector<double,3> & _r0,
+                      const Vector<double,3> & _core_dx,
+                      const Vector<double,3> & _core_min,
+                      const Vector<double,3> & _core_max,
+                      const Vector<double,3> & _shell_dx,
+                      const Vector<double,3> & _shell_min,
+                      const Vector<double,3> & _shell_max ) {
       r0 = _r0;
 
       core_dx = _core_dx;
@@ -116,7 +193,6 @@ namespace fields {
 
       core_dx_inv  = 1.0; core_dx_inv .compDiv(core_dx);
       core_L_2 = 0.5*compMult((core_N-1).to_type<double>(), core_dx);
-      data[CORE].initialize(core_N[X], core_N[Y], core_N[Z]);
 
 
       #ifndef DISABLE_SHELL_LOOKUP
@@ -132,12 +208,35 @@ namespace fields {
         }
 
         shell_dx_inv = 1.0; shell_dx_inv.compDiv(shell_dx);
-        data[SHELL].initialize(shell_N[X], shell_N[Y], shell_N[Z]);
       #endif
     }
 
+  public:
     const bool & isInitialized() const { return initialized; }
 
+    /** The reference point of the tables (the center of the CORE table for
+     * files written by createFieldFile). */
+    const Vector<double,3> & origin() const { return r0; }
+
+    /** Lookup statistics merged over all threads.  All counts are zero
+     * unless FIELDS_LOOKUP_STATS is defined (@see lookup-stats.h).
+     * Lookups that hit the cell cached by a FieldLookup::LookupContext do
+     * not compute table indices and are not counted. */
+    LookupStats stats() const {
+      #ifdef FIELDS_LOOKUP_STATS
+        return counters.stats();
+      #else
+        return LookupStats();
+      #endif
+    }
+
+    /** Reset the lookup statistics. */
+    void resetStats() {
+      #ifdef FIELDS_LOOKUP_STATS
+        counters.reset();
+      #endif
+    }
+
     /** this function will allow the user to change the field-file then
      * request a re-read mid-stream.  This is meant to be useful as a trigger
      * point inside a debugger if necessary. */
@@ -147,67 +246,7 @@ namespace fields {
 
   protected:
 
-    class DTable {
-    private:
-      Record * data;
-
-    public:
-      inline DTable () : data(NULL), xlen(0), ylen(0),
-                         zlen(0), xlen_times_ylen(0) {}
-
-      inline void initialize ( const unsigned int & Nx,
-                               const unsigned int & Ny,
-                               const unsigned int & Nz ) {
-        cleanup();
-
-        xlen = Nx;
-        ylen = Ny;
-        zlen = Nz;
-        xlen_times_ylen = Nx*Ny;
-
-        data = new Record[xlen*ylen*zlen];
-      }
-
-      inline void cleanup () {
-        if (data) {
-          delete[] data;
-          data = NULL;
-        }
-
-        xlen = ylen = zlen = xlen_times_ylen = 0;
-      }
-
-      inline ~DTable () {
-        cleanup();
-      }
-
-      inline std::istream & readindata(std::istream & in) {
-        unsigned int elt = 0;
-        char line[512] = {0};
-        for (unsigned int i = 0; i < zlen; i++) {
-          for (unsigned int j = 0; j < xlen; j++) {
-            for (unsigned int k = 0; k < ylen; k++, elt++) {
-              line[0] = 0x0;
-              while (in.good() && strlen(line) == 0) {
-                in.getline(line,sizeof(line));
-              }
-              std::istringstream ins(line);
-              ins >> data[elt];
-            }/* for */
-          }/* for */
-        }/* for */
-
-        return in;
-      }
-
-      inline const Record & operator()( const unsigned int & xi,
-                                        const unsigned int & yi,
-                                        const unsigned int & zi ) const {
-        return data[zi*(xlen_times_ylen) + xi*ylen + yi];
-      }
-
-      unsigned int xlen, ylen, zlen, xlen_times_ylen;
-    };
+    typedef Table DTable;
 
     /* two x,y,z tables:  core data and outlying data. */
     DTable data[2];
@@ -227,6 +266,10 @@ namespace fields {
     Vector<double,3> shell_min;
     Vector<double,3> shell_max;
 
+    #ifdef FIELDS_LOOKUP_STATS
+      /** Per-thread lookup statistics. */
+      mutable detail::LookupCounters counters;
+    #endif
 
   public:
 
@@ -240,8 +283,48 @@ namespace fields {
       SHELL = 1
     };
 
+    /** Access to the storage of one of the tables.  This is useful, for
+     * example, to set storage options before reading in the data. */
+    DTable & table( const DSECT & t ) { return data[t]; }
+
+    /** Access to the storage of one of the tables. */
+    const DTable & table( const DSECT & t ) const { return data[t]; }
+
+    /** Grid geometry of one of the tables. */
+    TableGeometry geometry( const DSECT & t ) const {
+      return t == CORE ? TableGeometry( core_N, core_dx, core_min, core_max )
+                       : TableGeometry( shell_N, shell_dx, shell_min, shell_max );
+    }
+
     /** only supposed to be called once, upon class initialization. */
     void readindata(const std::string & filename = "") {
+      readindata( filename, fullRegionMin(), fullRegionMax(), Vector<int,3>(1) );
+    }
+
+    /** Read in a region of interest from a file.
+     * Only the part of each table that covers the axis-aligned box
+     * [roi_min, roi_max] (in table coordinates) is kept, optionally taking
+     * only every stride'th grid point along each axis.  The geometry of each
+     * table (min, max, dx, N) is adjusted to that of the loaded sub-volume.
+     * If r0 is the center of the CORE table (as written by createFieldFile),
+     * it is moved to the center of the loaded CORE sub-table.
+     *
+     * For binary files (@see createFieldFile), only the rows of the file that
+     * intersect the region are read.
+     *
+     * @param filename
+     *     File to read [Default: previous filename].
+     * @param roi_min
+     *     Lower corner of the region.
+     * @param roi_max
+     *     Upper corner of the region.
+     * @param stride
+     *     Decimation stride along each axis [Default: 1].
+     */
+    void readindata( const std::string & filename,
+                     const Vector<double,3> & roi_min,
+                     const Vector<double,3> & roi_max,
+                     const Vector<int,3> & stride = Vector<int,3>(1) ) {
       if (filename.length() != 0) {
         fname = filename;
       }
@@ -264,49 +347,193 @@ namespace fields {
           CORE-DATA
           \n
           SHELL-DATA
+
+         For binary files, the last comment line is
+          # BINARY <sizeof(Record)> \n
+         which is immediately followed by the raw CORE-DATA and SHELL-DATA.
       */
-      std::ifstream infile(fname.c_str());
+      std::ifstream infile(fname.c_str(), std::ios::in | std::ios::binary);
 
       if (!infile.good()) {
         THROW(std::runtime_error,"field-lookup::readindata:  invalid filename.");
       }
 
-      readindata(infile);
+      readindata(infile, roi_min, roi_max, stride);
     }
 
     /** Read from an open stream. */
     void readindata( std::istream & infile ) {
+      readindata( infile, fullRegionMin(), fullRegionMax(), Vector<int,3>(1) );
+    }
+
+    /** Read a region of interest from an open stream.
+     * @see readindata(const std::string &, const Vector<double,3> &,
+     *                 const Vector<double,3> &, const Vector<int,3> &).
+     */
+    void readindata( std::istream & infile,
+                     const Vector<double,3> & roi_min,
+                     const Vector<double,3> & roi_max,
+                     const Vector<int,3> & stride = Vector<int,3>(1) ) {
+      FileLayout layout;
+      readHeader( infile, roi_min, roi_max, stride, layout );
+      readSection( infile, CORE, layout );
+      #ifndef DISABLE_SHELL_LOOKUP
+        readSection( infile, SHELL, layout );
+      #endif
+    }
+
+    /** Layout of the data-blocks of a file, as found by readHeader. */
+    struct FileLayout {
+      /** Dimensions of each table within the file. */
+      Vector<int,3> N[2];
+      /** Index of the first grid point of each table that is kept. */
+      Vector<int,3> first[2];
+      /** Decimation stride. */
+      Vector<int,3> stride;
+      /** Size of the binary records (zero for text files). */
+      std::size_t binary_size;
+      /** Array file of each table for NumPy tables (empty otherwise). */
+      std::string npy_file[2];
+      /** Header of the array file of each table. */
+      detail::NpyHeader npy[2];
+      /** Whether each table is mapped from its array file (no copy). */
+      bool npy_mapped[2];
+    };
+
+    /** Read the geometry lines at the beginning of a file header, without
+     * allocating any tables.  This is useful for inspecting (or resampling)
+     * tables that do not fit into memory.
+     * @param infile
+     *     Stream positioned at the beginning of the file.
+     * @param r0
+     *     Returns the reference point.
+     * @param core
+     *     Returns the geometry of the CORE table.
+     * @param shell
+     *     Returns the geometry of the SHELL table (unless
+     *     DISABLE_SHELL_LOOKUP is defined).
+     */
+    static void readGeometry( std::istream & infile,
+                              Vector<double,3> & r0,
+                              TableGeometry & core,
+                              TableGeometry & shell ) {
+      char pound;
+      char line[1024];
+
+      infile >> pound; infile.getline(line,sizeof(line)); /* # center  : */
+      infile >> pound >> r0;
+      infile >> pound; infile.getline(line,sizeof(line)); /* # CORE : */
+      infile >> pound >> core.N >> core.dx >> core.min >> core.max;
+
+      #ifndef DISABLE_SHELL_LOOKUP
+        infile >> pound; infile.getline(line,sizeof(line)); /* # SHELL : */
+        infile >> pound >> shell.N >> shell.dx >> shell.min >> shell.max;
+      #endif
+    }
+
+    /** Read the header of a file (up to the first data-block) and initialize
+     * the geometry of the tables.  This and readSection are the steps of
+     * readindata;  they are separated for loading the tables progressively
+     * (@see ProgressiveForce).
+     * @see readindata(std::istream &, const Vector<double,3> &,
+     *                 const Vector<double,3> &, const Vector<int,3> &).
+     */
+    void readHeader( std::istream & infile,
+                     const Vector<double,3> & roi_min,
+                     const Vector<double,3> & roi_max,
+                     const Vector<int,3> & stride,
+                     FileLayout & layout ) {
       if (!infile.good()) {
         THROW(std::runtime_error,"field-lookup::readindata:  invalid stream.");
       }
 
-      {
-        char pound;
-        char line[1024];
+      for ( unsigned int d = 0u; d < 3u; ++d )
+        if ( stride[d] < 1 )
+          THROW(std::runtime_error,"field-lookup::readindata:  invalid stride");
+
+      /* dimensions, offset, and stride of each table within the file. */
+      Vector<int,3> (&file_N)[2] = layout.N;
+      Vector<int,3> (&first)[2] = layout.first;
+      layout.stride = stride;
 
+      {
         Vector<double,3> _r0;
+        TableGeometry core, shell;
+        readGeometry( infile, _r0, core, shell );
+
+        Vector<double,3> & _core_dx  = core.dx;
+        Vector<int,3>    & _core_N   = core.N;
+        Vector<double,3> & _core_min = core.min;
+        Vector<double,3> & _core_max = core.max;
+
+        Vector<double,3> & _shell_dx  = shell.dx;
+        Vector<int,3>    & _shell_N   = shell.N;
+        Vector<double,3> & _shell_min = shell.min;
+        Vector<double,3> & _shell_max = shell.max;
 
-        Vector<double,3> _core_dx;
-        Vector<int,3>    _core_N;
-        Vector<double,3> _core_min;
-        Vector<double,3> _core_max;
-
-        Vector<double,3> _shell_dx;
-        Vector<int,3>    _shell_N;
-        Vector<double,3> _shell_min;
-        Vector<double,3> _shell_max;
-        
-        infile >> pound; infile.getline(line,sizeof(line)); /* # center  : */
-        infile >> pound >> _r0;
-        infile >> pound; infile.getline(line,sizeof(line)); /* # CORE : */
-        infile >> pound >> _core_N >> _core_dx >> _core_min >> _core_max;
+        file_N[CORE] = _core_N;
+        file_N[SHELL] = _shell_N;
+
+        {
+          const Vector<double,3> center = 0.5*(_core_min + _core_max);
+          const bool centered = (_r0 - center).abs() <= 1e-6*_core_dx.abs();
+
+          const bool cropped =
+            subRegion( _core_N, _core_dx, _core_min, _core_max,
+                       roi_min, roi_max, stride, first[CORE] );
+
+          if ( centered && cropped )
+            _r0 = _core_min
+                + 0.5*compMult((_core_N-1).to_type<double>(), _core_dx);
+        }
 
         #ifndef DISABLE_SHELL_LOOKUP
-          infile >> pound; infile.getline(line,sizeof(line)); /* # SHELL : */
-          infile >> pound >> _shell_N >> _shell_dx >> _shell_min >> _shell_max;
+          subRegion( _shell_N, _shell_dx, _shell_min, _shell_max,
+                     roi_min, roi_max, stride, first[SHELL] );
         #endif
 
-        initialize(_r0,_core_dx, _core_min, _core_max, _shell_dx, _shell_min, _shell_max);
+        readComments( infile, layout );
+
+        /* tables that are stored whole, in native layout, in NumPy files
+         * are mapped instead of allocated. */
+        const Vector<int,3> * const N[2] = { &_core_N, &_shell_N };
+        for ( unsigned int t = CORE; t <= SHELL; ++t ) {
+          layout.npy_mapped[t] = false;
+          #ifdef DISABLE_SHELL_LOOKUP
+            if ( t == SHELL )
+              break;
+          #endif
+          if ( layout.npy_file[t].empty() )
+            continue;
+
+          std::ifstream in( layout.npy_file[t].c_str(),
+                            std::ios::in | std::ios::binary );
+          if ( !in.good() )
+            THROW(std::runtime_error,"field-lookup::readindata:  could not "
+                                     "open '" + layout.npy_file[t] + '\'');
+          detail::NpyHeader & h = layout.npy[t];
+          detail::readNpyHeader( in, h );
+          if ( sizeof(typename DTable::value_type) % sizeof(double) != 0u ||
+               !h.isTable( file_N[t], sizeof(typename DTable::value_type)
+                                      / sizeof(double) ) )
+            THROW(std::runtime_error,"field-lookup::readindata:  shape of '" +
+                                     layout.npy_file[t] + "' does not match "
+                                     "the header and the table record");
+
+          layout.npy_mapped[t] = h.isNative() &&
+                                 *N[t] == file_N[t] &&
+                                 stride == Vector<int,3>(1) &&
+                                 detail::mappable( data[t] );
+        }
+
+        setGeometry( _r0, _core_dx, _core_min, _core_max,
+                     _shell_dx, _shell_min, _shell_max );
+        if ( !layout.npy_mapped[CORE] )
+          data[CORE].initialize( core_N[X], core_N[Y], core_N[Z] );
+        #ifndef DISABLE_SHELL_LOOKUP
+          if ( !layout.npy_mapped[SHELL] )
+            data[SHELL].initialize( shell_N[X], shell_N[Y], shell_N[Z] );
+        #endif
 
         if (//r0      != _r0          ||
           core_N  != _core_N
@@ -318,43 +545,243 @@ namespace fields {
         }
       }
 
+      if ( layout.binary_size &&
+           layout.binary_size != sizeof(typename DTable::value_type) )
+        THROW(std::runtime_error,"field-lookup::readindata:  binary record "
+                                 "size does not match the table record");
+    }
+
+    /** Read the data-block of one table.  The data-blocks must be read in
+     * order (CORE, then SHELL) after readHeader.  The lookup counts as
+     * initialized once the CORE table is read. */
+    void readSection( std::istream & infile,
+                      const DSECT & t,
+                      const FileLayout & layout ) {
+      if ( !layout.npy_file[t].empty() )
+        readNpyTable( t, layout );
+      else if ( layout.binary_size )
+        detail::readBinaryTable( data[t], infile,
+                                 layout.N[t], layout.first[t], layout.stride );
+      else
+        readTextTable( t, infile, layout.N[t], layout.first[t], layout.stride );
+
+      /* propagate to all (NUMA) replicas of the table. */
+      data[t].sync();
+
+      if ( t == CORE )
+        initialized = true;
+    }
+
+  private:
+    static Vector<double,3> fullRegionMin() {
+      return Vector<double,3>( -std::numeric_limits<double>::max() );
+    }
+
+    static Vector<double,3> fullRegionMax() {
+      return Vector<double,3>( std::numeric_limits<double>::max() );
+    }
+
+    /** Reduce the geometry of a table to the sub-volume that covers
+     * [roi_min, roi_max] (taking every stride'th grid point).  The
+     * sub-volume is extended to the next grid points outside of the region so
+     * that the entire region can be interpolated.
+     * @param first
+     *     Returns the index of the first grid point of the sub-volume.
+     * @return
+     *     Whether the table was reduced.
+     */
+    static bool subRegion( Vector<int,3> & N,
+                           Vector<double,3> & dx,
+                           Vector<double,3> & min,
+                           Vector<double,3> & max,
+                           const Vector<double,3> & roi_min,
+                           const Vector<double,3> & roi_max,
+                           const Vector<int,3> & stride,
+                           Vector<int,3> & first ) {
+      bool whole = true;
+      Vector<int,3> n;
+      for ( unsigned int d = 0u; d < 3u; ++d ) {
+        const double top = N[d] - 1;
+        const double lo = std::floor( (roi_min[d] - min[d]) / dx[d] );
+        const double hi = std::ceil ( (roi_max[d] - min[d]) / dx[d] );
+        first[d] = int( std::max( 0.0, std::min( top, lo ) ) );
+        const int last = int( std::max( 0.0, std::min( top, hi ) ) );
+
+        /* enough points to reach last, without running past the table. */
+        n[d] = (last - first[d] + stride[d] - 1) / stride[d] + 1;
+        if ( first[d] + (n[d] - 1) * stride[d] > N[d] - 1 )
+          --n[d];
+
+        /* a region that misses the table keeps the nearest cell. */
+        if ( n[d] < 2 && stride[d] <= N[d] - 1 ) {
+          first[d] = std::min( first[d], N[d] - 1 - stride[d] );
+          n[d] = 2;
+        }
+
+        /* (a single point is fine for the y-axis of an AxiSym table.) */
+        if ( n[d] < std::min( N[d], 2 ) )
+          THROW(std::runtime_error,"field-lookup::readindata:  region of "
+                                   "interest does not span a table cell");
+
+        whole = whole && first[d] == 0 && stride[d] == 1 && n[d] == N[d];
+      }
+
+      if ( whole )
+        return false;
 
-      /* now read in all comment lines and skip them */
+      for ( unsigned int d = 0u; d < 3u; ++d ) {
+        min[d] += first[d] * dx[d];
+        dx[d]  *= stride[d];
+        /* a small fraction of a cell keeps N from being truncated. */
+        max[d]  = min[d] + ( n[d] - 1 + 1e-6 ) * dx[d];
+      }
+      N = n;
+      return true;
+    }
+
+    /** Read the comment lines of a header (after the geometry), up to the
+     * first data-block.  Sets the binary record size or the NumPy array
+     * files of the layout. */
+    void readComments( std::istream & infile, FileLayout & layout ) const {
+      std::size_t & binary_size = layout.binary_size;
+      binary_size = 0u;
+      layout.npy_file[CORE] = layout.npy_file[SHELL] = "";
       while (infile.good()) {
         char testchar = infile.peek();
         if (isspace(testchar)) {
           (void)infile.get();
         } else if (testchar == '#') {
           /* read past comments. */
-          std::stringbuf cmtbuf;
-          infile.get(cmtbuf, '\n');
+          std::string cmt;
+          std::getline(infile, cmt);
+          const std::string marker = detail::binaryMarker();
+          const std::string npy = detail::npyMarker();
+          if ( cmt.compare(0, marker.length(), marker) == 0 ) {
+            /* raw records follow immediately. */
+            std::istringstream(cmt.substr(marker.length())) >> binary_size;
+            break;
+          } else if ( cmt.compare(0, npy.length(), npy) == 0 ) {
+            /* the data-blocks are in separate array files. */
+            std::istringstream files( cmt.substr(npy.length()) );
+            files >> layout.npy_file[CORE] >> layout.npy_file[SHELL];
+            layout.npy_file[CORE] = relativeToFile( layout.npy_file[CORE] );
+            layout.npy_file[SHELL] = relativeToFile( layout.npy_file[SHELL] );
+            break;
+          }
         } else {
           break;
         }
       }
+    }
 
-      /* now read in the core data-block. */
-      data[CORE].readindata(infile);
-      #ifndef DISABLE_SHELL_LOOKUP
-        data[SHELL].readindata(infile);
-      #endif
+    /** Path of a file named in a header, relative to the directory of the
+     * header file (if it was read by name). */
+    std::string relativeToFile( const std::string & name ) const {
+      const std::string::size_type slash = fname.rfind('/');
+      if ( name.empty() || name[0] == '/' || slash == std::string::npos )
+        return name;
+      return fname.substr( 0, slash + 1u ) + name;
+    }
 
-      initialized = true;
+    /** Read (or map) a table from its NumPy array file. */
+    void readNpyTable( const DSECT & t, const FileLayout & layout ) {
+      const detail::NpyHeader & h = layout.npy[t];
+      if ( layout.npy_mapped[t] ) {
+        detail::mapTable( data[t], layout.npy_file[t], h.offset,
+                          layout.N[t] );
+        return;
+      }
+
+      std::ifstream in( layout.npy_file[t].c_str(),
+                        std::ios::in | std::ios::binary );
+      in.seekg( h.offset );
+      if ( h.isNative() ) {
+        detail::readBinaryTable( data[t], in,
+                                 layout.N[t], layout.first[t], layout.stride );
+      } else {
+        detail::readNpyTable( data[t], in, h,
+                              layout.N[t], layout.first[t], layout.stride );
+      }
+    }
+
+    /** Read a text data-block into a table.  A whole table is read using
+     * the storage's own reader. */
+    void readTextTable( const DSECT & t,
+                        std::istream & infile,
+                        const Vector<int,3> & N,
+                        const Vector<int,3> & first,
+                        const Vector<int,3> & stride ) {
+      const DTable & tab = data[t];
+      if ( unsigned(N[X]) == tab.xlen &&
+           unsigned(N[Y]) == tab.ylen &&
+           unsigned(N[Z]) == tab.zlen )
+        data[t].readindata(infile);
+      else
+        detail::readTextTable( data[t], infile, N, first, stride );
     }
   };
 
   /** The cartesian field lookup class. */
-  template <class Record>
-  class FieldLookup : public FieldLookupBase<Record> {
+  template < class Record, class Table = detail::DTable<Record> >
+  class FieldLookup : public FieldLookupBase<Record,Table> {
   public:
-    typedef FieldLookupBase<Record> super;
+    typedef FieldLookupBase<Record,Table> super;
+
+    /** Maximum prefetch distance of the pipelined batch lookups. */
+    static const unsigned int MAX_PREFETCH_DISTANCE = 64u;
 
     /** Default constructor.
      * Does not initialize the lookup table.
      */
-    FieldLookup() : super() {}
+    FieldLookup() : super(), prefetch_distance(8u) {}
 
-    FieldLookup(const std::string & filename) : super(filename) { }
+    FieldLookup(const std::string & filename)
+      : super(filename), prefetch_distance(8u) { }
+
+  private:
+    /** Prefetch distance used by the pipelined batch lookups. */
+    unsigned int prefetch_distance;
+
+  public:
+
+
+    /** Per-particle lookup context for temporally coherent lookups.
+     * Between integrator sub-steps a particle nearly always stays inside the
+     * same table cell.  A context remembers the last table cell that was used
+     * along with the corner values that were read from it.  A lookup that
+     * lands in the same cell again skips the table clamping and integer index
+     * computation as well as the eight corner loads.
+     *
+     * A context may only be used with one lookup table and must not be shared
+     * between threads; keep one per particle (or per SoA lane).  Call
+     * invalidate() if the table is re-read.
+     */
+    class LookupContext {
+    public:
+      LookupContext() { invalidate(); }
+
+      /** Forget the cached cell (and thus the cached corners). */
+      inline void invalidate() {
+        table = NONE;
+        vector_species = scalar_species = NONE;
+        /* an empty cell:  no position will ever hit it. */
+        lo = std::numeric_limits<double>::infinity();
+        hi = -std::numeric_limits<double>::infinity();
+      }
+
+    private:
+      friend class FieldLookup;
+      static const unsigned int NONE = ~0u;
+
+      /** Which table/cell is cached. */
+      unsigned int table, xi, yi, zi;
+      /** Range of fractional table indices that fall into the cached cell. */
+      Vector<double,3> lo, hi;
+      /** Species for which the cached corners were loaded. */
+      unsigned int vector_species, scalar_species;
+      Vector<double,3> v[8];
+      double s[8];
+    };
 
 
     /** Provide acceleration data from a file source.
@@ -406,9 +833,268 @@ namespace fields {
            + xf*yf*zf * super::data[table](xi+1,yi+1,zi+1).scalar(i);
     }
 
+    /** Pipelined batch lookup of acceleration data.
+     * While the acceleration of particle k is interpolated, the table cell
+     * of particle k+distance is computed and its eight corners are
+     * prefetched, so that (for tables much larger than the caches) the
+     * memory latency of the random table reads is hidden.  The results are
+     * identical to vector_lookup(retval[k], r[k], i).
+     * @param retval
+     *     Returns the accelerations [n].
+     * @param r
+     *     The positions [n].
+     * @param n
+     *     The number of positions.
+     * @param i
+     *     The species.
+     * @param distance
+     *     The prefetch distance (in particles) [Default:  the distance set
+     *     by setPrefetchDistance or calibratePrefetch].
+     */
+    void vector_lookup( Vector<double,3> * retval,
+                        const Vector<double,3> * r,
+                        const std::size_t & n,
+                        const unsigned int & i,
+                        const unsigned int & distance = 0u ) const {
+      PipelineCell ring[MAX_PREFETCH_DISTANCE + 1u];
+      const std::size_t D = pipelineDistance(distance);
+      const std::size_t m = D + 1u;
+
+      for ( std::size_t k = 0u; k < D && k < n; ++k )
+        prepare( ring[k], r[k], i );
+
+      for ( std::size_t k = 0u; k < n; ++k ) {
+        if ( k + D < n )
+          prepare( ring[(k + D) % m], r[k + D], i );
+
+        const PipelineCell & c = ring[k % m];
+        const typename super::DTable & t = super::data[c.table];
+        register double xF = 1.0 - c.xf, yF = 1.0 - c.yf, zF = 1.0 - c.zf;
+        Vector<double,3> & a = retval[k];
+        a.zero();
+        a.addFraction(xF*yF*zF, t(c.xi  ,c.yi  ,c.zi  ).vector(i));
+        a.addFraction(c.xf*yF*zF, t(c.xi+1,c.yi  ,c.zi  ).vector(i));
+        a.addFraction(xF*c.yf*zF, t(c.xi  ,c.yi+1,c.zi  ).vector(i));
+        a.addFraction(c.xf*c.yf*zF, t(c.xi+1,c.yi+1,c.zi  ).vector(i));
+        a.addFraction(xF*yF*c.zf, t(c.xi  ,c.yi  ,c.zi+1).vector(i));
+        a.addFraction(c.xf*yF*c.zf, t(c.xi+1,c.yi  ,c.zi+1).vector(i));
+        a.addFraction(xF*c.yf*c.zf, t(c.xi  ,c.yi+1,c.zi+1).vector(i));
+        a.addFraction(c.xf*c.yf*c.zf, t(c.xi+1,c.yi+1,c.zi+1).vector(i));
+      }
+    }
+
+    /** Pipelined batch lookup of potential data.
+     * @see vector_lookup(Vector<double,3>*, const Vector<double,3>*,
+     *                    const std::size_t&, const unsigned int&,
+     *                    const unsigned int&).
+     */
+    void scalar_lookup( double * retval,
+                        const Vector<double,3> * r,
+                        const std::size_t & n,
+                        const unsigned int & i,
+                        const unsigned int & distance = 0u ) const {
+      PipelineCell ring[MAX_PREFETCH_DISTANCE + 1u];
+      const std::size_t D = pipelineDistance(distance);
+      const std::size_t m = D + 1u;
+
+      for ( std::size_t k = 0u; k < D && k < n; ++k )
+        prepare( ring[k], r[k], i, true );
+
+      for ( std::size_t k = 0u; k < n; ++k ) {
+        if ( k + D < n )
+          prepare( ring[(k + D) % m], r[k + D], i, true );
+
+        const PipelineCell & c = ring[k % m];
+        const typename super::DTable & t = super::data[c.table];
+        register double xF = 1.0 - c.xf, yF = 1.0 - c.yf, zF = 1.0 - c.zf;
+        retval[k] = xF*yF*zF * t(c.xi  ,c.yi  ,c.zi  ).scalar(i)
+                  + c.xf*yF*zF * t(c.xi+1,c.yi  ,c.zi  ).scalar(i)
+                  + xF*c.yf*zF * t(c.xi  ,c.yi+1,c.zi  ).scalar(i)
+                  + c.xf*c.yf*zF * t(c.xi+1,c.yi+1,c.zi  ).scalar(i)
+                  + xF*yF*c.zf * t(c.xi  ,c.yi  ,c.zi+1).scalar(i)
+                  + c.xf*yF*c.zf * t(c.xi+1,c.yi  ,c.zi+1).scalar(i)
+                  + xF*c.yf*c.zf * t(c.xi  ,c.yi+1,c.zi+1).scalar(i)
+                  + c.xf*c.yf*c.zf * t(c.xi+1,c.yi+1,c.zi+1).scalar(i);
+      }
+    }
+
+    /** Set the default prefetch distance of the batch lookups. */
+    void setPrefetchDistance( const unsigned int & d ) {
+      prefetch_distance = std::max( 1u, std::min( d, MAX_PREFETCH_DISTANCE ) );
+    }
+
+    /** The default prefetch distance of the batch lookups. */
+    const unsigned int & getPrefetchDistance() const {
+      return prefetch_distance;
+    }
+
+    /** Choose the prefetch distance by timing the batch vector_lookup with
+     * several distances on (a sample of) the given positions.  The fastest
+     * distance becomes the default.  The best distance depends on the
+     * machine, the table size, and the locality of the positions, so the
+     * sample should be representative.
+     * @return The chosen distance.
+     */
+    unsigned int calibratePrefetch( const Vector<double,3> * r,
+                                    const std::size_t & n,
+                                    const unsigned int & i = 0u ) {
+      const std::size_t m = std::min( n, std::size_t(1u << 15) );
+      if ( m == 0u )
+        return prefetch_distance;
+
+      std::vector< Vector<double,3> > a(m);
+      double best = std::numeric_limits<double>::infinity();
+      for ( unsigned int d = 1u; d <= MAX_PREFETCH_DISTANCE; d *= 2u ) {
+        double dt = std::numeric_limits<double>::infinity();
+        for ( unsigned int rep = 0u; rep < 3u; ++rep ) {
+          const double t0 = detail::wallTime();
+          vector_lookup( &a[0], r, m, i, d );
+          dt = std::min( dt, detail::wallTime() - t0 );
+        }
+        if ( dt < best ) {
+          best = dt;
+          prefetch_distance = d;
+        }
+      }
+      return prefetch_distance;
+    }
+
+    /** Provide acceleration data from a file source using (and updating) a
+     * per-particle lookup context.
+     * The result is identical to vector_lookup(retval,r,i).
+     * @see LookupContext.
+     */
+    inline void vector_lookup( Vector<double,3> & retval,
+                               const Vector<double,3> & r,
+                               const unsigned int & i,
+                               LookupContext & ctx ) const {
+      register double xf, yf, zf;
+      findCell(ctx, xf, yf, zf, r);
+
+      if ( ctx.vector_species != i ) {
+        const typename super::DTable & t = super::data[ctx.table];
+        ctx.v[0] = t(ctx.xi  ,ctx.yi  ,ctx.zi  ).vector(i);
+        ctx.v[1] = t(ctx.xi+1,ctx.yi  ,ctx.zi  ).vector(i);
+        ctx.v[2] = t(ctx.xi  ,ctx.yi+1,ctx.zi  ).vector(i);
+        ctx.v[3] = t(ctx.xi+1,ctx.yi+1,ctx.zi  ).vector(i);
+        ctx.v[4] = t(ctx.xi  ,ctx.yi  ,ctx.zi+1).vector(i);
+        ctx.v[5] = t(ctx.xi+1,ctx.yi  ,ctx.zi+1).vector(i);
+        ctx.v[6] = t(ctx.xi  ,ctx.yi+1,ctx.zi+1).vector(i);
+        ctx.v[7] = t(ctx.xi+1,ctx.yi+1,ctx.zi+1).vector(i);
+        ctx.vector_species = i;
+      }
+
+      register double xF = 1.0 - xf, yF = 1.0 - yf, zF = 1.0 - zf;
+      retval.zero();
+      retval.addFraction(xF*yF*zF, ctx.v[0]);
+      retval.addFraction(xf*yF*zF, ctx.v[1]);
+      retval.addFraction(xF*yf*zF, ctx.v[2]);
+      retval.addFraction(xf*yf*zF, ctx.v[3]);
+      retval.addFraction(xF*yF*zf, ctx.v[4]);
+      retval.addFraction(xf*yF*zf, ctx.v[5]);
+      retval.addFraction(xF*yf*zf, ctx.v[6]);
+      retval.addFraction(xf*yf*zf, ctx.v[7]);
+    }
+
+    /** Provide potential data from a file source using (and updating) a
+     * per-particle lookup context.
+     * The result is identical to scalar_lookup(r,i).
+     * @see LookupContext.
+     */
+    inline double scalar_lookup( const Vector<double,3> & r,
+                                 const unsigned int & i,
+                                 LookupContext & ctx ) const {
+      register double xf, yf, zf;
+      findCell(ctx, xf, yf, zf, r);
+
+      if ( ctx.scalar_species != i ) {
+        const typename super::DTable & t = super::data[ctx.table];
+        ctx.s[0] = t(ctx.xi  ,ctx.yi  ,ctx.zi  ).scalar(i);
+        ctx.s[1] = t(ctx.xi+1,ctx.yi  ,ctx.zi  ).scalar(i);
+        ctx.s[2] = t(ctx.xi  ,ctx.yi+1,ctx.zi  ).scalar(i);
+        ctx.s[3] = t(ctx.xi+1,ctx.yi+1,ctx.zi  ).scalar(i);
+        ctx.s[4] = t(ctx.xi  ,ctx.yi  ,ctx.zi+1).scalar(i);
+        ctx.s[5] = t(ctx.xi+1,ctx.yi  ,ctx.zi+1).scalar(i);
+        ctx.s[6] = t(ctx.xi  ,ctx.yi+1,ctx.zi+1).scalar(i);
+        ctx.s[7] = t(ctx.xi+1,ctx.yi+1,ctx.zi+1).scalar(i);
+        ctx.scalar_species = i;
+      }
+
+      register double xF = 1.0 - xf, yF = 1.0 - yf, zF = 1.0 - zf;
+      return xF*yF*zF * ctx.s[0]
+           + xf*yF*zF * ctx.s[1]
+           + xF*yf*zF * ctx.s[2]
+           + xf*yf*zF * ctx.s[3]
+           + xF*yF*zf * ctx.s[4]
+           + xf*yF*zf * ctx.s[5]
+           + xF*yf*zf * ctx.s[6]
+           + xf*yf*zf * ctx.s[7];
+    }
+
+    /** Whether r is inside of the lookup tables.  Lookups of positions
+     * outside of the tables are clamped to the table edges.
+     * @see HybridForce.
+     */
+    inline bool inDomain( const Vector<double,3> & r ) const {
+      const unsigned int table = whichTable(r);
+      const Vector<double,3> & min =
+        table == super::CORE ? super::core_min : super::shell_min;
+      const Vector<double,3> & dx_inv =
+        table == super::CORE ? super::core_dx_inv : super::shell_dx_inv;
+      const Vector<int,3> & N =
+        table == super::CORE ? super::core_N : super::shell_N;
+
+      for ( unsigned int d = 0u; d < 3u; ++d ) {
+        const double f = (r[d] - min[d]) * dx_inv[d];
+        if ( f < 0.0 || f > N[d] - 1 )
+          return false;
+      }
+      return true;
+    }
+
+    /** Linear index of the table cell that r is looked up in.
+     * CORE cells are numbered first, followed by the SHELL cells; within a
+     * table, cells are numbered in the memory order of the table.  Sorting
+     * particles by this index therefore sorts them into table memory order.
+     * @see cell-sort.h.
+     */
+    inline unsigned long long cellIndex( const Vector<double,3> & r ) const {
+      register unsigned int table, xi, yi, zi;
+      register double xf, yf, zf;
+      getindx(table, xi, xf, yi, yf, zi, zf, r);
+
+      const typename super::DTable & t = super::data[table];
+      unsigned long long retval =
+        (unsigned long long)zi * t.xlen_times_ylen + xi * t.ylen + yi;
+      if ( table == super::SHELL ) {
+        const typename super::DTable & c = super::data[super::CORE];
+        retval += (unsigned long long)c.xlen_times_ylen * c.zlen;
+      }
+      return retval;
+    }
+
+    /** Morton (Z-order) index of the table cell that r is looked up in.
+     * The 21 least significant bits of each of the x, y, and z cell indices
+     * are interleaved and SHELL cells have the most significant bit set.
+     * Sorting particles by this index keeps neighbors in all three dimensions
+     * close together.
+     * @see cell-sort.h.
+     */
+    inline unsigned long long mortonIndex( const Vector<double,3> & r ) const {
+      register unsigned int table, xi, yi, zi;
+      register double xf, yf, zf;
+      getindx(table, xi, xf, yi, yf, zi, zf, r);
+
+      return ( (unsigned long long)(table == super::SHELL) << 63 )
+           | ( detail::spreadBits3(zi) << 2 )
+           | ( detail::spreadBits3(xi) << 1 )
+           | ( detail::spreadBits3(yi)      );
+    }
+
     /** Obtain the nearest record of the lookup table.  */
-    Record & getRecord( const Vector<double,3> & r,
-                        const enum super::DSECT & table = super::CORE ) {
+    typename super::DTable::reference
+    getRecord( const Vector<double,3> & r,
+               const enum super::DSECT & table = super::CORE ) {
       register double xf, yf, zf;
 
       #if !defined(NOTRUNCX) || !defined(NOTRUNCY) || !defined(NOTRUNCZ)
@@ -447,6 +1133,112 @@ namespace fields {
     }
 
   private:
+    /** Table cell of one particle in the batch lookup pipeline. */
+    struct PipelineCell {
+      unsigned int table, xi, yi, zi;
+      double xf, yf, zf;
+    };
+
+    inline std::size_t pipelineDistance( const unsigned int & distance ) const {
+      return std::max( 1u, std::min( distance ? distance : prefetch_distance,
+                                     MAX_PREFETCH_DISTANCE ) );
+    }
+
+    /** Compute the table cell of r and prefetch the vector (or scalar) data
+     * of its corners. */
+    inline void prepare( PipelineCell & c,
+                         const Vector<double,3> & r,
+                         const unsigned int & i,
+                         const bool & scalar = false ) const {
+      getindx(c.table, c.xi, c.xf, c.yi, c.yf, c.zi, c.zf, r);
+      const typename super::DTable & t = super::data[c.table];
+      /* the y-neighbors are usually adjacent in memory, but not always (e.g.
+       * in SpeciesMajorTable), so all eight corners are prefetched. */
+      for ( unsigned int dz = 0u; dz < 2u; ++dz )
+        for ( unsigned int dy = 0u; dy < 2u; ++dy )
+          for ( unsigned int dx = 0u; dx < 2u; ++dx ) {
+            typename super::DTable::const_reference rec =
+              t(c.xi + dx, c.yi + dy, c.zi + dz);
+            if ( scalar )
+              detail::prefetch( &rec.scalar(i) );
+            else
+              detail::prefetch( &rec.vector(i) );
+          }
+    }
+
+  public:
+    /** Determine which table a position is looked up in. */
+    inline unsigned int whichTable( const Vector<double,3> & r ) const {
+      #ifndef DISABLE_SHELL_LOOKUP
+        if ( fabs(r[X] - super::r0[X]) > super::core_L_2[X] ||
+             fabs(r[Y] - super::r0[Y]) > super::core_L_2[Y] ||
+             fabs(r[Z] - super::r0[Z]) > super::core_L_2[Z]    )
+          return super::SHELL;
+      #endif
+      return super::CORE;
+    }
+
+  private:
+    /** Find the interpolation fractions of r in the cell cached by ctx.  If r
+     * is not in the cached cell, the cell is recomputed with getindx and the
+     * cached corners are invalidated only if the cell actually changed.  */
+    inline void findCell( LookupContext & ctx,
+                          double & xf,
+                          double & yf,
+                          double & zf,
+                          const Vector<double,3> & r ) const {
+      unsigned int table = whichTable(r);
+      const Vector<double,3> & min =
+        table == super::CORE ? super::core_min : super::shell_min;
+      const Vector<double,3> & dx_inv =
+        table == super::CORE ? super::core_dx_inv : super::shell_dx_inv;
+
+      if ( table == ctx.table ) {
+        /* same arithmetic as getindx so that the results are identical. */
+        xf = ( (r[X]-min[X]) * dx_inv[X] );
+        yf = ( (r[Y]-min[Y]) * dx_inv[Y] );
+        zf = ( (r[Z]-min[Z]) * dx_inv[Z] );
+        if ( xf >= ctx.lo[X] && xf < ctx.hi[X] &&
+             yf >= ctx.lo[Y] && yf < ctx.hi[Y] &&
+             zf >= ctx.lo[Z] && zf < ctx.hi[Z] ) {
+          xf -= ctx.xi;
+          yf -= ctx.yi;
+          zf -= ctx.zi;
+          return;
+        }
+      }
+
+      unsigned int xi, yi, zi;
+      getindx(table, xi, xf, yi, yf, zi, zf, r);
+
+      if ( table != ctx.table || xi != ctx.xi || yi != ctx.yi || zi != ctx.zi ) {
+        ctx.table = table;
+        ctx.xi = xi;
+        ctx.yi = yi;
+        ctx.zi = zi;
+        ctx.vector_species = ctx.scalar_species = LookupContext::NONE;
+      }
+
+      /* Remember the range of (unclamped) fractional indices that map to this
+       * cell.  Positions that getindx would clamp are never in this range. */
+      const Vector<int,3> & N =
+        table == super::CORE ? super::core_N : super::shell_N;
+      ctx.lo = V3( xi, yi, zi );
+      ctx.hi = ctx.lo + 1.0;
+      #if !defined(NOTRUNCX)
+        ctx.hi[X] = std::min( ctx.hi[X], N[X] - 1.001 );
+      #endif
+      #if !defined(NOTRUNCY)
+        ctx.hi[Y] = std::min( ctx.hi[Y], N[Y] - 1.001 );
+      #endif
+      #if !defined(NOTRUNCZ)
+        ctx.hi[Z] = std::min( ctx.hi[Z], N[Z] - 1.001 );
+      #endif
+    }
+
+  protected:
+    /** Compute the table, the cell, and the fractional position within the
+     * cell of r (clamped to the table). */
     inline void getindx ( unsigned int & table,
                           unsigned int & xi,
                           double       & xf,
@@ -460,9 +1252,7 @@ namespace fields {
       #endif
 
       #ifndef DISABLE_SHELL_LOOKUP
-        if ( fabs(r[X] - super::r0[X]) > super::core_L_2[X] ||
-             fabs(r[Y] - super::r0[Y]) > super::core_L_2[Y] ||
-             fabs(r[Z] - super::r0[Z]) > super::core_L_2[Z]    ) {
+        if ( whichTable(r) == super::SHELL ) {
           table = super::SHELL;
           xf = ( (r[X]-super::shell_min[X]) * super::shell_dx_inv[X] );
           yf = ( (r[Y]-super::shell_min[Y]) * super::shell_dx_inv[Y] );
@@ -481,6 +1271,10 @@ namespace fields {
           nmax = &( (const Vector<int,3> &) (super::core_N) );
         #endif
       }
+      #ifdef FIELDS_LOOKUP_STATS
+        super::counters.record( table, V3(xf, yf, zf),
+          table == super::CORE ? super::core_N : super::shell_N );
+      #endif
       #if !defined(NOTRUNCX)
         xf = std::max(0.0,std::min((double)((*nmax)[X])-1.001,xf));
       #endif
@@ -498,11 +1292,55 @@ namespace fields {
   };
 
 
+  template < class Record, class Table >
+  const unsigned int FieldLookup<Record,Table>::MAX_PREFETCH_DISTANCE;
+
+  namespace detail {
+    /** Rotation matrix that takes the unit vector k onto the z-axis. */
+    inline SquareMatrix<double,3> rotationInto(const Vector<double,3> & k) {
+      /* I know that the method I am doing for this is not the fastest, but who
+       * cares.  It is the most transparent and I only have to do this once
+       * anyway!
+       * */
+      /* cos(phi) = x/std::sqrt(x**2 + y**2)
+       * sin(phi) = y/std::sqrt(x**2 + y**2)
+       * cos(theta (polar)) = z/r
+       * sin(theta) = std::sqrt(1-cos(theta)**2)
+       * */
+      double costheta = k[Z] /* /r */;
+      double sintheta = std::sqrt(1.0 - SQR(costheta));
+      double cosphi = 1.0, sinphi = 0.0;
+      if (sintheta) {
+        cosphi = k[X] / hypot( k[X], k[Y]);
+        sinphi = k[Y] / hypot( k[X], k[Y]);
+      }
+
+      /* rotation matrix is given by:
+       * Rz[+phi].Ry[+theta]
+       * where Rz[x] and Ry[x] are passive rotations.
+       * */
+      const double ry_[3][3]  =
+        {{ costheta,    0,  -sintheta},
+         {   0,         1,       0   },
+         { sintheta,    0,   costheta}};
+
+      const double rz_[3][3]  =
+        {{ cosphi,    sinphi,    0   },
+         {-sinphi,    cosphi,    0   },
+         {   0,         0,       1   }};
+
+      SquareMatrix<double,3> & ry   = *((SquareMatrix<double,3>*)ry_);
+      SquareMatrix<double,3> & rz   = *((SquareMatrix<double,3>*)rz_);
+
+      return ry * rz;
+    }
+  }/* namespace fields::detail */
+
   /** The axially symmetric field lookup class. */
-  template <class Record>
-  class AxiSymFieldLookup : public FieldLookupBase<Record> {
+  template < class Record, class Table = detail::DTable<Record> >
+  class AxiSymFieldLookup : public FieldLookupBase<Record,Table> {
   public:
-    typedef FieldLookupBase<Record> super;
+    typedef FieldLookupBase<Record,Table> super;
 
     /** Default constructor.
      * Does not initialize the lookup table.
@@ -565,42 +1403,10 @@ namespace fields {
     }
 
   public:
+    /** Rotate the field such that the axis of the table is along k (a unit
+     * vector). */
     void rotateField(const Vector<double,3> & k) {
-      /* I know that the method I am doing for this is not the fastest, but who
-       * cares.  It is the most transparent and I only have to do this once
-       * anyway!
-       * */
-      /* cos(phi) = x/std::sqrt(x**2 + y**2)
-       * sin(phi) = y/std::sqrt(x**2 + y**2)
-       * cos(theta (polar)) = z/r
-       * sin(theta) = std::sqrt(1-cos(theta)**2)
-       * */
-      double costheta = k[Z] /* /r */;
-      double sintheta = std::sqrt(1.0 - SQR(costheta));
-      double cosphi = 1.0, sinphi = 0.0;
-      if (sintheta) {
-        cosphi = k[X] / hypot( k[X], k[Y]);
-        sinphi = k[Y] / hypot( k[X], k[Y]);
-      }
-
-      /* rotation matrix is given by:
-       * Rz[+phi].Ry[+theta]
-       * where Rz[x] and Ry[x] are passive rotations.
-       * */
-      const double ry_[3][3]  =
-        {{ costheta,    0,  -sintheta},
-         {   0,         1,       0   },
-         { sintheta,    0,   costheta}};
-
-      const double rz_[3][3]  =
-        {{ cosphi,    sinphi,    0   },
-         {-sinphi,    cosphi,    0   },
-         {   0,         0,       1   }};
-
-      SquareMatrix<double,3> & ry   = *((SquareMatrix<double,3>*)ry_);
-      SquareMatrix<double,3> & rz   = *((SquareMatrix<double,3>*)rz_);
-
-      R   = ry * rz;
+      R = detail::rotationInto(k);
     }
 
 
@@ -615,9 +1421,77 @@ namespace fields {
     }
 
 
+    /** Determine which table a position is looked up in. */
+    inline unsigned int whichTable( const Vector<double,3> & r ) const {
+      #ifndef DISABLE_SHELL_LOOKUP
+        double rho, z;
+        getRotatedRelativeCoords(r, rho, z);
+        if ( rho > super::core_max[RHO] || rho < super::core_min[RHO] ||
+             fabs(z) > super::core_L_2[Z] )
+          return super::SHELL;
+      #endif
+      return super::CORE;
+    }
+
+    /** Whether r is inside of the lookup tables.
+     * @see FieldLookup::inDomain.
+     */
+    inline bool inDomain( const Vector<double,3> & r ) const {
+      double rho, z;
+      getRotatedRelativeCoords(r, rho, z);
+
+      #ifndef DISABLE_SHELL_LOOKUP
+        if ( rho > super::core_max[RHO] || rho < super::core_min[RHO] ||
+             fabs(z) > super::core_L_2[Z] ) {
+          const double rhof =
+            (rho - super::shell_min[RHO]) * super::shell_dx_inv[RHO];
+          const double zf = (z - super::shell_min[Z]) * super::shell_dx_inv[Z];
+          return rhof >= 0.0 && rhof <= super::shell_N[RHO] - 1 &&
+                 zf   >= 0.0 && zf   <= super::shell_N[Z]   - 1;
+        }
+      #endif
+
+      const double rhof = (rho - super::core_min[RHO]) * super::core_dx_inv[RHO];
+      const double zf = (z - super::core_min[Z]) * super::core_dx_inv[Z];
+      return rhof >= 0.0 && rhof <= super::core_N[RHO] - 1 &&
+             zf   >= 0.0 && zf   <= super::core_N[Z]   - 1;
+    }
+
+    /** Linear index of the table cell that r is looked up in.
+     * @see FieldLookup::cellIndex.
+     */
+    inline unsigned long long cellIndex( const Vector<double,3> & r ) const {
+      register unsigned int table, rhoi, zi;
+      register double rhof, zf;
+      getindx(table, rhoi, rhof, zi, zf, r);
+
+      const typename super::DTable & t = super::data[table];
+      unsigned long long retval =
+        (unsigned long long)zi * t.xlen_times_ylen + rhoi * t.ylen;
+      if ( table == super::SHELL ) {
+        const typename super::DTable & c = super::data[super::CORE];
+        retval += (unsigned long long)c.xlen_times_ylen * c.zlen;
+      }
+      return retval;
+    }
+
+    /** Morton (Z-order) index of the table cell that r is looked up in.
+     * @see FieldLookup::mortonIndex.
+     */
+    inline unsigned long long mortonIndex( const Vector<double,3> & r ) const {
+      register unsigned int table, rhoi, zi;
+      register double rhof, zf;
+      getindx(table, rhoi, rhof, zi, zf, r);
+
+      return ( (unsigned long long)(table == super::SHELL) << 63 )
+           | ( detail::spreadBits3(zi) << 2 )
+           | ( detail::spreadBits3(rhoi) << 1 );
+    }
+
     /** Obtain the nearest record of the lookup table.  */
-    Record & getRecord( const Vector<double,3> & r,
-                        const enum super::DSECT & table = super::CORE ) {
+    typename super::DTable::reference
+    getRecord( const Vector<double,3> & r,
+               const enum super::DSECT & table = super::CORE ) {
       register double rhof, zf;
 
       #if !defined(NOTRUNCX) || !defined(NOTRUNCY) || !defined(NOTRUNCZ)
@@ -684,6 +1558,10 @@ namespace fields {
           nmax = &(super::core_N);
         #endif
       }
+      #ifdef FIELDS_LOOKUP_STATS
+        super::counters.record( table, V3(rhof, 0.0, zf),
+          table == super::CORE ? super::core_N : super::shell_N );
+      #endif
       #if !defined(NOTRUNCX)
         rhof = std::max(0.0,std::min((double)((*nmax)[RHO])-1.001,rhof));
       #endif
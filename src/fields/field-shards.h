@@ -0,0 +1,412 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+
+/** \file
+ * Generate a field-lookup table in independent shards and stitch the shards
+ * back together into one table file.
+ *
+ * Each table (CORE and SHELL) is split into nshards[X]*nshards[Y]*nshards[Z]
+ * bricks (z-slabs for nshards = (1,1,n)).  Shard s holds brick s of both
+ * tables and is a field file of its own:  the header gives the geometry of
+ * the complete tables and the range of grid indices of the bricks.  The
+ * shards can therefore be created by separate processes (or batch jobs)
+ * that share nothing but the filesystem:
+ * <code>
+ *   // job s of nshards.prod()
+ *   std::ofstream out( ("field.dat.shard-" + to_string(s)).c_str() );
+ *   fields::createFieldShard( src, X_MINc, X_MAXc, dxc, X_MINs, X_MAXs, dxs,
+ *                             nshards, s, out );
+ *   ...
+ *   // once all jobs are done
+ *   std::ofstream table( "field.dat" );
+ *   fields::mergeFieldShards< ForceRecord<> >( shard_files, table );
+ * </code>
+ * mergeFieldShards checks that the shards tile the tables exactly and
+ * streams the records through, so only one record per shard is held in
+ * memory.
+ */
+
+#ifndef fields_field_shards_h
+#define fields_field_shards_h
+
+#include <fields/createFieldFile.h>
+#include <fields/field-lookup.h>
+#include <fields/detail/table-io.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+#include <xylose/except.h>
+#include <xylose/strutil.h>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+
+namespace fields {
+
+  using xylose::Vector;
+  using xylose::V3;
+
+  /** Range of grid indices [lo,hi) of a brick of a table. */
+  struct IndexBox {
+    Vector<int,3> lo, hi;
+
+    IndexBox() : lo(0), hi(0) { }
+
+    /** Number of grid points in the brick. */
+    std::size_t size() const {
+      std::size_t n = 1u;
+      for ( unsigned int d = 0u; d < 3u; ++d )
+        n *= std::max( 0, hi[d] - lo[d] );
+      return n;
+    }
+
+    /** Whether the two bricks have any grid point in common. */
+    bool overlaps( const IndexBox & that ) const {
+      for ( unsigned int d = 0u; d < 3u; ++d )
+        if ( hi[d] <= that.lo[d] || that.hi[d] <= lo[d] )
+          return false;
+      return true;
+    }
+  };
+
+  /** The brick of a table with N grid points that belongs to one shard.
+   * @param N
+   *     Number of grid points of the table along each axis.
+   * @param nshards
+   *     Number of shards along each axis.
+   * @param shard
+   *     Index of the shard (in [0,nshards.prod()), x varying fastest).
+   */
+  inline IndexBox shardBox( const Vector<int,3> & N,
+                            const Vector<int,3> & nshards,
+                            const int & shard ) {
+    IndexBox b;
+    int s = shard;
+    for ( unsigned int d = 0u; d < 3u; ++d ) {
+      const int i = s % nshards[d];
+      s /= nshards[d];
+      b.lo[d] = int( ( (long long)(N[d]) * i ) / nshards[d] );
+      b.hi[d] = int( ( (long long)(N[d]) * (i+1) ) / nshards[d] );
+    }
+    return b;
+  }
+
+  namespace detail {
+
+    /** First line of the description of a shard in the header. */
+    inline const char * shardMarker() { return "# SHARD :"; }
+
+    /** A shard file opened for merging. */
+    template < class Record >
+    struct ShardFile {
+      std::string name;
+      std::ifstream in;
+      Vector<double,3> r0;
+      TableGeometry geometry[2];
+      IndexBox box[2];
+      /** Record size for binary shards (0 for text shards). */
+      std::size_t binary_size;
+
+      ShardFile( const std::string & name ) : name(name), binary_size(0u) {
+        in.open( name.c_str(), std::ios::in | std::ios::binary );
+        if ( !in.good() )
+          THROW(std::runtime_error,
+                "mergeFieldShards:  could not open '" + name + '\'');
+
+        FieldLookupBase<Record>::readGeometry( in, r0, geometry[0], geometry[1] );
+
+        bool found = false;
+        while ( in.good() ) {
+          const int c = in.peek();
+          if ( std::isspace(c) ) {
+            (void)in.get();
+          } else if ( c == '#' ) {
+            std::string cmt;
+            std::getline( in, cmt );
+            const std::string smarker = shardMarker();
+            const std::string bmarker = binaryMarker();
+            if ( cmt.compare( 0, smarker.length(), smarker ) == 0 ) {
+              char pound;
+              in >> pound >> box[0].lo >> box[0].hi
+                 >> pound >> box[1].lo >> box[1].hi;
+              found = true;
+            } else if ( cmt.compare( 0, bmarker.length(), bmarker ) == 0 ) {
+              std::istringstream( cmt.substr( bmarker.length() ) ) >> binary_size;
+              break;
+            }
+          } else
+            break;
+        }
+
+        if ( !found )
+          THROW(std::runtime_error,
+                "mergeFieldShards:  '" + name + "' is not a shard");
+      }
+
+      /** Read the next record of the shard. */
+      void read( Record & rec ) {
+        if ( binary_size ) {
+          in.read( reinterpret_cast<char*>(&rec), sizeof(Record) );
+        } else {
+          char line[512] = {0};
+          while ( in.good() && std::strlen(line) == 0 )
+            in.getline( line, sizeof(line) );
+          std::istringstream ins(line);
+          if ( !(ins >> rec) )
+            in.setstate( std::ios::failbit );
+        }
+
+        if ( !in )
+          THROW(std::runtime_error,
+                "mergeFieldShards:  '" + name + "' is truncated");
+      }
+    };
+
+    /** Whether two geometries (from file headers) are identical. */
+    inline bool sameGeometry( const TableGeometry & a, const TableGeometry & b ) {
+      return a.N == b.N && a.dx == b.dx && a.min == b.min && a.max == b.max;
+    }
+
+    /** Orders the bricks of a table by their y-offset. */
+    template < class Record >
+    struct ByY {
+      ByY( const std::vector<ShardFile<Record>*> & shards, const int & t )
+        : shards(shards), t(t) { }
+      bool operator()( const int & a, const int & b ) const {
+        return shards[a]->box[t].lo[1] < shards[b]->box[t].lo[1];
+      }
+      const std::vector<ShardFile<Record>*> & shards;
+      const int t;
+    };
+
+  }/* namespace fields::detail */
+
+  /** Create one shard of a field file (@see createFieldFile for the
+   * parameters that are not described here).  The records of each plane of
+   * the shard are calculated in parallel.
+   * @param nshards
+   *     Number of shards along each axis.
+   * @param shard
+   *     Index of the shard to create (in [0,nshards.prod()), x varying
+   *     fastest).
+   * @param fieldout
+   *     The place to store the shard.
+   * @return The number of records written.
+   */
+  template <class FieldTable>
+  long createFieldShard( const FieldTable & ftable,
+                         const Vector<double,3> & X_MINc,
+                         const Vector<double,3> & X_MAXc,
+                         const Vector<double,3> & dxc,
+                         const Vector<double,3> & X_MINs,
+                         const Vector<double,3> & X_MAXs,
+                         const Vector<double,3> & dxs,
+                         const Vector<int,3> & nshards,
+                         const int & shard,
+                         std::ostream & fieldout,
+                         const std::string & comments = "",
+                         const FileFormat & format = TEXT_FILE ) {
+    using xylose::to_string;
+    if ( nshards[0] < 1 || nshards[1] < 1 || nshards[2] < 1 ||
+         shard < 0 || shard >= nshards.prod() )
+      THROW(std::runtime_error,
+            "createFieldShard:  invalid shard " + to_string(shard));
+
+    Vector<int,3> N[2];
+    N[0] = compDiv( X_MAXc - X_MINc, dxc ) + 1.0;
+    N[1] = compDiv( X_MAXs - X_MINs, dxs ) + 1.0;
+    const Vector<double,3> min[2] = { X_MINc, X_MINs };
+    const Vector<double,3> dx[2]  = { dxc, dxs };
+
+    IndexBox box[2];
+    std::ostringstream header;
+    header << comments << detail::shardMarker() << ' '
+           << shard << ' ' << nshards << '\n';
+    for ( int t = 0; t < 2; ++t ) {
+      box[t] = shardBox( N[t], nshards, shard );
+      header << "# " << box[t].lo << '\t' << box[t].hi << '\n';
+    }
+
+    writeFieldHeader( fieldout, X_MINc + 0.5*(X_MAXc - X_MINc),
+                      N[0], dxc, X_MINc, X_MAXc,
+                      N[1], dxs, X_MINs, X_MAXs,
+                      header.str(), format,
+                      detail::recordSize(
+                        ftable.getRecord( GridPoint(X_MINc, dxc) ) ) );
+
+    long n = 0;
+    for ( int t = 0; t < 2; ++t ) {
+      n += spitfieldplanes( fieldout, ftable,
+                            min[t] + compMult( box[t].lo.to_type<double>(), dx[t] ),
+                            box[t].hi - box[t].lo, dx[t], format );
+      if ( t == 0 && format == TEXT_FILE )
+        fieldout << '\n';
+    }
+    return n;
+  }
+
+  /** Stitch a complete set of shards (@see createFieldShard) into one field
+   * file.  The shards must all have the same geometry and their bricks must
+   * tile both tables exactly;  they may be any mix of text and binary files.
+   * The records are streamed from the shards to the output, so that the
+   * memory used does not depend on the size of the table.
+   * @param Record
+   *     The type of records in the shards.
+   * @param shards
+   *     Names of the shard files (in any order).
+   * @param fieldout
+   *     The place to store the merged file.
+   * @param comments
+   *     A set of lines that begin with '#' each.
+   * @param format
+   *     Format of the data-blocks of the merged file [Default TEXT_FILE].
+   * @return The number of records written.
+   */
+  template < class Record >
+  long mergeFieldShards( const std::vector<std::string> & shards,
+                         std::ostream & fieldout,
+                         const std::string & comments = "",
+                         const FileFormat & format = TEXT_FILE ) {
+    using xylose::to_string;
+    if ( shards.empty() )
+      THROW(std::runtime_error,"mergeFieldShards:  no shards given");
+
+    typedef detail::ShardFile<Record> ShardFile;
+    std::vector<ShardFile*> files;
+    long n = 0;
+    try {
+      for ( std::size_t s = 0u; s < shards.size(); ++s )
+        files.push_back( new ShardFile( shards[s] ) );
+
+      /* validate the geometry and the tiling. */
+      const ShardFile & first = *files[0];
+      for ( std::size_t s = 0u; s < files.size(); ++s ) {
+        const ShardFile & f = *files[s];
+        if ( !( f.r0 == first.r0 &&
+                detail::sameGeometry( f.geometry[0], first.geometry[0] ) &&
+                detail::sameGeometry( f.geometry[1], first.geometry[1] ) ) )
+          THROW(std::runtime_error,
+                "mergeFieldShards:  geometry of '" + f.name +
+                "' differs from that of '" + first.name + '\'');
+        if ( f.binary_size && f.binary_size != sizeof(Record) )
+          THROW(std::runtime_error,
+                "mergeFieldShards:  record size of '" + f.name +
+                "' does not match");
+      }
+
+      for ( int t = 0; t < 2; ++t ) {
+        const Vector<int,3> & N = first.geometry[t].N;
+        std::size_t total = 0u;
+        for ( std::size_t s = 0u; s < files.size(); ++s ) {
+          const IndexBox & b = files[s]->box[t];
+          for ( unsigned int d = 0u; d < 3u; ++d )
+            if ( b.lo[d] < 0 || b.hi[d] > N[d] || b.lo[d] > b.hi[d] )
+              THROW(std::runtime_error,
+                    "mergeFieldShards:  brick of '" + files[s]->name +
+                    "' is outside of the table");
+          for ( std::size_t s2 = 0u; s2 < s; ++s2 )
+            if ( b.size() && files[s2]->box[t].size() &&
+                 b.overlaps( files[s2]->box[t] ) )
+              THROW(std::runtime_error,
+                    "mergeFieldShards:  bricks of '" + files[s2]->name +
+                    "' and '" + files[s]->name + "' overlap");
+          total += b.size();
+        }
+        if ( total != std::size_t(N[0]) * N[1] * N[2] )
+          THROW(std::runtime_error,
+                "mergeFieldShards:  shards cover " + to_string(total) +
+                " of " + to_string(N.prod()) + " records");
+      }
+
+      writeFieldHeader( fieldout, first.r0,
+                        first.geometry[0].N, first.geometry[0].dx,
+                        first.geometry[0].min, first.geometry[0].max,
+                        first.geometry[1].N, first.geometry[1].dx,
+                        first.geometry[1].min, first.geometry[1].max,
+                        comments, format, sizeof(Record) );
+
+      /* stitch:  each row (along y) of the table is made of the rows of the
+       * bricks that contain it, in the order of their y-offsets. */
+      Record rec;
+      for ( int t = 0; t < 2; ++t ) {
+        const Vector<int,3> & N = first.geometry[t].N;
+        std::vector<int> order;
+        for ( std::size_t s = 0u; s < files.size(); ++s )
+          if ( files[s]->box[t].size() )
+            order.push_back( int(s) );
+        std::sort( order.begin(), order.end(), detail::ByY<Record>( files, t ) );
+
+        for ( int k = 0; k < N[2]; ++k ) {
+          for ( int i = 0; i < N[0]; ++i )
+            for ( std::size_t o = 0u; o < order.size(); ++o ) {
+              ShardFile & f = *files[ order[o] ];
+              const IndexBox & b = f.box[t];
+              if ( i < b.lo[0] || i >= b.hi[0] || k < b.lo[2] || k >= b.hi[2] )
+                continue;
+              for ( int j = b.lo[1]; j < b.hi[1]; ++j, ++n ) {
+                f.read( rec );
+                if ( format == BINARY_FILE )
+                  detail::writeBinary( fieldout, rec );
+                else
+                  fieldout << rec << '\n';
+              }
+            }
+
+          if ( format == TEXT_FILE )
+            fieldout << '\n';
+        }
+
+        if ( t == 0 && format == TEXT_FILE )
+          fieldout << '\n';
+      }
+    } catch (...) {
+      for ( std::size_t s = 0u; s < files.size(); ++s )
+        delete files[s];
+      throw;
+    }
+
+    for ( std::size_t s = 0u; s < files.size(); ++s )
+      delete files[s];
+    return n;
+  }
+
+}/* namespace fields */
+
+#endif // fields_field_shards_h
@@ -0,0 +1,343 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+/** \file
+ * Tricubic Hermite interpolation of force lookup tables.
+ *
+ * A HermiteForceRecord stores, in addition to the acceleration and the
+ * potential, their spatial derivatives d/dx, d/dy, d/dz, d2/dxdy, d2/dxdz,
+ * d2/dydz, and d3/dxdydz.  HermiteFieldLookup interpolates these with the
+ * tensor product of cubic Hermite polynomials, which is continuous with a
+ * continuous gradient and typically reaches the accuracy of the trilinear
+ * lookup on a grid that is about three times coarser along each axis (each
+ * record is eight times larger, but there are ~27 times fewer of them).
+ *
+ * Example:
+ * <code>
+ *   // create the table
+ *   // (finite difference steps default to 1e-3 of the grid spacing)
+ *   fields::HermiteTableWrapper< BForce > src;
+ *   fields::createFieldFile( src, ..., "field.dat" );
+ *
+ *   // use the table
+ *   fields::ForceLookup< 3u,
+ *     fields::HermiteFieldLookup< fields::HermiteForceRecord<3u> > > lookup;
+ *   lookup.readindata( "field.dat" );
+ * </code>
+ */
+
+#ifndef fields_hermite_lookup_h
+#define fields_hermite_lookup_h
+
+#include <fields/force-lookup.h>
+#include <fields/field-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/indices.h>
+
+#include <xylose/except.h>
+
+#include <xylose/Vector.h>
+
+#include <istream>
+#include <ostream>
+#include <algorithm>
+#include <stdexcept>
+
+namespace fields {
+
+  using xylose::Vector;
+  using xylose::V3;
+
+  /** Force record with the derivatives needed for Hermite interpolation.
+   * Derivatives are stored in the order x, y, z, xy, xz, yz, xyz.
+   * @see HermiteFieldLookup.
+   */
+  template < unsigned int L = 3u, unsigned int N = 1u >
+  class HermiteForceRecord : public ForceRecord<L,N> {
+  public:
+    typedef ForceRecord<L,N> super;
+
+    /** Number of stored derivatives per quantity. */
+    static const unsigned int NDERIVS = 7u;
+
+    HermiteForceRecord() : super() {
+      for ( unsigned int i = 0u; i < N; ++i ) {
+        std::fill( da[i], da[i] + NDERIVS, Vector<double,L>(0.0) );
+        std::fill( dV[i], dV[i] + NDERIVS, 0.0 );
+      }
+    }
+
+    /** Derivatives of the acceleration of each species. */
+    Vector<double,L> da[N][NDERIVS];
+
+    /** Derivatives of the potential of each species. */
+    double dV[N][NDERIVS];
+
+    /** Index (into da/dV) of the derivative d^(px+py+pz)/dx^px dy^py dz^pz
+     * given as code = px | py << 1 | pz << 2 (code must not be 0). */
+    static unsigned int derivIndex( const unsigned int & code ) {
+      static const unsigned int index[8] = { 0u, 0u, 1u, 3u, 2u, 4u, 5u, 6u };
+      return index[code];
+    }
+
+    /** The acceleration (code = 0) or one of its derivatives.
+     * @see derivIndex. */
+    inline const Vector<double,L> & vector( const unsigned int & i,
+                                            const unsigned int & code ) const {
+      return code ? da[i][derivIndex(code)] : super::vector(i);
+    }
+
+    /** The potential (code = 0) or one of its derivatives.
+     * @see derivIndex. */
+    inline const double & scalar( const unsigned int & i,
+                                  const unsigned int & code ) const {
+      return code ? dV[i][derivIndex(code)] : super::scalar(i);
+    }
+
+    using super::vector;
+    using super::scalar;
+  };
+
+  template < unsigned int L, unsigned int N >
+  inline std::istream & operator>>( std::istream & input,
+                                    HermiteForceRecord<L,N> & fr ) {
+    for ( unsigned int i = 0u; i < N; ++i ) {
+      input >> fr.vector(i) >> fr.scalar(i);
+      for ( unsigned int d = 0u; d < fr.NDERIVS; ++d )
+        input >> fr.da[i][d] >> fr.dV[i][d];
+    }
+    return input;
+  }
+
+  template < unsigned int L, unsigned int N >
+  inline std::ostream & operator<<( std::ostream & output,
+                                    const HermiteForceRecord<L,N> & fr ) {
+    const char * presep = "";
+    for ( unsigned int i = 0u; i < N; ++i ) {
+      output << presep << fr.vector(i) << '\t' << fr.scalar(i);
+      for ( unsigned int d = 0u; d < fr.NDERIVS; ++d )
+        output << '\t' << fr.da[i][d] << '\t' << fr.dV[i][d];
+      presep = "\t";
+    }
+    return output;
+  }
+
+
+  /** Cartesian field lookup with tricubic Hermite interpolation.
+   * The records must provide vector(i,code) and scalar(i,code) (@see
+   * HermiteForceRecord).  Positions outside of the table are clamped like
+   * FieldLookup.
+   */
+  template < class Record, class Table = detail::DTable<Record> >
+  class HermiteFieldLookup : public FieldLookup<Record,Table> {
+  public:
+    typedef FieldLookup<Record,Table> super;
+    typedef typename super::super Base;
+
+    HermiteFieldLookup() : super() {}
+
+    HermiteFieldLookup(const std::string & filename) : super(filename) { }
+
+    /** Provide acceleration data interpolated from the table. */
+    inline void vector_lookup( Vector<double,3> & retval,
+                               const Vector<double,3> & r,
+                               const unsigned int & i ) const {
+      unsigned int table, xi, yi, zi;
+      double w[3][2][2];
+      weights( table, xi, yi, zi, w, r );
+
+      const typename Base::DTable & t = Base::data[table];
+      retval.zero();
+      for ( unsigned int cz = 0u; cz < 2u; ++cz )
+        for ( unsigned int cx = 0u; cx < 2u; ++cx )
+          for ( unsigned int cy = 0u; cy < 2u; ++cy ) {
+            typename Base::DTable::const_reference rec = t(xi+cx, yi+cy, zi+cz);
+            for ( unsigned int code = 0u; code < 8u; ++code )
+              retval.addFraction( w[X][cx][code & 1u]
+                                * w[Y][cy][(code >> 1) & 1u]
+                                * w[Z][cz][code >> 2],
+                                  rec.vector(i, code) );
+          }
+    }
+
+    /** Provide potential data interpolated from the table. */
+    inline double scalar_lookup( const Vector<double,3> & r,
+                                 const unsigned int & i ) const {
+      unsigned int table, xi, yi, zi;
+      double w[3][2][2];
+      weights( table, xi, yi, zi, w, r );
+
+      const typename Base::DTable & t = Base::data[table];
+      double retval = 0.0;
+      for ( unsigned int cz = 0u; cz < 2u; ++cz )
+        for ( unsigned int cx = 0u; cx < 2u; ++cx )
+          for ( unsigned int cy = 0u; cy < 2u; ++cy ) {
+            typename Base::DTable::const_reference rec = t(xi+cx, yi+cy, zi+cz);
+            for ( unsigned int code = 0u; code < 8u; ++code )
+              retval += w[X][cx][code & 1u]
+                      * w[Y][cy][(code >> 1) & 1u]
+                      * w[Z][cz][code >> 2]
+                      * rec.scalar(i, code);
+          }
+      return retval;
+    }
+
+  private:
+    /** Compute the cell of r and the 1D Hermite weights along each axis:
+     * w[axis][corner][0] multiplies the value and w[axis][corner][1] the
+     * derivative at the corner. */
+    inline void weights( unsigned int & table,
+                         unsigned int & xi,
+                         unsigned int & yi,
+                         unsigned int & zi,
+                         double (&w)[3][2][2],
+                         const Vector<double,3> & r ) const {
+      double f[3];
+      super::getindx( table, xi, f[X], yi, f[Y], zi, f[Z], r );
+      const Vector<double,3> & dx =
+        table == Base::CORE ? Base::core_dx : Base::shell_dx;
+
+      for ( unsigned int d = 0u; d < 3u; ++d ) {
+        const double t = f[d], s = 1.0 - t;
+        w[d][0][0] = (1.0 + 2.0*t) * s*s;
+        w[d][0][1] = t * s*s * dx[d];
+        w[d][1][0] = t*t * (3.0 - 2.0*t);
+        w[d][1][1] = -t*t * s * dx[d];
+      }
+    }
+  };
+
+
+  /** Wrapper for a force to create a table of HermiteForceRecords with
+   * createFieldFile.  The derivatives are computed by central finite
+   * differences (from a 3x3x3 stencil of accel/potential evaluations around
+   * each grid point).  The step must not be too small:  the mixed third
+   * derivative divides by the cube of the step, so round-off quickly swamps
+   * it.  By default, the step is a fraction (fd_fraction) of the spacing of
+   * the table being written (the table writers pass it with each GridPoint);
+   * records of any other points need an explicit fd_step.
+   *
+   * @param T
+   *     The force.
+   * @param L
+   *     Length of the vectors [Default 3].
+   * @param n_species
+   *     Number of species [Default 1].
+   */
+  template < class T, unsigned int L = 3U, unsigned int n_species = 1u >
+  class HermiteTableWrapper : public T {
+  public:
+    typedef T super;
+
+    /** Finite difference step along each axis.  Zero (the default) along
+     * an axis uses fd_fraction of the grid spacing along that axis. */
+    Vector<double,3> fd_step;
+
+    /** Finite difference step relative to the grid spacing [Default 1e-3]. */
+    double fd_fraction;
+
+    HermiteTableWrapper() : super(), fd_step(0.0), fd_fraction(1e-3) { }
+
+    /** The record of a grid point of a table being written. */
+    HermiteForceRecord<L,n_species> getRecord( const GridPoint & r ) const {
+      return compute( r, r.dx );
+    }
+
+    /** The record of any point (needs fd_step along every axis). */
+    HermiteForceRecord<L,n_species> getRecord( const Vector<double,3> & r ) const {
+      return compute( r, Vector<double,3>(0.0) );
+    }
+
+  private:
+    /** The record at r, with the default step relative to grid_dx. */
+    HermiteForceRecord<L,n_species>
+    compute( const Vector<double,3> & r,
+             const Vector<double,3> & grid_dx ) const {
+      using namespace indices;
+      HermiteForceRecord<L,n_species> retval;
+
+      Vector<double,3> h;
+      for ( unsigned int d = 0u; d < 3u; ++d ) {
+        h[d] = fd_step[d] > 0.0 ? fd_step[d] : fd_fraction * grid_dx[d];
+        if ( !( h[d] > 0.0 ) )
+          THROW(std::runtime_error,"HermiteTableWrapper::getRecord:  "
+                                   "unknown finite difference step");
+      }
+
+      for ( unsigned int i = 0u; i < n_species; ++i ) {
+        /* stencil s[z+1][x+1][y+1] */
+        Vector<double,L> a[3][3][3];
+        double V[3][3][3];
+        for ( int dz = -1; dz <= 1; ++dz )
+          for ( int dx = -1; dx <= 1; ++dx )
+            for ( int dy = -1; dy <= 1; ++dy ) {
+              const Vector<double,3> p =
+                r + V3( dx * h[X], dy * h[Y], dz * h[Z] );
+              super::accel( a[dz+1][dx+1][dy+1], p, 0.0, 0.0, 0.0, i );
+              V[dz+1][dx+1][dy+1] = super::potential( p, 0.0, 0.0, i );
+            }
+
+        retval.vector(i) = a[1][1][1];
+        retval.scalar(i) = V[1][1][1];
+        for ( unsigned int code = 1u; code < 8u; ++code ) {
+          const unsigned int d = retval.derivIndex(code);
+          retval.da[i][d] = difference( a, code, h );
+          retval.dV[i][d] = difference( V, code, h );
+        }
+      }
+      return retval;
+    }
+
+    /** Central difference (with step h) of the stencil for the derivative
+     * given by code (@see HermiteForceRecord::derivIndex). */
+    template < typename V >
+    V difference( const V (&s)[3][3][3],
+                  const unsigned int & code,
+                  const Vector<double,3> & h ) const {
+      using namespace indices;
+      const bool px = code & 1u, py = code & 2u, pz = code & 4u;
+      V retval = s[1][1][1] * 0.0;
+      double scale = 1.0;
+      for ( int dz = (pz ? -1 : 0); dz <= (pz ? 1 : 0); dz += 2 )
+        for ( int dx = (px ? -1 : 0); dx <= (px ? 1 : 0); dx += 2 )
+          for ( int dy = (py ? -1 : 0); dy <= (py ? 1 : 0); dy += 2 )
+            retval += double( (px ? dx : 1) * (py ? dy : 1) * (pz ? dz : 1) )
+                    * s[dz+1][dx+1][dy+1];
+      if ( px ) scale *= 2.0 * h[X];
+      if ( py ) scale *= 2.0 * h[Y];
+      if ( pz ) scale *= 2.0 * h[Z];
+      return retval / scale;
+    }
+  };
+
+}/* namespace fields */
+
+#endif // fields_hermite_lookup_h
@@ -0,0 +1,498 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+/** \file
+ * Inspection of field files without loading whole tables:  header and
+ * geometry summaries, extraction of lines and slices, and conversion between
+ * the file formats (one z-plane at a time).
+ */
+
+#ifndef fields_inspect_table_h
+#define fields_inspect_table_h
+
+#include <fields/field-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/detail/table-io.h>
+#include <fields/detail/npy.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+#include <xylose/except.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+
+namespace fields {
+  using namespace indices;
+  using xylose::Vector;
+  using xylose::V3;
+
+  /** Summary of the header of a field file. */
+  struct FieldFileInfo {
+    FieldFileInfo() : r0(0.0), format(TEXT_FILE), columns(0u),
+                      record_size(0u) { }
+
+    /** The reference point. */
+    Vector<double,3> r0;
+    /** Geometry of the CORE (table[0]) and SHELL (table[1]) tables. */
+    TableGeometry table[2];
+    /** Format of the data-blocks. */
+    FileFormat format;
+    /** Number of doubles per record (counted from the first record of text
+     * files). */
+    std::size_t columns;
+    /** Size of the records (in bytes) as stored in memory. */
+    std::size_t record_size;
+    /** Array file of each table for NPY_FILE (as a path usable from the
+     * current directory). */
+    std::string npy_file[2];
+    /** Header of the array file of each table for NPY_FILE. */
+    detail::NpyHeader npy[2];
+    /** The comment lines of the header (without the format markers). */
+    std::string comments;
+
+    /** Memory (in bytes) of table t when loaded whole. */
+    std::size_t bytes( const int & t ) const {
+      return table[t].size() * record_size;
+    }
+  };
+
+  namespace detail {
+    /** Path of a file named in the header of the given field file. */
+    inline std::string besideFile( const std::string & filename,
+                                   const std::string & name ) {
+      const std::string::size_type slash = filename.rfind('/');
+      if ( name.empty() || name[0] == '/' || slash == std::string::npos )
+        return name;
+      return filename.substr( 0, slash + 1u ) + name;
+    }
+
+    /** Whether a comment line only separates parts of the header. */
+    inline bool blankComment( const std::string & cmt ) {
+      return cmt.find_first_not_of( "# \t\r" ) == std::string::npos;
+    }
+
+    /** Read the header of a field file (up to the first data-block) into
+     * info.  For text files, the number of columns of the first record is
+     * counted without consuming it.
+     * @param filename
+     *     Name of the file (to find the array files of NPY_FILE headers).
+     */
+    inline void readFieldHeader( std::istream & in,
+                                 const std::string & filename,
+                                 FieldFileInfo & info ) {
+      if ( !in.good() )
+        THROW(std::runtime_error,"inspect-table:  invalid stream");
+
+      FieldLookupBase< ForceRecord<3u> >::readGeometry(
+        in, info.r0, info.table[0], info.table[1] );
+      if ( !in )
+        THROW(std::runtime_error,"inspect-table:  invalid field file header");
+
+      info.format = TEXT_FILE;
+      info.comments.clear();
+      while ( in.good() ) {
+        const int c = in.peek();
+        if ( c != '#' && std::isspace(c) ) {
+          (void)in.get();
+          continue;
+        } else if ( c != '#' ) {
+          break;
+        }
+
+        std::string cmt;
+        std::getline( in, cmt );
+        const std::string binary = binaryMarker(), npy = npyMarker();
+        if ( cmt.compare( 0, binary.length(), binary ) == 0 ) {
+          info.format = BINARY_FILE;
+          std::istringstream( cmt.substr(binary.length()) ) >> info.record_size;
+          break;
+        } else if ( cmt.compare( 0, npy.length(), npy ) == 0 ) {
+          info.format = NPY_FILE;
+          std::istringstream files( cmt.substr(npy.length()) );
+          files >> info.npy_file[0] >> info.npy_file[1];
+          break;
+        } else if ( !blankComment(cmt) ) {
+          info.comments += cmt + '\n';
+        }
+      }
+
+      if ( info.format == BINARY_FILE ) {
+        info.columns = info.record_size / sizeof(double);
+      } else if ( info.format == NPY_FILE ) {
+        for ( int t = 0; t < 2; ++t ) {
+          info.npy_file[t] = besideFile( filename, info.npy_file[t] );
+          std::ifstream a( info.npy_file[t].c_str(),
+                           std::ios::in | std::ios::binary );
+          if ( !a.good() )
+            THROW(std::runtime_error,"inspect-table:  could not open '" +
+                                     info.npy_file[t] + '\'');
+          readNpyHeader( a, info.npy[t] );
+          if ( info.npy[t].shape.size() != 4u ||
+               !info.npy[t].isTable( info.table[t].N, info.npy[t].shape[3] ) )
+            THROW(std::runtime_error,"inspect-table:  shape of '" +
+                                     info.npy_file[t] + "' does not match "
+                                     "the header");
+        }
+        info.columns = info.npy[0].shape[3];
+        info.record_size = info.columns * sizeof(double);
+      } else {
+        /* count the columns of the first record. */
+        const std::streampos data = in.tellg();
+        std::string line;
+        std::getline( in, line );
+        std::istringstream cols( line );
+        info.columns = 0u;
+        for ( std::string c; cols >> c; ++info.columns );
+        info.record_size = info.columns * sizeof(double);
+        in.clear();
+        in.seekg( data );
+      }
+    }
+
+    /** Reads the records of one table of a field file, one z-plane at a
+     * time. */
+    template < class Record >
+    class FieldPlaneReader {
+    public:
+      /** Prepare reading table t.  For text and binary files, the stream
+       * must be positioned at the data-block of the table. */
+      FieldPlaneReader( std::istream & in,
+                        const FieldFileInfo & info,
+                        const int & t )
+        : in(in), info(info), t(t), k(0) {
+        if ( info.format != NPY_FILE )
+          return;
+
+        const NpyHeader & h = info.npy[t];
+        if ( sizeof(Record) % sizeof(double) != 0u ||
+             h.shape[3] != sizeof(Record) / sizeof(double) )
+          THROW(std::runtime_error,"inspect-table:  records of '" +
+                                   info.npy_file[t] + "' do not match");
+        array.open( info.npy_file[t].c_str(), std::ios::in | std::ios::binary );
+        array.seekg( h.offset );
+        if ( h.fortran_order ) /* (column-major arrays are read whole.) */
+          readNpyDoubles( array, h, whole );
+      }
+
+      /** Read the next z-plane (Nx*Ny records, x slowest). */
+      void read( std::vector<Record> & plane ) {
+        const Vector<int,3> & N = info.table[t].N;
+        if ( k >= N[Z] )
+          THROW(std::runtime_error,"inspect-table:  read past the table");
+        plane.resize( std::size_t(N[X]) * N[Y] );
+
+        if ( info.format == TEXT_FILE ) {
+          for ( std::size_t e = 0u; e < plane.size(); ++e )
+            in >> plane[e];
+        } else if ( info.format == BINARY_FILE ) {
+          in.read( reinterpret_cast<char*>(&plane[0]),
+                   plane.size() * sizeof(Record) );
+        } else {
+          const std::size_t K = sizeof(Record) / sizeof(double);
+          const std::size_t n = plane.size() * K;
+          const double * src;
+          if ( !whole.empty() ) {
+            src = &whole[ std::size_t(k) * n ];
+          } else {
+            values.resize( n );
+            readNpyElements( array, info.npy[t], &values[0], n );
+            src = &values[0];
+          }
+          std::memcpy( static_cast<void*>(&plane[0]), src, n * sizeof(double) );
+        }
+
+        if ( !in || !array )
+          THROW(std::runtime_error,"inspect-table:  truncated data-block");
+        ++k;
+      }
+
+    private:
+      std::istream & in;
+      const FieldFileInfo & info;
+      const int t;
+      int k;
+      std::ifstream array;
+      std::vector<double> whole, values;
+    };
+  }/* namespace fields::detail */
+
+  /** Read the header of a field file.
+   * @see FieldFileInfo.
+   */
+  inline FieldFileInfo readFieldFileInfo( const std::string & filename ) {
+    std::ifstream in( filename.c_str(), std::ios::in | std::ios::binary );
+    if ( !in.good() )
+      THROW(std::runtime_error,"inspect-table:  could not open '" +
+                               filename + '\'');
+    FieldFileInfo info;
+    detail::readFieldHeader( in, filename, info );
+    return info;
+  }
+
+  /** Print a summary of the header, the geometry, and the memory needed to
+   * load the tables. */
+  inline std::ostream & operator<< ( std::ostream & out,
+                                     const FieldFileInfo & info ) {
+    const char * formats[] = { "text", "binary", "npy" };
+    const char * names[] = { "CORE", "SHELL" };
+    const double MB = 1048576.;
+
+    out << "format       " << formats[info.format];
+    if ( info.format == NPY_FILE )
+      out << " (" << info.npy_file[0] << ", " << info.npy_file[1] << ')';
+    out << "\nrecord       " << info.columns << " doubles ("
+        << info.record_size << " bytes)\n"
+           "center       " << info.r0 << '\n';
+    for ( int t = 0; t < 2; ++t ) {
+      const TableGeometry & g = info.table[t];
+      out << names[t] << '\n'
+          << "  N          " << g.N   << '\n'
+          << "  dx         " << g.dx  << '\n'
+          << "  min        " << g.min << '\n'
+          << "  max        " << g.max << '\n'
+          << "  memory     " << info.bytes(t) / MB << " MB\n";
+      if ( info.format == NPY_FILE )
+        out << "  dtype      " << info.npy[t].descr
+            << ( info.npy[t].fortran_order ? " (column-major)" : "" ) << '\n';
+    }
+
+    const std::size_t plane =
+      std::max( std::size_t(info.table[0].N[X]) * info.table[0].N[Y],
+                std::size_t(info.table[1].N[X]) * info.table[1].N[Y] )
+      * info.record_size;
+    out << "memory       " << (info.bytes(0) + info.bytes(1)) / MB
+        << " MB (" << (info.bytes(0) + info.bytes(1)) / 2. / MB
+        << " MB in single precision)\n"
+           "plane        " << plane / MB << " MB (per z-plane when converting)\n";
+    if ( !info.comments.empty() )
+      out << "comments\n" << info.comments;
+    return out;
+  }
+
+  /** Convert a field file to another format, reading and writing one z-plane
+   * at a time (so that the memory needed is that of a plane).  Column-major
+   * NumPy arrays are the exception:  they are read one table at a time.
+   * Text is written with 17 significant digits, so that converting a binary
+   * table to text and back is lossless.
+   * @param input
+   *     The field file to convert.
+   * @param output
+   *     The file to write (for NPY_FILE, the array files are written next to
+   *     it).
+   * @param format
+   *     Format of the output.
+   * @param single_precision
+   *     Store the NumPy arrays as floats (only for NPY_FILE).  Such tables are
+   *     converted back to doubles when read.
+   */
+  template < class Record >
+  void convertFieldFile( const std::string & input,
+                         const std::string & output,
+                         const FileFormat & format,
+                         const bool & single_precision = false ) {
+    if ( single_precision && format != NPY_FILE )
+      THROW(std::runtime_error,"convertFieldFile:  single precision is only "
+                               "available for NPY_FILE");
+    const std::size_t K = sizeof(Record) / sizeof(double);
+    if ( format == NPY_FILE && sizeof(Record) % sizeof(double) != 0u )
+      THROW(std::runtime_error,"convertFieldFile:  NPY_FILE needs records "
+                               "made of doubles");
+
+    std::ifstream in( input.c_str(), std::ios::in | std::ios::binary );
+    if ( !in.good() )
+      THROW(std::runtime_error,"convertFieldFile:  could not open '" +
+                               input + '\'');
+    FieldFileInfo info;
+    detail::readFieldHeader( in, input, info );
+    if ( info.record_size != sizeof(Record) )
+      THROW(std::runtime_error,"convertFieldFile:  records of '" + input +
+                               "' do not match the record type");
+
+    /* the array files are named relative to the header file. */
+    const std::string::size_type slash = output.rfind('/');
+    const std::string dir = slash == std::string::npos
+                          ? "" : output.substr( 0, slash + 1u );
+    const std::string base = output.substr( dir.length() );
+    const std::string npy[2] = { base + ".core.npy", base + ".shell.npy" };
+
+    std::ofstream out( output.c_str(), std::ios::out | std::ios::binary );
+    out.precision(17);
+    out << std::scientific;
+    const TableGeometry (&g)[2] = info.table;
+    writeFieldHeader( out, info.r0,
+                      g[0].N, g[0].dx, g[0].min, g[0].max,
+                      g[1].N, g[1].dx, g[1].min, g[1].max,
+                      format == NPY_FILE
+                        ? info.comments + detail::npyMarker() + ' ' + npy[0]
+                                        + ' ' + npy[1] + '\n'
+                        : info.comments,
+                      format, sizeof(Record) );
+
+    std::vector<Record> plane;
+    std::vector<float> floats;
+    for ( int t = 0; t < 2; ++t ) {
+      detail::FieldPlaneReader<Record> reader( in, info, t );
+
+      std::ofstream array;
+      std::ostream * dst = &out;
+      if ( format == NPY_FILE ) {
+        array.open( (dir + npy[t]).c_str(), std::ios::out | std::ios::binary );
+        std::vector<std::size_t> shape(4);
+        shape[0] = g[t].N[Z];
+        shape[1] = g[t].N[X];
+        shape[2] = g[t].N[Y];
+        shape[3] = K;
+        detail::writeNpyHeader( array, shape,
+                                single_precision ? detail::npyFloatDescr()
+                                                 : detail::npyDoubleDescr() );
+        dst = &array;
+      }
+
+      for ( int k = 0; k < g[t].N[Z]; ++k ) {
+        reader.read( plane );
+        if ( format == TEXT_FILE ) {
+          for ( std::size_t e = 0u; e < plane.size(); ++e )
+            out << plane[e] << '\n';
+          out << '\n';
+        } else if ( single_precision ) {
+          const double * v = reinterpret_cast<const double*>( &plane[0] );
+          floats.assign( v, v + plane.size() * K );
+          dst->write( reinterpret_cast<const char*>(&floats[0]),
+                      floats.size() * sizeof(float) );
+        } else {
+          dst->write( reinterpret_cast<const char*>(&plane[0]),
+                      plane.size() * sizeof(Record) );
+        }
+      }
+
+      if ( format == TEXT_FILE && t == 0 )
+        out << '\n';
+      if ( !dst->good() )
+        THROW(std::runtime_error,"convertFieldFile:  could not write '" +
+                                 output + '\'');
+    }
+  }
+
+  /** Write the vector and scalar (of the given species) along the line from
+   * p0 to p1 (n points), one line of text per point:
+   *    x y z  ax ay az  V
+   * Only the part of the tables that covers the line is loaded.
+   * @param Lookup
+   *     The lookup to interpolate with (e.g. FieldLookup< ForceRecord<3u> >).
+   */
+  template < class Lookup >
+  void extractLine( const std::string & filename,
+                    const Vector<double,3> & p0,
+                    const Vector<double,3> & p1,
+                    const int & n,
+                    std::ostream & out,
+                    const unsigned int & species = 0u ) {
+    /* one cell of margin keeps the ends of the line from being clamped. */
+    const FieldFileInfo info = readFieldFileInfo( filename );
+    Vector<double,3> lo, hi;
+    for ( unsigned int d = 0u; d < 3u; ++d ) {
+      const double margin = std::max( info.table[0].dx[d], info.table[1].dx[d] );
+      lo[d] = std::min( p0[d], p1[d] ) - margin;
+      hi[d] = std::max( p0[d], p1[d] ) + margin;
+    }
+
+    Lookup lookup;
+    lookup.readindata( filename, lo, hi );
+
+    out << "# x y z  ax ay az  V  (species " << species << ")\n";
+    for ( int i = 0; i < n; ++i ) {
+      const Vector<double,3> r = p0 + (p1 - p0) * ( n > 1 ? i / (n - 1.) : 0. );
+      Vector<double,3> a;
+      lookup.vector_lookup( a, r, species );
+      out << r << '\t' << a << '\t' << lookup.scalar_lookup( r, species ) << '\n';
+    }
+  }
+
+  /** Write the vector and scalar (of the given species) on the plane
+   * r[axis] == value over the extent of the tables (n x n points), in the
+   * format of extractLine with a blank line after each row (as for gnuplot's
+   * splot).  Only the part of the tables that covers the plane is loaded.
+   * @see extractLine.
+   */
+  template < class Lookup >
+  void extractSlice( const std::string & filename,
+                     const unsigned int & axis,
+                     const double & value,
+                     const int & n,
+                     std::ostream & out,
+                     const unsigned int & species = 0u ) {
+    if ( axis > Z )
+      THROW(std::runtime_error,"extractSlice:  invalid axis");
+
+    const FieldFileInfo info = readFieldFileInfo( filename );
+    Vector<double,3> lo, hi;
+    for ( unsigned int d = 0u; d < 3u; ++d ) {
+      lo[d] = std::min( info.table[0].min[d], info.table[1].min[d] );
+      hi[d] = std::max( info.table[0].min[d] + (info.table[0].N[d] - 1)
+                                             * info.table[0].dx[d],
+                        info.table[1].min[d] + (info.table[1].N[d] - 1)
+                                             * info.table[1].dx[d] );
+    }
+    lo[axis] = hi[axis] = value;
+
+    Lookup lookup;
+    lookup.readindata( filename, lo, hi );
+
+    const unsigned int u = (axis + 1u) % 3u, v = (axis + 2u) % 3u;
+    const double f = n > 1 ? 1. / (n - 1.) : 0.;
+    out << "# x y z  ax ay az  V  (species " << species << ")\n";
+    for ( int i = 0; i < n; ++i ) {
+      for ( int j = 0; j < n; ++j ) {
+        Vector<double,3> r;
+        r[axis] = value;
+        r[u] = lo[u] + (hi[u] - lo[u]) * i * f;
+        r[v] = lo[v] + (hi[v] - lo[v]) * j * f;
+        Vector<double,3> a;
+        lookup.vector_lookup( a, r, species );
+        out << r << '\t' << a << '\t' << lookup.scalar_lookup( r, species )
+            << '\n';
+      }
+      out << '\n';
+    }
+  }
+
+}/* namespace fields */
+
+#endif // fields_inspect_table_h
@@ -0,0 +1,279 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+/** \file
+ * Optional instrumentation of the field-lookup tables.
+ *
+ * If FIELDS_LOOKUP_STATS is defined before including the field-lookup
+ * headers, every table-index computation of FieldLookup and
+ * AxiSymFieldLookup is counted:  hits of the CORE and SHELL tables, clamp
+ * events (positions outside of the table) per axis, and a coarse occupancy
+ * histogram of each table.  The counters are kept per thread (and are only
+ * updated with relaxed atomic increments) so that lookups from many threads
+ * do not contend.  FieldLookupBase::stats() merges the counters of all
+ * threads.
+ *
+ * Without FIELDS_LOOKUP_STATS, the instrumentation is removed entirely and
+ * stats() always reports zeros.
+ *
+ * Example:
+ * <code>
+ *   #define FIELDS_LOOKUP_STATS
+ *   #include <fields/force-lookup.h>
+ *   ...
+ *   std::cout << lookup.stats() << std::endl;
+ * </code>
+ */
+
+#ifndef fields_lookup_stats_h
+#define fields_lookup_stats_h
+
+#include <fields/detail/omp.h>
+
+#include <xylose/Vector.h>
+
+#ifdef FIELDS_LOOKUP_STATS
+#  include <boost/atomic.hpp>
+#endif
+
+#include <ostream>
+#include <algorithm>
+
+#ifndef FIELDS_LOOKUP_STATS_THREADS
+/** Number of per-thread counter slots.  Threads beyond this number share
+ * slots (which is still correct, but slower). */
+#  define FIELDS_LOOKUP_STATS_THREADS 32
+#endif
+
+namespace fields {
+  using xylose::Vector;
+
+  /** Merged lookup statistics of a lookup table. */
+  struct LookupStats {
+    /** Number of histogram bins along each axis of a table. */
+    static const unsigned int BINS = 8u;
+
+    /** Number of lookups in the CORE table. */
+    unsigned long long core_hits;
+
+    /** Number of lookups in the SHELL table. */
+    unsigned long long shell_hits;
+
+    /** Number of lookups that were clamped to the lower edge of a table
+     * (per axis). */
+    unsigned long long clamp_low[3];
+
+    /** Number of lookups that were clamped to the upper edge of a table
+     * (per axis). */
+    unsigned long long clamp_high[3];
+
+    /** Occupancy of each table (CORE=0, SHELL=1), divided into BINS^3
+     * equal boxes of the table index space:  histogram[table][x][y][z]. */
+    unsigned long long histogram[2][BINS][BINS][BINS];
+
+    LookupStats() { reset(); }
+
+    void reset() {
+      core_hits = shell_hits = 0ull;
+      std::fill( clamp_low, clamp_low + 3, 0ull );
+      std::fill( clamp_high, clamp_high + 3, 0ull );
+      std::fill( &histogram[0][0][0][0], &histogram[0][0][0][0] + 2*BINS*BINS*BINS, 0ull );
+    }
+
+    /** Total number of lookups. */
+    unsigned long long total() const { return core_hits + shell_hits; }
+
+    /** Total number of clamp events (over all axes). */
+    unsigned long long clamps() const {
+      unsigned long long c = 0ull;
+      for ( unsigned int d = 0u; d < 3u; ++d )
+        c += clamp_low[d] + clamp_high[d];
+      return c;
+    }
+
+    /** Fraction of the histogram boxes of the given table that were hit. */
+    double occupancy( const unsigned int & table ) const {
+      unsigned int n = 0u;
+      const unsigned long long * h = &histogram[table][0][0][0];
+      for ( unsigned int i = 0u; i < BINS*BINS*BINS; ++i )
+        n += (h[i] != 0ull);
+      return double(n) / (BINS*BINS*BINS);
+    }
+
+    LookupStats & operator+= ( const LookupStats & that ) {
+      core_hits += that.core_hits;
+      shell_hits += that.shell_hits;
+      for ( unsigned int d = 0u; d < 3u; ++d ) {
+        clamp_low[d] += that.clamp_low[d];
+        clamp_high[d] += that.clamp_high[d];
+      }
+      unsigned long long * h = &histogram[0][0][0][0];
+      const unsigned long long * th = &that.histogram[0][0][0][0];
+      for ( unsigned int i = 0u; i < 2u*BINS*BINS*BINS; ++i )
+        h[i] += th[i];
+      return *this;
+    }
+  };
+
+  /** Print a short summary of the statistics. */
+  inline std::ostream & operator<< ( std::ostream & out,
+                                     const LookupStats & s ) {
+    const double n = std::max( 1.0, double(s.total()) );
+    out << "lookups: " << s.total() << " "
+           "(CORE: " << (100.0 * s.core_hits / n) << "%, "
+           "SHELL: " << (100.0 * s.shell_hits / n) << "%)\n"
+           "clamped (low/high): "
+           "x: " << s.clamp_low[0] << '/' << s.clamp_high[0] << ", "
+           "y: " << s.clamp_low[1] << '/' << s.clamp_high[1] << ", "
+           "z: " << s.clamp_low[2] << '/' << s.clamp_high[2] << "\n"
+           "occupancy: CORE: " << (100.0 * s.occupancy(0u)) << "%, "
+           "SHELL: " << (100.0 * s.occupancy(1u)) << '%';
+    return out;
+  }
+
+  namespace detail {
+
+#ifdef FIELDS_LOOKUP_STATS
+    /** Per-thread lookup counters. */
+    class LookupCounters {
+      /* TYPEDEFS */
+    private:
+      typedef boost::atomic<unsigned long long> Counter;
+
+      static const unsigned int BINS = LookupStats::BINS;
+
+      /** The counters of one thread (padded to keep threads from sharing
+       * cache lines). */
+      struct Slot {
+        Counter hits[2];
+        Counter clamp_low[3];
+        Counter clamp_high[3];
+        Counter histogram[2][BINS][BINS][BINS];
+        char pad[64];
+      };
+
+      /* MEMBER STORAGE */
+    private:
+      Slot * slots;
+
+      /* MEMBER FUNCTIONS */
+    public:
+      LookupCounters() : slots( new Slot[FIELDS_LOOKUP_STATS_THREADS] ) {
+        reset();
+      }
+
+      /** Counters are not copied:  a copy starts with fresh counters. */
+      LookupCounters( const LookupCounters & )
+        : slots( new Slot[FIELDS_LOOKUP_STATS_THREADS] ) {
+        reset();
+      }
+
+      LookupCounters & operator= ( const LookupCounters & ) {
+        reset();
+        return *this;
+      }
+
+      ~LookupCounters() { delete[] slots; }
+
+      void reset() {
+        for ( unsigned int t = 0u; t < FIELDS_LOOKUP_STATS_THREADS; ++t ) {
+          Slot & s = slots[t];
+          for ( unsigned int i = 0u; i < 2u; ++i )
+            s.hits[i].store( 0ull, boost::memory_order_relaxed );
+          for ( unsigned int d = 0u; d < 3u; ++d ) {
+            s.clamp_low[d].store( 0ull, boost::memory_order_relaxed );
+            s.clamp_high[d].store( 0ull, boost::memory_order_relaxed );
+          }
+          Counter * h = &s.histogram[0][0][0][0];
+          for ( unsigned int i = 0u; i < 2u*BINS*BINS*BINS; ++i )
+            h[i].store( 0ull, boost::memory_order_relaxed );
+        }
+      }
+
+      /** Count a lookup.
+       * @param table
+       *     The table that was used.
+       * @param f
+       *     The (unclamped) fractional table indices.
+       * @param N
+       *     The dimensions of the table.  Axes with fewer than two points
+       *     (e.g. the y-axis of the axially symmetric tables) are ignored.
+       */
+      inline void record( const unsigned int & table,
+                          const Vector<double,3> & f,
+                          const Vector<int,3> & N ) {
+        Slot & s = slots[ thread_num() % FIELDS_LOOKUP_STATS_THREADS ];
+        s.hits[table].fetch_add( 1ull, boost::memory_order_relaxed );
+
+        unsigned int b[3] = { 0u, 0u, 0u };
+        for ( unsigned int d = 0u; d < 3u; ++d ) {
+          if ( N[d] < 2 )
+            continue;
+
+          const double top = N[d] - 1.001;
+          if ( f[d] < 0.0 )
+            s.clamp_low[d].fetch_add( 1ull, boost::memory_order_relaxed );
+          else if ( f[d] > top )
+            s.clamp_high[d].fetch_add( 1ull, boost::memory_order_relaxed );
+
+          const double x = std::max( 0.0, std::min( top, f[d] ) );
+          b[d] = std::min( BINS - 1u, (unsigned int)( x * BINS / (N[d] - 1) ) );
+        }
+
+        s.histogram[table][b[0]][b[1]][b[2]]
+          .fetch_add( 1ull, boost::memory_order_relaxed );
+      }
+
+      /** Merge the counters of all threads. */
+      LookupStats stats() const {
+        LookupStats retval;
+        for ( unsigned int t = 0u; t < FIELDS_LOOKUP_STATS_THREADS; ++t ) {
+          const Slot & s = slots[t];
+          retval.core_hits += s.hits[0].load( boost::memory_order_relaxed );
+          retval.shell_hits += s.hits[1].load( boost::memory_order_relaxed );
+          for ( unsigned int d = 0u; d < 3u; ++d ) {
+            retval.clamp_low[d] += s.clamp_low[d].load( boost::memory_order_relaxed );
+            retval.clamp_high[d] += s.clamp_high[d].load( boost::memory_order_relaxed );
+          }
+          const Counter * h = &s.histogram[0][0][0][0];
+          unsigned long long * rh = &retval.histogram[0][0][0][0];
+          for ( unsigned int i = 0u; i < 2u*BINS*BINS*BINS; ++i )
+            rh[i] += h[i].load( boost::memory_order_relaxed );
+        }
+        return retval;
+      }
+    };
+#endif // FIELDS_LOOKUP_STATS
+
+  }/* namespace fields::detail */
+}/* namespace fields */
+
+#endif // fields_lookup_stats_h
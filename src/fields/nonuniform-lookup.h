@@ -0,0 +1,268 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+/** \file
+ * Field-lookup on a stretched (non-uniform) rectilinear grid.
+ * @see createFieldFile.h for routines to help creating the field-lookup table
+ * file.
+ */
+
+#ifndef fields_nonuniform_lookup_h
+#define fields_nonuniform_lookup_h
+
+#include <fields/indices.h>
+#include <fields/GridAxis.h>
+#include <fields/detail/DTable.h>
+
+#include <xylose/Vector.h>
+#include <xylose/except.h>
+
+#include <fstream>
+#include <string>
+#include <sstream>
+#include <stdexcept>
+#include <cctype>
+
+namespace fields {
+  using namespace indices;
+  using xylose::Vector;
+
+  /** Field-lookup on a rectilinear grid with an independent, monotone set of
+   * coordinates along each axis.
+   *
+   * FieldLookup assumes a constant cell size per axis (per table).  Fields
+   * that vary steeply near the sources and slowly elsewhere waste much of a
+   * uniform table.  Using GridAxis::sinh (or an arbitrary coordinate table)
+   * for each axis concentrates the resolution where the gradients are large.
+   * The cell of a position is still found in O(1) per axis (@see GridAxis).
+   * Since the resolution can vary continuously, there is only one table (no
+   * CORE/SHELL).
+   *
+   * The file format is the same as that of FieldLookup, except for the
+   * header:
+   * <pre>
+   *   # GRID : \n
+   *   #   Nx x0 x1 ... \n
+   *   #   Ny y0 y1 ... \n
+   *   #   Nz z0 z1 ... \n
+   *   # \n
+   *   <any number of consecutive comment lines>
+   *   # \n
+   *   DATA
+   * </pre>
+   *
+   * This class can be used in place of FieldLookup in ForceLookup:
+   *   ForceLookup< 3, NonUniformFieldLookup< ForceRecord<> > >.
+   *
+   * @see createFieldFile.h for routines to help creating the field-lookup table
+   * file.
+   */
+  template < class Record >
+  class NonUniformFieldLookup {
+    /* TYPEDEFS */
+  protected:
+    typedef detail::DTable<Record> DTable;
+
+
+    /* MEMBER STORAGE */
+  private:
+    std::string fname;
+    bool initialized;
+
+  protected:
+    /** Coordinates of the grid along x, y, and z. */
+    GridAxis axis[3];
+    DTable data;
+
+
+    /* MEMBER FUNCTIONS */
+  public:
+    /** Default constructor.
+     * Does not initialize the lookup table.
+     */
+    NonUniformFieldLookup() : fname(""), initialized(false) {}
+
+    /** Constructor to read in data from a specific file. */
+    NonUniformFieldLookup(const std::string & filename)
+      : fname(""), initialized(false) {
+      readindata(filename);
+    }
+
+    /** Create a field lookup table where each element in the field is default
+     * initialized (depends on the record constructor). */
+    void initialize( const GridAxis & x,
+                     const GridAxis & y,
+                     const GridAxis & z ) {
+      axis[X] = x;
+      axis[Y] = y;
+      axis[Z] = z;
+      data.initialize( x.size(), y.size(), z.size() );
+    }
+
+    const bool & isInitialized() const { return initialized; }
+
+    /** Coordinates of the grid along the given axis (X, Y, or Z). */
+    const GridAxis & getAxis( const int & i ) const { return axis[i]; }
+
+    /** Read the table from a file.  If filename is empty, the last file is
+     * re-read. */
+    void readindata(const std::string & filename = "") {
+      if (filename.length() != 0) {
+        fname = filename;
+      }
+
+      if (fname.length() == 0) {
+        THROW(std::runtime_error,"nonuniform-lookup:readindata:  missing filename.");
+      }
+
+      std::ifstream infile(fname.c_str());
+
+      if (!infile.good()) {
+        THROW(std::runtime_error,"nonuniform-lookup::readindata:  invalid filename.");
+      }
+
+      readindata(infile);
+    }
+
+    /** Read from an open stream. */
+    void readindata( std::istream & infile ) {
+      if (!infile.good()) {
+        THROW(std::runtime_error,"nonuniform-lookup::readindata:  invalid stream.");
+      }
+
+      {
+        char pound;
+        char line[1024];
+        GridAxis _x, _y, _z;
+
+        infile >> pound; infile.getline(line,sizeof(line)); /* # GRID : */
+        infile >> pound >> _x;
+        infile >> pound >> _y;
+        infile >> pound >> _z;
+
+        if ( !infile ) {
+          THROW(std::runtime_error,"nonuniform-lookup::readindata:  field filename header incorrect");
+        }
+
+        initialize( _x, _y, _z );
+      }
+
+      /* now read in all comment lines and skip them */
+      while (infile.good()) {
+        char testchar = infile.peek();
+        if (isspace(testchar)) {
+          (void)infile.get();
+        } else if (testchar == '#') {
+          /* read past comments. */
+          std::stringbuf cmtbuf;
+          infile.get(cmtbuf, '\n');
+        } else {
+          break;
+        }
+      }
+
+      data.readindata(infile);
+
+      initialized = true;
+    }
+
+    /** Provide acceleration data from a file source.
+     * The following employs a 3D lever rule, or triangle rule.
+     * @see Jackson's E&M book.
+     */
+    inline void vector_lookup( Vector<double,3> & retval,
+                               const Vector<double,3> & r,
+                               const unsigned int & i ) const {
+      register unsigned int xi, yi, zi;
+      register double xf, yf, zf, xF, yF, zF;
+      getindx(xi, xf, yi, yf, zi, zf, r);
+      xF = 1.0 - xf;
+      yF = 1.0 - yf;
+      zF = 1.0 - zf;
+
+      retval.zero();
+      retval.addFraction(xF*yF*zF, data(xi  ,yi  ,zi  ).vector(i));
+      retval.addFraction(xf*yF*zF, data(xi+1,yi  ,zi  ).vector(i));
+      retval.addFraction(xF*yf*zF, data(xi  ,yi+1,zi  ).vector(i));
+      retval.addFraction(xf*yf*zF, data(xi+1,yi+1,zi  ).vector(i));
+      retval.addFraction(xF*yF*zf, data(xi  ,yi  ,zi+1).vector(i));
+      retval.addFraction(xf*yF*zf, data(xi+1,yi  ,zi+1).vector(i));
+      retval.addFraction(xF*yf*zf, data(xi  ,yi+1,zi+1).vector(i));
+      retval.addFraction(xf*yf*zf, data(xi+1,yi+1,zi+1).vector(i));
+    }
+
+    /** Provide potential data from a file source.
+     * The following employs a 3D lever rule, or triangle rule.
+     * @see Jackson's E&M book.
+     */
+    inline double scalar_lookup(const Vector<double,3> & r, const unsigned int & i) const {
+      register unsigned int xi, yi, zi;
+      register double xf, yf, zf, xF, yF, zF;
+      getindx(xi, xf, yi, yf, zi, zf, r);
+      xF = 1.0 - xf;
+      yF = 1.0 - yf;
+      zF = 1.0 - zf;
+
+      return xF*yF*zF * data(xi  ,yi  ,zi  ).scalar(i)
+           + xf*yF*zF * data(xi+1,yi  ,zi  ).scalar(i)
+           + xF*yf*zF * data(xi  ,yi+1,zi  ).scalar(i)
+           + xf*yf*zF * data(xi+1,yi+1,zi  ).scalar(i)
+           + xF*yF*zf * data(xi  ,yi  ,zi+1).scalar(i)
+           + xf*yF*zf * data(xi+1,yi  ,zi+1).scalar(i)
+           + xF*yf*zf * data(xi  ,yi+1,zi+1).scalar(i)
+           + xf*yf*zf * data(xi+1,yi+1,zi+1).scalar(i);
+    }
+
+    /** Obtain the nearest record of the lookup table.  */
+    Record & getRecord( const Vector<double,3> & r ) {
+      register unsigned int xi, yi, zi;
+      register double xf, yf, zf;
+      getindx(xi, xf, yi, yf, zi, zf, r);
+      return data( xi + (xf >= 0.5), yi + (yf >= 0.5), zi + (zf >= 0.5) );
+    }
+
+  private:
+    inline void getindx ( unsigned int & xi,
+                          double       & xf,
+                          unsigned int & yi,
+                          double       & yf,
+                          unsigned int & zi,
+                          double       & zf,
+                          const Vector<double,3> & r) const {
+      axis[X].locate( r[X], xi, xf );
+      axis[Y].locate( r[Y], yi, yf );
+      axis[Z].locate( r[Z], zi, zf );
+    }
+  };
+
+}/* namespace fields */
+
+#endif // fields_nonuniform_lookup_h
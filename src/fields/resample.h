@@ -0,0 +1,391 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+
+/** \file
+ * Resample a field-lookup table onto a new grid.
+ *
+ * The records of the new grid are interpolated from an existing table
+ * (FieldLookup or AxiSymFieldLookup) either with the interpolant of the
+ * table itself or with a (higher order) tricubic interpolant.  The planes of
+ * the new table are calculated in parallel and written as they are
+ * completed.  To resample tables that do not fit into memory, the input can
+ * be read in bands of planes (@see resampleFieldFile).
+ *
+ * Example:
+ * <code>
+ *   typedef fields::FieldLookup< fields::ForceRecord<> > Lookup;
+ *   std::ofstream out( "fine.dat" );
+ *   fields::resampleFieldFile< Lookup >( "coarse.dat", out,
+ *                                        X_MINc, X_MAXc, dxc,
+ *                                        X_MINs, X_MAXs, dxs,
+ *                                        fields::CUBIC_INTERPOLANT );
+ * </code>
+ */
+
+#ifndef fields_resample_h
+#define fields_resample_h
+
+#include <fields/field-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+#include <xylose/except.h>
+
+#include <string>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+namespace fields {
+
+  using xylose::Vector;
+  using xylose::V3;
+
+  /** Interpolant used to resample a table. */
+  enum Interpolant {
+    /** The (trilinear) interpolant of the lookup table itself. */
+    TABLE_INTERPOLANT = 0,
+    /** Tricubic (Catmull-Rom) interpolant of the table records.  This is
+     * exact for quadratic fields and is continuous across cells. */
+    CUBIC_INTERPOLANT = 1
+  };
+
+  namespace detail {
+
+    /** Position (in the lab frame) of a point given in the coordinates of a
+     * table of a FieldLookup. */
+    template < class R, class T >
+    inline Vector<double,3> labPoint( const FieldLookup<R,T> &,
+                                      const Vector<double,3> & p ) {
+      return p;
+    }
+
+    /** Position (in the lab frame) of a point given in the coordinates of a
+     * table of an AxiSymFieldLookup, i.e. relative to the origin and in the
+     * rotated frame. */
+    template < class R, class T >
+    inline Vector<double,3> labPoint( const AxiSymFieldLookup<R,T> & lookup,
+                                      const Vector<double,3> & p ) {
+      Vector<double,3> r = lookup.origin();
+      for ( unsigned int i = 0u; i < 3u; ++i )
+        for ( unsigned int j = 0u; j < 3u; ++j )
+          r[i] += lookup.R[j][i] * p[j];
+      return r;
+    }
+
+    /** Grid coordinates of a point given in the coordinates of a table. */
+    template < class R, class T >
+    inline Vector<double,3> gridPoint( const FieldLookup<R,T> &,
+                                       const Vector<double,3> & p ) {
+      return p;
+    }
+
+    template < class R, class T >
+    inline Vector<double,3> gridPoint( const AxiSymFieldLookup<R,T> &,
+                                       const Vector<double,3> & p ) {
+      return V3( std::sqrt( SQR(p[X]) + SQR(p[Y]) ), 0.0, p[Z] );
+    }
+
+    /** Reference point of the resampled table:  the center of the new CORE
+     * table for Cartesian tables. */
+    template < class R, class T >
+    inline Vector<double,3> resampledOrigin( const FieldLookup<R,T> &,
+                                             const Vector<double,3> &,
+                                             const Vector<double,3> & X_MINc,
+                                             const Vector<double,3> & X_MAXc ) {
+      return X_MINc + 0.5*(X_MAXc - X_MINc);
+    }
+
+    /** The coordinates of axially symmetric tables are relative to their
+     * reference point, which is therefore kept. */
+    template < class R, class T >
+    inline Vector<double,3> resampledOrigin( const AxiSymFieldLookup<R,T> &,
+                                             const Vector<double,3> & r0,
+                                             const Vector<double,3> &,
+                                             const Vector<double,3> & ) {
+      return r0;
+    }
+
+    /** Whether the input table can be read in bands.  Regions of interest of
+     * axially symmetric tables would move their reference point. */
+    template < class R, class T >
+    inline bool bandable( const FieldLookup<R,T> & ) { return true; }
+
+    template < class R, class T >
+    inline bool bandable( const AxiSymFieldLookup<R,T> & ) { return false; }
+
+    /** Catmull-Rom weights for the grid points at offsets -1, 0, 1, 2 from
+     * the cell that contains fraction t. */
+    inline void cubicWeights( const double & t, double w[4] ) {
+      const double t2 = t*t, t3 = t2*t;
+      w[0] = 0.5 * ( -t3 + 2.0*t2 - t );
+      w[1] = 0.5 * ( 3.0*t3 - 5.0*t2 + 2.0 );
+      w[2] = 0.5 * ( -3.0*t3 + 4.0*t2 + t );
+      w[3] = 0.5 * ( t3 - t2 );
+    }
+
+    /** Lagrange weights for the n grid points at offsets 0..n-1 and position
+     * f (in units of the grid spacing). */
+    inline void lagrangeWeights( const double & f, const int & n, double w[4] ) {
+      for ( int m = 0; m < n; ++m ) {
+        w[m] = 1.0;
+        for ( int l = 0; l < n; ++l )
+          if ( l != m )
+            w[m] *= ( f - l ) / double( m - l );
+      }
+    }
+
+    /** Points and weights of the cubic interpolant along one axis of a grid
+     * with N points.  In the cells at the edges of the grid, the Catmull-Rom
+     * stencil would run off of the grid and the (one-sided) Lagrange
+     * polynomial through the nearest (up to) four points is used instead.
+     * @return The number of points.
+     */
+    inline int cubicStencil( const double & f, const int & N,
+                             int idx[4], double w[4] ) {
+      if ( N < 2 ) {
+        idx[0] = 0;
+        w[0] = 1.0;
+        return 1;
+      }
+
+      const double fc = std::max( 0.0, std::min( N - 1.0, f ) );
+      const int i = std::min( int(fc), N - 2 );
+      const int n = std::min( N, 4 );
+      const int first = std::max( 0, std::min( N - n, i - 1 ) );
+
+      if ( n == 4 && first == i - 1 )
+        cubicWeights( fc - i, w );
+      else
+        lagrangeWeights( fc - first, n, w );
+
+      for ( int m = 0; m < n; ++m )
+        idx[m] = first + m;
+      return n;
+    }
+
+    /** Interpolate a record with the interpolant of the lookup table. */
+    template < unsigned int N, class Lookup >
+    inline void tableRecord( ForceRecord<3u,N> & rec,
+                             const Lookup & lookup,
+                             const Vector<double,3> & r ) {
+      for ( unsigned int i = 0u; i < N; ++i ) {
+        lookup.vector_lookup( rec.vector(i), r, i );
+        rec.scalar(i) = lookup.scalar_lookup( r, i );
+      }
+    }
+
+    /** Interpolate a record with the cubic interpolant of the table records
+     * (@see cubicStencil).  Positions beyond the edges of the table are
+     * clamped. */
+    template < unsigned int N, class Lookup >
+    inline void cubicRecord( ForceRecord<3u,N> & rec,
+                             const Lookup & lookup,
+                             const Vector<double,3> & r,
+                             const Vector<double,3> & q ) {
+      typedef typename Lookup::DSECT DSECT;
+      const DSECT t = static_cast<DSECT>( lookup.whichTable(r) );
+      const TableGeometry g = lookup.geometry(t);
+      const typename Lookup::table_type & table = lookup.table(t);
+
+      int idx[3][4], n[3];
+      double w[3][4];
+      for ( unsigned int d = 0u; d < 3u; ++d )
+        n[d] = cubicStencil( (q[d] - g.min[d]) / g.dx[d], g.N[d], idx[d], w[d] );
+
+      rec = ForceRecord<3u,N>();
+      for ( int k = 0; k < n[Z]; ++k )
+        for ( int i = 0; i < n[X]; ++i )
+          for ( int j = 0; j < n[Y]; ++j ) {
+            const double wijk = w[X][i] * w[Y][j] * w[Z][k];
+            typename Lookup::table_type::const_reference e =
+              table( idx[X][i], idx[Y][j], idx[Z][k] );
+            for ( unsigned int s = 0u; s < N; ++s ) {
+              rec.vector(s).addFraction( wijk, e.vector(s) );
+              rec.scalar(s) += wijk * e.scalar(s);
+            }
+          }
+    }
+
+  }/* namespace fields::detail */
+
+  /** Source of records (for createFieldFile and spitfieldplanes) that
+   * interpolates an existing lookup table.  The positions given to getRecord
+   * are in the coordinates of the table:  lab coordinates for FieldLookup and
+   * (rho,0,z) relative to the reference point (and rotation) of an
+   * AxiSymFieldLookup.
+   *
+   * @param Lookup
+   *     The FieldLookup or AxiSymFieldLookup (or ForceLookup thereof).
+   * @param Record
+   *     The type of record returned; a ForceRecord<3,N>
+   *     [Default Lookup::record_type].
+   */
+  template < class Lookup, class Record = typename Lookup::record_type >
+  class TableInterpolant {
+  public:
+    TableInterpolant( const Lookup & lookup,
+                      const Interpolant & kind = TABLE_INTERPOLANT )
+      : lookup(lookup), kind(kind) { }
+
+    Record getRecord( const Vector<double,3> & p ) const {
+      Record rec;
+      const Vector<double,3> r = detail::labPoint( lookup, p );
+      if ( kind == CUBIC_INTERPOLANT )
+        detail::cubicRecord( rec, lookup, r, detail::gridPoint( lookup, p ) );
+      else
+        detail::tableRecord( rec, lookup, r );
+      return rec;
+    }
+
+  private:
+    const Lookup & lookup;
+    const Interpolant kind;
+  };
+
+  /** Resample the table of a field file onto a new grid and write the result
+   * as a new field file.  The geometry parameters have the same meaning as
+   * for createFieldFile;  for axially symmetric tables they are given in the
+   * (rho,0,z) coordinates of the table.
+   *
+   * @param input
+   *     Name of the field file to resample.
+   * @param fieldout
+   *     The place to store the new field file.
+   * @param interp
+   *     Interpolant of the input table [Default TABLE_INTERPOLANT].
+   * @param format
+   *     Format of the data-blocks of the output [Default TEXT_FILE].
+   * @param band
+   *     If positive, the output is calculated band planes at a time and only
+   *     the part of the input that covers each band is read (@see
+   *     FieldLookupBase::readindata with a region of interest).  This bounds
+   *     the memory to that of a band of the input, at the expense of reading
+   *     the input once per band (which is cheap only for BINARY_FILE input).
+   *     Axially symmetric tables are always read whole [Default 0].
+   * @param comments
+   *     A set of lines that begin with '#' each.
+   *
+   * @return The number of records written.
+   */
+  template < class Lookup >
+  long resampleFieldFile( const std::string & input,
+                          std::ostream & fieldout,
+                          const Vector<double,3> & X_MINc,
+                          const Vector<double,3> & X_MAXc,
+                          const Vector<double,3> & dxc,
+                          const Vector<double,3> & X_MINs,
+                          const Vector<double,3> & X_MAXs,
+                          const Vector<double,3> & dxs,
+                          const Interpolant & interp = TABLE_INTERPOLANT,
+                          const FileFormat & format = TEXT_FILE,
+                          const int & band = 0,
+                          const std::string & comments = "" ) {
+    typedef typename Lookup::record_type Record;
+
+    /* geometry of the input. */
+    Vector<double,3> in_r0;
+    TableGeometry in_core, in_shell;
+    {
+      std::ifstream infile( input.c_str() );
+      if ( !infile.good() )
+        THROW(std::runtime_error,
+              "resampleFieldFile:  could not open '" + input + '\'');
+      Lookup::readGeometry( infile, in_r0, in_core, in_shell );
+    }
+
+    Vector<int,3> N[2];
+    N[0] = compDiv( X_MAXc - X_MINc, dxc ) + 1.0;
+    N[1] = compDiv( X_MAXs - X_MINs, dxs ) + 1.0;
+    const Vector<double,3> min[2] = { X_MINc, X_MINs };
+    const Vector<double,3> dx[2]  = { dxc, dxs };
+
+    long n = 0;
+    Lookup * lookup = new Lookup;
+    try {
+      writeFieldHeader( fieldout,
+                        detail::resampledOrigin( *lookup, in_r0, X_MINc, X_MAXc ),
+                        N[0], dxc, X_MINc, X_MAXc,
+                        N[1], dxs, X_MINs, X_MAXs,
+                        comments, format, detail::recordSize( Record() ) );
+
+      if ( band <= 0 || !detail::bandable( *lookup ) ) {
+        lookup->readindata( input );
+        TableInterpolant<Lookup> src( *lookup, interp );
+        for ( int s = 0; s < 2; ++s ) {
+          n += spitfieldplanes( fieldout, src, min[s], N[s], dx[s], format );
+          if ( s == 0 && format == TEXT_FILE )
+            fieldout << '\n';
+        }
+      } else {
+        /* enough of the input around each band for the cubic interpolant. */
+        Vector<double,3> pad;
+        for ( unsigned int d = 0u; d < 3u; ++d )
+          pad[d] = 2.0 * std::max( in_core.dx[d], in_shell.dx[d] );
+
+        for ( int s = 0; s < 2; ++s ) {
+          for ( int k0 = 0; k0 < N[s][Z]; k0 += band ) {
+            Vector<int,3> Nb = N[s];
+            Nb[Z] = std::min( band, N[s][Z] - k0 );
+            const Vector<double,3> lo = min[s] + V3( 0., 0., k0*dx[s][Z] );
+            const Vector<double,3> hi =
+              lo + compMult( (Nb - 1).to_type<double>(), dx[s] );
+
+            delete lookup;
+            lookup = NULL;
+            lookup = new Lookup;
+            lookup->readindata( input, lo - pad, hi + pad, Vector<int,3>(1) );
+
+            TableInterpolant<Lookup> src( *lookup, interp );
+            n += spitfieldplanes( fieldout, src, lo, Nb, dx[s], format );
+          }
+
+          if ( s == 0 && format == TEXT_FILE )
+            fieldout << '\n';
+        }
+      }
+    } catch (...) {
+      delete lookup;
+      throw;
+    }
+
+    delete lookup;
+    return n;
+  }
+
+}/* namespace fields */
+
+#endif // fields_resample_h
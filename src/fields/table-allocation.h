@@ -0,0 +1,252 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+/** \file
+ * Memory allocation options for the field-lookup tables.
+ *
+ * Large tables suffer from TLB misses when backed by 4 KB pages, and on
+ * multi-socket machines half of the threads read the table across the
+ * socket interconnect.  The storage of a table can therefore be
+ *   - backed by transparent huge pages (a hint to the kernel) or by explicit
+ *     2 MB / 1 GB huge pages (which must have been reserved, e.g. via
+ *     /proc/sys/vm/nr_hugepages; allocation fails otherwise), and/or
+ *   - replicated on every NUMA node, with each thread reading the replica
+ *     of the node that it runs on.
+ *
+ * The options are set on each table before the table is initialized or read
+ * in:
+ * <code>
+ *   fields::ForceLookup<> lookup;
+ *   fields::setAllocation( lookup, fields::TableAllocation(
+ *     fields::HUGE_PAGES_2MB, true ) );
+ *   lookup.readindata( "field.dat" );
+ * </code>
+ *
+ * Threads determine their NUMA node the first time that they read a
+ * replicated table.  Threads should therefore be pinned (e.g. with
+ * OMP_PROC_BIND=true) or call detail::refreshNumaNode() after migrating.
+ * These options are only implemented on Linux; elsewhere they are ignored.
+ */
+
+#ifndef fields_table_allocation_h
+#define fields_table_allocation_h
+
+#include <xylose/except.h>
+
+#include <stdexcept>
+#include <cstddef>
+#include <cstdio>
+
+#ifdef __linux__
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+#ifndef FIELDS_MAX_NUMA_NODES
+/** Maximum number of NUMA nodes that tables are replicated on. */
+#  define FIELDS_MAX_NUMA_NODES 8
+#endif
+
+namespace fields {
+
+  /** Pages used to back a lookup table. */
+  enum PageSize {
+    /** Use the normal allocator. */
+    DEFAULT_PAGES = 0,
+    /** Ask the kernel to back the table with transparent huge pages. */
+    TRANSPARENT_HUGE_PAGES = 1,
+    /** Explicit 2 MB huge pages. */
+    HUGE_PAGES_2MB = 2,
+    /** Explicit 1 GB huge pages. */
+    HUGE_PAGES_1GB = 3
+  };
+
+  /** Allocation options of a lookup table. */
+  struct TableAllocation {
+    /** Pages used to back the table. */
+    PageSize pages;
+
+    /** Whether the table is replicated on every NUMA node. */
+    bool numa_replicas;
+
+    TableAllocation( const PageSize & pages = DEFAULT_PAGES,
+                     const bool & numa_replicas = false )
+      : pages(pages), numa_replicas(numa_replicas) { }
+
+    /** Whether the normal allocator can be used. */
+    bool isDefault() const { return pages == DEFAULT_PAGES && !numa_replicas; }
+  };
+
+  /** Set the allocation options of both tables of a lookup.  This must be
+   * done before the lookup is initialized or reads its data. */
+  template < typename Lookup >
+  inline void setAllocation( Lookup & lookup, const TableAllocation & alloc ) {
+    lookup.table(Lookup::CORE).setAllocation(alloc);
+    lookup.table(Lookup::SHELL).setAllocation(alloc);
+  }
+
+  namespace detail {
+
+    /** Number of NUMA nodes (1 if unknown). */
+    inline int numaNodes() {
+      static int n = 0;
+      if ( n == 0 ) {
+        int nodes = 1;
+        #ifdef __linux__
+          std::FILE * f =
+            std::fopen("/sys/devices/system/node/possible", "r");
+          if ( f ) {
+            int lo = 0, hi = 0;
+            int nread = std::fscanf( f, "%d-%d", &lo, &hi );
+            if ( nread == 2 )
+              nodes = hi + 1;
+            std::fclose(f);
+          }
+        #endif
+        n = nodes < FIELDS_MAX_NUMA_NODES ? nodes : FIELDS_MAX_NUMA_NODES;
+      }
+      return n;
+    }
+
+    /** Query the NUMA node that the calling thread runs on. */
+    inline int queryNumaNode() {
+      #if defined(__linux__) && defined(SYS_getcpu)
+        unsigned int cpu = 0u, node = 0u;
+        if ( syscall( SYS_getcpu, &cpu, &node, NULL ) == 0 )
+          return int(node);
+      #endif
+      return 0;
+    }
+
+    #if defined(__GNUC__)
+      /** NUMA node of the calling thread, as of its last query. */
+      inline int & cachedNumaNode() {
+        static __thread int node = -1;
+        return node;
+      }
+    #endif
+
+    /** NUMA node of the calling thread.  The node is queried once per thread
+     * (@see refreshNumaNode). */
+    inline int numaNode() {
+      #if defined(__GNUC__)
+        int & node = cachedNumaNode();
+        if ( node < 0 )
+          node = queryNumaNode();
+        return node;
+      #else
+        return queryNumaNode();
+      #endif
+    }
+
+    /** Query the NUMA node of the calling thread again (e.g. after the thread
+     * has been moved to another CPU). */
+    inline void refreshNumaNode() {
+      #if defined(__GNUC__)
+        cachedNumaNode() = queryNumaNode();
+      #endif
+    }
+
+    /** Allocate memory for a table.
+     * @param bytes
+     *     Size of the table.
+     * @param pages
+     *     Pages used to back the table.
+     * @param node
+     *     NUMA node to place the memory on (negative for no placement).
+     * @param mapped
+     *     Returns the number of bytes that were mapped (for freeTable).
+     */
+    inline void * allocTable( const std::size_t & bytes,
+                              const PageSize & pages,
+                              const int & node,
+                              std::size_t & mapped ) {
+      #ifdef __linux__
+        std::size_t page = sysconf(_SC_PAGESIZE);
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        switch ( pages ) {
+          case TRANSPARENT_HUGE_PAGES:
+            page = std::size_t(1) << 21;
+            break;
+          #ifdef MAP_HUGETLB
+          case HUGE_PAGES_2MB:
+            page = std::size_t(1) << 21;
+            flags |= MAP_HUGETLB | (21 << MAP_HUGE_SHIFT);
+            break;
+          case HUGE_PAGES_1GB:
+            page = std::size_t(1) << 30;
+            flags |= MAP_HUGETLB | (30 << MAP_HUGE_SHIFT);
+            break;
+          #endif
+          default:
+            break;
+        }
+
+        mapped = ( (bytes + page - 1u) / page ) * page;
+        void * p = mmap( NULL, mapped, PROT_READ | PROT_WRITE, flags, -1, 0 );
+        if ( p == MAP_FAILED )
+          THROW(std::runtime_error,"field-lookup:  could not allocate table "
+                                   "(are enough huge pages reserved?)");
+
+        #ifdef MADV_HUGEPAGE
+          if ( pages == TRANSPARENT_HUGE_PAGES )
+            madvise( p, mapped, MADV_HUGEPAGE );
+        #endif
+
+        #ifdef SYS_mbind
+          if ( node >= 0 ) {
+            /* MPOL_BIND; the placement is only a hint if it fails. */
+            unsigned long mask = 1ul << node;
+            syscall( SYS_mbind, p, mapped, 2, &mask, sizeof(mask)*8, 0 );
+          }
+        #endif
+
+        return p;
+      #else
+        mapped = bytes;
+        return ::operator new(bytes);
+      #endif
+    }
+
+    /** Free memory allocated by allocTable. */
+    inline void freeTable( void * p, const std::size_t & mapped ) {
+      #ifdef __linux__
+        munmap( p, mapped );
+      #else
+        ::operator delete(p);
+      #endif
+    }
+
+  }/* namespace fields::detail */
+}/* namespace fields */
+
+#endif // fields_table_allocation_h
@@ -0,0 +1,190 @@
+#define BOOST_TEST_MODULE  AxisExpansionLookup
+
+#include <fields/axis-expansion-lookup.h>
+#include <fields/force-lookup.h>
+
+#include <xylose/Vector.h>
+
+#include <sstream>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using xylose::SQR;
+
+  typedef fields::ForceLookup< 3u,
+    fields::AxisExpansionLookup< fields::ForceRecord<3u> > > Force;
+
+  /** A current-free field whose on-axis field is b(z) = 1 + z^2/2 + z^4/10
+   * (the off-axis expansion terminates at fourth order). */
+  struct Src {
+    const Force & f;
+    Src( const Force & f ) : f(f) { }
+
+    static double b(const unsigned int & k, const double & z) {
+      switch (k) {
+        case 0u: return 1.0 + 0.5*z*z + 0.1*z*z*z*z;
+        case 1u: return z + 0.4*z*z*z;
+        case 2u: return 1.0 + 1.2*z*z;
+        case 3u: return 2.4*z;
+        case 4u: return 2.4;
+        default: return 0.0;
+      }
+    }
+
+    /** Field in the frame of the lookup. */
+    static Vector<double,3> local( const Vector<double,3> & r ) {
+      const double rho2 = SQR(r[0]) + SQR(r[1]), z = r[2];
+      const double Bz = b(0,z) - rho2/4.*b(2,z) + rho2*rho2/64.*b(4,z);
+      const double Brho_rho = -b(1,z)/2. + rho2/16.*b(3,z);
+      return V3( Brho_rho * r[0], Brho_rho * r[1], Bz );
+    }
+
+    /** Field in the lab frame. */
+    void operator()( Vector<double,3> & B, const Vector<double,3> & r ) const {
+      const Vector<double,3> Bl = local( f.R * r );
+      for ( unsigned int j = 0u; j < 3u; ++j )
+        B[j] = f.R[0][j]*Bl[0] + f.R[1][j]*Bl[1] + f.R[2][j]*Bl[2];
+    }
+
+    double magnitude( const Vector<double,3> & r ) const {
+      Vector<double,3> B;
+      (*this)(B, r);
+      return B.abs();
+    }
+  };
+
+  inline double rnd() { return std::rand() / (RAND_MAX + 1.0); }
+
+  /** Derivatives on the nodes z = -1, -0.9, ..., 1. */
+  std::vector<double> derivs() {
+    std::vector<double> d;
+    for ( unsigned int n = 0u; n <= 20u; ++n )
+      for ( unsigned int k = 0u; k < 6u; ++k )
+        d.push_back( Src::b(k, -1.0 + 0.1*n) );
+    return d;
+  }
+
+  /** (rho,z) table of V = |B| (the acceleration is left zero). */
+  void writeTable( std::ostream & out ) {
+    out << "# center \n# 0 0 0\n"
+           "# CORE : \n# 5 1 9\t0.5 1 0.5\t0 0 -2\t2 0 2\n"
+           "# SHELL : \n# 5 1 9\t0.5 1 0.5\t0 0 -2\t2 0 2\n"
+           "# \n# \n";
+    for ( unsigned int k = 0u; k < 9u; ++k ) {
+      for ( unsigned int i = 0u; i < 5u; ++i ) {
+        fields::ForceRecord<3u> rec;
+        rec.V = Src::local( V3(0.5*i, 0., -2. + 0.5*k) ).abs();
+        out << rec << '\n';
+      }
+      out << '\n';
+    }
+  }
+
+}/* namespace (anon) */
+
+BOOST_AUTO_TEST_CASE( expansion ) {
+  Force force;
+  force.rotateField( V3(0.,1.,0.) );
+  const Src src(force);
+  BOOST_CHECK( !force.axisInitialized() );
+  force.initializeAxis( 4u, -1.0, 0.1, derivs(), 0.5 );
+  BOOST_CHECK( force.axisInitialized() );
+
+  const double mu = 2.0, mass = 4.0;
+  force.setMoment( 0u, mu, mass );
+
+  std::srand(7);
+  const double h = 1e-5;
+  for ( unsigned int i = 0u; i < 200u; ++i ) {
+    /* the axis is the lab-frame y-axis. */
+    const Vector<double,3> r = V3( .6*rnd()-.3, 2.*rnd()-1., .6*rnd()-.3 );
+    BOOST_REQUIRE( force.inParaxialRegion(r) );
+
+    Vector<double,3> B, Be;
+    force.field( B, r );
+    src( Be, r );
+    BOOST_CHECK_SMALL( (B - Be).abs(), 1e-12 );
+    BOOST_CHECK_CLOSE( force.magnitude(r), Be.abs(), 1e-10 );
+
+    Vector<double,3> g, ge;
+    force.gradientOfMagnitude( g, r );
+    for ( unsigned int j = 0u; j < 3u; ++j ) {
+      Vector<double,3> rp = r, rm = r;
+      rp[j] += h;
+      rm[j] -= h;
+      ge[j] = (src.magnitude(rp) - src.magnitude(rm)) / (2.*h);
+    }
+    BOOST_CHECK_SMALL( (g - ge).abs(), 1e-7 );
+
+    Vector<double,3> a;
+    force.accel( a, r );
+    BOOST_CHECK_SMALL( (a + (mu/mass) * g).abs(), 1e-12 );
+    BOOST_CHECK_CLOSE( force.potential(r), mu * Be.abs(), 1e-10 );
+  }
+
+  BOOST_CHECK( !force.inParaxialRegion( V3(0.6, 0., 0.) ) );
+  BOOST_CHECK( !force.inParaxialRegion( V3(0., 1.1, 0.) ) );
+}
+
+BOOST_AUTO_TEST_CASE( fit_axis ) {
+  Force force;
+  force.rotateField( V3(0.,1.,0.) );
+  force.fitAxis( Src(force), -1.0, 1.0, 21u, 4u, 0.5, 16u );
+
+  std::stringstream file;
+  file.precision(17);
+  force.writeAxis( file );
+
+  Force force2;
+  force2.readAxis( file );
+  BOOST_CHECK_EQUAL( force2.getOrder(), 4u );
+  BOOST_CHECK_EQUAL( force2.getParaxialRadius(), 0.5 );
+
+  /* compare the fitted derivatives via the (unrotated) on-axis field. */
+  for ( unsigned int n = 0u; n <= 20u; ++n ) {
+    const double z = -1.0 + 0.1*n;
+    BOOST_CHECK_CLOSE( force2.magnitude( V3(0.,0.,z) ), Src::b(0,z), 1e-9 );
+    Vector<double,3> g;
+    force2.gradientOfMagnitude( g, V3(0.,0.,z) );
+    BOOST_CHECK_SMALL( g[2] - Src::b(1,z), 1e-8 );
+  }
+
+  force2.rotateField( V3(0.,1.,0.) );
+  for ( unsigned int i = 0u; i < 50u; ++i ) {
+    const Vector<double,3> r = V3( .6*rnd()-.3, 2.*rnd()-1., .6*rnd()-.3 );
+    BOOST_CHECK_CLOSE( force2.potential(r), force.potential(r), 1e-8 );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( fallback ) {
+  Force force;
+  std::stringstream file;
+  writeTable( file );
+  force.readindata( file );
+  force.initializeAxis( 4u, -1.0, 0.1, derivs(), 0.5 );
+
+  fields::AxiSymFieldLookup< fields::ForceRecord<3u> > table;
+  file.clear();
+  file.seekg(0);
+  table.readindata( file );
+
+  /* outside of the paraxial region, the table is used. */
+  const Vector<double,3> r[] = { V3(1.2, 0.3, 0.4), V3(0.1, 0., 1.7) };
+  for ( unsigned int i = 0u; i < 2u; ++i ) {
+    BOOST_CHECK( !force.inParaxialRegion(r[i]) );
+    BOOST_CHECK_EQUAL( force.potential(r[i]), table.scalar_lookup(r[i], 0u) );
+  }
+
+  /* inside, the expansion is (much) more accurate than the table. */
+  const Vector<double,3> p = V3(0.13, 0.21, 0.37);
+  const double exact = Src::local(p).abs();
+  BOOST_CHECK_CLOSE( force.potential(p), exact, 1e-10 );
+  BOOST_CHECK( std::abs(table.scalar_lookup(p, 0u) - exact) > 1e-6 );
+}
@@ -0,0 +1,118 @@
+#define BOOST_TEST_MODULE  BMagnitudeLookup
+
+#include <fields/BMagnitudeLookup.h>
+#include <fields/bfield.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <physical/physical.h>
+
+#include <sstream>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+  namespace fbf = fields::BField;
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+  using namespace physical::units;
+
+  typedef fbf::BCalcs< fbf::ThinWireSrc > BCalcs;
+  typedef BCalcs::options::ChimpDB ChimpDB;
+  typedef fbf::BMagnitudeLookup< BCalcs::options, true > BLookup;
+  typedef fields::ForceLookup<> Lookup;
+
+  /** A particle with a species and a magnetic sub-state. */
+  struct Particle {
+    unsigned int s;
+    int mF;
+  };
+
+  inline const unsigned int & species( const Particle & p ) { return p.s; }
+  inline const int & state( const Particle & p ) { return p.mF; }
+
+  /** Two parallel wires along y, below the table. */
+  template < typename BSrc >
+  void addWires( BSrc & src ) {
+    src.currents.push_back(
+      fbf::ThinCurrentElement(-2e-3, -1.0, -3e-3, -2e-3, 1.0, -3e-3,  10.0) );
+    src.currents.push_back(
+      fbf::ThinCurrentElement( 2e-3, -1.0, -3e-3,  2e-3, 1.0, -3e-3, -10.0) );
+  }
+
+  /** Write a table of the given source to a string. */
+  template < typename Src >
+  std::string table( const Src & src ) {
+    std::ostringstream out;
+    out.precision(17);
+    fields::createFieldFile( src,
+                             V3(-1e-3,-1e-3,-1e-3), V3(1e-3,1e-3,1e-3),
+                             V3(.25e-3,.25e-3,.25e-3),
+                             V3(-2e-3,-2e-3,-2e-3), V3(2e-3,2e-3,2e-3),
+                             V3(.5e-3,.5e-3,.5e-3),
+                             out );
+    return out.str();
+  }
+}
+
+BOOST_AUTO_TEST_CASE( shared_table ) {
+  ChimpDB db;
+  db.addParticleType("87Rb");
+  db.addParticleType("85Rb");
+  db.initBinaryInteractions();
+
+  fbf::BMagnitudeTableWrapper< fbf::ThinWireSrc > bsrc;
+  addWires( bsrc );
+
+  BLookup blookup;
+  blookup.db = &db;
+  {
+    std::istringstream in( table(bsrc) );
+    blookup.readindata( in );
+  }
+
+  const int states[3] = { -1, 1, 2 };
+  for ( int m = 0; m < 3; ++m ) {
+    /* the equivalent per-state table of forces. */
+    fields::ForceTableWrapper< BCalcs > fsrc;
+    addWires( fsrc );
+    fsrc.db = &db;
+    fsrc.mu = states[m] * physical::constant::si::mu_B;
+
+    Lookup lookup;
+    {
+      std::istringstream in( table(fsrc) );
+      lookup.readindata( in );
+    }
+
+    for ( unsigned int s = 0u; s < 2u; ++s ) {
+      const Particle p = { s, states[m] };
+      const double mass =
+        db[s].chimp::property::mass::value / db[0].chimp::property::mass::value;
+
+      for ( int i = 0; i < 5; ++i ) {
+        const Vector<double,3> r = V3( -.9e-3 + .37e-3*i, .2e-3*i - .5e-3,
+                                       -.9e-3 + .33e-3*i );
+        Vector<double,3> a0, a1;
+        Particle q = p;
+        blookup.accel( a0, r, V3(0.,0.,0.), 0.0, 0.0, q );
+        lookup.accel( a1, r );
+        for ( int d = X; d <= Z; ++d )
+          BOOST_CHECK_CLOSE( a0[d] * mass, a1[d], 1e-9 );
+        BOOST_CHECK_CLOSE( blookup.potential( r, V3(0.,0.,0.), 0.0, p ),
+                           lookup.potential( r ), 1e-9 );
+      }
+    }
+  }
+
+  /* without a particle, the default moment is used. */
+  const Vector<double,3> r = V3( .1e-3, -.2e-3, .3e-3 );
+  BOOST_CHECK_CLOSE( blookup.potential( r ),
+                     blookup.mu * blookup.scalar_lookup( r, 0u ), 1e-12 );
+}
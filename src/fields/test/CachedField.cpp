@@ -0,0 +1,90 @@
+#define BOOST_TEST_MODULE  CachedField
+
+#include <fields/CachedField.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <boost/atomic.hpp>
+
+#include <sstream>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+
+  typedef fields::ForceRecord<> Record;
+
+  boost::atomic<unsigned long> ncalls(0ul);
+
+  /** Some non-linear source that counts how often it is called. */
+  struct Src {
+    Record getRecord( const Vector<double,3> & r ) const {
+      ++ncalls;
+      Record rec;
+      rec.a = V3( std::sin(r[X]), r[Y]*r[Z], r[X]*r[Y] );
+      rec.V = std::cos(r[X]*r[Y]) + r[Z]*r[Z];
+      return rec;
+    }
+  };
+
+}/* namespace (anon) */
+
+BOOST_AUTO_TEST_CASE( lazy_fill ) {
+  std::stringstream file;
+  file.precision(17);
+  fields::createFieldFile( Src(),
+                           V3(-1.,-1.,-1.), V3(1.,1.,1.), V3(.25,.25,.25),
+                           V3(-4.,-4.,-4.), V3(4.,4.,4.), V3(.5,.5,.5),
+                           file );
+  fields::ForceLookup<> full;
+  full.readindata( file );
+
+  fields::CachedField<Src> cached;
+  cached.initialize( V3(0.,0.,0.),
+                     V3(.25,.25,.25), V3(-1.,-1.,-1.), V3(1.,1.,1.),
+                     V3(.5,.5,.5),    V3(-4.,-4.,-4.), V3(4.,4.,4.) );
+  ncalls = 0ul;
+  BOOST_CHECK_EQUAL( cached.filled(cached.CORE), 0.0 );
+
+  /* only touch a small region first. */
+  Vector<double,3> a0, a1;
+  cached.accel( a1, V3(.1,.1,.1) );
+  full.accel( a0, V3(.1,.1,.1) );
+  BOOST_CHECK_EQUAL( a0, a1 );
+  BOOST_CHECK( ncalls > 0ul );
+  BOOST_CHECK( cached.filled(cached.CORE) < 1.0 );
+  BOOST_CHECK_EQUAL( cached.filled(cached.SHELL), 0.0 );
+
+  /* now the center of every cell (of both tables), from many threads. */
+  const int n = 32;
+  int nbad = 0;
+  #pragma omp parallel for reduction(+:nbad)
+  for ( int k = 0; k < n; ++k )
+    for ( int i = 0; i < n; ++i )
+      for ( int j = 0; j < n; ++j ) {
+        const Vector<double,3> r = V3( -3.875 + .25*i,
+                                       -3.875 + .25*j,
+                                       -3.875 + .25*k );
+        Vector<double,3> b0, b1;
+        full.accel( b0, r );
+        cached.accel( b1, r );
+        nbad += ( b0 != b1 ) || ( full.potential(r) != cached.potential(r) );
+      }
+  BOOST_CHECK_EQUAL( nbad, 0 );
+
+  /* every node was computed exactly once. */
+  BOOST_CHECK_EQUAL( cached.filled(cached.CORE), 1.0 );
+  BOOST_CHECK_EQUAL( cached.filled(cached.SHELL), 1.0 );
+  BOOST_CHECK_EQUAL( ncalls, 9ul*9ul*9ul + 17ul*17ul*17ul );
+
+  cached.clear();
+  BOOST_CHECK_EQUAL( cached.filled(cached.CORE), 0.0 );
+}
@@ -0,0 +1,99 @@
+#define BOOST_TEST_MODULE  CellSort
+
+#include <fields/cell-sort.h>
+#include <fields/field-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+
+  typedef fields::FieldLookup< fields::ForceRecord<> > Lookup;
+
+  struct TestTable : Lookup {
+    TestTable() {
+      initialize( V3(0.,0.,0.),
+                  V3(.1,.1,.1), V3(-1.,-1.,-1.), V3(1.,1.,1.),
+                  V3(.5,.5,.5), V3(-4.,-4.,-4.), V3(4.,4.,4.) );
+      for ( unsigned int t = CORE; t <= SHELL; ++t )
+        for ( unsigned int k = 0u; k < data[t].zlen; ++k )
+          for ( unsigned int i = 0u; i < data[t].xlen; ++i )
+            for ( unsigned int j = 0u; j < data[t].ylen; ++j ) {
+              data[t](i,j,k).a = V3( i, j, k );
+              data[t](i,j,k).V = i*j + k + t;
+            }
+    }
+  };
+
+  inline double rnd() { return std::rand() / (RAND_MAX + 1.0); }
+
+  std::vector< Vector<double,3> > randomPositions( const unsigned int & n ) {
+    std::vector< Vector<double,3> > r(n);
+    for ( unsigned int i = 0u; i < n; ++i )
+      r[i] = V3( 8.*(rnd()-.5), 8.*(rnd()-.5), 8.*(rnd()-.5) );
+    return r;
+  }
+
+}/* namespace (anon) */
+
+BOOST_AUTO_TEST_CASE( radix_sort ) {
+  std::srand(1);
+  std::vector<unsigned long long> keys(10000);
+  for ( unsigned int i = 0u; i < keys.size(); ++i )
+    keys[i] = ( (unsigned long long)std::rand() << 20 ) ^ (std::rand() % 7);
+  keys[17] = ~0ull;
+  keys[18] = 0ull;
+
+  std::vector<std::size_t> perm;
+  fields::radixSortPermutation( perm, keys );
+
+  BOOST_REQUIRE_EQUAL( perm.size(), keys.size() );
+  for ( unsigned int i = 1u; i < perm.size(); ++i ) {
+    BOOST_CHECK( keys[perm[i-1]] <= keys[perm[i]] );
+    /* stability */
+    if ( keys[perm[i-1]] == keys[perm[i]] )
+      BOOST_CHECK( perm[i-1] < perm[i] );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( sorted_lookup ) {
+  TestTable table;
+  std::srand(2);
+  const std::vector< Vector<double,3> > r = randomPositions(5000);
+
+  for ( int order = fields::TABLE_ORDER; order <= fields::MORTON_ORDER; ++order ) {
+    std::vector<unsigned long long> keys;
+    std::vector<std::size_t> perm;
+    std::vector< Vector<double,3> > rs;
+
+    fields::cellKeys( keys, table, &r[0], r.size(), fields::CellOrder(order) );
+    fields::radixSortPermutation( perm, keys );
+    fields::applyPermutation( rs, perm, r );
+
+    for ( unsigned int i = 1u; i < perm.size(); ++i )
+      BOOST_CHECK( keys[perm[i-1]] <= keys[perm[i]] );
+
+    std::vector< Vector<double,3> > a( rs.size() );
+    std::vector< double > V( rs.size() );
+    fields::sortedVectorLookup( &a[0], table, &rs[0], rs.size(), 0u );
+    fields::sortedScalarLookup( &V[0], table, &rs[0], rs.size(), 0u );
+
+    for ( unsigned int i = 0u; i < rs.size(); ++i ) {
+      Vector<double,3> a0;
+      table.vector_lookup( a0, rs[i], 0u );
+      BOOST_CHECK_EQUAL( a[i], a0 );
+      BOOST_CHECK_EQUAL( V[i], table.scalar_lookup( rs[i], 0u ) );
+    }
+  }
+}
@@ -0,0 +1,129 @@
+#define BOOST_TEST_MODULE  ChebyshevLookup
+
+#include <fields/chebyshev-lookup.h>
+#include <fields/force-lookup.h>
+
+#include <xylose/Vector.h>
+
+#include <sstream>
+#include <cstdlib>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+
+  /** A quadratic potential. */
+  struct Quadratic {
+    void accel(       Vector<double,3> & a,
+                const Vector<double,3> & r,
+                const Vector<double,3> & v = V3(0.,0.,0.),
+                const double & t = 0.0,
+                const double & dt = 0.0,
+                const unsigned int & species = 0u ) const {
+      a = -2.0 * r;
+    }
+
+    double potential( const Vector<double,3> & r,
+                      const Vector<double,3> & v = V3(0.,0.,0.),
+                      const double & t = 0.0,
+                      const unsigned int & species = 0u ) const {
+      return r * r;
+    }
+  };
+
+  /** A smooth, non-polynomial potential that differs by species. */
+  struct Smooth {
+    void accel(       Vector<double,3> & a,
+                const Vector<double,3> & r,
+                const Vector<double,3> & v = V3(0.,0.,0.),
+                const double & t = 0.0,
+                const double & dt = 0.0,
+                const unsigned int & species = 0u ) const {
+      const double s = species + 1.0;
+      const double V = potential(r, v, t, species);
+      a = -V * V3( 1.0/s, 0.5, -0.25 );
+    }
+
+    double potential( const Vector<double,3> & r,
+                      const Vector<double,3> & v = V3(0.,0.,0.),
+                      const double & t = 0.0,
+                      const unsigned int & species = 0u ) const {
+      const double s = species + 1.0;
+      return std::exp( r[0]/s + 0.5*r[1] - 0.25*r[2] );
+    }
+  };
+
+  inline double rnd() { return std::rand() / (RAND_MAX + 1.0); }
+
+}/* namespace (anon) */
+
+BOOST_AUTO_TEST_CASE( polynomial ) {
+  typedef fields::ForceLookup< 3u, fields::ChebyshevFieldLookup<> > Force;
+  Force force;
+  BOOST_CHECK( !force.isInitialized() );
+  force.fit( fields::ForceTableWrapper<Quadratic>(),
+             V3(-1.,-2.,-1.), V3(1.,2.,3.), Vector<int,3>(2),
+             1e-10, 1e-10 );
+  BOOST_CHECK( force.isInitialized() );
+
+  /* a quadratic is represented exactly with (at most) second order. */
+  for ( std::size_t b = 0u; b < force.getOrders().size(); ++b )
+    BOOST_CHECK_LE( force.getOrders()[b], 2u );
+
+  std::srand(3);
+  for ( unsigned int i = 0u; i < 200u; ++i ) {
+    const Vector<double,3> r = V3( 2.*rnd()-1., 4.*rnd()-2., 4.*rnd()-1. );
+    BOOST_CHECK( force.inDomain(r) );
+    Vector<double,3> a;
+    force.accel( a, r );
+    BOOST_CHECK_SMALL( (a + 2.0 * r).abs(), 1e-12 );
+    BOOST_CHECK_CLOSE( force.potential(r), r*r, 1e-10 );
+  }
+
+  BOOST_CHECK( !force.inDomain( V3(0., 0., 3.5) ) );
+}
+
+BOOST_AUTO_TEST_CASE( smooth ) {
+  typedef fields::ForceLookup< 3u, fields::ChebyshevFieldLookup<3u,2u> > Force;
+  typedef fields::ForceTableWrapper<Smooth,3u,2u> Source;
+  const double tol = 1e-6;
+
+  Force force;
+  force.fit( Source(), V3(-2.,-2.,-2.), V3(2.,2.,2.), Vector<int,3>(2),
+             tol, tol );
+
+  /* the orders are limited to the maximum. */
+  for ( std::size_t b = 0u; b < force.getOrders().size(); ++b )
+    BOOST_CHECK_LE( force.getOrders()[b], 8u );
+
+  const Source src;
+  std::srand(5);
+  for ( unsigned int i = 0u; i < 500u; ++i ) {
+    const Vector<double,3> r = V3( 4.*rnd()-2., 4.*rnd()-2., 4.*rnd()-2. );
+    const fields::ForceRecord<3u,2u> exact = src.getRecord(r);
+    for ( unsigned int s = 0u; s < 2u; ++s ) {
+      Vector<double,3> a;
+      force.vector_lookup( a, r, s );
+      BOOST_CHECK_SMALL( (a - exact.a[s]).abs(), 10.*tol );
+      BOOST_CHECK_SMALL( force.scalar_lookup(r, s) - exact.V[s], 10.*tol );
+    }
+  }
+
+  /* round trip through the text format. */
+  std::stringstream file;
+  file.precision(17);
+  force.writedata( file );
+  Force force2;
+  force2.readindata( file );
+  BOOST_CHECK_EQUAL( force2.size(), force.size() );
+  for ( unsigned int i = 0u; i < 50u; ++i ) {
+    const Vector<double,3> r = V3( 4.*rnd()-2., 4.*rnd()-2., 4.*rnd()-2. );
+    const unsigned int s = 1u;
+    BOOST_CHECK_CLOSE( force2.potential(r, V3(0.,0.,0.), 0.0, s),
+                       force.potential(r, V3(0.,0.,0.), 0.0, s), 1e-12 );
+  }
+}
@@ -0,0 +1,155 @@
+#define BOOST_TEST_MODULE  ErrorMap
+
+#include <fields/error-map.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/detail/npy.h>
+#include <fields/detail/omp.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <sstream>
+#include <vector>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+
+  typedef fields::ForceLookup<> Lookup;
+
+  /** A smooth force. */
+  struct Src {
+    void accel(       Vector<double,3> & a,
+                const Vector<double,3> & r,
+                const Vector<double,3> & v = V3(0.,0.,0.),
+                const double & t = 0.0,
+                const double & dt = 0.0,
+                const unsigned int & species = 0u ) const {
+      a = V3( std::sin(r[X]), std::cos(r[Y]) * r[Z], 1.0 + r[X]*r[Y] );
+    }
+
+    double potential( const Vector<double,3> & r,
+                      const Vector<double,3> & v = V3(0.,0.,0.),
+                      const double & t = 0.0,
+                      const unsigned int & species = 0u ) const {
+      return std::cos(r[X]) + r[Y] * r[Z];
+    }
+  };
+
+  /** Read a table of the source with CORE [-1,1]^3 (dx) and SHELL
+   * [-2,2]^3 (2*dx). */
+  void readTable( Lookup & lookup, const double & dx ) {
+    std::ostringstream out;
+    out.precision(17);
+    fields::createFieldFile( fields::ForceTableWrapper<Src>(),
+                             V3(-1.,-1.,-1.), V3(1.,1.,1.), V3(dx,dx,dx),
+                             V3(-2.,-2.,-2.), V3(2.,2.,2.),
+                             V3(2*dx,2*dx,2*dx),
+                             out, "", fields::BINARY_FILE );
+    std::istringstream in( out.str() );
+    lookup.readindata( in );
+  }
+
+  unsigned long total( const fields::ErrorStats * s ) {
+    unsigned long n = 0ul;
+    for ( int r = 0; r < fields::N_ERROR_REGIONS; ++r )
+      n += s[r].n;
+    return n;
+  }
+}
+
+BOOST_AUTO_TEST_CASE( regions_and_convergence ) {
+  Lookup fine, coarse;
+  readTable( fine, .125 );
+  readTable( coarse, .25 );
+
+  fields::ErrorMapOptions opts;
+  opts.samples = 20000;
+  const fields::ErrorMap f = fields::mapErrors( Src(), fine, opts );
+  const fields::ErrorMap c = fields::mapErrors( Src(), coarse, opts );
+
+  BOOST_CHECK_EQUAL( total(f.a), 20000ul );
+  BOOST_CHECK_EQUAL( total(f.V), 20000ul );
+  for ( int r = 0; r < fields::N_ERROR_REGIONS; ++r ) {
+    BOOST_CHECK_GT( f.a[r].n, 1000ul );
+    BOOST_CHECK_LE( f.a[r].p50, f.a[r].p90 );
+    BOOST_CHECK_LE( f.a[r].p90, f.a[r].p99 );
+    BOOST_CHECK_LE( f.a[r].p99, f.a[r].max );
+    BOOST_CHECK_LE( f.a[r].rms, f.a[r].max );
+  }
+  BOOST_CHECK_CLOSE( f.a_scale, c.a_scale, 1e-12 );
+
+  /* trilinear interpolation errors fall as dx^2. */
+  BOOST_CHECK_GT( c.a[fields::CORE_REGION].rms,
+                  3.0 * f.a[fields::CORE_REGION].rms );
+  BOOST_CHECK_GT( c.V[fields::SHELL_REGION].rms,
+                  3.0 * f.V[fields::SHELL_REGION].rms );
+  BOOST_CHECK_LT( f.a[fields::CORE_REGION].max, 1e-2 );
+
+  BOOST_CHECK( f.within( 1e-1, 1e-1 ) );
+  BOOST_CHECK( !f.within( 1e-6, 1e-1 ) );
+  BOOST_CHECK( !f.within( 1e-1, 1e-6 ) );
+}
+
+BOOST_AUTO_TEST_CASE( stratified_and_threads ) {
+  Lookup lookup;
+  readTable( lookup, .25 );
+
+  fields::ErrorMapOptions opts;
+  opts.samples = 9000;
+  opts.sampling = fields::STRATIFIED_SAMPLES;
+  const fields::ErrorMap m = fields::mapErrors( Src(), lookup, opts );
+  BOOST_CHECK_EQUAL( total(m.a), 8000ul ); /* 20^3 */
+
+#ifdef _OPENMP
+  /* the result does not depend on the number of threads. */
+  const int threads = fields::detail::max_threads();
+  omp_set_num_threads( 1 );
+  const fields::ErrorMap m1 = fields::mapErrors( Src(), lookup, opts );
+  omp_set_num_threads( threads );
+  for ( int r = 0; r < fields::N_ERROR_REGIONS; ++r ) {
+    BOOST_CHECK_EQUAL( m.a[r].n, m1.a[r].n );
+    BOOST_CHECK_EQUAL( m.a[r].max, m1.a[r].max );
+    BOOST_CHECK_EQUAL( m.V[r].p99, m1.V[r].p99 );
+  }
+#endif
+}
+
+BOOST_AUTO_TEST_CASE( error_volume ) {
+  Lookup lookup;
+  readTable( lookup, .25 );
+
+  fields::ErrorMapOptions opts;
+  opts.samples = 20000;
+  opts.volume = Vector<int,3>( V3(4,5,6) );
+  const fields::ErrorMap m = fields::mapErrors( Src(), lookup, opts );
+
+  std::stringstream s;
+  fields::writeErrorVolume( s, m );
+  fields::detail::NpyHeader h;
+  fields::detail::readNpyHeader( s, h );
+  BOOST_CHECK( h.isTable( Vector<int,3>( V3(4,5,6) ), 2u ) );
+
+  std::vector<double> v;
+  fields::detail::readNpyDoubles( s, h, v );
+  BOOST_REQUIRE_EQUAL( v.size(), 4u * 5u * 6u * 2u );
+
+  double amax = 0.0, Vmax = 0.0;
+  for ( std::size_t i = 0u; i < v.size(); i += 2u ) {
+    amax = std::max( amax, v[i] );
+    Vmax = std::max( Vmax, v[i+1u] );
+  }
+  double a = 0.0, V = 0.0;
+  for ( int r = 0; r < fields::N_ERROR_REGIONS; ++r ) {
+    a = std::max( a, m.a[r].max );
+    V = std::max( V, m.V[r].max );
+  }
+  BOOST_CHECK_EQUAL( amax, a );
+  BOOST_CHECK_EQUAL( Vmax, V );
+}
@@ -0,0 +1,307 @@
+#define BOOST_TEST_MODULE  FieldLookup
+
+#include <fields/field-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/table-allocation.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+
+  typedef fields::ForceRecord<3u,2u> Record;
+  typedef fields::FieldLookup<Record> Lookup;
+
+  /** Some arbitrary (but non-linear) function to fill the tables with. */
+  inline void fill( Record & rec, const Vector<double,3> & r ) {
+    for ( unsigned int i = 0u; i < 2u; ++i ) {
+      rec.a[i] = V3( std::sin(r[X]) + i, r[Y]*r[Z], r[X]*r[Y] - i );
+      rec.V[i] = std::cos(r[X]*r[Y]) + r[Z]*r[Z] + i;
+    }
+  }
+
+  /** A lookup table with dimensions
+   * CORE  : [-1,1]^3 with dx=0.25,
+   * SHELL : [-4,4]^3 with dx=0.5. */
+  struct TestTable : Lookup {
+    TestTable() {
+      initialize( V3(0.,0.,0.),
+                  V3(.25,.25,.25), V3(-1.,-1.,-1.), V3(1.,1.,1.),
+                  V3(.5,.5,.5),    V3(-4.,-4.,-4.), V3(4.,4.,4.) );
+      fillTable( CORE,  V3(.25,.25,.25), V3(-1.,-1.,-1.) );
+      fillTable( SHELL, V3(.5,.5,.5),    V3(-4.,-4.,-4.) );
+    }
+
+    void fillTable( const DSECT & t,
+                    const Vector<double,3> & dx,
+                    const Vector<double,3> & min ) {
+      for ( unsigned int k = 0u; k < data[t].zlen; ++k )
+        for ( unsigned int i = 0u; i < data[t].xlen; ++i )
+          for ( unsigned int j = 0u; j < data[t].ylen; ++j )
+            fill( data[t](i,j,k), min + compMult(V3(i,j,k), dx) );
+    }
+  };
+
+  /** Source for createFieldFile. */
+  struct FillSrc {
+    Record getRecord( const Vector<double,3> & r ) const {
+      Record rec;
+      fill( rec, r );
+      return rec;
+    }
+  };
+
+  /** Write the TestTable geometry to a stream. */
+  inline void writeTable( std::ostream & out,
+                          const fields::FileFormat & format ) {
+    out.precision(17);
+    fields::createFieldFile( FillSrc(),
+                             V3(-1.,-1.,-1.), V3(1.,1.,1.), V3(.25,.25,.25),
+                             V3(-4.,-4.,-4.), V3(4.,4.,4.), V3(.5,.5,.5),
+                             out, "", format );
+  }
+
+  inline double rnd() { return std::rand() / (RAND_MAX + 1.0); }
+
+}/* namespace (anon) */
+
+BOOST_AUTO_TEST_CASE( lookup_context ) {
+  TestTable table;
+  Lookup::LookupContext ctx;
+
+  /* random walk that covers core, shell, and clamped outside regions. */
+  Vector<double,3> r = V3(0.,0.,0.);
+  std::srand(42);
+  for ( unsigned int n = 0u; n < 20000u; ++n ) {
+    for ( int j = X; j <= Z; ++j )
+      r[j] += 0.1 * (rnd() - 0.5);
+    if ( n % 5000u == 4999u )
+      r = V3( 5.*(rnd()-.5), 5.*(rnd()-.5), 12.*(rnd()-.5) );
+
+    for ( unsigned int i = 0u; i < 2u; ++i ) {
+      Vector<double,3> a0, a1;
+      table.vector_lookup(a0, r, i);
+      table.vector_lookup(a1, r, i, ctx);
+      BOOST_CHECK_EQUAL( a0, a1 );
+      BOOST_CHECK_EQUAL( table.scalar_lookup(r, i),
+                         table.scalar_lookup(r, i, ctx) );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( region_of_interest ) {
+  std::stringstream text, binary;
+  writeTable( text, fields::TEXT_FILE );
+  writeTable( binary, fields::BINARY_FILE );
+
+  Lookup full, fullb, roi, roib, coarse;
+  full.readindata( text );
+  fullb.readindata( binary );
+
+  text.clear(); text.seekg(0);
+  binary.clear(); binary.seekg(0);
+  const Vector<double,3> lo = V3(-.5,-.3,-.6), hi = V3(.6,.3,.1);
+  roi.readindata( text, lo, hi );
+  roib.readindata( binary, lo, hi );
+
+  binary.clear(); binary.seekg(0);
+  coarse.readindata( binary, V3(-1.,-1.,-1.), V3(1.,1.,1.), Vector<int,3>(2) );
+
+  /* CORE:  x in [-.5,.75], y in [-.5,.5], z in [-.75,.25]. */
+  BOOST_CHECK_EQUAL( roi.table(Lookup::CORE).xlen, 6u );
+  BOOST_CHECK_EQUAL( roi.table(Lookup::CORE).ylen, 5u );
+  BOOST_CHECK_EQUAL( roi.table(Lookup::CORE).zlen, 5u );
+  BOOST_CHECK_EQUAL( coarse.table(Lookup::CORE).xlen, 5u );
+  BOOST_CHECK_EQUAL( coarse.table(Lookup::SHELL).xlen, 3u );
+
+  std::srand(7);
+  for ( unsigned int n = 0u; n < 2000u; ++n ) {
+    Vector<double,3> r;
+    for ( int j = X; j <= Z; ++j )
+      r[j] = lo[j] + (hi[j] - lo[j]) * rnd();
+
+    for ( unsigned int i = 0u; i < 2u; ++i ) {
+      Vector<double,3> a, ab, ar, arb;
+      full.vector_lookup(a, r, i);
+      fullb.vector_lookup(ab, r, i);
+      roi.vector_lookup(ar, r, i);
+      roib.vector_lookup(arb, r, i);
+      BOOST_CHECK_EQUAL( a, ab );
+      BOOST_CHECK_EQUAL( ar, arb );
+      BOOST_CHECK_SMALL( (a - ar).abs(), 1e-10 );
+      BOOST_CHECK_EQUAL( full.scalar_lookup(r, i), fullb.scalar_lookup(r, i) );
+      BOOST_CHECK_CLOSE( full.scalar_lookup(r, i), roi.scalar_lookup(r, i), 1e-8 );
+    }
+  }
+
+  /* the decimated table reproduces the grid points that it keeps (the upper
+   * boundary is skipped since lookups there are clamped). */
+  for ( int k = 0; k < 4; ++k )
+    for ( int j = 0; j < 4; ++j )
+      for ( int i = 0; i < 4; ++i ) {
+        const Vector<double,3> r = V3(-1. + .5*i, -1. + .5*j, -1. + .5*k);
+        BOOST_CHECK_CLOSE( full.scalar_lookup(r, 1u),
+                           coarse.scalar_lookup(r, 1u), 1e-8 );
+      }
+}
+
+BOOST_AUTO_TEST_CASE( axisym_region_of_interest ) {
+  typedef fields::AxiSymFieldLookup<Record> AxiSym;
+
+  /* the y-axis of an axially symmetric table has only a single point (and
+   * createFieldFile puts the center, thus the axis, at the origin). */
+  std::stringstream file;
+  file.precision(17);
+  fields::createFieldFile( FillSrc(),
+                           V3(-1.,0.,-1.), V3(1.,0.,1.), V3(.25,.25,.25),
+                           V3(-2.,0.,-2.), V3(2.,0.,2.), V3(.5,.5,.5),
+                           file, "", fields::BINARY_FILE );
+
+  AxiSym full, roi;
+  full.readindata( file );
+  file.clear(); file.seekg(0);
+  roi.readindata( file, V3(-.6,0.,-.6), V3(.6,0.,.6) );
+
+  BOOST_CHECK_EQUAL( full.table(AxiSym::CORE).ylen, 1u );
+  BOOST_CHECK_EQUAL( full.table(AxiSym::SHELL).ylen, 1u );
+  BOOST_CHECK_EQUAL( roi.table(AxiSym::CORE).xlen, 7u );
+  BOOST_CHECK_EQUAL( roi.table(AxiSym::CORE).ylen, 1u );
+  BOOST_CHECK_EQUAL( roi.table(AxiSym::CORE).zlen, 7u );
+
+  /* grid points of the rho-z plane. */
+  for ( int k = 0; k < 8; ++k )
+    for ( int i = 0; i < 4; ++i ) {
+      const Vector<double,3> r = V3(.25*i, 0., -1. + .25*k);
+      Record rec;
+      fill( rec, r );
+      BOOST_CHECK_CLOSE( full.scalar_lookup(r, 1u), rec.V[1], 1e-8 );
+    }
+
+  std::srand(11);
+  for ( unsigned int n = 0u; n < 500u; ++n ) {
+    const double rho = .5 * rnd(), phi = 6.28 * rnd();
+    const Vector<double,3> r =
+      V3( rho * std::cos(phi), rho * std::sin(phi), rnd() - .5 );
+    for ( unsigned int i = 0u; i < 2u; ++i ) {
+      Vector<double,3> a, ar;
+      full.vector_lookup(a, r, i);
+      roi.vector_lookup(ar, r, i);
+      BOOST_CHECK_SMALL( (a - ar).abs(), 1e-10 );
+      BOOST_CHECK_CLOSE( full.scalar_lookup(r, i), roi.scalar_lookup(r, i), 1e-8 );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( region_outside_core ) {
+  std::stringstream binary;
+  writeTable( binary, fields::BINARY_FILE );
+
+  Lookup full, roi;
+  full.readindata( binary );
+  binary.clear(); binary.seekg(0);
+
+  /* the region only overlaps the SHELL; the CORE keeps its nearest cell. */
+  const Vector<double,3> lo = V3(1.5,1.5,1.5), hi = V3(1.8,1.8,1.8);
+  roi.readindata( binary, lo, hi );
+
+  BOOST_CHECK_EQUAL( roi.table(Lookup::CORE).xlen, 2u );
+  BOOST_CHECK_EQUAL( roi.table(Lookup::CORE).ylen, 2u );
+  BOOST_CHECK_EQUAL( roi.table(Lookup::CORE).zlen, 2u );
+
+  std::srand(13);
+  for ( unsigned int n = 0u; n < 500u; ++n ) {
+    Vector<double,3> r;
+    for ( int j = X; j <= Z; ++j )
+      r[j] = lo[j] + (hi[j] - lo[j]) * rnd();
+
+    for ( unsigned int i = 0u; i < 2u; ++i ) {
+      Vector<double,3> a, ar;
+      full.vector_lookup(a, r, i);
+      roi.vector_lookup(ar, r, i);
+      BOOST_CHECK_SMALL( (a - ar).abs(), 1e-10 );
+      BOOST_CHECK_CLOSE( full.scalar_lookup(r, i), roi.scalar_lookup(r, i), 1e-8 );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( table_allocation ) {
+  std::stringstream file;
+  writeTable( file, fields::BINARY_FILE );
+  const std::string data = file.str();
+
+  const fields::TableAllocation allocs[] = {
+    fields::TableAllocation( fields::TRANSPARENT_HUGE_PAGES ),
+    fields::TableAllocation( fields::DEFAULT_PAGES, true ),
+    fields::TableAllocation( fields::TRANSPARENT_HUGE_PAGES, true )
+  };
+
+  std::istringstream in0(data);
+  Lookup plain;
+  plain.readindata( in0 );
+
+  for ( unsigned int a = 0u; a < 3u; ++a ) {
+    Lookup lookup;
+    fields::setAllocation( lookup, allocs[a] );
+    std::istringstream in(data);
+    lookup.readindata( in );
+    BOOST_CHECK( lookup.table(Lookup::CORE).replicas() >= 1 );
+
+    std::srand(5);
+    for ( unsigned int n = 0u; n < 1000u; ++n ) {
+      const Vector<double,3> r = V3( 9.*(rnd()-.5), 9.*(rnd()-.5), 9.*(rnd()-.5) );
+      Vector<double,3> a0, a1;
+      plain.vector_lookup(a0, r, 1u);
+      lookup.vector_lookup(a1, r, 1u);
+      BOOST_CHECK_EQUAL( a0, a1 );
+      BOOST_CHECK_EQUAL( plain.scalar_lookup(r, 0u), lookup.scalar_lookup(r, 0u) );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( pipelined_lookup ) {
+  TestTable table;
+
+  std::srand(17);
+  const std::size_t n = 5000u;
+  std::vector< Vector<double,3> > r(n), a(n);
+  std::vector<double> V(n);
+  for ( std::size_t k = 0u; k < n; ++k )
+    r[k] = V3( 9.*(rnd()-.5), 9.*(rnd()-.5), 3.*(rnd()-.5) );
+
+  const unsigned int distances[] = { 0u, 1u, 3u, 8u, 64u, 1000u };
+  for ( unsigned int d = 0u; d < 6u; ++d ) {
+    for ( unsigned int i = 0u; i < 2u; ++i ) {
+      table.vector_lookup( &a[0], &r[0], n, i, distances[d] );
+      table.scalar_lookup( &V[0], &r[0], n, i, distances[d] );
+      for ( std::size_t k = 0u; k < n; ++k ) {
+        Vector<double,3> ak;
+        table.vector_lookup( ak, r[k], i );
+        BOOST_CHECK_EQUAL( a[k], ak );
+        BOOST_CHECK_EQUAL( V[k], table.scalar_lookup(r[k], i) );
+      }
+    }
+  }
+
+  /* fewer positions than the prefetch distance. */
+  table.vector_lookup( &a[0], &r[0], 2u, 0u, 16u );
+  Vector<double,3> a1;
+  table.vector_lookup( a1, r[1], 0u );
+  BOOST_CHECK_EQUAL( a[1], a1 );
+
+  const unsigned int d = table.calibratePrefetch( &r[0], n );
+  BOOST_CHECK( d >= 1u && d <= Lookup::MAX_PREFETCH_DISTANCE );
+  BOOST_CHECK_EQUAL( table.getPrefetchDistance(), d );
+}
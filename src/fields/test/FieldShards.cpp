@@ -0,0 +1,128 @@
+#define BOOST_TEST_MODULE  FieldShards
+
+#include <fields/field-shards.h>
+#include <fields/createFieldFile.h>
+#include <fields/force-lookup.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <sstream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstdio>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+#include "fixture.h"
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+  using namespace fields::test;
+
+  std::string wholeFile( const fields::FileFormat & format ) {
+    std::ostringstream out;
+    out.precision(17);
+    fields::createFieldFile( FillSrc(), X_MINc, X_MAXc, dxc,
+                             X_MINs, X_MAXs, dxs, out, "", format );
+    return out.str();
+  }
+
+  /** Write all shards;  shard s is binary if binary[s % binary.size()]. */
+  std::vector<std::string> writeShards( const Vector<int,3> & nshards,
+                                        const std::vector<bool> & binary ) {
+    std::vector<std::string> names;
+    for ( int s = 0; s < nshards.prod(); ++s ) {
+      std::ostringstream name;
+      name << tempName("shard") << '-' << s;
+      names.push_back( name.str() );
+
+      std::ofstream out( name.str().c_str() );
+      out.precision(17);
+      fields::createFieldShard( FillSrc(), X_MINc, X_MAXc, dxc,
+                                X_MINs, X_MAXs, dxs, nshards, s, out, "",
+                                binary[s % binary.size()] ? fields::BINARY_FILE
+                                                          : fields::TEXT_FILE );
+    }
+    return names;
+  }
+
+  void removeAll( const std::vector<std::string> & names ) {
+    for ( std::size_t i = 0u; i < names.size(); ++i )
+      std::remove( names[i].c_str() );
+  }
+
+  std::string merge( const std::vector<std::string> & names,
+                     const fields::FileFormat & format ) {
+    std::ostringstream out;
+    out.precision(17);
+    fields::mergeFieldShards< Record >( names, out, "", format );
+    return out.str();
+  }
+}
+
+BOOST_AUTO_TEST_CASE( z_slabs ) {
+  const std::vector<std::string> names =
+    writeShards( Vector<int,3>(V3(1,1,3)), std::vector<bool>(1, false) );
+
+  /* the merged file is identical to one written in a single go. */
+  BOOST_CHECK( merge( names, fields::TEXT_FILE ) == wholeFile(fields::TEXT_FILE) );
+
+  /* the shards may be given in any order. */
+  std::vector<std::string> reversed( names.rbegin(), names.rend() );
+  BOOST_CHECK( merge( reversed, fields::BINARY_FILE ) ==
+               wholeFile(fields::BINARY_FILE) );
+
+  removeAll( names );
+}
+
+BOOST_AUTO_TEST_CASE( bricks ) {
+  std::vector<bool> binary;
+  binary.push_back(true);
+  binary.push_back(false);
+  const std::vector<std::string> names =
+    writeShards( Vector<int,3>(V3(2,3,2)), binary );
+
+  BOOST_CHECK( merge( names, fields::BINARY_FILE ) ==
+               wholeFile(fields::BINARY_FILE) );
+  BOOST_CHECK( merge( names, fields::TEXT_FILE ) == wholeFile(fields::TEXT_FILE) );
+
+  removeAll( names );
+}
+
+BOOST_AUTO_TEST_CASE( invalid_tiling ) {
+  const std::vector<std::string> names =
+    writeShards( Vector<int,3>(V3(1,2,2)), std::vector<bool>(1, true) );
+
+  /* missing shard. */
+  std::vector<std::string> some( names.begin(), names.end() - 1 );
+  BOOST_CHECK_THROW( merge( some, fields::TEXT_FILE ), std::runtime_error );
+
+  /* overlapping shards. */
+  some.push_back( names[0] );
+  BOOST_CHECK_THROW( merge( some, fields::TEXT_FILE ), std::runtime_error );
+
+  /* a shard of a different table. */
+  {
+    std::ofstream out( names[3].c_str() );
+    fields::createFieldShard( FillSrc(), X_MINc, X_MAXc, .5*dxc,
+                              X_MINs, X_MAXs, dxs,
+                              Vector<int,3>(V3(1,2,2)), 3, out );
+  }
+  BOOST_CHECK_THROW( merge( names, fields::TEXT_FILE ), std::runtime_error );
+
+  /* not a shard. */
+  {
+    std::ofstream out( names[3].c_str() );
+    out << wholeFile(fields::TEXT_FILE);
+  }
+  BOOST_CHECK_THROW( merge( names, fields::TEXT_FILE ), std::runtime_error );
+
+  removeAll( names );
+}
@@ -0,0 +1,182 @@
+#define BOOST_TEST_MODULE  HermiteLookup
+
+#include <fields/hermite-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <sstream>
+#include <cstdlib>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+
+  /** Polynomial force (at most cubic along each axis). */
+  struct Cubic {
+    void accel(       Vector<double,3> & a,
+                const Vector<double,3> & r,
+                const Vector<double,3> & v = V3(0.,0.,0.),
+                const double & t = 0.0,
+                const double & dt = 0.0,
+                const unsigned int & species = 0u ) const {
+      a = V3( r[X]*r[X]*r[Y], r[Y]*r[Z]*r[Z] - r[X], r[X]*r[Y]*r[Z] );
+    }
+
+    double potential( const Vector<double,3> & r,
+                      const Vector<double,3> & v = V3(0.,0.,0.),
+                      const double & t = 0.0,
+                      const unsigned int & species = 0u ) const {
+      return r[X]*r[X]*r[X] + r[X]*r[Y]*r[Z] - 2.*r[Z]*r[Z];
+    }
+  };
+
+  /** Smooth, non-polynomial force. */
+  struct Smooth {
+    void accel(       Vector<double,3> & a,
+                const Vector<double,3> & r,
+                const Vector<double,3> & v = V3(0.,0.,0.),
+                const double & t = 0.0,
+                const double & dt = 0.0,
+                const unsigned int & species = 0u ) const {
+      a = V3( std::sin(r[X]) * std::cos(r[Y]), std::exp(-r[Z]*r[Z]), 0. );
+    }
+
+    double potential( const Vector<double,3> & r,
+                      const Vector<double,3> & v = V3(0.,0.,0.),
+                      const double & t = 0.0,
+                      const unsigned int & species = 0u ) const {
+      return std::cos(r[X]*r[Y]) + r[Z]*r[Z];
+    }
+  };
+
+  typedef fields::ForceLookup< 3u,
+    fields::HermiteFieldLookup< fields::HermiteForceRecord<3u> > > Hermite;
+
+  template < typename Table, typename Lookup >
+  void create( Lookup & lookup, const Table & table, const double & dx ) {
+    std::stringstream file;
+    file.precision(17);
+    fields::createFieldFile( table,
+                             V3(-1.,-1.,-1.), V3(1.,1.,1.)*(1.+1e-9), V3(dx,dx,dx),
+                             V3(-2.,-2.,-2.), V3(2.,2.,2.)*(1.+1e-9), V3(dx,dx,dx)*2.,
+                             file );
+    lookup.readindata( file );
+  }
+
+  inline double rnd() { return std::rand() / (RAND_MAX + 1.0); }
+
+}/* namespace (anon) */
+
+BOOST_AUTO_TEST_CASE( polynomial ) {
+  fields::HermiteTableWrapper<Cubic> src;
+  src.fd_step = V3(1e-4,1e-4,1e-4);
+  Hermite lookup;
+  create( lookup, src, .5 );
+
+  Cubic exact;
+  std::srand(13);
+  for ( unsigned int n = 0u; n < 1000u; ++n ) {
+    const Vector<double,3> r = V3( 2.*rnd()-1., 2.*rnd()-1., 2.*rnd()-1. );
+    Vector<double,3> a0, a1;
+    exact.accel( a0, r );
+    lookup.accel( a1, r );
+    BOOST_CHECK_SMALL( (a0 - a1).abs(), 1e-6 );
+    BOOST_CHECK_SMALL( exact.potential(r) - lookup.potential(r), 1e-6 );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( accuracy ) {
+  /* Hermite on a 3x coarser grid beats trilinear. */
+  fields::HermiteTableWrapper<Smooth> hsrc;
+  hsrc.fd_step = V3(1e-5,1e-5,1e-5);
+  Hermite hermite;
+  create( hermite, hsrc, .5 );
+
+  fields::ForceLookup<> linear;
+  create( linear, fields::ForceTableWrapper<Smooth>(), .5/3. );
+
+  Smooth exact;
+  double herr = 0.0, lerr = 0.0;
+  std::srand(19);
+  for ( unsigned int n = 0u; n < 2000u; ++n ) {
+    const Vector<double,3> r = V3( 1.8*rnd()-.9, 1.8*rnd()-.9, 1.8*rnd()-.9 );
+    Vector<double,3> a0, ah, al;
+    exact.accel( a0, r );
+    hermite.accel( ah, r );
+    linear.accel( al, r );
+    herr = std::max( herr, (a0 - ah).abs() );
+    lerr = std::max( lerr, (a0 - al).abs() );
+  }
+  BOOST_CHECK( herr < lerr );
+
+  /* the text format round-trips. */
+  fields::HermiteForceRecord<3u> rec = hsrc.getRecord( V3(.1,.2,.3) ), rec2;
+  std::stringstream s;
+  s.precision(17);
+  s << rec;
+  s >> rec2;
+  BOOST_CHECK_EQUAL( rec.a, rec2.a );
+  BOOST_CHECK_EQUAL( rec.da[0][6], rec2.da[0][6] );
+  BOOST_CHECK_EQUAL( rec.dV[0][3], rec2.dV[0][3] );
+}
+
+BOOST_AUTO_TEST_CASE( default_step ) {
+  /* the default finite difference step follows the grid spacing. */
+  fields::HermiteTableWrapper<Smooth> src;
+  Hermite lookup;
+  create( lookup, src, .5 );
+
+  Smooth exact;
+  double err = 0.0;
+  std::srand(23);
+  for ( unsigned int n = 0u; n < 2000u; ++n ) {
+    const Vector<double,3> r = V3( 1.8*rnd()-.9, 1.8*rnd()-.9, 1.8*rnd()-.9 );
+    err = std::max( err, std::abs( exact.potential(r) - lookup.potential(r) ) );
+  }
+  BOOST_CHECK_SMALL( err, 1e-3 );
+
+  /* V = cos(xy) + z^2:  Vxy = -sin(xy) - xy cos(xy), Vxyz = 0. */
+  const Vector<double,3> r = V3(.1,.2,.3);
+  const fields::HermiteForceRecord<3u> rec =
+    src.getRecord( fields::GridPoint( r, V3(.5,.5,.5) ) );
+  const double xy = r[X]*r[Y];
+  BOOST_CHECK_CLOSE( rec.dV[0][3], -std::sin(xy) - xy*std::cos(xy), 1e-4 );
+  BOOST_CHECK_SMALL( rec.dV[0][6], 1e-5 );
+  BOOST_CHECK_SMALL( rec.da[0][6].abs(), 1e-5 );
+
+  /* away from a grid, the step must be given explicitly. */
+  BOOST_CHECK_THROW( src.getRecord( r ), std::runtime_error );
+  src.fd_step = V3(5e-4,5e-4,5e-4);
+  BOOST_CHECK_EQUAL( src.getRecord( r ).dV[0][3], rec.dV[0][3] );
+}
+
+BOOST_AUTO_TEST_CASE( planes ) {
+  /* the parallel writer also provides the grid spacing for the step. */
+  fields::HermiteTableWrapper<Smooth> src;
+  const Vector<double,3> xi = V3(-1.,-1.,-1.), dx = V3(.5,.5,.5);
+  std::stringstream lines, planes;
+  lines.precision(17);
+  planes.precision(17);
+  fields::spitfieldout( lines, src, xi, V3(1.,1.,1.), dx, fields::TEXT_FILE );
+  fields::spitfieldplanes( planes, src, xi, Vector<int,3>(5), dx );
+
+  /* (the writers separate the planes by empty lines differently.) */
+  std::string l, p;
+  unsigned int n = 0u;
+  while ( std::getline( lines, l ) ) {
+    if ( l.empty() )
+      continue;
+    while ( std::getline( planes, p ) && p.empty() ) ;
+    BOOST_CHECK_EQUAL( l, p );
+    ++n;
+  }
+  BOOST_CHECK_EQUAL( n, 125u );
+}
@@ -0,0 +1,94 @@
+#define BOOST_TEST_MODULE  HybridForce
+
+#include <fields/HybridForce.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <sstream>
+#include <vector>
+#include <cstdlib>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+
+  /** A quadratic potential (which the table only approximates). */
+  struct Exact {
+    void accel(       Vector<double,3> & a,
+                const Vector<double,3> & r,
+                const Vector<double,3> & v = V3(0.,0.,0.),
+                const double & t = 0.0,
+                const double & dt = 0.0,
+                const unsigned int & species = 0u ) const {
+      a = -2.0 * r;
+    }
+
+    double potential( const Vector<double,3> & r,
+                      const Vector<double,3> & v = V3(0.,0.,0.),
+                      const double & t = 0.0,
+                      const unsigned int & species = 0u ) const {
+      return r * r;
+    }
+  };
+
+  typedef fields::HybridForce< fields::ForceLookup<>, Exact > Force;
+
+  inline double rnd() { return std::rand() / (RAND_MAX + 1.0); }
+
+}/* namespace (anon) */
+
+BOOST_AUTO_TEST_CASE( hybrid ) {
+  std::stringstream file;
+  file.precision(17);
+  fields::createFieldFile( fields::ForceTableWrapper<Exact>(),
+                           V3(-1.,-1.,-1.), V3(1.,1.,1.), V3(.25,.25,.25),
+                           V3(-2.,-2.,-2.), V3(2.,2.,2.), V3(.5,.5,.5),
+                           file );
+  Force force;
+  force.readindata( file );
+
+  std::srand(11);
+  const std::size_t n = 1000u;
+  std::vector< Vector<double,3> > r(n), a(n);
+  std::vector<double> V(n);
+  for ( std::size_t i = 0u; i < n; ++i )
+    r[i] = V3( 6.*(rnd()-.5), 6.*(rnd()-.5), 6.*(rnd()-.5) );
+
+  force.accel( &a[0], &r[0], n );
+  force.potential( &V[0], &r[0], n );
+
+  std::size_t n_table = 0u;
+  for ( std::size_t i = 0u; i < n; ++i ) {
+    Vector<double,3> ai, ae, at;
+    force.accel( ai, r[i] );
+    force.Exact::accel( ae, r[i] );
+    force.Force::T::accel( at, r[i] );
+
+    BOOST_CHECK_EQUAL( a[i], ai );
+    BOOST_CHECK_EQUAL( V[i], force.potential(r[i]) );
+
+    const bool inside = std::abs(r[i][X]) <= 2. &&
+                        std::abs(r[i][Y]) <= 2. &&
+                        std::abs(r[i][Z]) <= 2.;
+    BOOST_CHECK_EQUAL( force.inTable(r[i]), inside );
+    if ( inside ) {
+      ++n_table;
+      BOOST_CHECK_EQUAL( ai, at );
+      /* the acceleration is linear, so the table is exact. */
+      BOOST_CHECK_SMALL( (ai - ae).abs(), 1e-10 );
+    } else {
+      BOOST_CHECK_EQUAL( ai, ae );
+      BOOST_CHECK_EQUAL( V[i], force.Exact::potential(r[i]) );
+    }
+  }
+
+  BOOST_CHECK( n_table > 0u );
+  BOOST_CHECK( n_table < n );
+}
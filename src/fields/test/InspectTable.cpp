@@ -0,0 +1,204 @@
+#define BOOST_TEST_MODULE  InspectTable
+
+#include <fields/inspect-table.h>
+#include <fields/field-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+#include "fixture.h"
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+  using namespace fields::test;
+
+  typedef fields::FieldLookup<Record> Lookup;
+
+  /** The SHELL is [-2,2]x[-2,2]x[-1.5,1.5] so that the dimensions of the
+   * tables differ. */
+  void writeFlatTable( const std::string & filename,
+                       const fields::FileFormat & format ) {
+    writeTable( filename, format, "# made for a test\n",
+                V3(-2.,-2.,-1.5), V3(2.,2.,1.5) );
+  }
+
+  /** Whether the tables of two files hold identical records. */
+  bool sameRecords( const std::string & file0, const std::string & file1 ) {
+    Lookup l0( file0 ), l1( file1 );
+    for ( int t = Lookup::CORE; t <= Lookup::SHELL; ++t ) {
+      const fields::detail::DTable<Record> & t0 = l0.table( Lookup::DSECT(t) );
+      const fields::detail::DTable<Record> & t1 = l1.table( Lookup::DSECT(t) );
+      if ( t0.xlen != t1.xlen || t0.ylen != t1.ylen || t0.zlen != t1.zlen )
+        return false;
+      for ( unsigned int k = 0u; k < t0.zlen; ++k )
+        for ( unsigned int i = 0u; i < t0.xlen; ++i )
+          for ( unsigned int j = 0u; j < t0.ylen; ++j )
+            if ( std::memcmp( &t0(i,j,k), &t1(i,j,k), sizeof(Record) ) != 0 )
+              return false;
+    }
+    return true;
+  }
+
+  /** Largest difference between the lookups of two files. */
+  double maxDifference( const std::string & file0, const std::string & file1 ) {
+    Lookup l0( file0 ), l1( file1 );
+    double diff = 0.0;
+    for ( int k = 0; k < 7; ++k )
+      for ( int j = 0; j < 7; ++j )
+        for ( int i = 0; i < 7; ++i ) {
+          const Vector<double,3> r = V3(i - 3., j - 3., k - 3.) * (1.9/3.);
+          for ( unsigned int s = 0u; s < 2u; ++s ) {
+            Vector<double,3> a0, a1;
+            l0.vector_lookup( a0, r, s );
+            l1.vector_lookup( a1, r, s );
+            diff = std::max( diff, (a0 - a1).abs() );
+            diff = std::max( diff, std::abs( l0.scalar_lookup(r, s) -
+                                             l1.scalar_lookup(r, s) ) );
+          }
+        }
+    return diff;
+  }
+}
+
+BOOST_AUTO_TEST_CASE( header ) {
+  const std::string txt = tempName("txt"), bin = tempName("bin"),
+                    npy = tempName("npy");
+  writeFlatTable( txt, fields::TEXT_FILE );
+  writeFlatTable( bin, fields::BINARY_FILE );
+  writeFlatTable( npy, fields::NPY_FILE );
+
+  const fields::FileFormat formats[3] =
+    { fields::TEXT_FILE, fields::BINARY_FILE, fields::NPY_FILE };
+  const std::string names[3] = { txt, bin, npy };
+  for ( int f = 0; f < 3; ++f ) {
+    const fields::FieldFileInfo info = fields::readFieldFileInfo( names[f] );
+    BOOST_CHECK_EQUAL( info.format, formats[f] );
+    BOOST_CHECK_EQUAL( info.columns, 8u );
+    BOOST_CHECK_EQUAL( info.record_size, sizeof(Record) );
+    BOOST_CHECK( (info.table[0].N == Vector<int,3>(9)) );
+    BOOST_CHECK( (info.table[1].N == Vector<int,3>(V3(9,9,7))) );
+    BOOST_CHECK_EQUAL( info.bytes(1), 9u*9u*7u*sizeof(Record) );
+    BOOST_CHECK_EQUAL( info.comments, "# made for a test\n" );
+
+    std::ostringstream out;
+    out << info;
+    BOOST_CHECK( out.str().find("made for a test") != std::string::npos );
+  }
+
+  BOOST_CHECK_THROW( fields::readFieldFileInfo( tempName("missing") ),
+                     std::runtime_error );
+
+  removeTable( txt );
+  removeTable( bin );
+  removeTable( npy );
+}
+
+BOOST_AUTO_TEST_CASE( convert ) {
+  const std::string txt = tempName("ctxt"), bin = tempName("cbin"),
+                    out = tempName("cout"), npy = tempName("cnpy"),
+                    back = tempName("cback");
+  writeFlatTable( txt, fields::TEXT_FILE );
+  writeFlatTable( bin, fields::BINARY_FILE );
+
+  /* binary to text and back is lossless. */
+  fields::convertFieldFile<Record>( bin, out, fields::TEXT_FILE );
+  fields::convertFieldFile<Record>( out, back, fields::BINARY_FILE );
+  BOOST_CHECK( sameRecords( bin, back ) );
+
+  /* text to binary (up to the precision of the text). */
+  fields::convertFieldFile<Record>( txt, out, fields::BINARY_FILE );
+  BOOST_CHECK_SMALL( maxDifference( bin, out ), 1e-7 );
+
+  /* through NumPy arrays and back is lossless. */
+  fields::convertFieldFile<Record>( bin, npy, fields::NPY_FILE );
+  BOOST_CHECK_SMALL( maxDifference( bin, npy ), 1e-15 );
+  fields::convertFieldFile<Record>( npy, out, fields::BINARY_FILE );
+  BOOST_CHECK( sameRecords( out, bin ) );
+
+  /* single precision arrays. */
+  fields::convertFieldFile<Record>( bin, npy, fields::NPY_FILE, true );
+  BOOST_CHECK_EQUAL( fields::readFieldFileInfo(npy).npy[0].descr,
+                     fields::detail::npyFloatDescr() );
+  BOOST_CHECK_SMALL( maxDifference( bin, npy ), 1e-6 );
+  BOOST_CHECK( fields::readFieldFileInfo(npy).comments == "# made for a test\n" );
+
+  /* mismatched records. */
+  BOOST_CHECK_THROW(
+    fields::convertFieldFile< fields::ForceRecord<3u> >( bin, out,
+                                                         fields::TEXT_FILE ),
+    std::runtime_error );
+  BOOST_CHECK_THROW(
+    fields::convertFieldFile<Record>( bin, out, fields::TEXT_FILE, true ),
+    std::runtime_error );
+
+  removeTable( txt );
+  removeTable( bin );
+  removeTable( out );
+  removeTable( npy );
+  removeTable( back );
+}
+
+BOOST_AUTO_TEST_CASE( extract ) {
+  const std::string bin = tempName("ebin");
+  writeFlatTable( bin, fields::BINARY_FILE );
+  Lookup whole( bin );
+
+  /* a line through the CORE and the SHELL. */
+  {
+    std::ostringstream out;
+    out.precision(17);
+    fields::extractLine<Lookup>( bin, V3(-1.8,.3,-.2), V3(1.7,-.4,.6), 11,
+                                 out, 1u );
+    std::istringstream in( out.str() );
+    std::string comment;
+    std::getline( in, comment );
+    BOOST_CHECK_EQUAL( comment[0], '#' );
+    int n = 0;
+    for ( Vector<double,3> r, a; in >> r >> a; ++n ) {
+      double V;
+      in >> V;
+      Vector<double,3> a0;
+      whole.vector_lookup( a0, r, 1u );
+      BOOST_CHECK_SMALL( (a - a0).abs(), 1e-12 );
+      BOOST_CHECK_SMALL( V - whole.scalar_lookup( r, 1u ), 1e-12 );
+    }
+    BOOST_CHECK_EQUAL( n, 11 );
+  }
+
+  /* a z-slice. */
+  {
+    std::ostringstream out;
+    out.precision(17);
+    fields::extractSlice<Lookup>( bin, Z, .3, 5, out );
+    std::istringstream in( out.str() );
+    std::string comment;
+    std::getline( in, comment );
+    int n = 0;
+    for ( Vector<double,3> r, a; in >> r >> a; ++n ) {
+      double V;
+      in >> V;
+      BOOST_CHECK_EQUAL( r[Z], .3 );
+      Vector<double,3> a0;
+      whole.vector_lookup( a0, r, 0u );
+      BOOST_CHECK_SMALL( (a - a0).abs(), 1e-12 );
+      BOOST_CHECK_SMALL( V - whole.scalar_lookup( r, 0u ), 1e-12 );
+    }
+    BOOST_CHECK_EQUAL( n, 25 );
+  }
+
+  removeTable( bin );
+}
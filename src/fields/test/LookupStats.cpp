@@ -0,0 +1,97 @@
+#define BOOST_TEST_MODULE  LookupStats
+#define FIELDS_LOOKUP_STATS
+
+#include <fields/field-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/lookup-stats.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+
+  typedef fields::ForceRecord<> Record;
+
+  /** CORE : [-1,1]^3 with dx=0.25,  SHELL : [-4,4]^3 with dx=0.5. */
+  struct TestTable : fields::FieldLookup<Record> {
+    TestTable() {
+      initialize( V3(0.,0.,0.),
+                  V3(.25,.25,.25), V3(-1.,-1.,-1.), V3(1.,1.,1.),
+                  V3(.5,.5,.5),    V3(-4.,-4.,-4.), V3(4.,4.,4.) );
+    }
+  };
+
+  /** CORE : rho,z in [-1,1] with dx=0.25,  SHELL : rho,z in [-2,2] with
+   * dx=0.5. */
+  struct AxiSymTable : fields::AxiSymFieldLookup<Record> {
+    AxiSymTable() {
+      initialize( V3(0.,0.,0.),
+                  V3(.25,.25,.25), V3(-1.,0.,-1.), V3(1.,0.,1.),
+                  V3(.5,.5,.5),    V3(-2.,0.,-2.), V3(2.,0.,2.) );
+    }
+  };
+
+}/* namespace (anon) */
+
+BOOST_AUTO_TEST_CASE( counters ) {
+  TestTable table;
+  Vector<double,3> a;
+
+  const int n = 1000;
+  #pragma omp parallel for private(a)
+  for ( int i = 0; i < n; ++i ) {
+    table.vector_lookup( a, V3(.1, .2, -.3), 0u );  /* CORE */
+    table.vector_lookup( a, V3(2., 0., 0.), 0u );   /* SHELL */
+    table.vector_lookup( a, V3(0., 0., 5.), 0u );   /* SHELL, clamped z */
+    (void)table.scalar_lookup( V3(-9., 0., 0.), 0u );/* SHELL, clamped x */
+  }
+
+  const fields::LookupStats s = table.stats();
+  BOOST_CHECK_EQUAL( s.total(), 4ull * n );
+  BOOST_CHECK_EQUAL( s.core_hits, 1ull * n );
+  BOOST_CHECK_EQUAL( s.shell_hits, 3ull * n );
+  BOOST_CHECK_EQUAL( s.clamp_low[X], 1ull * n );
+  BOOST_CHECK_EQUAL( s.clamp_high[X], 0ull );
+  BOOST_CHECK_EQUAL( s.clamp_low[Y] + s.clamp_high[Y], 0ull );
+  BOOST_CHECK_EQUAL( s.clamp_high[Z], 1ull * n );
+  BOOST_CHECK_EQUAL( s.clamps(), 2ull * n );
+
+  /* (.1,.2,-.3) is at index (4.4, 4.8, 2.8) of the 9-point core table. */
+  BOOST_CHECK_EQUAL( s.histogram[0][4][4][2], 1ull * n );
+  BOOST_CHECK_CLOSE( s.occupancy(0u), 1.0 / 512, 1e-8 );
+
+  table.resetStats();
+  BOOST_CHECK_EQUAL( table.stats().total(), 0ull );
+}
+
+BOOST_AUTO_TEST_CASE( axisym_counters ) {
+  AxiSymTable table;
+  Vector<double,3> a;
+
+  const int n = 1000;
+  #pragma omp parallel for private(a)
+  for ( int i = 0; i < n; ++i ) {
+    table.vector_lookup( a, V3(.1, .2, -.3), 0u );  /* CORE */
+    table.vector_lookup( a, V3(0., 0., 1.5), 0u );  /* SHELL */
+    (void)table.scalar_lookup( V3(0., 0., 5.), 0u );/* SHELL, clamped z */
+    (void)table.scalar_lookup( V3(0., 3., 0.), 0u );/* SHELL, clamped rho */
+  }
+
+  const fields::LookupStats s = table.stats();
+  BOOST_CHECK_EQUAL( s.total(), 4ull * n );
+  BOOST_CHECK_EQUAL( s.core_hits, 1ull * n );
+  BOOST_CHECK_EQUAL( s.shell_hits, 3ull * n );
+  BOOST_CHECK_EQUAL( s.clamp_high[X], 1ull * n );
+  BOOST_CHECK_EQUAL( s.clamp_low[Y] + s.clamp_high[Y], 0ull );
+  BOOST_CHECK_EQUAL( s.clamp_high[Z], 1ull * n );
+  BOOST_CHECK_EQUAL( s.clamps(), 2ull * n );
+
+  /* rho=.2236, z=-.3 is at index (4.89, 2.8) of the 9-point core table. */
+  BOOST_CHECK_EQUAL( s.histogram[0][4][0][2], 1ull * n );
+}
@@ -0,0 +1,111 @@
+#define BOOST_TEST_MODULE  NonUniformLookup
+
+#include <fields/GridAxis.h>
+#include <fields/nonuniform-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using fields::GridAxis;
+  using namespace fields::indices;
+
+  typedef fields::ForceRecord<> Record;
+
+  /** A linear field (which is exactly reproduced by the lookup). */
+  struct LinearSrc {
+    Record getRecord( const Vector<double,3> & r ) const {
+      Record rec;
+      rec.a = V3( 2.*r[X] - r[Z], r[Y] + 1., 3.*r[Z] );
+      rec.V = r[X] + 2.*r[Y] - 5.*r[Z];
+      return rec;
+    }
+  };
+
+  inline double rnd() { return std::rand() / (RAND_MAX + 1.0); }
+
+}/* namespace (anon) */
+
+BOOST_AUTO_TEST_CASE( locate ) {
+  std::vector<GridAxis> axes;
+  axes.push_back( GridAxis::uniform( -1., 1., 11u ) );
+  axes.push_back( GridAxis::sinh( -1e-3, 1e-3, 101u, 0., 1e-5 ) );
+  {
+    std::vector<double> c;
+    c.push_back(0.); c.push_back(.01); c.push_back(.5); c.push_back(.51);
+    c.push_back(3.); c.push_back(10.);
+    axes.push_back( GridAxis(c) );
+  }
+
+  std::srand(3);
+  for ( unsigned int a = 0u; a < axes.size(); ++a ) {
+    const GridAxis & ax = axes[a];
+    for ( unsigned int n = 0u; n < 10000u; ++n ) {
+      const double x = ax.min() + ax.length() * rnd();
+      unsigned int i;
+      double f;
+      ax.locate( x, i, f );
+      BOOST_REQUIRE( i + 1u < ax.size() );
+      BOOST_CHECK( ax[i] <= x );
+      BOOST_CHECK( x < ax[i+1] );
+      BOOST_CHECK_CLOSE( ax[i] + f * (ax[i+1] - ax[i]), x, 1e-8 );
+    }
+
+    /* clamped to the ends */
+    unsigned int i;
+    double f;
+    ax.locate( ax.min() - 1., i, f );
+    BOOST_CHECK_EQUAL( i, 0u );
+    BOOST_CHECK_EQUAL( f, 0.0 );
+    ax.locate( ax.max() + 1., i, f );
+    BOOST_CHECK_EQUAL( i, ax.size() - 2u );
+    BOOST_CHECK_EQUAL( f, 1.0 );
+  }
+
+  /* an axis needs at least two points. */
+  for ( unsigned int N = 0u; N < 2u; ++N ) {
+    BOOST_CHECK_THROW( GridAxis::uniform( -1., 1., N ), std::runtime_error );
+    BOOST_CHECK_THROW( GridAxis::sinh( -1., 1., N, 0., .1 ), std::runtime_error );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( lookup ) {
+  std::stringstream file;
+  file.precision(17);
+  fields::createFieldFile( LinearSrc(),
+                           GridAxis::sinh( -1., 1., 21u, 0., .1 ),
+                           GridAxis::uniform( -2., 2., 5u ),
+                           GridAxis::sinh( -1., 3., 15u, 1., .5 ),
+                           file );
+
+  fields::ForceLookup< 3u, fields::NonUniformFieldLookup<Record> > lookup;
+  lookup.readindata(file);
+  BOOST_REQUIRE( lookup.isInitialized() );
+  BOOST_CHECK_EQUAL( lookup.getAxis(X).size(), 21u );
+  BOOST_CHECK_EQUAL( lookup.getAxis(Z).size(), 15u );
+
+  std::srand(4);
+  for ( unsigned int n = 0u; n < 1000u; ++n ) {
+    const Vector<double,3> r =
+      V3( 2.*rnd() - 1., 4.*rnd() - 2., 4.*rnd() - 1. );
+    const Record exact = LinearSrc().getRecord(r);
+    Vector<double,3> a;
+    lookup.accel(a, r);
+    for ( int j = X; j <= Z; ++j )
+      BOOST_CHECK_SMALL( a[j] - exact.a[j], 1e-10 );
+    BOOST_CHECK_SMALL( lookup.potential(r) - exact.V, 1e-10 );
+  }
+}
@@ -0,0 +1,199 @@
+#define BOOST_TEST_MODULE  NpyTable
+
+#include <fields/field-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/SpeciesMajorTable.h>
+#include <fields/detail/npy.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <sstream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+#include "fixture.h"
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+  using namespace fields::test;
+
+  typedef fields::FieldLookup<Record> Lookup;
+
+  template < class L0, class L1 >
+  void checkSame( const L0 & l0, const L1 & l1,
+                  const Vector<double,3> & lo, const Vector<double,3> & hi ) {
+    for ( int k = 0; k < 7; ++k )
+      for ( int j = 0; j < 7; ++j )
+        for ( int i = 0; i < 7; ++i ) {
+          const Vector<double,3> r =
+            lo + compMult( hi - lo, V3(i,j,k) / 6.0 ) * 0.999;
+          for ( unsigned int s = 0u; s < 2u; ++s ) {
+            Vector<double,3> a0, a1;
+            l0.vector_lookup( a0, r, s );
+            l1.vector_lookup( a1, r, s );
+            BOOST_CHECK_SMALL( (a0 - a1).abs(), 1e-12 );
+            BOOST_CHECK_SMALL( l0.scalar_lookup(r, s) - l1.scalar_lookup(r, s),
+                               1e-12 );
+          }
+        }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( npy_header ) {
+  std::vector<std::size_t> shape;
+  shape.push_back(5);
+  shape.push_back(3);
+  shape.push_back(7);
+  shape.push_back(8);
+
+  std::stringstream s;
+  fields::detail::writeNpyHeader( s, shape );
+  BOOST_CHECK_EQUAL( s.str().size() % 64u, 0u );
+  BOOST_CHECK( s.str().find("'shape': (5, 3, 7, 8), }") != std::string::npos );
+
+  fields::detail::NpyHeader h;
+  fields::detail::readNpyHeader( s, h );
+  BOOST_CHECK_EQUAL( h.offset, s.str().size() );
+  BOOST_CHECK( h.shape == shape );
+  BOOST_CHECK( h.isNative() );
+  BOOST_CHECK( h.isTable( Vector<int,3>(V3(3,7,5)), 8u ) );
+}
+
+BOOST_AUTO_TEST_CASE( mapped_table ) {
+  const std::string bin = tempName("bin"), npy = tempName("npy");
+  writeTable( bin, fields::BINARY_FILE );
+  writeTable( npy, fields::NPY_FILE );
+
+  Lookup ref, mapped;
+  ref.readindata( bin );
+  mapped.readindata( npy );
+
+  BOOST_CHECK( mapped.table(Lookup::CORE).isMapped() );
+  BOOST_CHECK( mapped.table(Lookup::SHELL).isMapped() );
+  checkSame( ref, mapped, V3(-2.,-2.,-2.), V3(2.,2.,2.) );
+
+  /* a region of interest is copied out of the arrays. */
+  Lookup roi;
+  roi.readindata( npy, V3(-.5,-.3,-.6), V3(.6,.3,.1) );
+  BOOST_CHECK( !roi.table(Lookup::CORE).isMapped() );
+  BOOST_CHECK_EQUAL( roi.table(Lookup::CORE).xlen, 6u );
+  checkSame( ref, roi, V3(-.5,-.3,-.6), V3(.6,.3,.1) );
+
+  /* storage that cannot be mapped reads the arrays. */
+  typedef fields::FieldLookup< Record, fields::SpeciesMajorTable<3u,2u> >
+    SMLookup;
+  SMLookup sm;
+  sm.readindata( npy );
+  checkSame( ref, sm, V3(-2.,-2.,-2.), V3(2.,2.,2.) );
+
+  removeTable( bin );
+  removeTable( npy );
+}
+
+BOOST_AUTO_TEST_CASE( converted_table ) {
+  const std::string bin = tempName("convbin"), npy = tempName("conv");
+  writeTable( bin, fields::BINARY_FILE );
+  writeTable( npy, fields::NPY_FILE );
+  Lookup ref;
+  ref.readindata( bin );
+
+  /* rewrite the CORE array in column-major, single-precision form (as some
+   * other programs might). */
+  const fields::detail::DTable<Record> & t = ref.table(Lookup::CORE);
+  const unsigned int K = sizeof(Record) / sizeof(double);
+  {
+    std::ostringstream dict;
+    dict << "{'descr': '<f4', 'fortran_order': True, 'shape': ("
+         << t.zlen << ", " << t.xlen << ", " << t.ylen << ", " << K << "), }";
+    std::string h = dict.str();
+    h.append( 63u - (10u + h.size()) % 64u, ' ' );
+    h += '\n';
+
+    std::ofstream out( (npy + ".core.npy").c_str(), std::ios::binary );
+    out.write( "\x93NUMPY\x01\x00", 8 );
+    out.put( char(h.size() & 0xff) );
+    out.put( char(h.size() >> 8) );
+    out << h;
+    for ( unsigned int c = 0u; c < K; ++c )
+      for ( unsigned int j = 0u; j < t.ylen; ++j )
+        for ( unsigned int i = 0u; i < t.xlen; ++i )
+          for ( unsigned int k = 0u; k < t.zlen; ++k ) {
+            const float f = reinterpret_cast<const double*>( &t(i,j,k) )[c];
+            out.write( reinterpret_cast<const char*>(&f), sizeof(f) );
+          }
+  }
+
+  Lookup conv;
+  conv.readindata( npy );
+  BOOST_CHECK( !conv.table(Lookup::CORE).isMapped() );
+  BOOST_CHECK( conv.table(Lookup::SHELL).isMapped() );
+  for ( unsigned int k = 0u; k < t.zlen; ++k )
+    for ( unsigned int i = 0u; i < t.xlen; ++i )
+      for ( unsigned int j = 0u; j < t.ylen; ++j )
+        BOOST_CHECK_CLOSE( conv.table(Lookup::CORE)(i,j,k).V[1],
+                           t(i,j,k).V[1], 1e-5 );
+
+  removeTable( bin );
+  removeTable( npy );
+}
+
+BOOST_AUTO_TEST_CASE( swapped_planes ) {
+  const std::string bin = tempName("swapbin"), npy = tempName("swap");
+  writeTable( bin, fields::BINARY_FILE );
+  writeTable( npy, fields::NPY_FILE );
+  Lookup ref;
+  ref.readindata( bin );
+
+  /* rewrite the CORE array in row-major form with the other byte order. */
+  const fields::detail::DTable<Record> & t = ref.table(Lookup::CORE);
+  const unsigned int K = sizeof(Record) / sizeof(double);
+  {
+    std::vector<std::size_t> shape;
+    shape.push_back(t.zlen);
+    shape.push_back(t.xlen);
+    shape.push_back(t.ylen);
+    shape.push_back(K);
+    std::ofstream out( (npy + ".core.npy").c_str(), std::ios::binary );
+    fields::detail::writeNpyHeader( out, shape,
+      fields::detail::littleEndian() ? ">f8" : "<f8" );
+    for ( unsigned int k = 0u; k < t.zlen; ++k )
+      for ( unsigned int i = 0u; i < t.xlen; ++i )
+        for ( unsigned int j = 0u; j < t.ylen; ++j )
+          for ( unsigned int c = 0u; c < K; ++c ) {
+            char e[8];
+            std::memcpy( e, reinterpret_cast<const double*>(&t(i,j,k)) + c, 8u );
+            std::reverse( e, e + 8 );
+            out.write( e, 8 );
+          }
+  }
+
+  /* the whole table, and a decimated region of interest (which reads only
+   * some of the z-planes). */
+  Lookup conv, roi;
+  conv.readindata( npy );
+  BOOST_CHECK( !conv.table(Lookup::CORE).isMapped() );
+  checkSame( ref, conv, V3(-2.,-2.,-2.), V3(2.,2.,2.) );
+
+  roi.readindata( npy, V3(-.5,-.5,-.5), V3(.5,1.,.5), Vector<int,3>(2) );
+  const fields::detail::DTable<Record> & r = roi.table(Lookup::CORE);
+  BOOST_CHECK_EQUAL( r.zlen, 3u );
+  for ( unsigned int k = 0u; k < r.zlen; ++k )
+    for ( unsigned int i = 0u; i < r.xlen; ++i )
+      for ( unsigned int j = 0u; j < r.ylen; ++j )
+        BOOST_CHECK_EQUAL( r(i,j,k).V[1], t(2u+2u*i, 2u+2u*j, 2u+2u*k).V[1] );
+
+  removeTable( bin );
+  removeTable( npy );
+}
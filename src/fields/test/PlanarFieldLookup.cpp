@@ -0,0 +1,208 @@
+#define BOOST_TEST_MODULE  PlanarFieldLookup
+
+#include <fields/PlanarFieldLookup.h>
+#include <fields/field-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <unistd.h>
+
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <cstdio>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+
+  typedef fields::ForceRecord<3u,2u> Record;
+  typedef fields::FieldLookup<Record> Lookup;
+  typedef fields::PlanarFieldLookup<Record> Planar;
+
+  /** Source that does not vary along the given axis. */
+  struct FillSrc {
+    FillSrc( const unsigned int & axis ) : axis(axis) { }
+
+    Record getRecord( const Vector<double,3> & r ) const {
+      const double u = r[(axis + 1u) % 3u], v = r[(axis + 2u) % 3u];
+      Record rec;
+      for ( unsigned int i = 0u; i < 2u; ++i ) {
+        rec.a[i] = V3( std::sin(u) + i, std::cos(v) * u, u*v - i );
+        rec.V[i] = std::cos(u*v) + u + i;
+      }
+      return rec;
+    }
+
+    unsigned int axis;
+  };
+
+  std::string tempName( const std::string & name ) {
+    std::ostringstream s;
+    s << "/tmp/PlanarFieldLookup-" << name << '-' << getpid();
+    return s.str();
+  }
+
+  /** Write a table with CORE [-1,1]^3 (dx=0.25) and SHELL [-2,2]^3 (dx=0.5),
+   * collapsed to a single plane along the invariant axis if planar. */
+  void writeTable( const std::string & filename,
+                   const unsigned int & axis,
+                   const bool & planar ) {
+    Vector<double,3> X_MINc = V3(-1.,-1.,-1.), X_MAXc = V3(1.,1.,1.);
+    Vector<double,3> X_MINs = V3(-2.,-2.,-2.), X_MAXs = V3(2.,2.,2.);
+    if ( planar )
+      X_MINc[axis] = X_MAXc[axis] = X_MINs[axis] = X_MAXs[axis] = 0.0;
+    fields::createFieldFile( FillSrc(axis),
+                             X_MINc, X_MAXc, V3(.25,.25,.25),
+                             X_MINs, X_MAXs, V3(.5,.5,.5),
+                             filename, "", fields::BINARY_FILE );
+  }
+
+  /** Compare the planar lookup with a full table of the same source. */
+  void checkAxis( const unsigned int & axis ) {
+    const std::string full = tempName("full"), plane = tempName("plane");
+    writeTable( full, axis, false );
+    writeTable( plane, axis, true );
+
+    Lookup ref;
+    ref.readindata( full );
+    Planar planar;
+    planar.setInvariantAxis( axis );
+    planar.readindata( plane );
+
+    /* the tables hold a single plane. */
+    for ( int t = Planar::CORE; t <= Planar::SHELL; ++t )
+      BOOST_CHECK_EQUAL( planar.geometry( Planar::DSECT(t) ).N[axis], 1 );
+
+    const double along[3] = { -.9, .35, .8 };
+    for ( int j = 0; j < 9; ++j )
+      for ( int i = 0; i < 9; ++i )
+        for ( int k = 0; k < 3; ++k ) {
+          Vector<double,3> r;
+          r[(axis + 1u) % 3u] = ( -2. + i * .5 ) * .999;
+          r[(axis + 2u) % 3u] = ( -2. + j * .5 ) * .999;
+          r[axis] = along[k];
+
+          Vector<double,3> far = r;
+          far[axis] = 100.0;
+          BOOST_CHECK( planar.inDomain(far) );
+          BOOST_CHECK_EQUAL( planar.whichTable(r), ref.whichTable(r) );
+
+          for ( unsigned int s = 0u; s < 2u; ++s ) {
+            Vector<double,3> a0, a1, a2;
+            ref.vector_lookup( a0, r, s );
+            planar.vector_lookup( a1, r, s );
+            planar.vector_lookup( a2, far, s );
+            BOOST_CHECK_SMALL( (a0 - a1).abs(), 1e-12 );
+            BOOST_CHECK_SMALL( (a1 - a2).abs(), 1e-12 );
+            BOOST_CHECK_SMALL( ref.scalar_lookup(r, s) -
+                               planar.scalar_lookup(r, s), 1e-12 );
+            BOOST_CHECK_SMALL( planar.scalar_lookup(r, s) -
+                               planar.scalar_lookup(far, s), 1e-12 );
+          }
+        }
+
+    std::remove( full.c_str() );
+    std::remove( plane.c_str() );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( z_invariant ) {
+  checkAxis( Z );
+}
+
+BOOST_AUTO_TEST_CASE( other_axes ) {
+  checkAxis( X );
+  checkAxis( Y );
+
+  Planar planar;
+  BOOST_CHECK_THROW( planar.setInvariantAxis( 3u ), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( not_planar ) {
+  const std::string full = tempName("notplanar"), plane = tempName("planex");
+
+  /* a table that is not collapsed along any axis. */
+  writeTable( full, Z, false );
+  Planar p0;
+  BOOST_CHECK_THROW( p0.readindata( full ), std::runtime_error );
+  BOOST_CHECK_THROW( Planar( full, X ), std::runtime_error );
+
+  /* a table collapsed along a different axis than the invariant axis. */
+  writeTable( plane, X, true );
+  Planar p1;
+  BOOST_CHECK_THROW( p1.readindata( plane ), std::runtime_error );
+  Planar p2( plane, X );
+  BOOST_CHECK_THROW( p2.setInvariantAxis( Y ), std::runtime_error );
+  BOOST_CHECK_EQUAL( p2.invariantAxis(), unsigned(X) );
+
+  std::remove( full.c_str() );
+  std::remove( plane.c_str() );
+}
+
+BOOST_AUTO_TEST_CASE( rotated ) {
+  const std::string plane = tempName("rotated");
+  writeTable( plane, Z, true );
+
+  Planar orig, rot;
+  orig.readindata( plane );
+  rot.readindata( plane );
+
+  /* invariant along x:  the lab position (x,y,z) is (-z,y,x) in the table
+   * frame and table vectors (ax,ay,az) are (az,ay,-ax) in the lab. */
+  rot.rotateField( V3(1.,0.,0.) );
+  for ( int i = 0; i < 7; ++i )
+    for ( int j = 0; j < 7; ++j ) {
+      const double y = -1.8 + .6 * j, z = -1.8 + .6 * i;
+      const Vector<double,3> t = V3(-z, y, 0.);
+      Vector<double,3> at, al;
+      orig.vector_lookup( at, t, 1u );
+      for ( int x = -2; x <= 2; ++x ) {
+        const Vector<double,3> r = V3(3.*x, y, z);
+        rot.vector_lookup( al, r, 1u );
+        BOOST_CHECK_SMALL( (al - V3(at[Z], at[Y], -at[X])).abs(), 1e-12 );
+        BOOST_CHECK_SMALL( rot.scalar_lookup(r, 1u) -
+                           orig.scalar_lookup(t, 1u), 1e-12 );
+      }
+    }
+
+  /* an oblique invariant axis, also with the table invariant along x. */
+  const Vector<double,3> k = V3(1.,2.,-2.) / 3.;
+  const unsigned int axes[2] = { X, Z };
+  for ( int n = 0; n < 2; ++n ) {
+    const unsigned int axis = axes[n];
+    Planar p;
+    if ( axis == X ) {
+      writeTable( plane, X, true );
+      p.setInvariantAxis( X );
+    } else
+      writeTable( plane, Z, true );
+    p.readindata( plane );
+    p.rotateField( k );
+
+    const Vector<double,3> Rk = p.rotation() * k;
+    BOOST_CHECK_CLOSE( Rk[axis], 1.0, 1e-10 );
+
+    for ( int i = 0; i < 5; ++i ) {
+      const Vector<double,3> p0 = V3(.3 * i - .6, .7 - .25 * i, .1 * i);
+      Vector<double,3> a0, a1;
+      p.vector_lookup( a0, p0, 0u );
+      for ( int s = -3; s <= 3; ++s ) {
+        p.vector_lookup( a1, p0 + 2. * s * k, 0u );
+        BOOST_CHECK_SMALL( (a0 - a1).abs(), 1e-12 );
+        BOOST_CHECK_SMALL( p.scalar_lookup(p0, 0u) -
+                           p.scalar_lookup(p0 + 2. * s * k, 0u), 1e-12 );
+      }
+    }
+  }
+
+  std::remove( plane.c_str() );
+}
@@ -0,0 +1,177 @@
+#define BOOST_TEST_MODULE  ProgressiveForce
+
+#include <fields/ProgressiveForce.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+
+#include <xylose/Vector.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sstream>
+#include <fstream>
+#include <string>
+#include <cstdio>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+
+  /** A quadratic potential (which the table only approximates). */
+  struct Exact {
+    void accel(       Vector<double,3> & a,
+                const Vector<double,3> & r,
+                const Vector<double,3> & v = V3(0.,0.,0.),
+                const double & t = 0.0,
+                const double & dt = 0.0,
+                const unsigned int & species = 0u ) const {
+      a = -2.0 * r;
+    }
+
+    double potential( const Vector<double,3> & r,
+                      const Vector<double,3> & v = V3(0.,0.,0.),
+                      const double & t = 0.0,
+                      const unsigned int & species = 0u ) const {
+      return r * r + 1.0;
+    }
+  };
+
+  /** The contents of a table file of Exact with 9^3 CORE records. */
+  std::string contents() {
+    std::stringstream file;
+    file.precision(17);
+    fields::createFieldFile( fields::ForceTableWrapper<Exact>(),
+                             V3(-1.,-1.,-1.), V3(1.,1.,1.), V3(.25,.25,.25),
+                             V3(-2.,-2.,-2.), V3(2.,2.,2.), V3(.5,.5,.5),
+                             file );
+    return file.str();
+  }
+
+  /** Offset of the end of the CORE data-block of a text file. */
+  std::size_t coreEnd( const std::string & s ) {
+    std::istringstream in(s);
+    std::string line;
+    unsigned int records = 0u;
+    while ( records < 9u*9u*9u && std::getline(in, line) )
+      if ( !line.empty() && line[0] != '#' )
+        ++records;
+    return std::size_t( in.tellg() );
+  }
+
+  void writeAll( const int & fd, const std::string & s ) {
+    for ( std::size_t n = 0u; n < s.size(); ) {
+      const ssize_t w = write( fd, s.data() + n, s.size() - n );
+      BOOST_REQUIRE( w > 0 );
+      n += w;
+    }
+  }
+
+  std::string tempName( const std::string & name ) {
+    std::ostringstream s;
+    s << "/tmp/ProgressiveForce-" << name << '-' << getpid();
+    return s.str();
+  }
+
+  typedef fields::ProgressiveForce< fields::ForceLookup<> > Blocking;
+  typedef fields::ProgressiveForce< fields::ForceLookup<>, Exact > Direct;
+
+}/* namespace (anon) */
+
+BOOST_AUTO_TEST_CASE( load_file ) {
+  const std::string filename = tempName("table");
+  {
+    std::ofstream out(filename.c_str());
+    out << contents();
+  }
+
+  fields::ForceLookup<> reference;
+  reference.readindata( filename );
+
+  Blocking force;
+  BOOST_CHECK( force.loadStatus().ready() );
+  const fields::TableLoad & load = force.readindataAsync( filename );
+
+  /* lookups wait for the tables by themselves. */
+  const Vector<double,3> r[] = { V3(.1,.2,.3), V3(1.7,-1.2,.4) };
+  for ( unsigned int i = 0u; i < 2u; ++i ) {
+    Vector<double,3> a0, a1;
+    force.accel( a0, r[i] );
+    reference.accel( a1, r[i] );
+    BOOST_CHECK_EQUAL( a0, a1 );
+    BOOST_CHECK_EQUAL( force.potential(r[i]), reference.potential(r[i]) );
+  }
+
+  load.wait();
+  BOOST_CHECK( load.ready() );
+  BOOST_CHECK( force.isInitialized() );
+  std::remove( filename.c_str() );
+}
+
+BOOST_AUTO_TEST_CASE( core_first ) {
+  /* a pipe lets the test control when the SHELL data arrives. */
+  const std::string fifo = tempName("fifo");
+  BOOST_REQUIRE( mkfifo( fifo.c_str(), 0600 ) == 0 );
+
+  const std::string s = contents();
+  const std::size_t core_end = coreEnd(s);
+
+  /* (opened read-write so that neither end blocks in open.) */
+  const int out = open( fifo.c_str(), O_RDWR );
+  BOOST_REQUIRE( out >= 0 );
+
+  Direct force;
+  const fields::TableLoad & load = force.readindataAsync( fifo );
+  writeAll( out, s.substr(0, core_end) );
+
+  load.waitCore();
+  BOOST_CHECK( load.coreReady() );
+  BOOST_CHECK( !load.ready() );
+
+  /* the CORE table is used already;  the SHELL falls back to Exact. */
+  const Vector<double,3> rc = V3(.1,.2,.3), rs = V3(1.7,-1.2,.4);
+  BOOST_CHECK( force.useTable(rc) );
+  BOOST_CHECK( !force.useTable(rs) );
+  fields::ForceLookup<> reference;
+  {
+    std::istringstream in(s);
+    reference.readindata(in);
+  }
+  BOOST_CHECK_EQUAL( force.potential(rc), reference.potential(rc) );
+  BOOST_CHECK_EQUAL( force.potential(rs), rs*rs + 1.0 );
+  Vector<double,3> a;
+  force.accel( a, rs );
+  BOOST_CHECK_EQUAL( a, -2.0 * rs );
+
+  writeAll( out, s.substr(core_end) );
+  close( out );
+  load.wait();
+
+  BOOST_CHECK( force.useTable(rs) );
+  BOOST_CHECK_EQUAL( force.potential(rs), reference.potential(rs) );
+
+  std::remove( fifo.c_str() );
+}
+
+BOOST_AUTO_TEST_CASE( failures ) {
+  Blocking force;
+  BOOST_CHECK_THROW( force.readindataAsync( tempName("missing") ),
+                     std::runtime_error );
+
+  const std::string filename = tempName("truncated");
+  {
+    std::ofstream out(filename.c_str());
+    out << "# center \n# 0 0 0\n# CORE : \n";
+  }
+  const fields::TableLoad & load = force.readindataAsync( filename );
+  BOOST_CHECK_THROW( load.wait(), std::runtime_error );
+  BOOST_CHECK( load.failed() );
+  BOOST_CHECK_THROW( force.potential( V3(0.,0.,0.) ), std::runtime_error );
+  std::remove( filename.c_str() );
+}
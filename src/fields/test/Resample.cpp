@@ -0,0 +1,236 @@
+#define BOOST_TEST_MODULE  Resample
+
+#include <fields/resample.h>
+#include <fields/field-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <unistd.h>
+
+#include <sstream>
+#include <fstream>
+#include <string>
+#include <cstdio>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+
+  typedef fields::ForceRecord<3u,2u> Record;
+  typedef fields::FieldLookup<Record> Lookup;
+
+  /** A smooth field to fill the tables with. */
+  inline void fill( Record & rec, const Vector<double,3> & r ) {
+    for ( unsigned int i = 0u; i < 2u; ++i ) {
+      rec.a[i] = V3( std::sin(r[X]) + i, std::cos(r[Y]) * r[Z], r[X]*r[Y] - i );
+      rec.V[i] = std::sin(r[X]) * std::cos(r[Y]) + r[Z]*r[Z] + i;
+    }
+  }
+
+  /** Source for createFieldFile. */
+  struct FillSrc {
+    Record getRecord( const Vector<double,3> & r ) const {
+      Record rec;
+      fill( rec, r );
+      return rec;
+    }
+  };
+
+  std::string tempName( const std::string & name ) {
+    std::ostringstream s;
+    s << "/tmp/Resample-" << name << '-' << getpid();
+    return s.str();
+  }
+
+  /** Write a table with CORE [-1,1]^3 (dx) and SHELL [-2,2]^3 (2*dx). */
+  void writeTable( const std::string & filename,
+                   const double & dx,
+                   const fields::FileFormat & format ) {
+    std::ofstream out( filename.c_str() );
+    out.precision(17);
+    fields::createFieldFile( FillSrc(),
+                             V3(-1.,-1.,-1.), V3(1.,1.,1.), V3(dx,dx,dx),
+                             V3(-2.,-2.,-2.), V3(2.,2.,2.),
+                             V3(2*dx,2*dx,2*dx),
+                             out, "", format );
+  }
+
+  /** Resample the given file onto CORE [-1,1]^3 (dx) and SHELL [-2,2]^3
+   * (2*dx). */
+  std::string resample( const std::string & input,
+                        const double & dx,
+                        const fields::Interpolant & interp,
+                        const fields::FileFormat & format,
+                        const int & band = 0 ) {
+    std::ostringstream out;
+    out.precision(17);
+    fields::resampleFieldFile< Lookup >(
+      input, out,
+      V3(-1.,-1.,-1.), V3(1.,1.,1.), V3(dx,dx,dx),
+      V3(-2.,-2.,-2.), V3(2.,2.,2.), V3(2*dx,2*dx,2*dx),
+      interp, format, band );
+    return out.str();
+  }
+
+  /** Maximum difference between the records of two table files. */
+  double maxDifference( const std::string & file0, const std::string & file1 ) {
+    std::istringstream in0( file0 ), in1( file1 );
+    Lookup l0, l1;
+    l0.readindata( in0 );
+    l1.readindata( in1 );
+
+    double diff = 0.0;
+    for ( int t = Lookup::CORE; t <= Lookup::SHELL; ++t ) {
+      const fields::detail::DTable<Record> & t0 = l0.table( Lookup::DSECT(t) );
+      const fields::detail::DTable<Record> & t1 = l1.table( Lookup::DSECT(t) );
+      for ( unsigned int k = 0u; k < t0.zlen; ++k )
+        for ( unsigned int i = 0u; i < t0.xlen; ++i )
+          for ( unsigned int j = 0u; j < t0.ylen; ++j )
+            for ( unsigned int s = 0u; s < 2u; ++s ) {
+              diff = std::max( diff, (t0(i,j,k).a[s] - t1(i,j,k).a[s]).abs() );
+              diff = std::max( diff, std::abs( t0(i,j,k).V[s] - t1(i,j,k).V[s] ) );
+            }
+    }
+    return diff;
+  }
+
+  /** Maximum error of the potential at the CORE grid points. */
+  double maxError( Lookup & lookup, const double & dx ) {
+    const int n = int( 2.0 / dx + .5 );
+    double err = 0.0;
+    for ( int k = 0; k < n; ++k )
+      for ( int i = 0; i < n; ++i )
+        for ( int j = 0; j < n; ++j ) {
+          const Vector<double,3> r = V3(-1.,-1.,-1.) + dx * V3(i,j,k);
+          Record rec;
+          fill( rec, r );
+          err = std::max( err, std::abs( lookup.scalar_lookup(r, 1u) - rec.V[1] ) );
+        }
+    return err;
+  }
+}
+
+BOOST_AUTO_TEST_CASE( same_grid ) {
+  const std::string input = tempName("same");
+  writeTable( input, .25, fields::BINARY_FILE );
+
+  Lookup orig;
+  orig.readindata( input );
+
+  const fields::Interpolant kinds[2] =
+    { fields::TABLE_INTERPOLANT, fields::CUBIC_INTERPOLANT };
+  for ( int m = 0; m < 2; ++m ) {
+    std::istringstream in( resample( input, .25, kinds[m], fields::TEXT_FILE ) );
+    Lookup result;
+    result.readindata( in );
+
+    BOOST_CHECK_EQUAL( result.geometry(Lookup::CORE).size(),
+                       orig.geometry(Lookup::CORE).size() );
+    BOOST_CHECK_EQUAL( result.geometry(Lookup::SHELL).size(),
+                       orig.geometry(Lookup::SHELL).size() );
+
+    /* the table interpolant clamps lookups below the upper boundaries of
+     * the CORE (which also affects the SHELL records on those boundaries),
+     * so only the cubic interpolant reproduces those exactly. */
+    const bool cubic = kinds[m] == fields::CUBIC_INTERPOLANT;
+    const unsigned int skip = cubic ? 0u : 1u;
+    for ( int t = Lookup::CORE; t <= (cubic ? Lookup::SHELL : Lookup::CORE); ++t ) {
+      const fields::detail::DTable<Record> & o = orig.table( Lookup::DSECT(t) );
+      const fields::detail::DTable<Record> & n = result.table( Lookup::DSECT(t) );
+      for ( unsigned int k = 0u; k < o.zlen - skip; ++k )
+        for ( unsigned int i = 0u; i < o.xlen - skip; ++i )
+          for ( unsigned int j = 0u; j < o.ylen - skip; ++j )
+            for ( unsigned int s = 0u; s < 2u; ++s ) {
+              BOOST_CHECK_SMALL( (o(i,j,k).a[s] - n(i,j,k).a[s]).abs(), 1e-12 );
+              BOOST_CHECK_SMALL( o(i,j,k).V[s] - n(i,j,k).V[s], 1e-12 );
+            }
+    }
+  }
+
+  std::remove( input.c_str() );
+}
+
+BOOST_AUTO_TEST_CASE( bands ) {
+  const std::string input = tempName("bands");
+  writeTable( input, .25, fields::BINARY_FILE );
+
+  /* reading the input in bands gives the same output (up to the rounding of
+   * the cell fractions relative to the cropped tables). */
+  const fields::Interpolant kinds[2] =
+    { fields::TABLE_INTERPOLANT, fields::CUBIC_INTERPOLANT };
+  for ( int m = 0; m < 2; ++m ) {
+    const std::string whole =
+      resample( input, .125, kinds[m], fields::BINARY_FILE );
+    const std::string bands =
+      resample( input, .125, kinds[m], fields::BINARY_FILE, 3 );
+    BOOST_REQUIRE_EQUAL( whole.size(), bands.size() );
+    BOOST_CHECK_SMALL( maxDifference( whole, bands ), 1e-12 );
+  }
+
+  std::remove( input.c_str() );
+}
+
+BOOST_AUTO_TEST_CASE( cubic_interpolant ) {
+  const std::string input = tempName("cubic");
+  writeTable( input, .25, fields::BINARY_FILE );
+
+  std::istringstream lin( resample( input, .125, fields::TABLE_INTERPOLANT,
+                                    fields::BINARY_FILE ) );
+  std::istringstream cub( resample( input, .125, fields::CUBIC_INTERPOLANT,
+                                    fields::BINARY_FILE ) );
+  Lookup linear, cubic;
+  linear.readindata( lin );
+  cubic.readindata( cub );
+
+  const double elin = maxError( linear, .125 ), ecub = maxError( cubic, .125 );
+  BOOST_CHECK_LT( ecub, 0.2 * elin );
+  BOOST_CHECK_LT( ecub, 1e-3 );
+
+  std::remove( input.c_str() );
+}
+
+BOOST_AUTO_TEST_CASE( axisym ) {
+  typedef fields::AxiSymFieldLookup<Record> AxiSym;
+  const std::string input = tempName("axisym");
+  {
+    std::ofstream out( input.c_str() );
+    out.precision(17);
+    fields::createFieldFile( FillSrc(),
+                             V3(0.,0.,-1.), V3(1.,0.,1.), V3(.25,.25,.25),
+                             V3(0.,0.,-2.), V3(2.,0.,2.), V3(.5,.5,.5),
+                             out );
+  }
+
+  std::ostringstream out;
+  out.precision(17);
+  fields::resampleFieldFile< AxiSym >(
+    input, out,
+    V3(0.,0.,-1.), V3(1.,0.,1.), V3(.25,.25,.25),
+    V3(0.,0.,-2.), V3(2.,0.,2.), V3(.5,.5,.5),
+    fields::CUBIC_INTERPOLANT, fields::TEXT_FILE, 2 );
+
+  std::istringstream in( out.str() );
+  AxiSym orig, result;
+  orig.readindata( input );
+  result.readindata( in );
+
+  BOOST_CHECK_SMALL( (result.origin() - orig.origin()).abs(), 1e-15 );
+  for ( int t = AxiSym::CORE; t <= AxiSym::SHELL; ++t ) {
+    const fields::detail::DTable<Record> & o = orig.table( AxiSym::DSECT(t) );
+    const fields::detail::DTable<Record> & n = result.table( AxiSym::DSECT(t) );
+    BOOST_REQUIRE_EQUAL( n.ylen, 1u );
+    for ( unsigned int k = 0u; k < o.zlen; ++k )
+      for ( unsigned int i = 0u; i < o.xlen; ++i )
+        BOOST_CHECK_SMALL( o(i,0,k).V[1] - n(i,0,k).V[1], 1e-12 );
+  }
+
+  std::remove( input.c_str() );
+}
@@ -0,0 +1,122 @@
+#define BOOST_TEST_MODULE  RigidTransform
+
+#include <fields/RigidTransform.h>
+#include <fields/field-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+#include <xylose/timing/Timing.h>
+#include <xylose/timing/element/PowerLaw.h>
+
+#include <sstream>
+#include <string>
+#include <limits>
+#include <cstdio>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+#include "fixture.h"
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+  using namespace fields::test;
+  namespace timing = xylose::timing;
+
+  typedef fields::FieldLookup<Record> Lookup;
+  typedef fields::RigidTransform<Lookup> Moved;
+
+  /** Rotation by angle about the z-axis. */
+  Vector<double,3> rotZ( const Vector<double,3> & r, const double & angle ) {
+    const double c = std::cos(angle), s = std::sin(angle);
+    return V3( c*r[X] - s*r[Y], s*r[X] + c*r[Y], r[Z] );
+  }
+
+  /** Check that m(r) == Rot(plain(p)) where p = pivot + Rot^-1 (r - pivot -
+   * d) for a rotation about z. */
+  void checkPose( const Moved & m, const Lookup & plain,
+                  const Vector<double,3> & d, const double & angle,
+                  const Vector<double,3> & pivot ) {
+    for ( int k = 0; k < 5; ++k )
+      for ( int j = 0; j < 5; ++j )
+        for ( int i = 0; i < 5; ++i ) {
+          const Vector<double,3> r = V3(i - 2., j - 2., k - 2.) * .55;
+          const Vector<double,3> p = pivot + rotZ( r - pivot - d, -angle );
+          BOOST_CHECK_SMALL( (m.tableCoords(r) - p).abs(), 1e-12 );
+          BOOST_CHECK_EQUAL( m.whichTable(r), plain.whichTable(p) );
+          for ( unsigned int s = 0u; s < 2u; ++s ) {
+            Vector<double,3> am, ap;
+            m.vector_lookup( am, r, s );
+            plain.vector_lookup( ap, p, s );
+            BOOST_CHECK_SMALL( (am - rotZ(ap, angle)).abs(), 1e-12 );
+            BOOST_CHECK_SMALL( m.scalar_lookup(r, s) -
+                               plain.scalar_lookup(p, s), 1e-12 );
+          }
+        }
+  }
+
+  timing::element::PowerLaw * constant( const double & val ) {
+    return new timing::element::PowerLaw(
+      -std::numeric_limits<double>::infinity(), 1.0, 1.0, val
+    );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( identity ) {
+  const TableFile t("rigid");
+  Lookup plain( t.name );
+  Moved m( t.name );
+  checkPose( m, plain, V3(0.,0.,0.), 0.0, V3(0.,0.,0.) );
+}
+
+BOOST_AUTO_TEST_CASE( static_pose ) {
+  const TableFile t("rigid");
+  Lookup plain( t.name );
+  Moved m( t.name );
+
+  m.setTranslation( V3(.3,-.2,.1) );
+  checkPose( m, plain, V3(.3,-.2,.1), 0.0, V3(0.,0.,0.) );
+
+  m.setRotation( V3(0.,0.,1.), M_PI/3. );
+  checkPose( m, plain, V3(.3,-.2,.1), M_PI/3., V3(0.,0.,0.) );
+
+  m.setPivot( V3(.5,.5,0.) );
+  checkPose( m, plain, V3(.3,-.2,.1), M_PI/3., V3(.5,.5,0.) );
+
+  /* a general axis:  the table point on the axis through the pivot stays
+   * on that axis. */
+  const Vector<double,3> k = V3(1.,2.,-2.) / 3.;
+  m.setTranslation( V3(0.,0.,0.) );
+  m.setRotation( k, .7 );
+  BOOST_CHECK_SMALL( (m.tableCoords( V3(.5,.5,0.) + .4 * k ) -
+                      (V3(.5,.5,0.) + .4 * k)).abs(), 1e-12 );
+}
+
+BOOST_AUTO_TEST_CASE( timed_pose ) {
+  const TableFile t("rigid");
+  Lookup plain( t.name );
+  fields::ForceLookup< 3u, Moved > m;
+  m.readindata( t.name );
+
+  m.setTranslation( V3(.4,0.,0.) );
+  m.setRotation( V3(0.,0.,1.), M_PI/2. );
+
+  m.translation_timing.timings.clear();
+  m.translation_timing.timings.push_back( constant(.5) );
+  m.rotation_timing.timings.clear();
+  m.rotation_timing.timings.push_back( constant(.25) );
+  m.set_time( 0.0 );
+  checkPose( m, plain, V3(.2,0.,0.), M_PI/8., V3(0.,0.,0.) );
+
+  /* the force follows the moved table. */
+  const Vector<double,3> r = V3(.3,.1,-.2);
+  Vector<double,3> a, ap;
+  m.accel( a, r, V3(0.,0.,0.), 0.0, 0.0, 1u );
+  plain.vector_lookup( ap, rotZ( r - V3(.2,0.,0.), -M_PI/8. ), 1u );
+  BOOST_CHECK_SMALL( (a - rotZ(ap, M_PI/8.)).abs(), 1e-12 );
+}
@@ -0,0 +1,192 @@
+#define BOOST_TEST_MODULE  SpeciesMajorTable
+
+#include <fields/SpeciesMajorTable.h>
+#include <fields/field-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/table-allocation.h>
+#include <fields/indices.h>
+#include <fields/make_options.h>
+
+#include <xylose/Vector.h>
+
+#include <sstream>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <stdexcept>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+
+  typedef fields::ForceRecord<3u,3u> Record;
+  typedef fields::ForceLookup< 3u, fields::FieldLookup<Record> > Lookup;
+  typedef fields::ForceLookup<
+    3u,
+    fields::FieldLookup< Record, fields::SpeciesMajorTable<3u,3u> >
+  > PlaneLookup;
+
+  typedef fields::make_options<>::type::ChimpDB ChimpDB;
+
+  template < unsigned int N >
+  struct Src {
+    fields::ForceRecord<3u,N> getRecord( const Vector<double,3> & r ) const {
+      fields::ForceRecord<3u,N> rec;
+      for ( unsigned int i = 0u; i < N; ++i ) {
+        rec.vector(i) = V3( std::sin(r[X]) * (i+1), r[Y]*r[Z] - i, r[X] );
+        rec.scalar(i) = std::cos(r[Y]) + i*r[Z];
+      }
+      return rec;
+    }
+  };
+
+  inline double rnd() { return std::rand() / (RAND_MAX + 1.0); }
+
+  /** Compare lookups from a SpeciesMajorTable with the default storage. */
+  template < unsigned int N, bool split_species >
+  void compare( const fields::FileFormat & format,
+                const fields::TableAllocation & alloc ) {
+    typedef fields::ForceRecord<3u,N> Record;
+    typedef fields::ForceLookup< 3u, fields::FieldLookup<Record> > Lookup;
+    typedef fields::ForceLookup<
+      3u,
+      fields::FieldLookup< Record,
+                           fields::SpeciesMajorTable<3u,N,split_species> >
+    > ChannelLookup;
+
+    std::stringstream file;
+    file.precision(17);
+    fields::createFieldFile( Src<N>(),
+                             V3(-1.,-1.,-1.), V3(1.,1.,1.), V3(.25,.25,.25),
+                             V3(-3.,-3.,-3.), V3(3.,3.,3.), V3(.5,.5,.5),
+                             file, "", format );
+    const std::string contents = file.str();
+
+    Lookup lookup;
+    {
+      std::istringstream in(contents);
+      lookup.readindata(in);
+    }
+
+    ChannelLookup channels;
+    fields::setAllocation( channels, alloc );
+    {
+      std::istringstream in(contents);
+      channels.readindata(in);
+    }
+
+    std::srand(5);
+    const unsigned int n_r = 1000u;
+    std::vector< Vector<double,3> > r_all(n_r);
+    std::vector<double> V(n_r);
+    for ( unsigned int n = 0u; n < n_r; ++n )
+      r_all[n] = V3( 7.*(rnd()-.5), 7.*(rnd()-.5), 7.*(rnd()-.5) );
+
+    /* potential-only sweep through the pipelined batch lookup. */
+    channels.scalar_lookup( &V[0], &r_all[0], n_r, 0u );
+
+    for ( unsigned int n = 0u; n < n_r; ++n ) {
+      const Vector<double,3> & r = r_all[n];
+      BOOST_CHECK_EQUAL( V[n], lookup.potential(r) );
+      for ( unsigned int s = 0u; s < N; ++s ) {
+        Vector<double,3> a0, a1;
+        lookup.vector_lookup(a0, r, s);
+        channels.vector_lookup(a1, r, s);
+        BOOST_CHECK_EQUAL( a0, a1 );
+        BOOST_CHECK_EQUAL( lookup.scalar_lookup(r, s),
+                           channels.scalar_lookup(r, s) );
+      }
+    }
+  }
+
+}/* namespace (anon) */
+
+BOOST_AUTO_TEST_CASE( species_planes ) {
+  std::stringstream file;
+  file.precision(17);
+  fields::createFieldFile( Src<3u>(),
+                           V3(-1.,-1.,-1.), V3(1.,1.,1.), V3(.25,.25,.25),
+                           V3(-3.,-3.,-3.), V3(3.,3.,3.), V3(.5,.5,.5),
+                           file );
+  const std::string contents = file.str();
+
+  Lookup lookup;
+  {
+    std::istringstream in(contents);
+    lookup.readindata(in);
+  }
+
+  PlaneLookup planes;
+  std::vector<bool> mask(3u, true);
+  mask[1] = false;
+  fields::selectSpecies( planes, mask );
+  {
+    std::istringstream in(contents);
+    planes.readindata(in);
+  }
+  BOOST_CHECK( !planes.table(PlaneLookup::CORE).isSelected(1u) );
+
+  std::srand(5);
+  for ( unsigned int n = 0u; n < 1000u; ++n ) {
+    const Vector<double,3> r =
+      V3( 7.*(rnd()-.5), 7.*(rnd()-.5), 7.*(rnd()-.5) );
+    for ( unsigned int s = 0u; s < 3u; s += 2u ) {
+      Vector<double,3> a0, a1;
+      lookup.vector_lookup(a0, r, s);
+      planes.vector_lookup(a1, r, s);
+      BOOST_CHECK_EQUAL( a0, a1 );
+      BOOST_CHECK_EQUAL( lookup.scalar_lookup(r, s),
+                         planes.scalar_lookup(r, s) );
+    }
+  }
+
+  /* the species that was not loaded cannot be looked up. */
+  Vector<double,3> a;
+  BOOST_CHECK_THROW( planes.vector_lookup(a, V3(0.,0.,0.), 1u),
+                     std::runtime_error );
+  BOOST_CHECK_THROW( planes.scalar_lookup(V3(2.,2.,2.), 1u),
+                     std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( chimp_species ) {
+  std::stringstream file;
+  file.precision(17);
+  fields::createFieldFile( Src<3u>(),
+                           V3(-1.,-1.,-1.), V3(1.,1.,1.), V3(.5,.5,.5),
+                           V3(-2.,-2.,-2.), V3(2.,2.,2.), V3(1.,1.,1.),
+                           file );
+
+  ChimpDB db;
+  db.addParticleType("87Rb");
+  db.addParticleType("85Rb");
+
+  PlaneLookup planes;
+  fields::selectSpecies( planes, db );
+  planes.readindata(file);
+
+  BOOST_CHECK(  planes.table(PlaneLookup::CORE).isSelected(1u) );
+  BOOST_CHECK( !planes.table(PlaneLookup::CORE).isSelected(2u) );
+  BOOST_CHECK(  planes.table(PlaneLookup::SHELL).isSelected(1u) );
+  BOOST_CHECK( !planes.table(PlaneLookup::SHELL).isSelected(2u) );
+
+  /* a grid point, so the lookup is exact. */
+  const Vector<double,3> r = V3(.5,-.5,0.);
+  BOOST_CHECK_CLOSE( planes.scalar_lookup(r, 1u), Src<3u>().getRecord(r).V[1],
+                     1e-8 );
+  BOOST_CHECK_THROW( planes.scalar_lookup(r, 2u), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( separate_channels ) {
+  compare<1u,true>( fields::TEXT_FILE, fields::TableAllocation() );
+  compare<3u,true>( fields::TEXT_FILE, fields::TableAllocation() );
+  compare<3u,false>( fields::TEXT_FILE, fields::TableAllocation() );
+  compare<3u,true>( fields::BINARY_FILE, fields::TableAllocation() );
+  compare<3u,false>( fields::BINARY_FILE, fields::TableAllocation() );
+  compare<1u,true>( fields::TEXT_FILE,
+                    fields::TableAllocation( fields::TRANSPARENT_HUGE_PAGES ) );
+}
@@ -0,0 +1,110 @@
+#define BOOST_TEST_MODULE  StaticFieldLookup
+
+#include <fields/StaticFieldLookup.h>
+#include <fields/field-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <cstdio>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+#include "fixture.h"
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+  using namespace fields::test;
+
+  typedef fields::FieldLookup<Record> Lookup;
+  typedef fields::StaticFieldLookup<Record,9u,9u,9u> Static;
+
+  template < class L0, class L1 >
+  void checkSame( const L0 & l0, const L1 & l1 ) {
+    for ( int k = 0; k < 9; ++k )
+      for ( int j = 0; j < 9; ++j )
+        for ( int i = 0; i < 9; ++i ) {
+          /* includes positions outside of the table (clamped). */
+          const Vector<double,3> r = V3(-1.1,-1.1,-1.1) + .27 * V3(i,j,k);
+          if ( std::abs(r[X]) > 1. || std::abs(r[Y]) > 1. ||
+               std::abs(r[Z]) > 1. )
+            continue;
+          for ( unsigned int s = 0u; s < 2u; ++s ) {
+            Vector<double,3> a0, a1;
+            l0.vector_lookup( a0, r, s );
+            l1.vector_lookup( a1, r, s );
+            BOOST_CHECK_SMALL( (a0 - a1).abs(), 1e-14 );
+            BOOST_CHECK_SMALL( l0.scalar_lookup(r, s) - l1.scalar_lookup(r, s),
+                               1e-14 );
+          }
+        }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( same_as_core_table ) {
+  const std::string file = tempName("core");
+  writeTable( file, fields::BINARY_FILE );
+
+  Lookup lookup;
+  lookup.readindata( file );
+
+  Static * s = new Static;
+  s->readindata( file );
+  BOOST_CHECK_SMALL( (s->geometry().max - V3(1.,1.,1.)).abs(), 1e-15 );
+  checkSame( lookup, *s );
+
+  /* filled directly from the source. */
+  Static * f = new Static;
+  f->fill( FillSrc(), V3(-1.,-1.,-1.), V3(.25,.25,.25) );
+  checkSame( *s, *f );
+
+  /* positions outside of the table are clamped as in FieldLookup. */
+  const Vector<double,3> out = V3(1.5, -3., .2);
+  BOOST_CHECK( !s->inDomain(out) );
+  BOOST_CHECK( s->inDomain( V3(.9,-.9,.2) ) );
+  BOOST_CHECK_CLOSE( s->scalar_lookup( out, 1u ),
+                     s->scalar_lookup( V3(1.,-1.,.2), 1u ), 1e-6 );
+
+  delete f;
+  delete s;
+  std::remove( file.c_str() );
+}
+
+BOOST_AUTO_TEST_CASE( region_of_interest ) {
+  const std::string file = tempName("roi");
+  writeTable( file, fields::BINARY_FILE );
+
+  /* a 5^3 sub-table of the CORE. */
+  typedef fields::ForceLookup< 3u, fields::StaticFieldLookup<
+    Record, 5u, 5u, 5u > > Small;
+  fields::ForceLookup< 3u, Lookup > lookup;
+  lookup.readindata( file );
+
+  Small small;
+  small.readindata( file, V3(-.5,-.5,-.5), V3(.5,.5,.5) );
+  for ( int i = 0; i < 10; ++i ) {
+    const Vector<double,3> r = V3(-.45 + .1*i, .4 - .09*i, .03*i - .2);
+    Vector<double,3> a0, a1;
+    lookup.accel( a0, r, V3(0.,0.,0.), 0., 0., 1u );
+    small.accel( a1, r, V3(0.,0.,0.), 0., 0., 1u );
+    BOOST_CHECK_SMALL( (a0 - a1).abs(), 1e-14 );
+    BOOST_CHECK_SMALL( lookup.potential(r, V3(0.,0.,0.), 0., 1u) -
+                       small.potential(r, V3(0.,0.,0.), 0., 1u), 1e-14 );
+  }
+
+  /* the region must have the dimensions of the table. */
+  Small wrong;
+  BOOST_CHECK_THROW( wrong.readindata( file, V3(-.5,-.5,-.5), V3(.75,.5,.5) ),
+                     std::runtime_error );
+
+  std::remove( file.c_str() );
+}
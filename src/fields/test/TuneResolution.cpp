@@ -0,0 +1,100 @@
+#define BOOST_TEST_MODULE  TuneResolution
+
+#include <fields/tune-resolution.h>
+#include <fields/field-lookup.h>
+#include <fields/force-lookup.h>
+#include <fields/createFieldFile.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace fields::indices;
+
+  typedef fields::ForceRecord<3u,1u> Record;
+  typedef fields::FieldLookup<Record> Lookup;
+
+  /** A gentle background with a sharp feature near (.2,-.1,0). */
+  struct BumpSrc {
+    Record getRecord( const Vector<double,3> & r ) const {
+      const Vector<double,3> dr = r - V3(.2,-.1,0.);
+      const double g = std::exp( - (dr*dr) / (2 * .1 * .1) );
+      Record rec;
+      rec.a = V3( .1 * r[X], .05, .1 * r[Z] ) - dr * (g / (.1 * .1));
+      rec.V = g;
+      return rec;
+    }
+  };
+
+  const Vector<double,3> X_MIN = V3(-1.,-1.,-1.), X_MAX = V3(1.,1.,1.);
+}
+
+BOOST_AUTO_TEST_CASE( meets_error_target ) {
+  const double rel_error = 1e-2;
+  const fields::TableResolution res =
+    fields::tuneResolution( BumpSrc(), X_MIN, X_MAX, rel_error, 64e6 );
+
+  BOOST_CHECK_LE( res.error[0], rel_error );
+  BOOST_CHECK_LE( res.error[1], rel_error );
+
+  /* the CORE surrounds the feature and is finer than the SHELL. */
+  for ( int d = X; d <= Z; ++d ) {
+    BOOST_CHECK_LT( res.X_MINc[d], V3(.2,-.1,0.)[d] );
+    BOOST_CHECK_GT( res.X_MAXc[d], V3(.2,-.1,0.)[d] );
+    BOOST_CHECK_LT( res.dxc[d], res.dxs[d] );
+  }
+  BOOST_CHECK_LT( (res.X_MAXc - res.X_MINc).prod(), (X_MAX - X_MIN).prod() );
+
+  /* cheaper than a single table with the CORE spacing. */
+  double uniform = sizeof(Record);
+  for ( int d = X; d <= Z; ++d )
+    uniform *= std::floor( (X_MAX[d] - X_MIN[d]) / res.dxc[d] + .5 ) + 1;
+  BOOST_CHECK_LT( res.bytes, 0.5 * uniform );
+
+  /* a table with this geometry has the requested accuracy. */
+  std::ostringstream out;
+  out.precision(17);
+  fields::createFieldFile( BumpSrc(), res.X_MINc, res.X_MAXc, res.dxc,
+                           res.X_MINs, res.X_MAXs, res.dxs, out );
+  std::istringstream in( out.str() );
+  Lookup lookup;
+  lookup.readindata( in );
+
+  double scale = 0.0, err = 0.0;
+  for ( int k = 0; k < 4000; ++k ) {
+    /* stay off of the upper boundaries, where the lookups are clamped. */
+    const Vector<double,3> r =
+      X_MIN + .98 * compMult( X_MAX - X_MIN, fields::detail::halton(k + 7u) );
+    Vector<double,3> a;
+    lookup.vector_lookup( a, r, 0u );
+    const Record rec = BumpSrc().getRecord(r);
+    for ( int d = X; d <= Z; ++d ) {
+      scale = std::max( scale, std::abs(rec.a[d]) );
+      err = std::max( err, std::abs(a[d] - rec.a[d]) );
+    }
+  }
+  BOOST_CHECK_LE( err / scale, rel_error );
+}
+
+BOOST_AUTO_TEST_CASE( memory_budget ) {
+  BOOST_CHECK_THROW(
+    fields::tuneResolution( BumpSrc(), X_MIN, X_MAX, 1e-2, 1e6 ),
+    std::runtime_error );
+
+  /* the potential of this source is smooth enough for a small budget. */
+  const fields::TableResolution res =
+    fields::tuneResolution( BumpSrc(), X_MIN, X_MAX, 1e-2, 4e6,
+                            fields::PotentialQuantity() );
+  BOOST_CHECK_LE( res.bytes, 4e6 );
+  BOOST_CHECK_LE( res.error[0], 1e-2 );
+  BOOST_CHECK_LE( res.error[1], 1e-2 );
+}
@@ -0,0 +1,88 @@
+/** \file
+ * The table that the tests of the file based lookups write and read back.
+ */
+
+#ifndef fields_test_fixture_h
+#define fields_test_fixture_h
+
+#include <fields/createFieldFile.h>
+#include <fields/force-lookup.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+
+#include <unistd.h>
+
+#include <sstream>
+#include <string>
+#include <cstdio>
+#include <cmath>
+
+namespace fields {
+  namespace test {
+
+    using xylose::Vector;
+    using xylose::V3;
+
+    typedef ForceRecord<3u,2u> Record;
+
+    /** Source for createFieldFile. */
+    struct FillSrc {
+      Record getRecord( const Vector<double,3> & r ) const {
+        using namespace indices;
+        Record rec;
+        for ( unsigned int i = 0u; i < 2u; ++i ) {
+          rec.a[i] = V3( std::sin(r[X]) + i, r[Y]*r[Z], r[X]*r[Y] - i );
+          rec.V[i] = std::cos(r[X]*r[Y]) + r[Z]*r[Z] + i;
+        }
+        return rec;
+      }
+    };
+
+    /* CORE : [-1,1]^3 with dx=0.25 (9^3),  SHELL : [-2,2]^3 with dx=0.5. */
+    const Vector<double,3> X_MINc = V3(-1.,-1.,-1.), X_MAXc = V3(1.,1.,1.);
+    const Vector<double,3> X_MINs = V3(-2.,-2.,-2.), X_MAXs = V3(2.,2.,2.);
+    const Vector<double,3> dxc = V3(.25,.25,.25), dxs = V3(.5,.5,.5);
+
+    /** A file name for the test (unique to the process). */
+    inline std::string tempName( const std::string & name ) {
+      std::ostringstream s;
+      s << "/tmp/fields-test-" << name << '-' << getpid();
+      return s.str();
+    }
+
+    /** Write the table (with the given SHELL extent). */
+    inline void writeTable( const std::string & filename,
+                            const FileFormat & format,
+                            const std::string & comments = "",
+                            const Vector<double,3> & shell_min = X_MINs,
+                            const Vector<double,3> & shell_max = X_MAXs ) {
+      createFieldFile( FillSrc(), X_MINc, X_MAXc, dxc,
+                       shell_min, shell_max, dxs,
+                       filename, comments, format );
+    }
+
+    /** Remove a table file (and its NumPy arrays). */
+    inline void removeTable( const std::string & filename ) {
+      std::remove( filename.c_str() );
+      std::remove( (filename + ".core.npy").c_str() );
+      std::remove( (filename + ".shell.npy").c_str() );
+    }
+
+    /** A table file that lives as long as this object. */
+    struct TableFile {
+      TableFile( const std::string & name,
+                 const FileFormat & format = BINARY_FILE )
+        : name( tempName(name) ) {
+        writeTable( this->name, format );
+      }
+
+      ~TableFile() { removeTable( name ); }
+
+      const std::string name;
+    };
+
+  }/* namespace fields::test */
+}/* namespace fields */
+
+#endif // fields_test_fixture_h
@@ -0,0 +1,623 @@
+// -*- c++ -*-
+// $Id$
+/*@HEADER
+ *         olson-tools:  A variety of routines and algorithms that
+ *      I've developed and collected over the past few years.  This collection
+ *      represents tools that are most useful for scientific and numerical
+ *      software.  This software is released under the LGPL license except
+ *      otherwise explicitly stated in individual files included in this
+ *      package.  Generally, the files in this package are copyrighted by
+ *      Spencer Olson--exceptions will be noted.   
+ *                 Copyright 2004-2008 Spencer Olson
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *  
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *                                                                                 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA.                                                                           .
+ * 
+ * Questions? Contact Spencer Olson (olsonse@umich.edu) 
+ */
+
+
+
+/** \file
+ * Choose the CORE/SHELL geometry of a field-lookup table from an error
+ * target and a memory budget, instead of by repeated generation and
+ * testing.
+ *
+ * The source is sampled on an octree of blocks over the table extents.  In
+ * each block, second differences of the sampled quantity give the
+ * curvature along each axis and thus, from the error of trilinear
+ * interpolation
+ *   err <= 1/8 * sum_d dx_d^2 * |d^2 f / dx_d^2|,
+ * the largest spacing that the block tolerates.  Blocks where the
+ * curvature is not uniform are subdivided.  The CORE is then placed over
+ * the blocks that need the finest spacing such that the memory of both
+ * tables is smallest, and the resulting geometry is checked (and refined)
+ * by comparing interpolated values on that grid directly with the source.
+ * This check samples the cells of random points as well as every SHELL cell
+ * next to the CORE, testing the center and the face centers of each cell,
+ * so the reported error is an estimate (usually close to, but not a bound
+ * on, the largest error of the table):
+ * <code>
+ *   fields::TableResolution res =
+ *     fields::tuneResolution( src, X_MIN, X_MAX, 1e-4, 512u << 20 );
+ *   fields::createFieldFile( src, res.X_MINc, res.X_MAXc, res.dxc,
+ *                            res.X_MINs, res.X_MAXs, res.dxs, "field.dat" );
+ * </code>
+ */
+
+#ifndef fields_tune_resolution_h
+#define fields_tune_resolution_h
+
+#include <fields/force-lookup.h>
+#include <fields/indices.h>
+
+#include <xylose/Vector.h>
+#include <xylose/except.h>
+#include <xylose/strutil.h>
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <cstddef>
+#include <cmath>
+
+namespace fields {
+
+  using xylose::Vector;
+  using xylose::V3;
+  using namespace indices;
+
+  /** The error quantity of ForceRecord tables:  the accelerations of all
+   * species.  Errors are relative to the largest magnitude of any component
+   * anywhere in the table. */
+  struct AccelQuantity {
+    template < unsigned int L, unsigned int N >
+    void operator()( std::vector<double> & q,
+                     const ForceRecord<L,N> & rec ) const {
+      q.resize( L*N );
+      for ( unsigned int i = 0u; i < N; ++i )
+        for ( unsigned int d = 0u; d < L; ++d )
+          q[i*L + d] = rec.vector(i)[d];
+    }
+  };
+
+  /** The error quantity of ForceRecord tables:  the potentials of all
+   * species. */
+  struct PotentialQuantity {
+    template < unsigned int L, unsigned int N >
+    void operator()( std::vector<double> & q,
+                     const ForceRecord<L,N> & rec ) const {
+      q.resize( N );
+      for ( unsigned int i = 0u; i < N; ++i )
+        q[i] = rec.scalar(i);
+    }
+  };
+
+  /** Geometry of a lookup table (the arguments of createFieldFile).  The
+   * upper corners include a margin of 1e-6*dx for round-off. */
+  struct TableResolution {
+    Vector<double,3> X_MINc, X_MAXc, dxc;
+    Vector<double,3> X_MINs, X_MAXs, dxs;
+    /** Memory of both tables. */
+    double bytes;
+    /** Estimated (from samples) maximum relative error of interpolation in
+     * the CORE and in the SHELL (outside of the CORE). */
+    double error[2];
+  };
+
+  namespace detail {
+
+    /** Evaluates the error quantity of a source and tracks the largest
+     * magnitude of its components. */
+    template < class Src, class Quantity >
+    struct TuneSampler {
+      TuneSampler( const Src & src, const Quantity & quantity )
+        : src(src), quantity(quantity), scale(0.0) { }
+
+      void operator()( std::vector<double> & q, const Vector<double,3> & r ) {
+        quantity( q, src.getRecord(r) );
+        for ( std::size_t c = 0u; c < q.size(); ++c )
+          scale = std::max( scale, std::abs(q[c]) );
+      }
+
+      const Src & src;
+      const Quantity & quantity;
+      double scale;
+    };
+
+    /** A leaf of the sampling octree with the largest curvature along each
+     * axis. */
+    struct TuneBlock {
+      Vector<double,3> lo, hi, curvature;
+      /** The spacing that the block tolerates. */
+      Vector<double,3> h;
+
+      bool contains( const Vector<double,3> & a,
+                     const Vector<double,3> & b ) const {
+        for ( int d = X; d <= Z; ++d )
+          if ( lo[d] < a[d] || b[d] < hi[d] )
+            return false;
+        return true;
+      }
+
+      bool overlaps( const Vector<double,3> & a,
+                     const Vector<double,3> & b ) const {
+        for ( int d = X; d <= Z; ++d )
+          if ( hi[d] <= a[d] || b[d] <= lo[d] )
+            return false;
+        return true;
+      }
+    };
+
+    /** Orders blocks by the volume of the tolerated cells. */
+    inline bool finerBlock( const TuneBlock & a, const TuneBlock & b ) {
+      return a.h.prod() < b.h.prod();
+    }
+
+    /** Point k of the Halton sequence (bases 2, 3, 5) in [0,1)^3. */
+    inline Vector<double,3> halton( unsigned int k ) {
+      const unsigned int base[3] = { 2u, 3u, 5u };
+      Vector<double,3> p;
+      for ( int d = X; d <= Z; ++d ) {
+        double f = 1.0, x = 0.0;
+        for ( unsigned int i = k + 1u; i > 0u; i /= base[d] ) {
+          f /= base[d];
+          x += f * (i % base[d]);
+        }
+        p[d] = x;
+      }
+      return p;
+    }
+
+    inline double maxAbs( const std::vector<double> & q ) {
+      double m = 0.0;
+      for ( std::size_t c = 0u; c < q.size(); ++c )
+        m = std::max( m, std::abs(q[c]) );
+      return m;
+    }
+
+    /** Sample the curvature of a block (at 3x3x3 interior points) and add
+     * it, or its octants if the curvature varies by more than a factor of
+     * four within it, to the leaves. */
+    template < class Sampler >
+    void sampleBlock( Sampler & sample,
+                      const Vector<double,3> & lo,
+                      const Vector<double,3> & hi,
+                      const int & depth,
+                      const int & max_depth,
+                      std::vector<TuneBlock> & leaves ) {
+      const Vector<double,3> size = hi - lo;
+      const Vector<double,3> step = size / 8.0;
+
+      TuneBlock b;
+      b.lo = lo;
+      b.hi = hi;
+      b.curvature = 0.0;
+      double cmin = -1.0, cmax = 0.0;
+
+      std::vector<double> q0, qm, qp, d2;
+      for ( int k = 1; k <= 3; ++k )
+        for ( int j = 1; j <= 3; ++j )
+          for ( int i = 1; i <= 3; ++i ) {
+            const Vector<double,3> r = lo + compMult( size, V3(i,j,k) / 4.0 );
+            sample( q0, r );
+
+            double c = 0.0;
+            for ( int d = X; d <= Z; ++d ) {
+              Vector<double,3> dr(0.0);
+              dr[d] = step[d];
+              sample( qm, r - dr );
+              sample( qp, r + dr );
+              d2.resize( q0.size() );
+              for ( std::size_t e = 0u; e < q0.size(); ++e )
+                d2[e] = qp[e] - 2.0 * q0[e] + qm[e];
+              const double cd = maxAbs( d2 ) / (step[d] * step[d]);
+              b.curvature[d] = std::max( b.curvature[d], cd );
+              c += cd;
+            }
+            cmin = cmin < 0.0 ? c : std::min( cmin, c );
+            cmax = std::max( cmax, c );
+          }
+
+      if ( depth < max_depth && ( depth == 0 || cmax > 4.0 * cmin ) ) {
+        for ( int o = 0; o < 8; ++o ) {
+          Vector<double,3> a = lo, c = lo + 0.5 * size;
+          for ( int d = X; d <= Z; ++d )
+            if ( o & (1 << d) ) {
+              a[d] = c[d];
+              c[d] = hi[d];
+            }
+          sampleBlock( sample, a, c, depth + 1, max_depth, leaves );
+        }
+      } else
+        leaves.push_back( b );
+    }
+
+    /** Number of points of a grid over extent with spacing no larger than
+     * h. */
+    inline Vector<int,3> tunePoints( const Vector<double,3> & extent,
+                                     const Vector<double,3> & h ) {
+      Vector<int,3> N;
+      for ( int d = X; d <= Z; ++d )
+        N[d] = h[d] >= extent[d]
+             ? 2
+             : int( std::ceil( extent[d] / h[d] - 1e-9 ) ) + 1;
+      return N;
+    }
+
+    /** Memory of a table of the given number of points. */
+    inline double tableBytes( const Vector<int,3> & N,
+                              const std::size_t & record_size ) {
+      return double(N[X]) * double(N[Y]) * double(N[Z]) * record_size;
+    }
+
+    inline Vector<double,3> tuneSpacing( const Vector<double,3> & extent,
+                                         const Vector<int,3> & N ) {
+      Vector<double,3> dx;
+      for ( int d = X; d <= Z; ++d )
+        dx[d] = extent[d] / (N[d] - 1);
+      return dx;
+    }
+
+    /** Whether r is strictly inside of (a,b). */
+    inline bool insideBox( const Vector<double,3> & r,
+                           const Vector<double,3> & a,
+                           const Vector<double,3> & b ) {
+      for ( int d = X; d <= Z; ++d )
+        if ( r[d] <= a[d] || b[d] <= r[d] )
+          return false;
+      return true;
+    }
+
+    /** Largest absolute error of trilinear interpolation in cell i of the
+     * grid (lo, dx), tested at the given fractional positions within the
+     * cell.  Positions strictly inside of (ea,eb) are moved to the nearest
+     * face of that box (if it crosses the cell).  For a cell with
+     * uniform curvature, the error is largest at the center of the cell;
+     * where the curvature changes across the cell, it is often largest at
+     * the center of a face. */
+    template < class Sampler >
+    double cellError( Sampler & sample,
+                      const Vector<double,3> & lo,
+                      const Vector<double,3> & dx,
+                      const Vector<int,3> & i,
+                      const Vector<double,3> * f,
+                      const int & nf,
+                      const Vector<double,3> & ea,
+                      const Vector<double,3> & eb ) {
+      double err = 0.0;
+      std::vector<double> q, qc[8];
+      bool corners = false;
+      for ( int t = 0; t < nf; ++t ) {
+        Vector<double,3> ft = f[t];
+        Vector<double,3> r = lo + compMult( i.to_type<double>() + ft, dx );
+        if ( insideBox( r, ea, eb ) ) {
+          /* in a cell that straddles the box, test the nearest face of the
+           * box instead. */
+          int dmin = -1;
+          double fmin = 0.0;
+          for ( int d = X; d <= Z; ++d )
+            for ( int side = 0; side < 2; ++side ) {
+              const double x = ( (side ? eb[d] : ea[d]) - lo[d] ) / dx[d] - i[d];
+              if ( 0.0 <= x && x <= 1.0 &&
+                   ( dmin < 0 || std::abs(x - ft[d]) * dx[d] <
+                                 std::abs(fmin - ft[dmin]) * dx[dmin] ) ) {
+                dmin = d;
+                fmin = x;
+              }
+            }
+          if ( dmin < 0 )
+            continue;
+          ft[dmin] = fmin;
+          r[dmin] = lo[dmin] + (i[dmin] + fmin) * dx[dmin];
+        }
+
+        if ( !corners ) {
+          for ( int c = 0; c < 8; ++c ) {
+            Vector<double,3> rc = lo;
+            for ( int d = X; d <= Z; ++d )
+              rc[d] += (i[d] + ((c >> d) & 1)) * dx[d];
+            sample( qc[c], rc );
+          }
+          corners = true;
+        }
+
+        sample( q, r );
+        for ( std::size_t e = 0u; e < q.size(); ++e ) {
+          double interp = 0.0;
+          for ( int c = 0; c < 8; ++c ) {
+            double w = 1.0;
+            for ( int d = X; d <= Z; ++d )
+              w *= (c >> d) & 1 ? ft[d] : 1.0 - ft[d];
+            interp += w * qc[c][e];
+          }
+          err = std::max( err, std::abs( interp - q[e] ) );
+        }
+      }
+      return err;
+    }
+
+    /** The fractional positions of the center and the face centers of a
+     * cell (the remaining entry is left for a sampled point). */
+    inline void cellPoints( Vector<double,3> (&f)[8] ) {
+      for ( int t = 0; t < 7; ++t )
+        f[t] = V3(.5,.5,.5);
+      for ( int d = X; d <= Z; ++d ) {
+        f[1 + 2*d][d] = 0.0;
+        f[2 + 2*d][d] = 1.0;
+      }
+    }
+
+    /** Cell of the grid (lo, dx, N) that r is interpolated in and the
+     * fractional position of r within it. */
+    inline Vector<int,3> gridCell( const Vector<double,3> & r,
+                                   const Vector<double,3> & lo,
+                                   const Vector<double,3> & dx,
+                                   const Vector<int,3> & N,
+                                   Vector<double,3> & f ) {
+      Vector<int,3> i;
+      for ( int d = X; d <= Z; ++d ) {
+        const double x = (r[d] - lo[d]) / dx[d];
+        i[d] = std::max( 0, std::min( N[d] - 2, int( std::floor(x) ) ) );
+        f[d] = x - i[d];
+      }
+      return i;
+    }
+
+    /** Largest absolute error of trilinear interpolation on the grid
+     * (lo, dx, N), sampled in the cells of points in [a,b] (except those
+     * strictly inside of (ea,eb)).  Each point as well as the center and
+     * the face centers of its cell are tested. */
+    template < class Sampler >
+    double interpolationError( Sampler & sample,
+                               const Vector<double,3> & lo,
+                               const Vector<double,3> & dx,
+                               const Vector<int,3> & N,
+                               const Vector<double,3> & a,
+                               const Vector<double,3> & b,
+                               const Vector<double,3> & ea,
+                               const Vector<double,3> & eb,
+                               const unsigned int & nsamples ) {
+      Vector<double,3> f[8];
+      cellPoints( f );
+
+      double err = 0.0;
+      unsigned int n = 0u;
+      for ( unsigned int k = 0u; n < nsamples && k < 8u * nsamples; ++k ) {
+        const Vector<double,3> r = a + compMult( b - a, halton(k) );
+        if ( insideBox( r, ea, eb ) )
+          continue;
+        ++n;
+
+        const Vector<int,3> i = gridCell( r, lo, dx, N, f[7] );
+        err = std::max( err, cellError( sample, lo, dx, i, f, 8, ea, eb ) );
+      }
+      return err;
+    }
+
+    /** Largest absolute error of trilinear interpolation in the cells of
+     * the grid (lo, dx, N) that touch the boundary of the box [ea,eb] from
+     * outside, tested at the center and the face centers of each cell.  The
+     * CORE covers the largest curvature, so the error of the SHELL is
+     * usually largest right next to it, where random samples rarely land. */
+    template < class Sampler >
+    double boundaryError( Sampler & sample,
+                          const Vector<double,3> & lo,
+                          const Vector<double,3> & dx,
+                          const Vector<int,3> & N,
+                          const Vector<double,3> & ea,
+                          const Vector<double,3> & eb ) {
+      Vector<double,3> f[8];
+      cellPoints( f );
+
+      Vector<int,3> i0, i1;
+      for ( int d = X; d <= Z; ++d ) {
+        i0[d] = std::max( 0, int( std::floor( (ea[d] - lo[d]) / dx[d] ) ) - 1 );
+        i1[d] = std::min( N[d] - 2, int( std::ceil( (eb[d] - lo[d]) / dx[d] ) ) );
+      }
+
+      double err = 0.0;
+      Vector<int,3> i;
+      for ( i[Z] = i0[Z]; i[Z] <= i1[Z]; ++i[Z] )
+        for ( i[Y] = i0[Y]; i[Y] <= i1[Y]; ++i[Y] )
+          for ( i[X] = i0[X]; i[X] <= i1[X]; ++i[X] ) {
+            /* cells within the box are looked up in the CORE. */
+            bool inside = true;
+            for ( int d = X; d <= Z; ++d )
+              if ( lo[d] + i[d] * dx[d] < ea[d] ||
+                   eb[d] < lo[d] + (i[d] + 1) * dx[d] )
+                inside = false;
+            if ( !inside )
+              err = std::max( err, cellError( sample, lo, dx, i, f, 7,
+                                              ea, eb ) );
+          }
+      return err;
+    }
+
+    /** @see fields::tuneResolution (the prototype gives the Record type). */
+    template < class Src, class Quantity, class Record >
+    TableResolution tuneResolution( const Src & src,
+                                    const Vector<double,3> & X_MIN,
+                                    const Vector<double,3> & X_MAX,
+                                    const double & rel_error,
+                                    const double & max_bytes,
+                                    const Quantity & quantity,
+                                    const int & max_depth,
+                                    const Record & ) {
+      const Vector<double,3> extent = X_MAX - X_MIN;
+      for ( int d = X; d <= Z; ++d )
+        if ( !( extent[d] > 0.0 ) )
+          THROW(std::runtime_error,"tuneResolution:  empty table extents");
+
+      TuneSampler<Src,Quantity> sample( src, quantity );
+      std::vector<TuneBlock> leaves;
+      sampleBlock( sample, X_MIN, X_MAX, 0, max_depth, leaves );
+
+      /* the spacing that each block tolerates (equal shares of the error
+       * from each axis). */
+      const double tol = rel_error * sample.scale;
+      for ( std::size_t l = 0u; l < leaves.size(); ++l )
+        for ( int d = X; d <= Z; ++d )
+          leaves[l].h[d] = leaves[l].curvature[d] > 0.0
+                         ? std::sqrt( 8.0 * tol / (3.0 * leaves[l].curvature[d]) )
+                         : extent[d];
+      std::sort( leaves.begin(), leaves.end(), finerBlock );
+
+      /* the CORE covers the k blocks that need the finest spacing. */
+      TableResolution res;
+      res.X_MINs = X_MIN;
+      res.X_MAXs = X_MAX;
+      res.bytes = -1.0;
+      Vector<int,3> Nc(2), Ns(2);
+      Vector<double,3> lo = leaves[0].lo, hi = leaves[0].hi;
+      for ( std::size_t k = 0u; k < leaves.size(); ++k ) {
+        for ( int d = X; d <= Z; ++d ) {
+          lo[d] = std::min( lo[d], leaves[k].lo[d] );
+          hi[d] = std::max( hi[d], leaves[k].hi[d] );
+        }
+
+        Vector<double,3> hc = extent, hs = extent;
+        for ( std::size_t l = 0u; l < leaves.size(); ++l ) {
+          const TuneBlock & b = leaves[l];
+          for ( int d = X; d <= Z; ++d ) {
+            if ( b.overlaps( lo, hi ) )
+              hc[d] = std::min( hc[d], b.h[d] );
+            if ( !b.contains( lo, hi ) )
+              hs[d] = std::min( hs[d], b.h[d] );
+          }
+        }
+
+        const Vector<int,3> nc = tunePoints( hi - lo, hc ),
+                            ns = tunePoints( extent, hs );
+        const double bytes = tableBytes( nc, sizeof(Record) )
+                           + tableBytes( ns, sizeof(Record) );
+        if ( res.bytes < 0.0 || bytes < res.bytes ) {
+          res.bytes = bytes;
+          res.X_MINc = lo;
+          res.X_MAXc = hi;
+          Nc = nc;
+          Ns = ns;
+        }
+      }
+
+      /* check the interpolation error on the chosen grids directly and
+       * refine where the curvature estimate was too optimistic. */
+      const unsigned int nsamples = 1000u;
+      const Vector<double,3> empty = X_MIN - extent;
+      for ( int iter = 0; ; ++iter ) {
+        res.bytes = tableBytes( Nc, sizeof(Record) )
+                  + tableBytes( Ns, sizeof(Record) );
+        if ( res.bytes > max_bytes )
+          THROW(std::runtime_error,
+                "tuneResolution:  the error target needs " +
+                xylose::to_string(res.bytes) +
+                " bytes, more than the budget of " +
+                xylose::to_string(max_bytes) );
+
+        res.dxc = tuneSpacing( res.X_MAXc - res.X_MINc, Nc );
+        res.dxs = tuneSpacing( extent, Ns );
+        res.error[0] = interpolationError( sample, res.X_MINc, res.dxc, Nc,
+                                           res.X_MINc, res.X_MAXc,
+                                           empty, empty, nsamples );
+        res.error[1] = std::max(
+          interpolationError( sample, res.X_MINs, res.dxs, Ns,
+                              res.X_MINs, res.X_MAXs,
+                              res.X_MINc, res.X_MAXc, nsamples ),
+          boundaryError( sample, res.X_MINs, res.dxs, Ns,
+                         res.X_MINc, res.X_MAXc ) );
+        for ( int t = 0; t < 2; ++t )
+          res.error[t] = sample.scale > 0.0 ? res.error[t] / sample.scale : 0.0;
+
+        if ( res.error[0] <= rel_error && res.error[1] <= rel_error ) {
+          /* leave a margin for the round-off of createFieldFile (which steps
+           * from X_MIN to X_MAX by dx). */
+          res.X_MAXc = res.X_MINc + compMult( (Nc - 1).to_type<double>(),
+                                              res.dxc ) + 1e-6 * res.dxc;
+          res.X_MAXs = res.X_MINs + compMult( (Ns - 1).to_type<double>(),
+                                              res.dxs ) + 1e-6 * res.dxs;
+          break;
+        }
+        if ( iter == 10 )
+          THROW(std::runtime_error,
+                "tuneResolution:  could not meet the error target of " +
+                xylose::to_string(rel_error) );
+
+        Vector<int,3> * N[2] = { &Nc, &Ns };
+        for ( int t = 0; t < 2; ++t )
+          if ( res.error[t] > rel_error ) {
+            const double f = std::max( 1.25,
+                                       std::sqrt(res.error[t] / rel_error) );
+            for ( int d = X; d <= Z; ++d )
+              (*N[t])[d] = int( std::ceil( ((*N[t])[d] - 1) * f ) ) + 1;
+          }
+      }
+
+      return res;
+    }
+
+  }/* namespace fields::detail */
+
+  /** Find the geometry of the smallest CORE/SHELL table for the given source
+   * whose interpolation error stays below rel_error and whose memory stays
+   * within max_bytes.
+   *
+   * @param src
+   *     Source of the table records (as for createFieldFile).
+   * @param X_MIN
+   *     Lower corner of the table (the SHELL).
+   * @param X_MAX
+   *     Upper corner of the table (the SHELL).
+   * @param rel_error
+   *     Largest tolerated error of the interpolated quantity, relative to the
+   *     largest magnitude of the quantity in the table.
+   * @param max_bytes
+   *     Memory budget of both tables.
+   * @param quantity
+   *     Functor that extracts the error quantity of a record into a
+   *     std::vector<double> (@see AccelQuantity, PotentialQuantity).
+   * @param max_depth
+   *     Maximum depth of the sampling octree.
+   *
+   * @throws std::runtime_error if the error target cannot be met within the
+   *     memory budget.
+   */
+  template < class Src, class Quantity >
+  TableResolution tuneResolution( const Src & src,
+                                  const Vector<double,3> & X_MIN,
+                                  const Vector<double,3> & X_MAX,
+                                  const double & rel_error,
+                                  const double & max_bytes,
+                                  const Quantity & quantity,
+                                  const int & max_depth = 3 ) {
+    return detail::tuneResolution( src, X_MIN, X_MAX, rel_error, max_bytes,
+                                   quantity, max_depth, src.getRecord(X_MIN) );
+  }
+
+  /** Find the geometry of the smallest table with the given error in the
+   * accelerations (@see tuneResolution, AccelQuantity). */
+  template < class Src >
+  TableResolution tuneResolution( const Src & src,
+                                  const Vector<double,3> & X_MIN,
+                                  const Vector<double,3> & X_MAX,
+                                  const double & rel_error,
+                                  const double & max_bytes ) {
+    return tuneResolution( src, X_MIN, X_MAX, rel_error, max_bytes,
+                           AccelQuantity() );
+  }
+
+}/* namespace fields */
+
+#endif // fields_tune_resolution_h